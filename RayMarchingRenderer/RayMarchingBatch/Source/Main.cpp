@@ -0,0 +1,395 @@
+//
+// Main.cpp
+// Headless batch renderer. Renders a scene file along a camera path on the
+// CPU path, writes the frames and prints per-frame timing and step counts.
+// Per-pixel cost histograms and heatmaps can be written for tuning render
+// settings and scene layout, and per-object costs for finding which objects
+// to simplify. A Chrome trace of the render's profiler zones can be written
+// for seeing how the work spread over the threads, and live metrics published
+// for a scraper while long renders run.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "CPU/AnalyticPrimitives.h"
+#include "CPU/BatchRenderer.h"
+#include "CPU/ImageFile.h"
+#include "CPU/Metrics.h"
+#include "CPU/Profiler.h"
+#include "CPU/SceneFile.h"
+#include "CPU/SignedDistance.h"
+
+namespace
+{
+	struct Options
+	{
+		std::filesystem::path ScenePath{};
+		std::filesystem::path CameraPathFile{};
+		std::filesystem::path OutputDirectory{};
+		std::string ImageFormat{ "ppm" };
+		std::filesystem::path StatsPath{};
+		std::filesystem::path HistogramPath{};
+		std::filesystem::path ObjectCostPath{};
+		std::filesystem::path TracePath{};
+		CPU::MetricsExportSettings Metrics{};
+		int HeatmapMetric{ -1 };
+		float HeatmapMax{ 0.0f };
+
+		CPU::BatchSettings Batch{};
+		std::optional<float> StartTime{};
+		std::optional<float> EndTime{};
+		unsigned int Threads{ 0u };
+		std::optional<float> ConeThreshold{};
+		std::optional<float> SecondaryConeThreshold{};
+		bool Analytic{ false };
+	};
+
+	void PrintUsage()
+	{
+		std::printf(
+			"Usage: RayMarchingBatch [options]\n"
+			"  --scene <file.rmscene>   Scene to render (default: the editor's start-up scene)\n"
+			"  --path <file.txt>        Camera path, one key per line: time px py pz rx ry rz [fov]\n"
+			"                           (default: the scene's camera)\n"
+			"  --frames <n>             Number of frames (default 1)\n"
+			"  --start <t> --end <t>    Path time of the first and last frame (default: the path's range)\n"
+			"  --size <w>x<h>           Resolution (default 1280x720)\n"
+			"  --output <directory>     Write frame_NNNN images here (default: no images)\n"
+			"  --format ppm|pfm         Image format (default ppm)\n"
+			"  --stats <file.csv>       Write per-frame stats as CSV\n"
+			"  --histograms <file.json> Write per-pixel cost histograms, summed over all frames\n"
+			"  --heatmap <metric>       Write a heatmap of a cost counter instead of the colour: primary_steps,\n"
+			"                           normal_evaluations, shadow_steps, reflection_steps, sdf_evaluations\n"
+			"                           or light<n>_shadow_steps\n"
+			"  --heatmap-max <n>        Cost shown as red (default: each frame's 99th percentile)\n"
+			"  --reflections            Also trace reflection rays, so their cost is counted\n"
+			"  --analytic               Intersect primitives only unioned with the scene in closed form instead of marching\n"
+			"  --tiles                  Cull the objects primary and shadow rays evaluate with per tile lists\n"
+			"  --proxies                Start primary rays at the depth of rasterised bounding boxes\n"
+			"  --cone-threshold <k>     Hit threshold of k pixel cone radii at each ray's depth instead of the scene's\n"
+			"  --secondary-cone-threshold <k>\n"
+			"                           The same for shadow and reflection rays, usually a few times coarser\n"
+			"  --object-costs <file>    Write estimated scene distance cost per object and SDF type as JSON\n"
+			"  --trace <file.json>      Write a Chrome trace of the render, for chrome://tracing or ui.perfetto.dev\n"
+			"  --metrics <file.prom>    Publish Prometheus metrics to a file while rendering\n"
+			"  --metrics-port <n>       Serve Prometheus metrics over HTTP on this loopback port while rendering\n"
+			"  --metrics-interval <s>   Seconds between metrics file writes (default: 5)\n"
+			"  --threads <n>            Worker threads including this one (default: all cores)\n"
+			"  --in-flight <n>          Frames rendered concurrently (default: enough to fill every thread)\n");
+	}
+
+	int ParseInt(const std::string& value, const char* name)
+	{
+		size_t end = 0;
+		const int result = std::stoi(value, &end);
+		if (end != value.size() || result < 1)
+			throw std::invalid_argument(std::string(name) + " must be a positive integer");
+		return result;
+	}
+
+	Options ParseOptions(int argc, char* argv[])
+	{
+		Options options{};
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			if (arg == "--help" || arg == "-h")
+			{
+				PrintUsage();
+				std::exit(0);
+			}
+
+			if (arg == "--reflections")
+			{
+				options.Batch.Reflections = true;
+				continue;
+			}
+			if (arg == "--analytic")
+			{
+				options.Analytic = true;
+				continue;
+			}
+			if (arg == "--tiles")
+			{
+				options.Batch.TileCulling = true;
+				continue;
+			}
+			if (arg == "--proxies")
+			{
+				options.Batch.ProxyRaster = true;
+				continue;
+			}
+
+			if (i + 1 >= argc)
+				throw std::invalid_argument(arg + " needs a value");
+			const std::string value = argv[++i];
+
+			if (arg == "--scene")
+				options.ScenePath = value;
+			else if (arg == "--path")
+				options.CameraPathFile = value;
+			else if (arg == "--frames")
+				options.Batch.FrameCount = ParseInt(value, "--frames");
+			else if (arg == "--start")
+				options.StartTime = std::stof(value);
+			else if (arg == "--end")
+				options.EndTime = std::stof(value);
+			else if (arg == "--size")
+			{
+				const size_t x = value.find('x');
+				if (x == std::string::npos)
+					throw std::invalid_argument("--size must be <width>x<height>");
+				options.Batch.Width = ParseInt(value.substr(0, x), "--size width");
+				options.Batch.Height = ParseInt(value.substr(x + 1), "--size height");
+			}
+			else if (arg == "--output")
+				options.OutputDirectory = value;
+			else if (arg == "--format")
+			{
+				if (value != "ppm" && value != "pfm")
+					throw std::invalid_argument("--format must be ppm or pfm");
+				options.ImageFormat = value;
+			}
+			else if (arg == "--stats")
+				options.StatsPath = value;
+			else if (arg == "--histograms")
+				options.HistogramPath = value;
+			else if (arg == "--object-costs")
+			{
+				options.ObjectCostPath = value;
+				options.Batch.ObjectCosts = true;
+			}
+			else if (arg == "--trace")
+				options.TracePath = value;
+			else if (arg == "--metrics")
+				options.Metrics.Path = value;
+			else if (arg == "--metrics-port")
+			{
+				const int port = ParseInt(value, "--metrics-port");
+				if (port > 65535)
+					throw std::invalid_argument("--metrics-port must be at most 65535");
+				options.Metrics.Port = static_cast<uint16_t>(port);
+			}
+			else if (arg == "--metrics-interval")
+				options.Metrics.IntervalSeconds = std::stod(value);
+			else if (arg == "--heatmap")
+			{
+				options.HeatmapMetric = CPU::FindCostMetric(value.c_str());
+				if (options.HeatmapMetric < 0)
+					throw std::invalid_argument("Unknown --heatmap metric " + value);
+			}
+			else if (arg == "--heatmap-max")
+				options.HeatmapMax = static_cast<float>(ParseInt(value, "--heatmap-max"));
+			else if (arg == "--threads")
+				options.Threads = static_cast<unsigned int>(ParseInt(value, "--threads"));
+			else if (arg == "--in-flight")
+				options.Batch.FramesInFlight = ParseInt(value, "--in-flight");
+			else if (arg == "--cone-threshold")
+				options.ConeThreshold = std::stof(value);
+			else if (arg == "--secondary-cone-threshold")
+				options.SecondaryConeThreshold = std::stof(value);
+			else
+				throw std::invalid_argument("Unknown option " + arg);
+		}
+
+		return options;
+	}
+
+	int Run(const Options& options)
+	{
+		CPU::Scene scene = CPU::CreateDefaultScene();
+		CPU::RenderSettings settings{};
+		CPU::CameraPath path{ CPU::PackedCamera{} };
+		std::vector<std::string> objectNames{};
+
+		if (!options.ScenePath.empty())
+		{
+			const CPU::SceneFileView file(options.ScenePath);
+			scene = CPU::CreateScene(file);
+			for (size_t i = 0; i < scene.Objects.size(); ++i)
+				objectNames.emplace_back(file.GetObjectName(i));
+			settings = CPU::CreateRenderSettings(file.GetRenderSettings(), 0, 0);
+			path = CPU::CameraPath(file.GetCamera());
+		}
+
+		if (!options.CameraPathFile.empty())
+			path = CPU::CameraPath::Load(options.CameraPathFile);
+		if (options.ConeThreshold)
+			settings.ConeThresholdScale = *options.ConeThreshold;
+		if (options.SecondaryConeThreshold)
+			settings.SecondaryConeThresholdScale = *options.SecondaryConeThreshold;
+		if (options.Analytic)
+			CPU::FindAnalyticPrimitives(scene);
+
+		CPU::BatchSettings batch = options.Batch;
+		batch.StartTime = options.StartTime.value_or(path.GetStartTime());
+		batch.EndTime = options.EndTime.value_or(path.GetEndTime());
+
+		if (!options.OutputDirectory.empty())
+			std::filesystem::create_directories(options.OutputDirectory);
+
+		CPU::SetProfilerThreadName("Main");
+		CPU::SetProfilerEnabled(!options.TracePath.empty());
+
+		// Publishes until the end of the run, then once more with the final values
+		std::optional<CPU::MetricsExporter> metrics{};
+		if (!options.Metrics.Path.empty() || options.Metrics.Port != 0u)
+			metrics.emplace(CPU::GetMetrics(), options.Metrics);
+
+		CPU::ThreadPool pool(options.Threads);
+		CPU::BatchRenderer renderer(pool);
+
+		std::printf("%zu objects, %zu lights, %d frames at %dx%d, %u threads, %d frames in flight\n",
+		            scene.Objects.size(), scene.Lights.size(), batch.FrameCount, batch.Width, batch.Height,
+		            pool.GetThreadCount(), renderer.GetFramesInFlight(batch));
+		if (options.Analytic)
+			std::printf("%zu objects intersected analytically\n", scene.AnalyticPrimitives.size());
+
+		const auto start = std::chrono::steady_clock::now();
+		const auto stats = renderer.Render(scene, path, settings, batch, [&](const int frame, const CPU::GBuffer& gbuffer, const CPU::Image<CPU::PixelCost>& costs)
+		{
+			if (options.OutputDirectory.empty())
+				return;
+
+			char name[32]{};
+			std::snprintf(name, sizeof(name), "frame_%04d.%s", frame, options.ImageFormat.c_str());
+			if (options.HeatmapMetric < 0)
+			{
+				CPU::WriteImage(options.OutputDirectory / name, gbuffer.Colour);
+				return;
+			}
+
+			float heatmapMax = options.HeatmapMax;
+			if (heatmapMax <= 0.0f)
+			{
+				CPU::CostHistogram histogram = CPU::CreateCostHistograms(settings.MaxSteps, static_cast<int>(scene.Lights.size()),
+				                                                         CPU::BatchRenderer::HistogramBins).Metrics[options.HeatmapMetric];
+				for (int y = 0; y < costs.GetHeight(); ++y)
+					for (int x = 0; x < costs.GetWidth(); ++x)
+						histogram.Add(CPU::GetCostValue(costs.At(x, y), options.HeatmapMetric));
+				heatmapMax = static_cast<float>(histogram.GetPercentile(0.99));
+			}
+
+			CPU::Image<CPU::Float4> heatmap{};
+			CPU::RenderCostHeatmap(costs, options.HeatmapMetric, heatmapMax, heatmap);
+			CPU::WriteImage(options.OutputDirectory / name, heatmap);
+		});
+		const double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		if (!options.TracePath.empty())
+		{
+			CPU::SetProfilerEnabled(false);
+			const auto threads = CPU::CaptureProfile();
+			CPU::WriteChromeTrace(options.TracePath, threads);
+
+			size_t zones = 0u;
+			for (const CPU::ProfileThread& thread : threads)
+				zones += thread.Events.size();
+			std::printf("Wrote %zu zones from %zu threads to %s\n", zones, threads.size(), options.TracePath.string().c_str());
+		}
+
+		std::printf("%6s %8s %10s %10s %11s %9s %9s %13s %6s\n", "frame", "time", "wall ms", "cpu ms", "mean steps", "p99 steps",
+		            "max steps", "shadow steps", "hit %");
+		double cpuMs = 0.0;
+		double meanSteps = 0.0;
+		for (const CPU::BatchFrameStats& frame : stats)
+		{
+			std::printf("%6d %8.3f %10.2f %10.2f %11.2f %9u %9u %13.2f %6.1f\n", frame.Frame, static_cast<double>(frame.Time), frame.WallMs,
+			            frame.CpuMs, frame.MeanSteps, frame.P99Steps, frame.MaxSteps, frame.MeanShadowSteps, frame.HitFraction * 100.0);
+			cpuMs += frame.CpuMs;
+			meanSteps += frame.MeanSteps;
+		}
+
+		const double pixels = static_cast<double>(batch.Width) * batch.Height * static_cast<double>(stats.size());
+		std::printf("Total %.2fms (%.2fms per frame, %.2f Mrays/s), %.2f mean steps per pixel, %.1fx average concurrency\n",
+		            totalMs, totalMs / static_cast<double>(std::max<size_t>(1, stats.size())), pixels / (totalMs * 1000.0),
+		            meanSteps / static_cast<double>(std::max<size_t>(1, stats.size())), cpuMs / totalMs);
+
+		if (!options.HistogramPath.empty() && !stats.empty())
+		{
+			CPU::CostHistograms histograms = stats[0].Costs;
+			for (size_t i = 1; i < stats.size(); ++i)
+				histograms.Merge(stats[i].Costs);
+			CPU::WriteCostHistogramsJson(options.HistogramPath, histograms);
+
+			std::printf("\n%-22s %10s %8s %8s %8s %8s\n", "cost per pixel", "mean", "p50", "p90", "p99", "max");
+			for (int i = 0; i < static_cast<int>(CPU::CostMetric::LightShadowSteps) + static_cast<int>(std::min<size_t>(scene.Lights.size(), CPU::MaxCostLights)); ++i)
+			{
+				const CPU::CostHistogram& histogram = histograms.Metrics[i];
+				std::printf("%-22s %10.2f %8u %8u %8u %8u\n", CPU::GetCostMetricName(i), histogram.GetMean(), histogram.GetPercentile(0.5),
+				            histogram.GetPercentile(0.9), histogram.GetPercentile(0.99), histogram.Max);
+			}
+		}
+
+		if (!options.ObjectCostPath.empty() && !stats.empty())
+		{
+			CPU::ObjectCostCounters counters = stats[0].ObjectCosts;
+			for (size_t i = 1; i < stats.size(); ++i)
+				counters.Merge(stats[i].ObjectCosts);
+
+			// The CPU path evaluates the built-in primitives, so those are what is timed
+			const std::vector<double> unitCosts = CPU::MeasureObjectUnitCosts(scene);
+			std::vector<CPU::ObjectCostSource> sources{};
+			for (size_t i = 0; i < scene.Objects.size(); ++i)
+			{
+				const bool named = i < objectNames.size() && !objectNames[i].empty();
+				sources.push_back({ named ? objectNames[i] : "Object " + std::to_string(i), scene.Objects[i].SDFType,
+				                    CPU::GetSDFTypeName(scene.Objects[i].SDFType), unitCosts[i] });
+			}
+
+			CPU::ObjectCostReport report = CPU::CreateObjectCostReport(counters, sources, "ns");
+			CPU::WriteObjectCostsJson(options.ObjectCostPath, report);
+
+			CPU::SortObjectCosts(report.Objects, CPU::ObjectCostColumn::EstimatedCost, false);
+			std::printf("\n%-24s %-10s %14s %8s %10s %8s\n", "object", "type", "nearest evals", "nearest", "ns / eval", "cost");
+			for (const CPU::ObjectCostEntry& entry : report.Objects)
+				std::printf("%-24.24s %-10.10s %14llu %7.1f%% %10.2f %7.1f%%\n", entry.Name.c_str(), entry.TypeName.c_str(),
+				            static_cast<unsigned long long>(entry.Nearest),
+				            100.0 * static_cast<double>(entry.Nearest) / static_cast<double>(std::max<uint64_t>(1u, report.SceneEvaluations)),
+				            entry.UnitCost, entry.Share * 100.0);
+		}
+
+		if (!options.StatsPath.empty())
+		{
+			std::ofstream csv(options.StatsPath);
+			if (!csv)
+				throw std::runtime_error("Stats file \"" + options.StatsPath.string() + "\" could not be opened for writing");
+
+			csv << "frame,time,wall_ms,cpu_ms,mean_steps,p99_steps,max_steps,mean_shadow_steps,hit_fraction\n";
+			for (const CPU::BatchFrameStats& frame : stats)
+				csv << frame.Frame << ',' << frame.Time << ',' << frame.WallMs << ',' << frame.CpuMs << ',' << frame.MeanSteps << ','
+				    << frame.P99Steps << ',' << frame.MaxSteps << ',' << frame.MeanShadowSteps << ',' << frame.HitFraction << '\n';
+		}
+
+		return 0;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		return Run(ParseOptions(argc, argv));
+	}
+	catch (const std::invalid_argument& e)
+	{
+		std::fprintf(stderr, "%s\n\n", e.what());
+		PrintUsage();
+		return 2;
+	}
+	catch (const std::exception& e)
+	{
+		std::fprintf(stderr, "Error: %s\n", e.what());
+		return 1;
+	}
+}
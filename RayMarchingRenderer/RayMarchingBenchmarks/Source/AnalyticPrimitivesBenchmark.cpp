@@ -0,0 +1,135 @@
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "BenchmarkScenes.h"
+#include "CPU/AnalyticPrimitives.h"
+#include "CPU/RayMarcher.h"
+#include "CPU/SignedDistance.h"
+#include "CPU/ThreadPool.h"
+
+// Primary rays through scenes of randomly placed and rotated built-in
+// primitives on a ground box, with a box minus a sphere in front that stays
+// marched. Each scene is marched in full and with its union-only primitives
+// intersected analytically. A pixel differs when it hits where the marched
+// frame misses or the other way round, or lands further from the marched hit
+// than the pixel is wide there: mostly silhouettes, which the intersection
+// threshold fattens when marching. Marching the largest scene takes too long,
+// so it is only intersected.
+namespace
+{
+	constexpr int Width = 128;
+	constexpr int Height = 72;
+	constexpr int MarchedObjectLimit = 1000;
+
+	struct Primary
+	{
+		std::vector<CPU::Ray> Rays{};
+		double Ms{ 0.0 };
+		double MeanSteps{ 0.0 };
+	};
+
+	CPU::Scene CreatePrimitivesScene(const int count)
+	{
+		CPU::Scene scene{};
+		CPU::Object ground{};
+		ground.SDFType = static_cast<int>(CPU::SDFType::Box);
+		ground.Position = CPU::Float3(0.0f, -0.5f, 0.0f);
+		ground.Parameters = CPU::Float3(40.0f, 0.5f, 40.0f);
+		scene.Objects.push_back(ground);
+
+		CPU::Object carved{};
+		carved.SDFType = static_cast<int>(CPU::SDFType::Box);
+		carved.Position = CPU::Float3(0.0f, 1.0f, 12.0f);
+		scene.Objects.push_back(carved);
+		CPU::Object hole{};
+		hole.Position = CPU::Float3(0.5f, 1.5f, 12.5f);
+		hole.Parameters = CPU::Float3(0.8f);
+		hole.BoolOperator = 2;
+		scene.Objects.push_back(hole);
+
+		// The same seed, so each scene holds the smaller ones' objects
+		const std::vector<CPU::Object> field = CreatePrimitiveField(count, 5u, { CPU::Float3(-35.0f, 0.0f, -45.0f), CPU::Float3(70.0f, 3.0f, 70.0f) });
+		scene.Objects.insert(scene.Objects.end(), field.begin(), field.end());
+		return scene;
+	}
+
+	Primary MarchPrimary(CPU::ThreadPool& pool, const CPU::Scene& scene, const CPU::RenderSettings& settings, const CPU::Camera& camera)
+	{
+		Primary primary{};
+		primary.Rays.resize(static_cast<size_t>(Width) * Height);
+		const CPU::RayCone cone{ CPU::CalculatePixelConeAngle(camera, settings) };
+		primary.Ms = TimeIterations(3, [&]()
+		{
+			pool.ParallelFor(Height, [&](const int y)
+			{
+				for (int x = 0; x < Width; ++x)
+				{
+					const CPU::Float2 texCoord((static_cast<float>(x) + 0.5f) / Width, (static_cast<float>(y) + 0.5f) / Height);
+					primary.Rays[static_cast<size_t>(y) * Width + x] =
+						CPU::RayMarch(scene, settings, camera.Position, CPU::CalculateRayDirection(camera, settings, texCoord), cone);
+				}
+			});
+		}).MinMs;
+
+		for (const CPU::Ray& ray : primary.Rays)
+			primary.MeanSteps += ray.StepCount;
+		primary.MeanSteps /= static_cast<double>(primary.Rays.size());
+		return primary;
+	}
+
+	double CountDifferentPercent(const Primary& primary, const Primary& reference, const float pixelAngle)
+	{
+		size_t different = 0u;
+		for (size_t i = 0; i < primary.Rays.size(); ++i)
+		{
+			const CPU::Ray& ray = primary.Rays[i];
+			const CPU::Ray& truth = reference.Rays[i];
+			if (ray.Hit != truth.Hit || (ray.Hit && Distance(ray.HitPosition, truth.HitPosition) > truth.Depth * pixelAngle))
+				++different;
+		}
+		return static_cast<double>(different) * 100.0 / static_cast<double>(primary.Rays.size());
+	}
+
+	void AnalyticPrimitivesBenchmark()
+	{
+		CPU::ThreadPool pool{};
+		const CPU::Camera camera = CPU::CreateLookAtCamera(CPU::Float3(0.0f, 6.0f, 20.0f), CPU::Float3(0.0f, 0.0f, -5.0f));
+		CPU::RenderSettings settings{};
+		settings.Width = Width;
+		settings.Height = Height;
+		const float pixelAngle = 2.0f * CPU::CalculatePixelConeAngle(camera, settings);
+
+		std::printf("%-8s %9s %11s %11s %9s %11s %11s %9s\n", "objects", "analytic", "marched ms", "analytic ms", "speedup", "steps march", "steps anal.",
+		            "differ");
+		for (const int count : { 10, 100, 1000, 10000 })
+		{
+			CPU::Scene scene = CreatePrimitivesScene(count);
+			CPU::FindAnalyticPrimitives(scene);
+			const Primary analytic = MarchPrimary(pool, scene, settings, camera);
+			const size_t analyticCount = scene.AnalyticPrimitives.size();
+
+			const std::string prefix = "AnalyticPrimitives/" + std::to_string(count) + "/";
+			ReportMetric(prefix + "AnalyticMs", "ms", { analytic.Ms }, false);
+			if (count > MarchedObjectLimit)
+			{
+				std::printf("%-8d %9zu %11s %11.2f %9s %11s %11.2f %9s\n", count, analyticCount, "-", analytic.Ms, "-", "-",
+				            analytic.MeanSteps, "-");
+				continue;
+			}
+
+			scene.AnalyticPrimitives.clear();
+			scene.MarchedObjects.clear();
+			const Primary marched = MarchPrimary(pool, scene, settings, camera);
+			const double different = CountDifferentPercent(analytic, marched, pixelAngle);
+			std::printf("%-8d %9zu %11.2f %11.2f %8.2fx %11.2f %11.2f %8.2f%%\n", count, analyticCount, marched.Ms, analytic.Ms,
+			            marched.Ms / analytic.Ms, marched.MeanSteps, analytic.MeanSteps, different);
+			ReportMetric(prefix + "Speedup", "x", { marched.Ms / analytic.Ms }, true);
+			ReportMetric(prefix + "DifferentPixels", "%", { different }, false);
+		}
+	}
+}
+
+REGISTER_BENCHMARK("AnalyticPrimitives", AnalyticPrimitivesBenchmark);
@@ -0,0 +1,109 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Minimal benchmark harness. Benchmarks register themselves with
+// REGISTER_BENCHMARK and are run (optionally filtered by name) from Main.cpp.
+// Benchmarks that track regressions also report metrics, which Main.cpp can
+// write as JSON and compare against a stored baseline (BenchmarkReport.h).
+
+struct BenchmarkTiming
+{
+	int Iterations{ 0 };
+	double MeanMs{ 0.0 };
+	double MinMs{ 0.0 };
+	double MaxMs{ 0.0 };
+};
+
+// Runs func once to warm caches, then times the given number of iterations.
+template <typename F>
+[[nodiscard]] BenchmarkTiming TimeIterations(int iterations, F&& func)
+{
+	using Clock = std::chrono::steady_clock;
+
+	func();
+
+	BenchmarkTiming timing{};
+	timing.Iterations = iterations;
+	timing.MinMs = 1e300;
+	for (int i = 0; i < iterations; ++i)
+	{
+		const auto start = Clock::now();
+		func();
+		const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		timing.MeanMs += ms;
+		timing.MinMs = std::min(timing.MinMs, ms);
+		timing.MaxMs = std::max(timing.MaxMs, ms);
+	}
+	timing.MeanMs /= std::max(1, iterations);
+
+	return timing;
+}
+
+// A tracked result. Value is the median of the samples and Noise a robust
+// estimate of their standard deviation (1.4826 * median absolute deviation).
+struct BenchmarkMetric
+{
+	std::string Name{};
+	std::string Unit{};
+	double Value{ 0.0 };
+	double Noise{ 0.0 };
+	bool HigherIsBetter{ false };
+	int Samples{ 0 };
+};
+
+[[nodiscard]] inline std::vector<BenchmarkMetric>& GetReportedMetrics()
+{
+	static std::vector<BenchmarkMetric> metrics;
+	return metrics;
+}
+
+[[nodiscard]] inline double CalculateMedian(std::vector<double> values)
+{
+	if (values.empty())
+		return 0.0;
+
+	std::sort(values.begin(), values.end());
+	const size_t mid = values.size() / 2;
+	return values.size() % 2 ? values[mid] : (values[mid - 1] + values[mid]) * 0.5;
+}
+
+inline void ReportMetric(const std::string& name, const std::string& unit, const std::vector<double>& samples, bool higherIsBetter)
+{
+	BenchmarkMetric metric{ name, unit, CalculateMedian(samples), 0.0, higherIsBetter, static_cast<int>(samples.size()) };
+
+	std::vector<double> deviations{};
+	deviations.reserve(samples.size());
+	for (const double sample : samples)
+		deviations.push_back(std::abs(sample - metric.Value));
+	metric.Noise = 1.4826 * CalculateMedian(deviations);
+
+	GetReportedMetrics().push_back(metric);
+}
+
+struct BenchmarkEntry
+{
+	std::string Name;
+	std::function<void()> Run;
+};
+
+[[nodiscard]] inline std::vector<BenchmarkEntry>& GetBenchmarks()
+{
+	static std::vector<BenchmarkEntry> benchmarks;
+	return benchmarks;
+}
+
+struct BenchmarkRegistration
+{
+	BenchmarkRegistration(const std::string& name, std::function<void()> run)
+	{
+		GetBenchmarks().push_back({ name, std::move(run) });
+	}
+};
+
+#define REGISTER_BENCHMARK(name, func) static const BenchmarkRegistration func##Registration(name, func)
@@ -0,0 +1,320 @@
+#include "BenchmarkReport.h"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+	// Just enough JSON for the files written below
+	struct JsonValue
+	{
+		enum class Type { Null, Bool, Number, String, Array, Object } Kind{ Type::Null };
+		bool Bool{ false };
+		double Number{ 0.0 };
+		std::string String{};
+		std::vector<JsonValue> Array{};
+		std::vector<std::pair<std::string, JsonValue>> Object{};
+
+		[[nodiscard]] const JsonValue* Find(const std::string& key) const
+		{
+			for (const auto& [name, value] : Object)
+				if (name == key)
+					return &value;
+			return nullptr;
+		}
+	};
+
+	class JsonParser
+	{
+	public:
+		explicit JsonParser(const std::string& text) : Text(text) {}
+
+		JsonValue Parse()
+		{
+			JsonValue value = ParseValue();
+			SkipWhitespace();
+			if (Position != Text.size())
+				Fail("trailing characters");
+			return value;
+		}
+
+	private:
+		[[noreturn]] void Fail(const std::string& message) const
+		{
+			throw std::runtime_error("JSON " + message + " at offset " + std::to_string(Position));
+		}
+
+		void SkipWhitespace()
+		{
+			while (Position < Text.size() && std::isspace(static_cast<unsigned char>(Text[Position])))
+				++Position;
+		}
+
+		bool Consume(const char c)
+		{
+			SkipWhitespace();
+			if (Position < Text.size() && Text[Position] == c)
+			{
+				++Position;
+				return true;
+			}
+			return false;
+		}
+
+		void Expect(const char c)
+		{
+			if (!Consume(c))
+				Fail(std::string("expected '") + c + "'");
+		}
+
+		JsonValue ParseValue()
+		{
+			SkipWhitespace();
+			if (Position >= Text.size())
+				Fail("unexpected end");
+
+			JsonValue value{};
+			const char c = Text[Position];
+			if (c == '{')
+			{
+				value.Kind = JsonValue::Type::Object;
+				++Position;
+				if (Consume('}'))
+					return value;
+				do
+				{
+					SkipWhitespace();
+					std::string key = ParseString();
+					Expect(':');
+					value.Object.emplace_back(std::move(key), ParseValue());
+				} while (Consume(','));
+				Expect('}');
+			}
+			else if (c == '[')
+			{
+				value.Kind = JsonValue::Type::Array;
+				++Position;
+				if (Consume(']'))
+					return value;
+				do
+				{
+					value.Array.push_back(ParseValue());
+				} while (Consume(','));
+				Expect(']');
+			}
+			else if (c == '"')
+			{
+				value.Kind = JsonValue::Type::String;
+				value.String = ParseString();
+			}
+			else if (Text.compare(Position, 4, "true") == 0 || Text.compare(Position, 5, "false") == 0)
+			{
+				value.Kind = JsonValue::Type::Bool;
+				value.Bool = Text[Position] == 't';
+				Position += value.Bool ? 4 : 5;
+			}
+			else if (Text.compare(Position, 4, "null") == 0)
+			{
+				Position += 4;
+			}
+			else
+			{
+				value.Kind = JsonValue::Type::Number;
+				size_t length = 0;
+				try
+				{
+					value.Number = std::stod(Text.substr(Position, 32), &length);
+				}
+				catch (const std::exception&)
+				{
+					Fail("invalid value");
+				}
+				Position += length;
+			}
+
+			return value;
+		}
+
+		std::string ParseString()
+		{
+			if (Position >= Text.size() || Text[Position] != '"')
+				Fail("expected string");
+			++Position;
+
+			std::string result{};
+			while (Position < Text.size() && Text[Position] != '"')
+			{
+				char c = Text[Position++];
+				if (c == '\\' && Position < Text.size())
+				{
+					c = Text[Position++];
+					if (c == 'n')
+						c = '\n';
+					else if (c == 't')
+						c = '\t';
+				}
+				result += c;
+			}
+
+			if (Position >= Text.size())
+				Fail("unterminated string");
+			++Position;
+			return result;
+		}
+
+		const std::string& Text;
+		size_t Position{ 0 };
+	};
+
+	std::string Escape(const std::string& text)
+	{
+		std::string result{};
+		for (const char c : text)
+		{
+			if (c == '"' || c == '\\')
+				result += '\\';
+			result += c;
+		}
+		return result;
+	}
+
+	const BenchmarkMetric* FindMetric(const std::vector<BenchmarkMetric>& metrics, const std::string& name)
+	{
+		for (const BenchmarkMetric& metric : metrics)
+			if (metric.Name == name)
+				return &metric;
+		return nullptr;
+	}
+}
+
+void WriteBenchmarkJson(const std::filesystem::path& path, const std::vector<BenchmarkMetric>& metrics,
+                        const std::vector<std::pair<std::string, std::string>>& metadata)
+{
+	std::ofstream file(path);
+	if (!file)
+		throw std::runtime_error("Results file \"" + path.string() + "\" could not be opened for writing");
+
+	file << "{\n  \"version\": 1,\n";
+	for (const auto& [key, value] : metadata)
+		file << "  \"" << Escape(key) << "\": \"" << Escape(value) << "\",\n";
+
+	file << "  \"metrics\": [\n";
+	char number[64]{};
+	for (size_t i = 0; i < metrics.size(); ++i)
+	{
+		const BenchmarkMetric& metric = metrics[i];
+		file << "    { \"name\": \"" << Escape(metric.Name) << "\", \"unit\": \"" << Escape(metric.Unit) << "\"";
+		std::snprintf(number, sizeof(number), "%.6g", metric.Value);
+		file << ", \"value\": " << number;
+		std::snprintf(number, sizeof(number), "%.6g", metric.Noise);
+		file << ", \"noise\": " << number;
+		file << ", \"higher_is_better\": " << (metric.HigherIsBetter ? "true" : "false");
+		file << ", \"samples\": " << metric.Samples << " }" << (i + 1 < metrics.size() ? ",\n" : "\n");
+	}
+	file << "  ]\n}\n";
+
+	if (!file)
+		throw std::runtime_error("Results file \"" + path.string() + "\" write failed");
+}
+
+std::vector<BenchmarkMetric> ReadBenchmarkJson(const std::filesystem::path& path)
+{
+	std::ifstream file(path);
+	if (!file)
+		throw std::runtime_error("Results file \"" + path.string() + "\" could not be opened");
+
+	std::stringstream text{};
+	text << file.rdbuf();
+	const std::string contents = text.str();
+	const JsonValue root = JsonParser(contents).Parse();
+
+	const JsonValue* list = root.Find("metrics");
+	if (!list || list->Kind != JsonValue::Type::Array)
+		throw std::runtime_error("Results file \"" + path.string() + "\" has no metrics");
+
+	std::vector<BenchmarkMetric> metrics{};
+	for (const JsonValue& entry : list->Array)
+	{
+		const JsonValue* name = entry.Find("name");
+		const JsonValue* value = entry.Find("value");
+		if (!name || !value)
+			throw std::runtime_error("Results file \"" + path.string() + "\" has a metric without a name or value");
+
+		BenchmarkMetric metric{};
+		metric.Name = name->String;
+		metric.Value = value->Number;
+		if (const JsonValue* unit = entry.Find("unit"))
+			metric.Unit = unit->String;
+		if (const JsonValue* noise = entry.Find("noise"))
+			metric.Noise = noise->Number;
+		if (const JsonValue* higher = entry.Find("higher_is_better"))
+			metric.HigherIsBetter = higher->Bool;
+		if (const JsonValue* samples = entry.Find("samples"))
+			metric.Samples = static_cast<int>(samples->Number);
+		metrics.push_back(metric);
+	}
+
+	return metrics;
+}
+
+std::vector<BenchmarkMetric> SelectBestRuns(const std::vector<BenchmarkMetric>& metrics)
+{
+	std::vector<BenchmarkMetric> best{};
+	for (const BenchmarkMetric& metric : metrics)
+	{
+		BenchmarkMetric* kept = nullptr;
+		for (BenchmarkMetric& candidate : best)
+			if (candidate.Name == metric.Name)
+				kept = &candidate;
+
+		if (!kept)
+			best.push_back(metric);
+		else if (metric.HigherIsBetter ? metric.Value > kept->Value : metric.Value < kept->Value)
+			*kept = metric;
+	}
+	return best;
+}
+
+BenchmarkComparison CompareBenchmarks(const std::vector<BenchmarkMetric>& baseline, const std::vector<BenchmarkMetric>& current, const double tolerance)
+{
+	BenchmarkComparison result{};
+
+	std::printf("%-44s %12s %12s %9s  %s\n", "metric", "baseline", "current", "change", "verdict");
+	for (const BenchmarkMetric& metric : current)
+	{
+		const BenchmarkMetric* base = FindMetric(baseline, metric.Name);
+		if (!base)
+		{
+			std::printf("%-44s %12s %12.4g %9s  new\n", metric.Name.c_str(), "-", metric.Value, "");
+			continue;
+		}
+
+		const double delta = metric.Value - base->Value;
+		const double allowed = std::max(tolerance * std::abs(base->Value), 3.0 * std::sqrt(base->Noise * base->Noise + metric.Noise * metric.Noise));
+		const double change = base->Value != 0.0 ? delta / std::abs(base->Value) * 100.0 : 0.0;
+		const bool worse = metric.HigherIsBetter ? delta < 0.0 : delta > 0.0;
+
+		const char* verdict = "ok";
+		if (std::abs(delta) > allowed)
+		{
+			verdict = worse ? "REGRESSION" : "improved";
+			++(worse ? result.Regressions : result.Improvements);
+		}
+
+		std::printf("%-44s %12.4g %12.4g %+8.1f%%  %s\n", metric.Name.c_str(), base->Value, metric.Value, change, verdict);
+	}
+
+	for (const BenchmarkMetric& metric : baseline)
+	{
+		if (!FindMetric(current, metric.Name))
+		{
+			std::printf("%-44s %12.4g %12s %9s  missing\n", metric.Name.c_str(), metric.Value, "-", "");
+			++result.Missing;
+		}
+	}
+
+	return result;
+}
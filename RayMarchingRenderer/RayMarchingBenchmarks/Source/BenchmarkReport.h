@@ -0,0 +1,35 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Benchmark.h"
+
+// JSON results and baseline comparison for reported metrics.
+//
+// A metric regresses when it moves in its bad direction by more than
+//   max(tolerance * |baseline|, 3 * sqrt(baselineNoise^2 + currentNoise^2))
+// so noisy timings need a clear shift while deterministic counts (zero
+// noise) are held to the relative tolerance alone.
+
+struct BenchmarkComparison
+{
+	int Regressions{ 0 };
+	int Improvements{ 0 };
+	int Missing{ 0 }; // In the baseline but not in this run
+};
+
+// Metadata is written as string fields alongside the metrics. Throws std::runtime_error on failure.
+void WriteBenchmarkJson(const std::filesystem::path& path, const std::vector<BenchmarkMetric>& metrics,
+                        const std::vector<std::pair<std::string, std::string>>& metadata);
+
+// Throws std::runtime_error if the file is missing or not a results file
+[[nodiscard]] std::vector<BenchmarkMetric> ReadBenchmarkJson(const std::filesystem::path& path);
+
+// One metric per name from several runs of the same benchmarks, each the run with the best value and that run's
+// noise. Deterministic counts are the same every run; timings keep the run least disturbed by the rest of the machine.
+[[nodiscard]] std::vector<BenchmarkMetric> SelectBestRuns(const std::vector<BenchmarkMetric>& metrics);
+
+// Prints a line per metric in the current run and returns the totals
+BenchmarkComparison CompareBenchmarks(const std::vector<BenchmarkMetric>& baseline, const std::vector<BenchmarkMetric>& current, double tolerance);
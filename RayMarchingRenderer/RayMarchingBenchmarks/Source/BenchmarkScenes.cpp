@@ -0,0 +1,79 @@
+#include "BenchmarkScenes.h"
+
+#include <cmath>
+#include <random>
+
+#include "Benchmark.h"
+#include "CPU/SignedDistance.h"
+
+std::vector<CPU::Object> CreatePrimitiveField(const int count, const unsigned int seed, const PrimitiveFieldExtent& extent)
+{
+	std::vector<CPU::Object> objects{};
+	objects.reserve(count);
+
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	for (int i = 0; i < count; ++i)
+	{
+		CPU::Object object{};
+		object.SDFType = i % 5;
+		object.Position = extent.Corner + CPU::Float3(unit(rng), unit(rng), unit(rng)) * extent.Size;
+		object.Rotation = CPU::Float3(unit(rng), unit(rng), unit(rng)) * CPU::Float3(6.283f);
+		object.Scale = CPU::Float3(extent.MinScale + unit(rng) * extent.ScaleRange);
+		object.Parameters = CPU::Float3(0.5f + unit(rng), 0.5f + unit(rng), 0.5f + unit(rng));
+		// A thinner tube, so most tori keep their hole
+		if (object.SDFType == static_cast<int>(CPU::SDFType::Torus))
+			object.Parameters.y *= 0.4f;
+		objects.push_back(object);
+	}
+	return objects;
+}
+
+GBufferFrame RenderGBufferFrame(CPU::ThreadPool& pool, const CPU::Scene& scene, const CPU::RenderSettings& settings, const CPU::Camera& camera,
+                                const CPU::ObjectCulling* culling, const CPU::Image<float>* proxyDepths)
+{
+	GBufferFrame frame{};
+	frame.Output.Resize(settings.Width, settings.Height);
+	frame.Costs.Resize(settings.Width, settings.Height);
+	frame.Ms = TimeIterations(3, [&]()
+	{
+		pool.ParallelFor(settings.Height, [&](const int y)
+		{
+			CPU::RenderGBufferRows(scene, camera, settings, frame.Output, y, y + 1, &frame.Costs, culling, proxyDepths);
+		});
+	}).MinMs;
+
+	for (int y = 0; y < settings.Height; ++y)
+	{
+		for (int x = 0; x < settings.Width; ++x)
+		{
+			frame.MeanSteps += frame.Costs.At(x, y).PrimarySteps;
+			frame.MeanShadowSteps += frame.Costs.At(x, y).ShadowSteps;
+		}
+	}
+	const double pixels = static_cast<double>(settings.Width) * settings.Height;
+	frame.MeanSteps /= pixels;
+	frame.MeanShadowSteps /= pixels;
+	return frame;
+}
+
+double CountDifferentHitPercent(const CPU::GBuffer& frame, const CPU::GBuffer& reference, const float pixelAngle)
+{
+	const int width = reference.NormDepth.GetWidth();
+	const int height = reference.NormDepth.GetHeight();
+	size_t different = 0u;
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			const bool hit = frame.MaterialIndex.At(x, y).w > 0.0f;
+			const bool truth = reference.MaterialIndex.At(x, y).w > 0.0f;
+			const float depth = frame.NormDepth.At(x, y).w;
+			const float truthDepth = reference.NormDepth.At(x, y).w;
+			// Both depths are over the same MaxDist, which cancels
+			if (hit != truth || (hit && std::abs(depth - truthDepth) > truthDepth * pixelAngle))
+				++different;
+		}
+	}
+	return static_cast<double>(different) * 100.0 / static_cast<double>(width * height);
+}
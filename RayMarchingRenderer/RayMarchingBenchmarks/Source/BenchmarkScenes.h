@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+
+#include "CPU/CostCounters.h"
+#include "CPU/Image.h"
+#include "CPU/ObjectCulling.h"
+#include "CPU/RayMarcher.h"
+#include "CPU/SceneData.h"
+#include "CPU/ThreadPool.h"
+
+// Scenes and G-buffer renders shared by the benchmarks that compare one way of
+// marching a scene against another.
+
+// Where CreatePrimitiveField scatters its objects: positions in Corner + [0, Size) and scales in
+// MinScale + [0, ScaleRange)
+struct PrimitiveFieldExtent
+{
+	CPU::Float3 Corner{ 0.0f };
+	CPU::Float3 Size{ 1.0f };
+	float MinScale{ 0.3f };
+	float ScaleRange{ 0.7f };
+};
+
+// count built-in primitives, cycling through the five types, each placed, rotated, scaled and sized at random. The
+// same seed gives the same objects, so a field holds the first objects of any larger one.
+[[nodiscard]] std::vector<CPU::Object> CreatePrimitiveField(int count, unsigned int seed, const PrimitiveFieldExtent& extent);
+
+struct GBufferFrame
+{
+	CPU::GBuffer Output{};
+	CPU::Image<CPU::PixelCost> Costs{};
+	double Ms{ 0.0 }; // Fastest of three renders
+	double MeanSteps{ 0.0 };
+	double MeanShadowSteps{ 0.0 };
+};
+
+// Renders settings.Width x settings.Height a row per job, with culling and proxyDepths passed to RenderGBufferRows
+[[nodiscard]] GBufferFrame RenderGBufferFrame(CPU::ThreadPool& pool, const CPU::Scene& scene, const CPU::RenderSettings& settings,
+                                              const CPU::Camera& camera, const CPU::ObjectCulling* culling = nullptr,
+                                              const CPU::Image<float>* proxyDepths = nullptr);
+
+// Share of pixels, in percent, where one frame hits and the other misses, or both hit further apart than the
+// reference's depth times pixelAngle, about a pixel's width there. Culling and the like change how rays step past
+// objects, not where they stop, so these are the pixels they moved.
+[[nodiscard]] double CountDifferentHitPercent(const CPU::GBuffer& frame, const CPU::GBuffer& reference, float pixelAngle);
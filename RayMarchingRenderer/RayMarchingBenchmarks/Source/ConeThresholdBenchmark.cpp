@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "CPU/RayMarcher.h"
+#include "CPU/SignedDistance.h"
+#include "CPU/ThreadPool.h"
+
+// Hit thresholds from the pixel cone against the fixed IntersectionThreshold,
+// on a deep scene: a field of spheres, half of them metal, on a ground plane
+// that the camera looks along to the horizon. Each frame renders the G-buffer
+// and the reflection pass with cost counters, so primary, shadow and reflection
+// steps are counted separately. A pixel's hit has moved when it hits where the
+// fixed threshold frame misses or the other way round, or lands further from
+// that frame's surface than the pixel is wide there. Its colour has changed when any channel,
+// with reflections, moves by more than ColourTolerance, about two 8-bit levels.
+// Ambient occlusion comes from the step count, so fewer steps alone lighten it.
+namespace
+{
+	constexpr int Width = 256;
+	constexpr int Height = 144;
+	constexpr float ColourTolerance = 2.0f / 255.0f;
+
+	struct Frame
+	{
+		CPU::GBuffer GBuffer{};
+		CPU::Image<CPU::Float4> Reflections{};
+		double Ms{ 0.0 };
+		double PrimarySteps{ 0.0 };
+		double ShadowSteps{ 0.0 };
+		double ReflectionSteps{ 0.0 };
+	};
+
+	CPU::Scene CreateFieldScene()
+	{
+		CPU::Scene scene{};
+		CPU::Object ground{};
+		ground.SDFType = static_cast<int>(CPU::SDFType::Box);
+		ground.Position = CPU::Float3(0.0f, -0.5f, -200.0f);
+		ground.Parameters = CPU::Float3(200.0f, 0.5f, 200.0f);
+		ground.Colour = CPU::Float3(0.6f, 0.6f, 0.5f);
+		ground.Metalicness = 0.3f;
+		scene.Objects.push_back(ground);
+
+		// 8 x 8 spheres every 32 units, reaching 250 units away
+		for (int z = 0; z < 8; ++z)
+		{
+			for (int x = 0; x < 8; ++x)
+			{
+				CPU::Object sphere{};
+				sphere.Position = CPU::Float3(static_cast<float>(x - 4) * 32.0f + 16.0f, 1.0f, static_cast<float>(-z) * 32.0f - 8.0f);
+				sphere.Colour = CPU::Float3(0.2f + 0.1f * static_cast<float>(x), 0.3f, 0.2f + 0.1f * static_cast<float>(z));
+				sphere.Metalicness = (x + z) % 2 == 0 ? 0.8f : 0.0f;
+				scene.Objects.push_back(sphere);
+			}
+		}
+
+		CPU::Light light{};
+		light.Position = CPU::Float3(10.0f, 40.0f, -20.0f);
+		light.LinearAttenuation = 0.0f;
+		light.QuadraticAttenuation = 0.0f;
+		scene.Lights.push_back(light);
+		return scene;
+	}
+
+	Frame RenderFrame(CPU::ThreadPool& pool, const CPU::Scene& scene, const CPU::Camera& camera, const CPU::RenderSettings& settings)
+	{
+		Frame frame{};
+		frame.GBuffer.Resize(Width, Height);
+		frame.Reflections.Resize(Width, Height);
+		CPU::Image<CPU::PixelCost> costs{};
+		frame.Ms = TimeIterations(3, [&]()
+		{
+			costs.Resize(Width, Height);
+			pool.ParallelFor(Height, [&](const int y) { CPU::RenderGBufferRows(scene, camera, settings, frame.GBuffer, y, y + 1, &costs); });
+			pool.ParallelFor(Height, [&](const int y) { CPU::TraceReflectionRows(scene, camera, settings, frame.GBuffer, frame.Reflections, y, y + 1, &costs); });
+		}).MinMs;
+
+		for (int y = 0; y < Height; ++y)
+		{
+			for (int x = 0; x < Width; ++x)
+			{
+				const CPU::PixelCost& cost = costs.At(x, y);
+				frame.PrimarySteps += cost.PrimarySteps;
+				frame.ShadowSteps += cost.ShadowSteps;
+				frame.ReflectionSteps += cost.ReflectionSteps;
+			}
+		}
+		const double pixels = static_cast<double>(Width) * Height;
+		frame.PrimarySteps /= pixels;
+		frame.ShadowSteps /= pixels;
+		frame.ReflectionSteps /= pixels;
+		return frame;
+	}
+
+	bool HasColourChanged(const CPU::Float4& a, const CPU::Float4& b)
+	{
+		return std::max({ std::abs(CPU::Saturate(a.x) - CPU::Saturate(b.x)), std::abs(CPU::Saturate(a.y) - CPU::Saturate(b.y)),
+		                  std::abs(CPU::Saturate(a.z) - CPU::Saturate(b.z)) }) > ColourTolerance;
+	}
+
+	// Percentage of pixels whose primary hit moved, and whose displayed colour changed
+	void Compare(const Frame& frame, const Frame& reference, const CPU::Camera& camera, const CPU::RenderSettings& settings, double& movedHits,
+	             double& changedColours)
+	{
+		const float pixelAngle = 2.0f * CPU::CalculatePixelConeAngle(camera, settings);
+		size_t moved = 0u, changed = 0u;
+		for (int y = 0; y < Height; ++y)
+		{
+			for (int x = 0; x < Width; ++x)
+			{
+				// Distance between the two hits along the reference normal, against the pixel's width at its depth
+				const CPU::Float4 normDepth = reference.GBuffer.NormDepth.At(x, y);
+				const CPU::Float3 normal = CPU::Float3(normDepth.x, normDepth.y, normDepth.z) * CPU::Float3(2.0f) - CPU::Float3(1.0f);
+				const float depth = frame.GBuffer.NormDepth.At(x, y).w;
+				const CPU::Float2 texCoord((static_cast<float>(x) + 0.5f) / Width, (static_cast<float>(y) + 0.5f) / Height);
+				const float facing = std::abs(CPU::Dot(normal, CPU::CalculateRayDirection(camera, settings, texCoord)));
+				const bool hit = frame.GBuffer.MaterialIndex.At(x, y).w > 0.0f;
+				const bool referenceHit = reference.GBuffer.MaterialIndex.At(x, y).w > 0.0f;
+				if (hit != referenceHit || (hit && std::abs(depth - normDepth.w) * facing > normDepth.w * pixelAngle))
+					++moved;
+				if (HasColourChanged(frame.GBuffer.Colour.At(x, y), reference.GBuffer.Colour.At(x, y)) ||
+				    HasColourChanged(frame.Reflections.At(x, y), reference.Reflections.At(x, y)))
+					++changed;
+			}
+		}
+		const double pixels = static_cast<double>(Width) * Height;
+		movedHits = static_cast<double>(moved) * 100.0 / pixels;
+		changedColours = static_cast<double>(changed) * 100.0 / pixels;
+	}
+
+	void ConeThresholdBenchmark()
+	{
+		struct Variant
+		{
+			std::string Name{};
+			float Scale{ 0.0f };
+			float SecondaryScale{ 0.0f };
+		};
+		const std::vector<Variant> variants = {
+			{ "Fixed", 0.0f, 0.0f },
+			{ "Cone1", 1.0f, 4.0f },
+			{ "Cone2", 2.0f, 8.0f },
+		};
+
+		CPU::ThreadPool pool{};
+		const CPU::Scene scene = CreateFieldScene();
+		const CPU::Camera camera = CPU::CreateLookAtCamera(CPU::Float3(0.0f, 2.5f, 4.0f), CPU::Float3(0.0f, 1.5f, -60.0f));
+		CPU::RenderSettings settings{};
+		settings.Width = Width;
+		settings.Height = Height;
+
+		std::printf("%-10s %9s %9s %9s %9s %9s %9s %9s\n", "threshold", "ms", "speedup", "primary", "shadow", "reflect", "hits", "colours");
+		Frame reference{};
+		for (const Variant& variant : variants)
+		{
+			settings.ConeThresholdScale = variant.Scale;
+			settings.SecondaryConeThresholdScale = variant.SecondaryScale;
+			Frame frame = RenderFrame(pool, scene, camera, settings);
+			if (variant.Scale <= 0.0f)
+				reference = frame;
+
+			double movedHits = 0.0, changedColours = 0.0;
+			Compare(frame, reference, camera, settings, movedHits, changedColours);
+			std::printf("%-10s %9.2f %8.2fx %9.2f %9.2f %9.2f %8.2f%% %8.2f%%\n", variant.Name.c_str(), frame.Ms, reference.Ms / frame.Ms, frame.PrimarySteps,
+			            frame.ShadowSteps, frame.ReflectionSteps, movedHits, changedColours);
+
+			const std::string prefix = "ConeThreshold/" + variant.Name + "/";
+			ReportMetric(prefix + "PrimarySteps", "steps/pixel", { frame.PrimarySteps }, false);
+			ReportMetric(prefix + "SecondarySteps", "steps/pixel", { frame.ShadowSteps + frame.ReflectionSteps }, false);
+			ReportMetric(prefix + "MovedHits", "%", { movedHits }, false);
+		}
+	}
+}
+
+REGISTER_BENCHMARK("ConeThreshold", ConeThresholdBenchmark);
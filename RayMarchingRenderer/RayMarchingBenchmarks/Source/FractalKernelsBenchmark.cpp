@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "CPU/FractalKernels.h"
+#include "CPU/SnippetCost.h"
+#include "CPU/SnippetPorts.h"
+
+// Built-in fractal kernels against the text snippet ports they replace, over
+// the snippet benchmark's points: one point at a time, then batched four per
+// SSE2 instruction. Also checks the batched results against the single point
+// ones and FastLog against std::log.
+namespace
+{
+	constexpr uint32_t PointCount = 1u << 16u;
+
+	struct Kernel
+	{
+		std::string Name{};
+		CPU::SignedDistanceFunction Snippet{ nullptr }; // Port of the example snippet, if there is one
+		float (*Scalar)(const CPU::Float3&, const CPU::Float3&, float){ nullptr };
+		void (*Batch)(const CPU::Float3*, size_t, const CPU::Float3&, float, float*){ nullptr };
+		CPU::Float3 Parameters{ 1.0f };
+	};
+
+	template <typename Function>
+	double MeasureRate(const std::vector<CPU::Float3>& points, const CPU::Float3& parameters, const Function& sdf)
+	{
+		volatile float sink = 0.0f;
+		const BenchmarkTiming timing = TimeIterations(5, [&]()
+		{
+			float sum = 0.0f;
+			for (const CPU::Float3& p : points)
+				sum += sdf(p, parameters);
+			sink = sink + sum;
+		});
+		return static_cast<double>(points.size()) / (timing.MinMs * 1e3);
+	}
+
+	void FractalKernelsBenchmark()
+	{
+		std::vector<CPU::Float3> points(PointCount);
+		for (uint32_t i = 0; i < PointCount; ++i)
+			points[i] = CPU::GetSnippetBenchmarkPoint(i);
+
+		// Largest error of FastLog over a log spaced sweep, absolute and relative to the result
+		double logError = 0.0, logRelativeError = 0.0;
+		for (int i = 0; i <= 1 << 20; ++i)
+		{
+			const float x = std::exp2(-40.0f + 80.0f * static_cast<float>(i) / static_cast<float>(1 << 20));
+			const double exact = std::log(static_cast<double>(x));
+			const double error = std::abs(static_cast<double>(CPU::FastLog(x)) - exact);
+			logError = std::max(logError, error);
+			if (std::abs(exact) > 1e-3)
+				logRelativeError = std::max(logRelativeError, error / std::abs(exact));
+		}
+		std::printf("FastLog over [2^-40, 2^40]: max error %.3g, max relative error %.3g\n", logError, logRelativeError);
+		ReportMetric("FractalKernels/FastLogError", "abs", { logError }, false);
+
+		const std::vector<Kernel> kernels = {
+			{ "Mandelbulb", &CPU::SdfMandelbulbSnippet, &CPU::SdfMandelbulb, &CPU::SdfMandelbulbBatch, CPU::Float3(8.0f) },
+			{ "Juliabulb", &CPU::SdfJuliabulbSnippet, &CPU::SdfJuliabulb, &CPU::SdfJuliabulbBatch, CPU::Float3(0.35f, 0.25f, -0.4f) },
+			{ "Julia", &CPU::SdfJuliaSnippet, &CPU::SdfQuaternionJulia, &CPU::SdfQuaternionJuliaBatch, CPU::Float3(-0.2f, 0.6f, 0.2f) },
+			{ "Sierpinski", &CPU::SdfSierpinskiSnippet, &CPU::SdfSierpinski, &CPU::SdfSierpinskiBatch, CPU::Float3(1.0f) },
+			{ "Menger", nullptr, &CPU::SdfMenger, &CPU::SdfMengerBatch, CPU::Float3(1.0f) },
+		};
+
+		std::printf("%-12s %12s %12s %12s %9s %12s\n", "Mevals/s", "snippet", "scalar", "batch", "speedup", "batch diff");
+		std::vector<float> distances(PointCount);
+		for (const Kernel& kernel : kernels)
+		{
+			const double snippet = kernel.Snippet ? MeasureRate(points, kernel.Parameters, kernel.Snippet) : 0.0;
+			const double scalar = MeasureRate(points, kernel.Parameters, [&kernel](const CPU::Float3& p, const CPU::Float3& param) { return kernel.Scalar(p, param, 0.0f); });
+			const BenchmarkTiming batchTiming = TimeIterations(5, [&]() { kernel.Batch(points.data(), points.size(), kernel.Parameters, 0.0f, distances.data()); });
+			const double batch = static_cast<double>(points.size()) / (batchTiming.MinMs * 1e3);
+
+			// Largest difference to the single point kernel, relative to the distance where that is over 1
+			double difference = 0.0;
+			for (size_t i = 0; i < points.size(); ++i)
+			{
+				const double expected = kernel.Scalar(points[i], kernel.Parameters, 0.0f);
+				if (std::isfinite(expected))
+					difference = std::max(difference, std::abs(distances[i] - expected) / std::max(1.0, std::abs(expected)));
+			}
+
+			const double baseline = kernel.Snippet ? snippet : scalar;
+			std::printf("%-12s %12.2f %12.2f %12.2f %8.2fx %12.3g\n", kernel.Name.c_str(), snippet, scalar, batch, batch / baseline, difference);
+			ReportMetric("FractalKernels/" + kernel.Name + "/Batch", "Mevals/s", { batch }, true);
+		}
+	}
+}
+
+REGISTER_BENCHMARK("FractalKernels", FractalKernelsBenchmark);
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "CPU/RayMarcher.h"
+#include "CPU/SignedDistance.h"
+#include "CPU/ThreadPool.h"
+
+// Fractal iteration LOD from the pixel cone footprint, on the built-in fractal
+// types. Each fractal is rendered from the suite's fractal camera and from
+// further back along the same view, with every iteration and with detail
+// below the footprint dropped. A pixel has changed when any channel of its
+// colour moves by more than ColourTolerance, about two 8-bit levels. Without
+// antialiasing, sub-pixel detail shades as per-pixel noise either way, so the
+// visible change is taken over Block x Block pixel averages.
+namespace
+{
+	constexpr int Width = 256;
+	constexpr int Height = 144;
+	constexpr float ColourTolerance = 2.0f / 255.0f;
+	constexpr int Block = 4;
+
+	struct Frame
+	{
+		CPU::GBuffer GBuffer{};
+		double Ms{ 0.0 };
+		double MeanSteps{ 0.0 };
+	};
+
+	Frame RenderFrame(CPU::ThreadPool& pool, const CPU::Scene& scene, const CPU::Camera& camera, const CPU::RenderSettings& settings)
+	{
+		Frame frame{};
+		frame.GBuffer.Resize(Width, Height);
+		CPU::Image<CPU::PixelCost> costs{};
+		costs.Resize(Width, Height);
+		frame.Ms = TimeIterations(5, [&]()
+		{
+			pool.ParallelFor(Height, [&](const int y) { CPU::RenderGBufferRows(scene, camera, settings, frame.GBuffer, y, y + 1, &costs); });
+		}).MinMs;
+
+		for (int y = 0; y < Height; ++y)
+			for (int x = 0; x < Width; ++x)
+				frame.MeanSteps += costs.At(x, y).PrimarySteps;
+		frame.MeanSteps /= static_cast<double>(Width) * Height;
+		return frame;
+	}
+
+	CPU::Float3 GetDisplayedColour(const Frame& frame, const int x, const int y)
+	{
+		const CPU::Float4 colour = frame.GBuffer.Colour.At(x, y);
+		return CPU::Float3(CPU::Saturate(colour.x), CPU::Saturate(colour.y), CPU::Saturate(colour.z));
+	}
+
+	float GetLargestChange(const CPU::Float3& a, const CPU::Float3& b)
+	{
+		return std::max({ std::abs(a.x - b.x), std::abs(a.y - b.y), std::abs(a.z - b.z) });
+	}
+
+	// Percentage of pixels, and of blocks of pixels averaged together, whose displayed colour changed
+	void CompareColour(const Frame& frame, const Frame& reference, double& changedPixels, double& changedBlocks)
+	{
+		size_t pixels = 0u, blocks = 0u;
+		for (int blockY = 0; blockY < Height; blockY += Block)
+		{
+			for (int blockX = 0; blockX < Width; blockX += Block)
+			{
+				CPU::Float3 sum(0.0f), referenceSum(0.0f);
+				for (int y = blockY; y < blockY + Block; ++y)
+				{
+					for (int x = blockX; x < blockX + Block; ++x)
+					{
+						const CPU::Float3 colour = GetDisplayedColour(frame, x, y);
+						const CPU::Float3 referenceColour = GetDisplayedColour(reference, x, y);
+						if (GetLargestChange(colour, referenceColour) > ColourTolerance)
+							++pixels;
+						sum += colour;
+						referenceSum += referenceColour;
+					}
+				}
+				if (GetLargestChange(sum, referenceSum) > ColourTolerance * Block * Block)
+					++blocks;
+			}
+		}
+		changedPixels = static_cast<double>(pixels) * 100.0 / (static_cast<double>(Width) * Height);
+		changedBlocks = static_cast<double>(blocks) * 100.0 * Block * Block / (static_cast<double>(Width) * Height);
+	}
+
+	void FractalLodBenchmark()
+	{
+		struct Fractal
+		{
+			std::string Name{};
+			CPU::SDFType Type{ CPU::SDFType::Sphere };
+			CPU::Float3 Parameters{ 1.0f };
+		};
+		const std::vector<Fractal> fractals = {
+			{ "Mandelbulb", CPU::SDFType::Mandelbulb, CPU::Float3(1.0f) },
+			{ "Juliabulb", CPU::SDFType::Juliabulb, CPU::Float3(0.35f, 0.25f, -0.4f) },
+			{ "Julia", CPU::SDFType::QuaternionJulia, CPU::Float3(-0.2f, 0.6f, 0.2f) },
+			{ "Sierpinski", CPU::SDFType::Sierpinski, CPU::Float3(1.0f) },
+			{ "Menger", CPU::SDFType::Menger, CPU::Float3(1.0f) },
+		};
+
+		struct View
+		{
+			std::string Name{};
+			float Distance{ 1.0f }; // Multiple of the suite's fractal camera distance
+		};
+		const std::vector<View> views = { { "Near", 1.0f }, { "Far", 4.0f } };
+
+		CPU::ThreadPool pool{};
+		CPU::RenderSettings fullSettings{};
+		fullSettings.Width = Width;
+		fullSettings.Height = Height;
+		fullSettings.FootprintScale = 0.0f;
+		CPU::RenderSettings lodSettings = fullSettings;
+		lodSettings.FootprintScale = 1.0f;
+
+		std::printf("%-18s %9s %9s %8s %11s %11s %9s %9s\n", "fractal", "full ms", "LOD ms", "speedup", "steps full", "steps LOD", "pixels", "blocks");
+		for (const Fractal& fractal : fractals)
+		{
+			CPU::Scene scene{};
+			CPU::Object object{};
+			object.SDFType = static_cast<int>(fractal.Type);
+			object.Parameters = fractal.Parameters;
+			scene.Objects.push_back(object);
+			CPU::Light light{};
+			light.Position = CPU::Float3(2.0f, 3.0f, 3.0f);
+			scene.Lights.push_back(light);
+
+			for (const View& view : views)
+			{
+				const CPU::Camera camera = CPU::CreateLookAtCamera(CPU::Float3(0.0f, 0.6f, 2.6f) * CPU::Float3(view.Distance), CPU::Float3(0.0f));
+				const Frame full = RenderFrame(pool, scene, camera, fullSettings);
+				const Frame lod = RenderFrame(pool, scene, camera, lodSettings);
+				double changedPixels = 0.0, changedBlocks = 0.0;
+				CompareColour(lod, full, changedPixels, changedBlocks);
+
+				const std::string name = fractal.Name + "/" + view.Name;
+				std::printf("%-18s %9.2f %9.2f %7.2fx %11.2f %11.2f %8.2f%% %8.2f%%\n", name.c_str(), full.Ms, lod.Ms, full.Ms / lod.Ms, full.MeanSteps,
+				            lod.MeanSteps, changedPixels, changedBlocks);
+
+				const std::string prefix = "FractalLod/" + name + "/";
+				ReportMetric(prefix + "Speedup", "x", { full.Ms / lod.Ms }, true);
+				ReportMetric(prefix + "ChangedBlocks", "%", { changedBlocks }, false);
+			}
+		}
+	}
+}
+
+REGISTER_BENCHMARK("FractalLod", FractalLodBenchmark);
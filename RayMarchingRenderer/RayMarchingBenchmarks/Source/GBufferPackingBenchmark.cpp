@@ -0,0 +1,124 @@
+#include <cstdio>
+#include <tuple>
+
+#include "Benchmark.h"
+#include "CPU/GBuffer.h"
+#include "CPU/RayMarcher.h"
+
+namespace
+{
+	// All five primitives with a spread of materials, including CSG so object indices change across silhouettes
+	CPU::Scene CreatePrimitivesScene()
+	{
+		CPU::Scene scene{};
+
+		for (int i = 0; i <= static_cast<int>(CPU::SDFType::Cylinder); ++i)
+		{
+			CPU::Object object{};
+			object.SDFType = i;
+			object.Position = CPU::Float3(-3.0f + 1.5f * static_cast<float>(i), 0.0f, 0.0f);
+			object.Rotation = CPU::Float3(0.3f * static_cast<float>(i), 0.5f, 0.0f);
+			object.Parameters = i == 2 ? CPU::Float3(0.5f, 0.2f, 0.0f) : CPU::Float3(0.5f, 0.6f, 0.6f);
+			object.Colour = CPU::Float3(0.2f * static_cast<float>(i), 0.5f, 1.0f - 0.2f * static_cast<float>(i));
+			object.Metalicness = static_cast<float>(i % 2);
+			object.Roughness = 0.25f * static_cast<float>(i);
+			scene.Objects.push_back(object);
+		}
+
+		CPU::Object cutter{};
+		cutter.Position = CPU::Float3(-3.0f, 0.5f, 0.5f);
+		cutter.Parameters = CPU::Float3(0.4f);
+		cutter.BoolOperator = 2;
+		scene.Objects.push_back(cutter);
+
+		CPU::Light light{};
+		light.Position = CPU::Float3(1.0f, 2.0f, 4.0f);
+		scene.Lights.push_back(light);
+		light.Position = CPU::Float3(-3.0f, 3.0f, 2.0f);
+		light.Colour = CPU::Float3(0.5f, 0.5f, 0.8f);
+		scene.Lights.push_back(light);
+
+		return scene;
+	}
+
+	void ValidateRoundTrip(const char* label, const CPU::GBuffer& reference, const CPU::GBufferDepthFormat depthFormat, const float maxDist)
+	{
+		CPU::CompactGBuffer packed;
+		const BenchmarkTiming pack = TimeIterations(5, [&]() { CPU::PackGBuffer(reference, depthFormat, packed); });
+
+		CPU::GBuffer unpacked;
+		const BenchmarkTiming unpack = TimeIterations(5, [&]() { CPU::UnpackGBuffer(packed, unpacked); });
+
+		double normalErrorSum = 0.0, normalErrorMax = 0.0;
+		double depthErrorMax = 0.0;
+		double colourErrorMax = 0.0;
+		double materialErrorMax = 0.0;
+		int indexMismatches = 0;
+		int hits = 0;
+		for (int y = 0; y < reference.GetHeight(); ++y)
+		{
+			for (int x = 0; x < reference.GetWidth(); ++x)
+			{
+				const CPU::Float4& refMaterial = reference.MaterialIndex.At(x, y);
+				const CPU::Float4& material = unpacked.MaterialIndex.At(x, y);
+				indexMismatches += refMaterial.z != material.z || refMaterial.w != material.w;
+				materialErrorMax = std::max({ materialErrorMax, static_cast<double>(std::abs(refMaterial.x - material.x)), static_cast<double>(std::abs(refMaterial.y - material.y)) });
+
+				const CPU::Float4& refColour = reference.Colour.At(x, y);
+				const CPU::Float4& colour = unpacked.Colour.At(x, y);
+				for (const float c : { std::abs(refColour.x - colour.x) / std::max(refColour.x, 1e-3f),
+				                       std::abs(refColour.y - colour.y) / std::max(refColour.y, 1e-3f),
+				                       std::abs(refColour.z - colour.z) / std::max(refColour.z, 1e-3f) })
+					colourErrorMax = std::max(colourErrorMax, static_cast<double>(c));
+
+				// Normal and depth are only meaningful where the primary ray hit
+				if (!refMaterial.w)
+					continue;
+				++hits;
+
+				const CPU::Float3 refNormal = reference.NormDepth.At(x, y).xyz() * CPU::Float3(2.0f) - CPU::Float3(1.0f);
+				const CPU::Float3 normal = unpacked.NormDepth.At(x, y).xyz() * CPU::Float3(2.0f) - CPU::Float3(1.0f);
+				const double angle = std::acos(std::clamp(static_cast<double>(CPU::Dot(CPU::Normalize(refNormal), CPU::Normalize(normal))), -1.0, 1.0)) * 180.0 / CPU::PI;
+				normalErrorSum += angle;
+				normalErrorMax = std::max(normalErrorMax, angle);
+
+				const double depthError = std::abs(reference.NormDepth.At(x, y).w - unpacked.NormDepth.At(x, y).w) * maxDist;
+				depthErrorMax = std::max(depthErrorMax, depthError);
+			}
+		}
+
+		std::printf("  %-20s %zu bytes  pack %6.2fms  unpack %6.2fms\n", label, packed.GetSizeInBytes(), pack.MeanMs, unpack.MeanMs);
+		std::printf("    normal error mean %.5f max %.5f deg | depth error max %.5f units | colour rel error max %.5f | metal/rough error max %.4f | index mismatches %d (%d hits)\n",
+		            normalErrorSum / std::max(hits, 1), normalErrorMax, depthErrorMax, colourErrorMax, materialErrorMax, indexMismatches, hits);
+	}
+
+	void RunScene(const char* label, const CPU::Scene& scene, const CPU::Camera& camera)
+	{
+		CPU::RenderSettings settings{};
+		settings.Width = 480;
+		settings.Height = 270;
+
+		CPU::GBuffer reference;
+		const BenchmarkTiming render = TimeIterations(1, [&]() { CPU::RenderGBuffer(scene, camera, settings, reference); });
+
+		std::printf("%s %dx%d, reference render %.1fms\n", label, settings.Width, settings.Height, render.MeanMs);
+		ValidateRoundTrip("compact (32-bit depth)", reference, CPU::GBufferDepthFormat::Float32, settings.MaxDist);
+		ValidateRoundTrip("compact (16-bit depth)", reference, CPU::GBufferDepthFormat::Unorm16, settings.MaxDist);
+	}
+
+	void GBufferPackingBenchmark()
+	{
+		for (const auto& [label, width, height] : { std::tuple{ "1080p", 1920, 1080 }, std::tuple{ "4K", 3840, 2160 } })
+		{
+			std::printf("Budget at %s\n", label);
+			std::printf("Legacy layout:\n%s", CPU::FormatGBufferBudget(CPU::GetLegacyGBufferLayout(), width, height).c_str());
+			std::printf("Compact layout (32-bit depth):\n%s", CPU::FormatGBufferBudget(CPU::GetCompactGBufferLayout(CPU::GBufferDepthFormat::Float32), width, height).c_str());
+			std::printf("Compact layout (16-bit depth):\n%s\n", CPU::FormatGBufferBudget(CPU::GetCompactGBufferLayout(CPU::GBufferDepthFormat::Unorm16), width, height).c_str());
+		}
+
+		RunScene("Default scene", CPU::CreateDefaultScene(), CPU::Camera{});
+		RunScene("Primitives scene", CreatePrimitivesScene(), CPU::CreateLookAtCamera(CPU::Float3(0.0f, 1.5f, 6.0f), CPU::Float3(0.0f)));
+	}
+}
+
+REGISTER_BENCHMARK("GBufferPacking", GBufferPackingBenchmark);
@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Benchmark.h"
+#include "BenchmarkScenes.h"
+#include "CPU/ObjectCulling.h"
+#include "CPU/RayMarcher.h"
+#include "CPU/SignedDistance.h"
+#include "CPU/ThreadPool.h"
+#include "CPU/TransformHierarchy.h"
+
+// Cached world transforms. A hundred thousand nodes, eight children each,
+// have a fraction of them moved per frame, picked at random so most are
+// leaves, and Update recomputes only the subtrees under them, then refits the
+// ancestors' bounds once each. The cost per recomputed node stays flat, so a
+// frame costs what moved, where moving the root costs a full recompute. Every
+// update is checked against a hierarchy built from scratch with the same local
+// transforms.
+//
+// Then a scene of clustered objects, each cluster a node over its objects, is
+// rendered with every object evaluated each step, with the clusters' group
+// bounds skipping whole clusters further than the distance so far, and with
+// per tile lists (see TileCullingBenchmark). Skipping never changes a
+// distance, so the group render matches the full one.
+namespace
+{
+	constexpr int NodeCount = 100000;
+	constexpr int Fanout = 8;
+	constexpr int Width = 128;
+	constexpr int Height = 72;
+	constexpr int ClusterSide = 6;
+	constexpr int ClusterSize = 8;
+
+	CPU::Transform RandomLocal(std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		CPU::Transform local{};
+		local.Position = CPU::Float3(unit(rng), unit(rng), unit(rng)) * CPU::Float3(2.0f);
+		local.Rotation = CPU::Float3(unit(rng), unit(rng), unit(rng)) * CPU::Float3(3.0f);
+		local.Scale = 0.9f + 0.1f * unit(rng);
+		return local;
+	}
+
+	CPU::TransformHierarchy CreateTree(std::mt19937& rng)
+	{
+		CPU::TransformHierarchy hierarchy{};
+		for (int i = 0; i < NodeCount; ++i)
+			hierarchy.AddNode(i == 0 ? CPU::TransformHierarchy::NoParent : (i - 1) / Fanout, RandomLocal(rng), 0.5f);
+		hierarchy.Update();
+		return hierarchy;
+	}
+
+	// Largest difference from a hierarchy built and updated in one go
+	float GetLargestError(const CPU::TransformHierarchy& hierarchy)
+	{
+		CPU::TransformHierarchy reference{};
+		for (int i = 0; i < static_cast<int>(hierarchy.GetNodeCount()); ++i)
+			reference.AddNode(hierarchy.GetParent(i), hierarchy.GetLocal(i), 0.5f);
+		reference.Update();
+
+		float error = 0.0f;
+		for (int i = 0; i < static_cast<int>(hierarchy.GetNodeCount()); ++i)
+		{
+			error = std::max(error, CPU::Distance(hierarchy.GetWorld(i).Position, reference.GetWorld(i).Position));
+			error = std::max(error, std::abs(hierarchy.GetGroupBound(i).Radius - reference.GetGroupBound(i).Radius));
+		}
+		return error;
+	}
+
+	void BenchmarkUpdates()
+	{
+		std::mt19937 rng(5u);
+		CPU::TransformHierarchy hierarchy = CreateTree(rng);
+
+		std::printf("%-8s %9s %11s %9s %10s %12s %9s\n", "moved", "nodes", "recomputed", "refit", "update ms", "ns per node", "error");
+		for (const double fraction : { 0.001, 0.01, 0.1, -1.0 })
+		{
+			const bool root = fraction < 0.0;
+			const int moved = root ? 1 : static_cast<int>(NodeCount * fraction);
+			std::uniform_int_distribution<int> pick(0, NodeCount - 1);
+
+			const double ms = TimeIterations(5, [&]()
+			{
+				for (int i = 0; i < moved; ++i)
+				{
+					const int node = root ? 0 : pick(rng);
+					hierarchy.SetLocal(node, RandomLocal(rng));
+				}
+				hierarchy.Update();
+			}).MinMs;
+
+			const size_t recomputed = hierarchy.GetUpdatedNodeCount();
+			const double nsPerNode = ms * 1e6 / static_cast<double>(std::max<size_t>(recomputed, 1u));
+			const float error = GetLargestError(hierarchy);
+
+			char name[16]{};
+			std::snprintf(name, sizeof(name), root ? "root" : "%.1f%%", fraction * 100.0);
+			std::printf("%-8s %9d %11zu %9zu %10.3f %12.1f %9.2g\n", name, moved, recomputed, hierarchy.GetRefitNodeCount(), ms, nsPerNode, error);
+
+			const std::string prefix = "Hierarchy/" + std::string(root ? "Root" : name) + "/";
+			ReportMetric(prefix + "UpdateMs", "ms", { ms }, false);
+			ReportMetric(prefix + "NsPerNode", "ns", { nsPerNode }, false);
+		}
+	}
+
+	// Clusters of primitives on a grid over a ground box, each cluster a node under one root, each object a node
+	// under its cluster
+	CPU::Scene CreateClusterScene(CPU::TransformHierarchy& hierarchy, std::vector<int>& objectNodes)
+	{
+		CPU::Scene scene{};
+		CPU::Object ground{};
+		ground.SDFType = static_cast<int>(CPU::SDFType::Box);
+		ground.Position = CPU::Float3(0.0f, -0.5f, 0.0f);
+		ground.Parameters = CPU::Float3(30.0f, 0.5f, 30.0f);
+		scene.Objects.push_back(ground);
+
+		const int root = hierarchy.AddNode(CPU::TransformHierarchy::NoParent, {});
+		objectNodes.push_back(hierarchy.AddNode(root, { ground.Position, ground.Rotation, 1.0f },
+		                                        CPU::GetSDFBoundingRadius(ground.SDFType, ground.Parameters)));
+
+		std::mt19937 rng(17u);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		for (int cz = 0; cz < ClusterSide; ++cz)
+		{
+			for (int cx = 0; cx < ClusterSide; ++cx)
+			{
+				CPU::Transform clusterLocal{};
+				clusterLocal.Position = CPU::Float3((static_cast<float>(cx) - 2.5f) * 4.0f, 1.0f, (static_cast<float>(cz) - 4.5f) * 4.0f);
+				clusterLocal.Rotation = CPU::Float3(0.0f, unit(rng) * 6.283f, 0.0f);
+				const int cluster = hierarchy.AddNode(root, clusterLocal);
+
+				// Placed about the cluster's origin, so each object's transform is its local one
+				const std::vector<CPU::Object> objects =
+					CreatePrimitiveField(ClusterSize, rng(), { CPU::Float3(-1.0f, 0.0f, -1.0f), CPU::Float3(2.0f, 1.5f, 2.0f), 0.2f, 0.2f });
+				for (const CPU::Object& object : objects)
+				{
+					const CPU::Transform local{ object.Position, object.Rotation, object.Scale.x };
+					objectNodes.push_back(hierarchy.AddNode(cluster, local, CPU::GetSDFBoundingRadius(object.SDFType, object.Parameters)));
+					scene.Objects.push_back(object);
+				}
+			}
+		}
+		hierarchy.Update();
+		CPU::ApplyWorldTransforms(hierarchy, objectNodes, scene.Objects);
+
+		CPU::Light light{};
+		light.Position = CPU::Float3(8.0f, 12.0f, 10.0f);
+		scene.Lights.push_back(light);
+		return scene;
+	}
+
+	void BenchmarkGroups()
+	{
+		CPU::TransformHierarchy hierarchy{};
+		std::vector<int> objectNodes{};
+		CPU::Scene scene = CreateClusterScene(hierarchy, objectNodes);
+		CPU::Scene grouped = scene;
+		const double groupMs = TimeIterations(3, [&]() { CPU::BuildObjectGroups(hierarchy, objectNodes, grouped); }).MinMs;
+
+		CPU::ThreadPool pool{};
+		const CPU::Camera camera = CPU::CreateLookAtCamera(CPU::Float3(0.0f, 8.0f, 14.0f), CPU::Float3(0.0f, 1.0f, -6.0f));
+		CPU::RenderSettings settings{};
+		settings.Width = Width;
+		settings.Height = Height;
+		const float pixelAngle = 2.0f * CPU::CalculatePixelConeAngle(camera, settings);
+
+		CPU::ObjectCulling culling{};
+		const double buildMs = TimeIterations(3, [&]() { culling = CPU::BuildObjectCulling(scene, camera, settings); }).MinMs;
+		const GBufferFrame full = RenderGBufferFrame(pool, scene, settings, camera);
+		const GBufferFrame groups = RenderGBufferFrame(pool, grouped, settings, camera);
+		const GBufferFrame tiled = RenderGBufferFrame(pool, scene, settings, camera, &culling);
+
+		std::printf("\n%zu objects in %zu groups, built in %.3f ms\n", scene.Objects.size(), grouped.Groups.size(), groupMs);
+		std::printf("%-8s %9s %9s %9s %9s\n", "render", "ms", "speedup", "steps", "differ");
+		const auto print = [&](const char* name, const GBufferFrame& frame, const double extraMs)
+		{
+			const double ms = frame.Ms + extraMs;
+			const double different = CountDifferentHitPercent(frame.Output, full.Output, pixelAngle);
+			std::printf("%-8s %9.2f %8.2fx %9.2f %8.2f%%\n", name, ms, full.Ms / ms, frame.MeanSteps, different);
+			return std::pair(full.Ms / ms, different);
+		};
+		print("full", full, 0.0);
+		const auto [groupSpeedup, groupDifferent] = print("groups", groups, groupMs);
+		const auto [tiledSpeedup, tiledDifferent] = print("tiled", tiled, buildMs);
+
+		ReportMetric("Hierarchy/Groups/Speedup", "x", { groupSpeedup }, true);
+		ReportMetric("Hierarchy/Groups/DifferentPixels", "%", { groupDifferent }, false);
+		ReportMetric("Hierarchy/Tiled/Speedup", "x", { tiledSpeedup }, true);
+	}
+
+	void HierarchyBenchmark()
+	{
+		BenchmarkUpdates();
+		BenchmarkGroups();
+	}
+}
+
+REGISTER_BENCHMARK("Hierarchy", HierarchyBenchmark);
@@ -0,0 +1,100 @@
+//
+// Main.cpp
+// Headless benchmark runner.
+// Usage: RayMarchingBenchmarks [name filter] [--json <results.json>] [--baseline <baseline.json>] [--tolerance <fraction>] [--runs <n>]
+// --runs repeats the matched benchmarks and keeps each metric's best run, for timings on a busy or single core machine.
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Benchmark.h"
+#include "BenchmarkReport.h"
+
+int main(int argc, char* argv[])
+{
+	std::string filter{};
+	std::string jsonPath{};
+	std::string baselinePath{};
+	double tolerance = 0.05;
+	int runs = 1;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		if ((arg == "--json" || arg == "--baseline" || arg == "--tolerance" || arg == "--runs") && i + 1 < argc)
+		{
+			const std::string value = argv[++i];
+			if (arg == "--json")
+				jsonPath = value;
+			else if (arg == "--baseline")
+				baselinePath = value;
+			else if (arg == "--tolerance")
+				tolerance = std::stod(value);
+			else
+				runs = std::max(1, std::stoi(value));
+		}
+		else
+		{
+			filter = arg;
+		}
+	}
+
+	int run = 0;
+	for (int repeat = 0; repeat < runs; ++repeat)
+	{
+		for (const auto& benchmark : GetBenchmarks())
+		{
+			if (!filter.empty() && benchmark.Name.find(filter) == std::string::npos)
+				continue;
+
+			if (runs > 1)
+				std::printf("== %s (run %d of %d) ==\n", benchmark.Name.c_str(), repeat + 1, runs);
+			else
+				std::printf("== %s ==\n", benchmark.Name.c_str());
+			benchmark.Run();
+			std::printf("\n");
+			++run;
+		}
+	}
+
+	if (run == 0)
+	{
+		std::printf("No benchmarks matched \"%s\"\n", filter.c_str());
+		return 1;
+	}
+
+	try
+	{
+		const std::vector<BenchmarkMetric> metrics = runs > 1 ? SelectBestRuns(GetReportedMetrics()) : GetReportedMetrics();
+		if (!jsonPath.empty())
+		{
+			WriteBenchmarkJson(jsonPath, metrics, {
+				{ "filter", filter },
+				{ "hardware_threads", std::to_string(std::thread::hardware_concurrency()) },
+				{ "runs", std::to_string(runs) },
+			});
+			std::printf("Wrote %zu metrics to %s\n", metrics.size(), jsonPath.c_str());
+		}
+
+		if (!baselinePath.empty())
+		{
+			std::printf("\nComparing against %s (tolerance %.1f%%)\n", baselinePath.c_str(), tolerance * 100.0);
+			const BenchmarkComparison comparison = CompareBenchmarks(ReadBenchmarkJson(baselinePath), metrics, tolerance);
+			std::printf("%d regressions, %d improvements, %d not run\n", comparison.Regressions, comparison.Improvements, comparison.Missing);
+			if (comparison.Regressions > 0)
+				return 2;
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::fprintf(stderr, "Error: %s\n", e.what());
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,54 @@
+#include <cstdio>
+#include <string>
+
+#include "Benchmark.h"
+#include "CPU/Metrics.h"
+
+// Cost of recording metrics on the frame path, and of formatting the registry
+// for a scrape. Uses a registry of its own so the process-wide one is untouched.
+namespace
+{
+	constexpr int RecordCount = 1 << 20;
+	constexpr int FillerCount = 24;
+
+	void MetricsBenchmark()
+	{
+		CPU::Metrics metrics{};
+		const CPU::MetricId counter = metrics.AddCounter("benchmark_frames_total", "Frames");
+		const CPU::MetricId gauge = metrics.AddGauge("benchmark_objects", "Objects");
+		const CPU::MetricId summary = metrics.AddSummary("benchmark_frame_seconds", "Frame time");
+		for (int i = 0; i < FillerCount; ++i)
+			metrics.AddGauge("benchmark_gauge_" + std::to_string(i), "Filler to bring the registry to a realistic size");
+
+		const auto timePerRecord = [](const BenchmarkTiming& timing) { return timing.MinMs * 1e6 / RecordCount; };
+		const double addNs = timePerRecord(TimeIterations(5, [&]()
+		{
+			for (int i = 0; i < RecordCount; ++i)
+				metrics.Add(counter);
+		}));
+		const double setNs = timePerRecord(TimeIterations(5, [&]()
+		{
+			for (int i = 0; i < RecordCount; ++i)
+				metrics.Set(gauge, static_cast<double>(i));
+		}));
+		const double observeNs = timePerRecord(TimeIterations(5, [&]()
+		{
+			for (int i = 0; i < RecordCount; ++i)
+				metrics.Observe(summary, static_cast<double>(i & 1023) * 1e-4);
+		}));
+		std::printf("record: add %.2fns, set %.2fns, observe %.2fns\n", addNs, setNs, observeNs);
+
+		std::string text{};
+		const BenchmarkTiming write = TimeIterations(20, [&]()
+		{
+			text.clear();
+			metrics.Write(text);
+		});
+		std::printf("write %d metrics: %.3fms (%zu bytes)\n", 3 + FillerCount, write.MinMs, text.size());
+
+		ReportMetric("Metrics/Observe", "ns", { observeNs }, false);
+		ReportMetric("Metrics/Write", "ms", { write.MinMs }, false);
+	}
+}
+
+REGISTER_BENCHMARK("Metrics", MetricsBenchmark);
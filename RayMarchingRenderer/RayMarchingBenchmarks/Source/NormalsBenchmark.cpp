@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "CPU/RayMarcher.h"
+#include "CPU/SignedDistance.h"
+#include "CPU/SnippetPorts.h"
+
+// CalculateNormal, one scene evaluation plus the nearest object's gradient,
+// against the six tap central differences of the scene at a fixed 0.005
+// offset it replaced. Both run on the hit points of 128x72 primary rays and
+// are measured against a reference. The primitives' gradients are exact, so
+// they are their own reference and only the scene taps have an error; the
+// thin plates are narrower than those taps. The fractal and the snippet have
+// no exact gradient and take taps on their own object, and their reference is
+// central differences of a double precision port at a 1e-7 offset. Four
+// tetrahedral taps were tried there, and were 6.1 degrees out on average on
+// the mandelbulb and 9.2 on the snippet, against 1.3 and 7.5 for the six.
+namespace
+{
+	constexpr int Width = 128;
+	constexpr int Height = 72;
+	constexpr float CentralOffset = 0.005f;
+	constexpr double ReferenceOffset = 1e-7;
+
+	using ReferenceDistance = double (*)(double x, double y, double z);
+
+	struct NormalsScene
+	{
+		std::string Name{};
+		CPU::Scene Scene{};
+		CPU::Camera Camera{};
+		// The single object's distance in double precision, or nullptr when its gradient is exact
+		ReferenceDistance Reference{ nullptr };
+	};
+
+	struct HitPoint
+	{
+		CPU::Float3 Position{};
+		float Offset{ 0.0f };
+	};
+
+	CPU::Object CreateObject(CPU::SDFType type, int boolOperator, const CPU::Float3& position, const CPU::Float3& parameters)
+	{
+		CPU::Object object{};
+		object.SDFType = static_cast<int>(type);
+		object.BoolOperator = boolOperator;
+		object.Position = position;
+		object.Parameters = parameters;
+		return object;
+	}
+
+	// The Suite's CSG scene
+	CPU::Scene CreateCSGScene()
+	{
+		CPU::Scene scene{};
+		scene.Objects.push_back(CreateObject(CPU::SDFType::Box, 0, CPU::Float3(0.0f), CPU::Float3(1.0f)));
+		scene.Objects.push_back(CreateObject(CPU::SDFType::Sphere, 1, CPU::Float3(0.0f), CPU::Float3(1.35f)));
+		scene.Objects.push_back(CreateObject(CPU::SDFType::Cylinder, 2, CPU::Float3(0.0f), CPU::Float3(0.5f, 2.0f, 0.0f)));
+		scene.Objects.push_back(CreateObject(CPU::SDFType::Torus, 0, CPU::Float3(0.0f), CPU::Float3(1.7f, 0.15f, 0.0f)));
+		scene.Objects.push_back(CreateObject(CPU::SDFType::Cone, 0, CPU::Float3(2.8f, 0.8f, 0.0f), CPU::Float3(1.0f, 2.0f, 1.5f)));
+		return scene;
+	}
+
+	// Randomly placed and rotated primitives of every type
+	CPU::Scene CreatePrimitivesScene(const int count)
+	{
+		CPU::Scene scene{};
+		std::mt19937 rng(3u);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		for (int i = 0; i < count; ++i)
+		{
+			CPU::Object object = CreateObject(static_cast<CPU::SDFType>(i % 5), 0,
+			                                  CPU::Float3(unit(rng) * 12.0f - 6.0f, unit(rng) * 6.0f - 3.0f, unit(rng) * 12.0f - 12.0f),
+			                                  CPU::Float3(0.3f + unit(rng) * 0.5f, 0.3f + unit(rng) * 0.5f, 0.3f + unit(rng) * 0.5f));
+			object.Rotation = CPU::Float3(unit(rng) * 6.283f, unit(rng) * 6.283f, unit(rng) * 6.283f);
+			scene.Objects.push_back(object);
+		}
+		return scene;
+	}
+
+	// Fanned boxes 4 thousandths thick, thinner than the central differences' taps are apart
+	CPU::Scene CreateThinPlatesScene()
+	{
+		CPU::Scene scene{};
+		for (int i = 0; i < 8; ++i)
+		{
+			CPU::Object plate = CreateObject(CPU::SDFType::Box, 0, CPU::Float3(static_cast<float>(i - 4) * 0.6f + 0.3f, 0.0f, 0.0f),
+			                                 CPU::Float3(0.25f, 1.0f, 0.002f));
+			plate.Rotation = CPU::Float3(0.0f, 0.3f + 0.1f * static_cast<float>(i), 0.0f);
+			scene.Objects.push_back(plate);
+		}
+		return scene;
+	}
+
+	CPU::Scene CreateSingleObjectScene(CPU::SDFType type, const CPU::Float3& parameters)
+	{
+		CPU::Scene scene{};
+		scene.Objects.push_back(CreateObject(type, 0, CPU::Float3(0.0f), parameters));
+		return scene;
+	}
+
+	// CPU::SdfMandelbulb's power 8 polynomial form without the footprint or FastLog
+	double MandelbulbReference(const double px, const double py, const double pz)
+	{
+		double wx = px, wy = py, wz = pz;
+		double m = wx * wx + wy * wy + wz * wz;
+		double dz = 1.0;
+		for (int i = 0; i < 4; ++i)
+		{
+			const double x2 = wx * wx, x4 = x2 * x2;
+			const double y2 = wy * wy, y4 = y2 * y2;
+			const double z2 = wz * wz, z4 = z2 * z2;
+			const double k3 = x2 + z2;
+			const double k2 = 1.0 / std::sqrt(k3 * k3 * k3 * k3 * k3 * k3 * k3);
+			const double k1 = x4 + y4 + z4 - 6.0 * y2 * z2 - 6.0 * x2 * y2 + 2.0 * z2 * x2;
+			const double k4 = x2 - y2 + z2;
+
+			dz = 8.0 * m * m * m * std::sqrt(m) * dz + 1.0;
+			const double nx = 64.0 * wx * wy * wz * (x2 - z2) * k4 * (x4 - 6.0 * x2 * z2 + z4) * k1 * k2;
+			const double ny = -16.0 * y2 * k3 * k4 * k4 + k1 * k1;
+			const double nz = -8.0 * wy * k4 * (x4 * x4 - 28.0 * x4 * x2 * z2 + 70.0 * x4 * z4 - 28.0 * x2 * z2 * z4 + z4 * z4) * k1 * k2;
+			wx = nx + px;
+			wy = ny + py;
+			wz = nz + pz;
+
+			m = wx * wx + wy * wy + wz * wz;
+			if (m > 256.0)
+				break;
+		}
+		return 0.25 * std::log(m) * std::sqrt(m) / dz;
+	}
+
+	// CPU::SdfJuliaSnippet with the scene's param
+	double JuliaSnippetReference(const double px, const double py, const double pz)
+	{
+		constexpr double cx = -0.2, cy = 0.6, cz = 0.2;
+		double zx = px, zy = py, zz = pz, zw = 0.0;
+		double md2 = 1.0;
+		double mz2 = zx * zx + zy * zy + zz * zz;
+		for (int i = 0; i < 11; ++i)
+		{
+			md2 *= 4.0 * mz2;
+			const double nx = zx * zx - zy * zy - zz * zz - zw * zw + cx;
+			const double ny = 2.0 * zx * zy + cy;
+			const double nz = 2.0 * zx * zz + cz;
+			const double nw = 2.0 * zx * zw;
+			zx = nx;
+			zy = ny;
+			zz = nz;
+			zw = nw;
+
+			mz2 = zx * zx + zy * zy + zz * zz + zw * zw;
+			if (mz2 > 4.0)
+				break;
+		}
+		return 0.25 * std::sqrt(mz2 / md2) * std::log(mz2);
+	}
+
+	CPU::Float3 CalculateReferenceNormal(const ReferenceDistance d, const CPU::Float3& p)
+	{
+		const double h = ReferenceOffset;
+		const double x = p.x, y = p.y, z = p.z;
+		const double gx = d(x + h, y, z) - d(x - h, y, z);
+		const double gy = d(x, y + h, z) - d(x, y - h, z);
+		const double gz = d(x, y, z + h) - d(x, y, z - h);
+		const double length = std::sqrt(gx * gx + gy * gy + gz * gz);
+		return CPU::Float3(static_cast<float>(gx / length), static_cast<float>(gy / length), static_cast<float>(gz / length));
+	}
+
+	double GetAngle(const CPU::Float3& a, const CPU::Float3& b)
+	{
+		return std::acos(std::clamp(static_cast<double>(CPU::Dot(a, b)), -1.0, 1.0)) * 57.29577951308232;
+	}
+
+	struct AngleError
+	{
+		double Mean{ 0.0 };
+		double WidePercent{ 0.0 }; // More than 5 degrees out
+	};
+
+	AngleError GetAngleError(const std::vector<CPU::Float3>& normals, const std::vector<CPU::Float3>& reference)
+	{
+		AngleError error{};
+		for (size_t i = 0; i < normals.size(); ++i)
+		{
+			const double angle = GetAngle(normals[i], reference[i]);
+			error.Mean += angle;
+			error.WidePercent += angle > 5.0 ? 1.0 : 0.0;
+		}
+		error.Mean /= static_cast<double>(normals.size());
+		error.WidePercent *= 100.0 / static_cast<double>(normals.size());
+		return error;
+	}
+
+	CPU::Float3 CalculateCentralNormal(const CPU::Scene& scene, const CPU::Float3& p, const float maxDist)
+	{
+		const auto d = [&](const CPU::Float3& o) { return CPU::GetDistanceToScene(scene, p + o, maxDist).Distance; };
+		return CPU::Normalize(CPU::Float3(d(CPU::Float3(CentralOffset, 0.0f, 0.0f)) - d(CPU::Float3(-CentralOffset, 0.0f, 0.0f)),
+		                                  d(CPU::Float3(0.0f, CentralOffset, 0.0f)) - d(CPU::Float3(0.0f, -CentralOffset, 0.0f)),
+		                                  d(CPU::Float3(0.0f, 0.0f, CentralOffset)) - d(CPU::Float3(0.0f, 0.0f, -CentralOffset))));
+	}
+
+	std::vector<HitPoint> FindHitPoints(const NormalsScene& normalsScene, const CPU::RenderSettings& settings)
+	{
+		const CPU::RayCone cone{ CPU::CalculatePixelConeAngle(normalsScene.Camera, settings) };
+		std::vector<HitPoint> hits{};
+		for (int y = 0; y < Height; ++y)
+		{
+			for (int x = 0; x < Width; ++x)
+			{
+				const CPU::Float2 texCoord((static_cast<float>(x) + 0.5f) / Width, (static_cast<float>(y) + 0.5f) / Height);
+				const CPU::Ray ray = CPU::RayMarch(normalsScene.Scene, settings, normalsScene.Camera.Position,
+				                                   CPU::CalculateRayDirection(normalsScene.Camera, settings, texCoord), cone);
+				if (ray.Hit)
+					hits.push_back({ ray.HitPosition, 0.5f * CPU::GetIntersectionThreshold(settings, settings.ConeThresholdScale, cone, ray.Depth) });
+			}
+		}
+		return hits;
+	}
+
+	void NormalsBenchmark()
+	{
+		std::vector<NormalsScene> scenes{};
+		scenes.push_back({ "CSG", CreateCSGScene(), CPU::CreateLookAtCamera(CPU::Float3(1.5f, 2.5f, 6.0f), CPU::Float3(0.5f, 0.0f, 0.0f)) });
+		scenes.push_back({ "Primitives100", CreatePrimitivesScene(100), CPU::CreateLookAtCamera(CPU::Float3(0.0f, 3.0f, 8.0f), CPU::Float3(0.0f, 0.0f, -6.0f)) });
+		scenes.push_back({ "ThinPlates", CreateThinPlatesScene(), CPU::CreateLookAtCamera(CPU::Float3(0.5f, 1.0f, 4.0f), CPU::Float3(0.0f)) });
+		scenes.push_back({ "Mandelbulb", CreateSingleObjectScene(CPU::SDFType::Mandelbulb, CPU::Float3(1.0f)),
+		                   CPU::CreateLookAtCamera(CPU::Float3(0.0f, 0.6f, 2.6f), CPU::Float3(0.0f)), MandelbulbReference });
+		NormalsScene snippet{ "JuliaSnippet", CreateSingleObjectScene(CPU::SDFType::Sphere, CPU::Float3(-0.2f, 0.6f, 0.2f)),
+		                      CPU::CreateLookAtCamera(CPU::Float3(0.0f, 0.6f, 2.6f), CPU::Float3(0.0f)), JuliaSnippetReference };
+		snippet.Scene.SDFLibrary.push_back(CPU::SdfJuliaSnippet);
+		scenes.push_back(snippet);
+
+		CPU::RenderSettings settings{};
+		settings.Width = Width;
+		settings.Height = Height;
+
+		std::printf("%-14s %6s %9s %9s %9s %11s %9s %11s %9s\n", "scene", "hits", "6-tap us", "new us", "speedup", "6-tap deg", "> 5 deg",
+		            "new deg", "> 5 deg");
+		for (const NormalsScene& normalsScene : scenes)
+		{
+			const std::vector<HitPoint> hits = FindHitPoints(normalsScene, settings);
+			if (hits.empty())
+				continue;
+
+			std::vector<CPU::Float3> central(hits.size()), exact(hits.size());
+			const double centralMs = TimeIterations(5, [&]()
+			{
+				for (size_t i = 0; i < hits.size(); ++i)
+					central[i] = CalculateCentralNormal(normalsScene.Scene, hits[i].Position, settings.MaxDist);
+			}).MinMs;
+			const double exactMs = TimeIterations(5, [&]()
+			{
+				for (size_t i = 0; i < hits.size(); ++i)
+					exact[i] = CPU::CalculateNormal(normalsScene.Scene, hits[i].Position, settings.MaxDist, 0.0f, hits[i].Offset);
+			}).MinMs;
+
+			std::vector<CPU::Float3> reference = exact;
+			if (normalsScene.Reference)
+				for (size_t i = 0; i < hits.size(); ++i)
+					reference[i] = CalculateReferenceNormal(normalsScene.Reference, hits[i].Position);
+			const AngleError centralError = GetAngleError(central, reference);
+			const AngleError exactError = GetAngleError(exact, reference);
+
+			const double perHit = 1000.0 / static_cast<double>(hits.size());
+			std::printf("%-14s %6zu %9.3f %9.3f %8.2fx %11.3f %8.2f%% %11.3f %8.2f%%\n", normalsScene.Name.c_str(), hits.size(), centralMs * perHit,
+			            exactMs * perHit, centralMs / exactMs, centralError.Mean, centralError.WidePercent, exactError.Mean, exactError.WidePercent);
+
+			const std::string prefix = "Normals/" + normalsScene.Name + "/";
+			ReportMetric(prefix + "Speedup", "x", { centralMs / exactMs }, true);
+			ReportMetric(prefix + "ErrorDegrees", "deg", { exactError.Mean }, false);
+		}
+	}
+}
+
+REGISTER_BENCHMARK("Normals", NormalsBenchmark);
@@ -0,0 +1,325 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Benchmark.h"
+#include "CPU/ObjectPool.h"
+
+// Scene churn the way the editor's GameObjects see it: a thousand objects, a
+// transform and two or three other components each, with a twentieth of them
+// removed and as many added every frame, then every component updated. Three
+// layouts are run through the same frames. The first is the one GameObject
+// had: each object and component from new, components in shared_ptrs in an
+// unordered_map of vectors, and removal dropping the pointer as the scene
+// view's remove button did, so removed objects leak. The second is the same
+// with removal deleting the object. The third is GameObject's now: objects and
+// components in per type CPU::ObjectPools, components in one vector per object
+// in the order added, filled by a first run so the second is measured with
+// the pools warm, as a scene loaded after another is. Global new and delete
+// are counted for the allocations per frame and what is still allocated once
+// the scene is torn down. Handles to removed objects are kept, and none may
+// resolve once their slots are reused.
+namespace
+{
+	std::atomic<size_t> Allocations{ 0u };
+	std::atomic<size_t> Deallocations{ 0u };
+}
+
+void* operator new(const size_t size)
+{
+	Allocations.fetch_add(1u, std::memory_order_relaxed);
+	if (void* memory = std::malloc(size ? size : 1u))
+		return memory;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+	if (!memory)
+		return;
+	Deallocations.fetch_add(1u, std::memory_order_relaxed);
+	std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	operator delete(memory);
+}
+
+namespace
+{
+	constexpr int ObjectCount = 1000;
+	constexpr int FrameCount = 500;
+	constexpr int ChurnPerFrame = ObjectCount / 20;
+
+	// Stand-ins for the editor's components, at roughly their sizes
+	struct Component
+	{
+		virtual ~Component() = default;
+		virtual float Update(float deltaTime) = 0;
+	};
+
+	struct Transform final : Component
+	{
+		float Position[3]{};
+		float Rotation[3]{};
+		float Scale[3]{ 1.0f, 1.0f, 1.0f };
+		float World[16]{};
+		float Update(const float deltaTime) override { Position[1] += deltaTime; return Position[1]; }
+	};
+
+	struct Marched final : Component
+	{
+		float Parameters[3]{ 1.0f, 1.0f, 1.0f };
+		int Type{ 0 };
+		int Operator{ 0 };
+		float BlendRadius{ 0.25f };
+		float Repetition[10]{};
+		float Update(const float deltaTime) override { Parameters[0] += deltaTime; return Parameters[0]; }
+	};
+
+	struct Material final : Component
+	{
+		float Colour[3]{ 1.0f, 1.0f, 1.0f };
+		float Metalicness{ 0.0f };
+		float Roughness{ 0.5f };
+		float Update(const float deltaTime) override { return Roughness + deltaTime; }
+	};
+
+	struct Light final : Component
+	{
+		float Colour[3]{ 1.0f, 1.0f, 1.0f };
+		float Attenuation[4]{};
+		float Update(const float deltaTime) override { return Colour[0] + deltaTime; }
+	};
+
+	// Before: every object and component its own allocation, components shared and mapped by type
+	struct MappedObject
+	{
+		std::string Name{};
+		std::unordered_map<std::type_index, std::vector<std::shared_ptr<Component>>> Components{};
+
+		template <typename T>
+		void Add() { Components[std::type_index(typeid(T))].push_back(std::shared_ptr<Component>(new T())); }
+	};
+
+	// Now: pooled objects owning pooled components through a deleter that returns them
+	template <typename T>
+	CPU::ObjectPool<T>& GetPool()
+	{
+		static CPU::ObjectPool<T> pool{};
+		return pool;
+	}
+
+	struct PooledObject
+	{
+		using ComponentPtr = std::unique_ptr<Component, void (*)(Component*)>;
+
+		std::string Name{};
+		std::vector<std::pair<std::type_index, ComponentPtr>> Components{};
+
+		explicit PooledObject(std::string name) : Name(std::move(name)) { Components.reserve(4); }
+		~PooledObject()
+		{
+			while (!Components.empty())
+				Components.pop_back();
+		}
+
+		template <typename T>
+		void Add()
+		{
+			Components.emplace_back(std::type_index(typeid(T)), ComponentPtr(GetPool<T>().Create(), [](Component* owned)
+			{
+				GetPool<T>().Destroy(static_cast<T*>(owned));
+			}));
+		}
+	};
+
+	enum class Layout
+	{
+		Leaking,
+		Deleting,
+		Pooled
+	};
+
+	struct ChurnResult
+	{
+		double ChurnMs{ 0.0 };
+		double UpdateMs{ 0.0 };
+		double AllocationsPerFrame{ 0.0 };
+		size_t Outstanding{ 0u };
+		size_t StaleResolved{ 0u };
+		size_t LiveMissed{ 0u };
+		size_t Chunks{ 0u };
+	};
+
+	// Every object a transform, then a marched object and material, or a light
+	template <typename Object>
+	void AddComponents(Object& object, const int kind)
+	{
+		object.template Add<Transform>();
+		if (kind % 8 == 0)
+		{
+			object.template Add<Light>();
+			return;
+		}
+		object.template Add<Marched>();
+		object.template Add<Material>();
+	}
+
+	template <typename Object>
+	float UpdateAll(const std::vector<Object*>& objects)
+	{
+		float sum = 0.0f;
+		for (const Object* object : objects)
+		{
+			if constexpr (std::is_same_v<Object, MappedObject>)
+			{
+				for (const auto& [type, components] : object->Components)
+					for (const auto& component : components)
+						sum += component->Update(1e-3f);
+			}
+			else
+			{
+				for (const auto& [type, component] : object->Components)
+					sum += component->Update(1e-3f);
+			}
+		}
+		return sum;
+	}
+
+	template <typename Object>
+	ChurnResult RunChurn(const Layout layout)
+	{
+		using Clock = std::chrono::steady_clock;
+
+		const size_t allocationsBefore = Allocations.load();
+		const size_t deallocationsBefore = Deallocations.load();
+		ChurnResult result{};
+		{
+			std::mt19937 rng(3u);
+			std::vector<Object*> objects{};
+			std::vector<Object*> leaked{};
+			std::vector<CPU::PoolHandle> removed{};
+			objects.reserve(ObjectCount);
+			leaked.reserve(static_cast<size_t>(FrameCount) * ChurnPerFrame);
+			removed.reserve(static_cast<size_t>(FrameCount) * ChurnPerFrame);
+
+			int created = 0;
+			const auto create = [&]()
+			{
+				Object* object{ nullptr };
+				if constexpr (std::is_same_v<Object, PooledObject>)
+					object = GetPool<PooledObject>().Create("Ray Marched Object");
+				else
+				{
+					object = new MappedObject();
+					object->Name = "Ray Marched Object";
+				}
+				AddComponents(*object, created++);
+				objects.push_back(object);
+			};
+			for (int i = 0; i < ObjectCount; ++i)
+				create();
+
+			volatile float sink = 0.0f;
+			const size_t frameAllocations = Allocations.load();
+			for (int frame = 0; frame < FrameCount; ++frame)
+			{
+				const auto start = Clock::now();
+				for (int i = 0; i < ChurnPerFrame; ++i)
+				{
+					const size_t index = std::uniform_int_distribution<size_t>(0u, objects.size() - 1u)(rng);
+					Object* object = objects[index];
+					objects.erase(objects.begin() + static_cast<std::ptrdiff_t>(index));
+
+					if constexpr (std::is_same_v<Object, PooledObject>)
+					{
+						removed.push_back(GetPool<PooledObject>().GetHandle(object));
+						GetPool<PooledObject>().Destroy(object);
+					}
+					else if (layout == Layout::Leaking)
+						leaked.push_back(object);
+					else
+						delete object;
+				}
+				for (int i = 0; i < ChurnPerFrame; ++i)
+					create();
+				const auto churned = Clock::now();
+
+				sink = sink + UpdateAll(objects);
+				result.ChurnMs += std::chrono::duration<double, std::milli>(churned - start).count();
+				result.UpdateMs += std::chrono::duration<double, std::milli>(Clock::now() - churned).count();
+			}
+			result.AllocationsPerFrame = static_cast<double>(Allocations.load() - frameAllocations) / FrameCount;
+			result.ChurnMs /= FrameCount;
+			result.UpdateMs /= FrameCount;
+
+			if constexpr (std::is_same_v<Object, PooledObject>)
+			{
+				auto& pool = GetPool<PooledObject>();
+				for (const CPU::PoolHandle handle : removed)
+					result.StaleResolved += pool.Get(handle) != nullptr ? 1u : 0u;
+				for (const PooledObject* object : objects)
+					result.LiveMissed += pool.Get(pool.GetHandle(object)) != object ? 1u : 0u;
+				result.Chunks = pool.GetCounters().ChunkAllocations + GetPool<Transform>().GetCounters().ChunkAllocations +
+				                GetPool<Marched>().GetCounters().ChunkAllocations + GetPool<Material>().GetCounters().ChunkAllocations +
+				                GetPool<Light>().GetCounters().ChunkAllocations;
+
+				// Torn down newest first, as Game does
+				for (auto object = objects.rbegin(); object != objects.rend(); ++object)
+					pool.Destroy(*object);
+			}
+			else
+			{
+				// The leaking layout loses the removed objects, so only the scene is torn down
+				for (auto object = objects.rbegin(); object != objects.rend(); ++object)
+					delete *object;
+			}
+		}
+
+		result.Outstanding = (Allocations.load() - allocationsBefore) - (Deallocations.load() - deallocationsBefore);
+		return result;
+	}
+
+	void ObjectPoolBenchmark()
+	{
+		std::printf("%d objects, %d removed and added per frame over %d frames\n", ObjectCount, ChurnPerFrame, FrameCount);
+		std::printf("%-10s %10s %10s %12s %12s %8s %8s\n", "layout", "churn ms", "update ms", "allocs/frame", "outstanding", "stale", "chunks");
+
+		const auto print = [](const char* name, const ChurnResult& result)
+		{
+			std::printf("%-10s %10.4f %10.4f %12.1f %12zu %8zu %8zu\n", name, result.ChurnMs, result.UpdateMs, result.AllocationsPerFrame, result.Outstanding,
+			            result.StaleResolved, result.Chunks);
+		};
+
+		const ChurnResult leaking = RunChurn<MappedObject>(Layout::Leaking);
+		const ChurnResult deleting = RunChurn<MappedObject>(Layout::Deleting);
+		// The pools keep their chunks for the next scene, so a first run fills them and the second is measured
+		static_cast<void>(RunChurn<PooledObject>(Layout::Pooled));
+		const ChurnResult pooled = RunChurn<PooledObject>(Layout::Pooled);
+		print("leaking", leaking);
+		print("deleting", deleting);
+		print("pooled", pooled);
+		if (pooled.LiveMissed > 0u)
+			std::printf("%zu live handles failed to resolve\n", pooled.LiveMissed);
+
+		ReportMetric("ObjectPool/AllocationsPerFrame", "allocs", { pooled.AllocationsPerFrame }, false);
+		ReportMetric("ObjectPool/Outstanding", "allocs", { static_cast<double>(pooled.Outstanding) }, false);
+		ReportMetric("ObjectPool/StaleHandlesResolved", "handles", { static_cast<double>(pooled.StaleResolved) }, false);
+		ReportMetric("ObjectPool/ChurnSpeedup", "x", { deleting.ChurnMs / pooled.ChurnMs }, true);
+		ReportMetric("ObjectPool/UpdateSpeedup", "x", { deleting.UpdateMs / pooled.UpdateMs }, true);
+	}
+}
+
+REGISTER_BENCHMARK("ObjectPool", ObjectPoolBenchmark);
@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+#include "Benchmark.h"
+#include "CPU/BatchRenderer.h"
+#include "CPU/Profiler.h"
+
+// Cost of profiler zones, switched off and on, and what that adds to a batch
+// render. The measured difference between two renders is within run to run
+// noise, so the overhead is also derived from the zones a frame records and
+// the cost of one zone.
+namespace
+{
+	constexpr int ZoneCount = 1 << 20;
+
+	CPU::Scene CreateScene()
+	{
+		CPU::Scene scene{};
+		for (int i = 0; i < 4; ++i)
+		{
+			CPU::Object object{};
+			object.SDFType = i % 2 == 0 ? static_cast<int>(CPU::SDFType::Sphere) : static_cast<int>(CPU::SDFType::Box);
+			object.Position = CPU::Float3(static_cast<float>(i) * 2.5f - 3.75f, 0.0f, 0.0f);
+			object.Parameters = CPU::Float3(0.8f);
+			scene.Objects.push_back(object);
+		}
+
+		CPU::Light light{};
+		light.Position = CPU::Float3(3.0f, 4.0f, 4.0f);
+		scene.Lights.push_back(light);
+		return scene;
+	}
+
+	double TimeZonesNs()
+	{
+		const BenchmarkTiming timing = TimeIterations(5, []()
+		{
+			for (int i = 0; i < ZoneCount; ++i)
+			{
+				PROFILE_ZONE("Benchmark");
+			}
+		});
+		return timing.MinMs * 1e6 / ZoneCount;
+	}
+
+	size_t CountZones(const std::vector<CPU::ProfileThread>& threads)
+	{
+		size_t zones = 0u;
+		for (const CPU::ProfileThread& thread : threads)
+			zones += thread.Events.size();
+		return zones;
+	}
+
+	void ProfilerBenchmark()
+	{
+		CPU::SetProfilerEnabled(false);
+		const double disabledNs = TimeZonesNs();
+		CPU::SetProfilerEnabled(true);
+		const double enabledNs = TimeZonesNs();
+		CPU::SetProfilerEnabled(false);
+		std::printf("zone: %.2fns disabled, %.2fns enabled\n", disabledNs, enabledNs);
+
+		CPU::ThreadPool pool{};
+		CPU::BatchRenderer renderer(pool);
+		const CPU::Scene scene = CreateScene();
+		CPU::PackedCamera camera{};
+		camera.Position = CPU::Float3(0.0f, 1.0f, 8.0f);
+
+		CPU::BatchSettings batch{};
+		batch.Width = 256;
+		batch.Height = 144;
+		batch.FrameCount = 5;
+		batch.FramesInFlight = 1;
+
+		// Alternate so drift in machine load hits both the same
+		std::vector<double> offMs{}, onMs{};
+		size_t zonesPerFrame = 0u;
+		for (int run = 0; run < 3; ++run)
+		{
+			for (const bool enabled : { false, true })
+			{
+				const uint64_t start = CPU::GetProfilerTime();
+				CPU::SetProfilerEnabled(enabled);
+				const auto frames = renderer.Render(scene, CPU::CameraPath(camera), CPU::RenderSettings{}, batch, nullptr);
+				CPU::SetProfilerEnabled(false);
+
+				for (const CPU::BatchFrameStats& frame : frames)
+					(enabled ? onMs : offMs).push_back(frame.WallMs);
+				if (enabled)
+					zonesPerFrame = CountZones(CPU::CaptureProfile(start)) / frames.size();
+			}
+		}
+
+		const double offMedian = CalculateMedian(offMs);
+		const double derivedPercent = static_cast<double>(zonesPerFrame) * enabledNs / (offMedian * 1e6) * 100.0;
+		const double measuredPercent = (CalculateMedian(onMs) / offMedian - 1.0) * 100.0;
+		std::printf("batch frame: %.3fms off, %.3fms on, %zu zones per frame\n", offMedian, CalculateMedian(onMs), zonesPerFrame);
+		std::printf("overhead: %.4f%% derived, %.2f%% measured\n", derivedPercent, measuredPercent);
+
+		ReportMetric("Profiler/ZoneDisabled", "ns", { disabledNs }, false);
+		ReportMetric("Profiler/ZoneEnabled", "ns", { enabledNs }, false);
+		ReportMetric("Profiler/BatchOverhead", "%", { derivedPercent }, false);
+
+		// Export of everything recorded above
+		const std::filesystem::path path = std::filesystem::temp_directory_path() / "RayMarchingProfilerBenchmark.json";
+		std::vector<CPU::ProfileThread> threads{};
+		const BenchmarkTiming capture = TimeIterations(3, [&]() { threads = CPU::CaptureProfile(); });
+		const BenchmarkTiming write = TimeIterations(3, [&]() { CPU::WriteChromeTrace(path, threads); });
+		std::printf("capture %zu zones: %.3fms, write trace: %.3fms (%.2fMB)\n", CountZones(threads), capture.MinMs, write.MinMs,
+		            static_cast<double>(std::filesystem::file_size(path)) / (1024.0 * 1024.0));
+		std::filesystem::remove(path);
+	}
+}
+
+REGISTER_BENCHMARK("Profiler", ProfilerBenchmark);
@@ -0,0 +1,95 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "BenchmarkScenes.h"
+#include "CPU/ProxyRaster.h"
+#include "CPU/RayMarcher.h"
+#include "CPU/ThreadPool.h"
+
+// G-buffer renders of randomly placed primitives floating over a ground box
+// the camera looks down on, whose proxy passes behind the eye and is clipped.
+// Each scene is rendered with primary rays marching from the eye and from the
+// depth of the rasterised proxies. Covered is the share of pixels any proxy
+// covers; the rest are not marched. Early counts the pixels whose ray, marched
+// from the eye, hits nearer than its proxy depth, which a conservative raster
+// never has. Shading follows the step count through the ambient occlusion, so
+// colours are not compared, only where the rays stop.
+namespace
+{
+	constexpr int Width = 128;
+	constexpr int Height = 72;
+
+	CPU::Scene CreateFieldScene(const int count, const bool ground)
+	{
+		CPU::Scene scene{};
+		if (ground)
+		{
+			CPU::Object box{};
+			box.SDFType = static_cast<int>(CPU::SDFType::Box);
+			box.Position = CPU::Float3(0.0f, -0.5f, 0.0f);
+			box.Parameters = CPU::Float3(40.0f, 0.5f, 40.0f);
+			scene.Objects.push_back(box);
+		}
+
+		const std::vector<CPU::Object> field =
+			CreatePrimitiveField(count, 7u, { CPU::Float3(-20.0f, 1.0f, -30.0f), CPU::Float3(40.0f, 4.0f, 40.0f), 0.3f, 0.5f });
+		scene.Objects.insert(scene.Objects.end(), field.begin(), field.end());
+
+		CPU::Light light{};
+		light.Position = CPU::Float3(8.0f, 12.0f, 10.0f);
+		scene.Lights.push_back(light);
+		return scene;
+	}
+
+	void ProxyRasterBenchmark()
+	{
+		CPU::ThreadPool pool{};
+		const CPU::Camera camera = CPU::CreateLookAtCamera(CPU::Float3(0.0f, 8.0f, 18.0f), CPU::Float3(0.0f, 1.0f, -6.0f));
+		CPU::RenderSettings settings{};
+		settings.Width = Width;
+		settings.Height = Height;
+		const float pixelAngle = 2.0f * CPU::CalculatePixelConeAngle(camera, settings);
+
+		std::printf("%-14s %8s %9s %9s %9s %9s %11s %11s %7s %9s\n", "scene", "covered", "raster ms", "eye ms", "proxy ms", "speedup", "steps eye",
+		            "steps proxy", "early", "differ");
+		for (const bool ground : { false, true })
+		{
+			for (const int count : { 10, 100, 1000 })
+			{
+				const CPU::Scene scene = CreateFieldScene(count, ground);
+				CPU::Image<float> proxyDepths{};
+				const double rasterMs = TimeIterations(3, [&]() { CPU::RasteriseProxyDepths(scene, camera, settings, proxyDepths); }).MinMs;
+				const GBufferFrame fromEye = RenderGBufferFrame(pool, scene, settings, camera);
+				const GBufferFrame fromProxies = RenderGBufferFrame(pool, scene, settings, camera, nullptr, &proxyDepths);
+
+				size_t covered = 0u, early = 0u;
+				for (int y = 0; y < Height; ++y)
+				{
+					for (int x = 0; x < Width; ++x)
+					{
+						covered += proxyDepths.At(x, y) < settings.MaxDist ? 1u : 0u;
+						const bool truth = fromEye.Output.MaterialIndex.At(x, y).w > 0.0f;
+						const float truthDepth = fromEye.Output.NormDepth.At(x, y).w * settings.MaxDist;
+						if (truth && truthDepth < proxyDepths.At(x, y))
+							++early;
+					}
+				}
+				const double different = CountDifferentHitPercent(fromProxies.Output, fromEye.Output, pixelAngle);
+
+				const double pixels = static_cast<double>(Width * Height);
+				const double speedup = fromEye.Ms / (fromProxies.Ms + rasterMs);
+				const std::string name = std::to_string(count) + (ground ? "+ground" : "");
+				std::printf("%-14s %7.1f%% %9.3f %9.2f %9.2f %8.2fx %11.2f %11.2f %7zu %8.2f%%\n", name.c_str(), static_cast<double>(covered) * 100.0 / pixels,
+				            rasterMs, fromEye.Ms, fromProxies.Ms + rasterMs, speedup, fromEye.MeanSteps, fromProxies.MeanSteps, early, different);
+
+				const std::string prefix = "ProxyRaster/" + name + "/";
+				ReportMetric(prefix + "Speedup", "x", { speedup }, true);
+				ReportMetric(prefix + "EarlyHits", "pixels", { static_cast<double>(early) }, false);
+			}
+		}
+	}
+}
+
+REGISTER_BENCHMARK("ProxyRaster", ProxyRasterBenchmark);
@@ -0,0 +1,87 @@
+#include <cstdio>
+
+#include "Benchmark.h"
+#include "CPU/ReflectionComposite.h"
+
+namespace
+{
+	struct ReflectionInputs
+	{
+		CPU::Image<CPU::Float4> Colour;
+		CPU::Image<CPU::Float4> ReflectionColDepth;
+		CPU::Image<CPU::Float2> MetalicnessRoughness;
+	};
+
+	// Synthetic G-buffer: half of the screen metallic in 64px stripes, roughness ramping 0..1 down the screen.
+	ReflectionInputs CreateInputs(int width, int height)
+	{
+		ReflectionInputs inputs{};
+		inputs.Colour.Resize(width, height);
+		inputs.ReflectionColDepth.Resize(width, height);
+		inputs.MetalicnessRoughness.Resize(width, height);
+
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				const float checker = ((x / 16 + y / 16) % 2) ? 1.0f : 0.1f;
+				inputs.Colour.At(x, y) = CPU::Float4(0.5f, 0.4f, 0.3f, 1.0f);
+				inputs.ReflectionColDepth.At(x, y) = CPU::Float4(checker, checker * 0.5f, 1.0f - checker, 10.0f);
+				inputs.MetalicnessRoughness.At(x, y) = CPU::Float2((x / 64) % 2 ? 1.0f : 0.0f,
+				                                                   static_cast<float>(y) / static_cast<float>(height));
+			}
+		}
+
+		return inputs;
+	}
+
+	void RunAtResolution(const char* label, int width, int height)
+	{
+		const ReflectionInputs inputs = CreateInputs(width, height);
+		const CPU::ReflectionCompositeInput input{ &inputs.Colour, &inputs.ReflectionColDepth, &inputs.MetalicnessRoughness };
+
+		CPU::Image<CPU::Float4> directionalOutput;
+		const BenchmarkTiming directional = TimeIterations(3, [&]()
+		{
+			CPU::CompositeReflectionsDirectional(input, directionalOutput);
+		});
+
+		CPU::ImagePyramid pyramid;
+		const BenchmarkTiming pyramidBuild = TimeIterations(10, [&]()
+		{
+			CPU::BuildReflectionPyramid(inputs.ReflectionColDepth, pyramid);
+		});
+
+		CPU::Image<CPU::Float4> pyramidOutput;
+		const BenchmarkTiming pyramidComposite = TimeIterations(10, [&]()
+		{
+			CPU::CompositeReflectionsPyramid(input, pyramid, pyramidOutput);
+		});
+
+		// Mean absolute difference between the two methods, as a sanity check on the pyramid footprint
+		double difference = 0.0;
+		for (int y = 0; y < height; ++y)
+			for (int x = 0; x < width; ++x)
+			{
+				const CPU::Float4 d = directionalOutput.At(x, y) - pyramidOutput.At(x, y);
+				difference += (std::abs(d.x) + std::abs(d.y) + std::abs(d.z)) / 3.0;
+			}
+		difference /= static_cast<double>(width) * height;
+
+		const double pyramidTotal = pyramidBuild.MeanMs + pyramidComposite.MeanMs;
+		std::printf("%-6s %4dx%-4d  directional %9.2fms (96 taps)  pyramid %8.2fms (build %.2fms + composite %.2fms, 4 trilinear taps)  speedup %.1fx  mean abs diff %.4f\n",
+		            label, width, height,
+		            directional.MeanMs,
+		            pyramidTotal, pyramidBuild.MeanMs, pyramidComposite.MeanMs,
+		            directional.MeanMs / pyramidTotal,
+		            difference);
+	}
+
+	void ReflectionCompositeBenchmark()
+	{
+		RunAtResolution("1080p", 1920, 1080);
+		RunAtResolution("4K", 3840, 2160);
+	}
+}
+
+REGISTER_BENCHMARK("ReflectionComposite", ReflectionCompositeBenchmark);
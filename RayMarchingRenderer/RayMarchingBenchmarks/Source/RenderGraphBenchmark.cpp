@@ -0,0 +1,236 @@
+#include <cstdio>
+#include <string>
+#include <utility>
+
+#include "Benchmark.h"
+#include "CPU/RayMarcher.h"
+#include "CPU/ReflectionComposite.h"
+#include "CPU/RenderGraphImages.h"
+#include "Rendering/RenderGraph.h"
+
+namespace
+{
+	constexpr int Width = 320;
+	constexpr int Height = 180;
+
+	// Metallic sphere next to a matte one, so reflection rays have something to hit
+	CPU::Scene CreateReflectionScene()
+	{
+		CPU::Scene scene = CPU::CreateDefaultScene();
+		scene.Objects[0].Metalicness = 1.0f;
+		scene.Objects[0].Roughness = 0.3f;
+
+		CPU::Object neighbour{};
+		neighbour.Position = CPU::Float3(2.2f, 0.0f, 0.0f);
+		neighbour.Colour = CPU::Float3(0.9f, 0.2f, 0.1f);
+		scene.Objects.push_back(neighbour);
+
+		return scene;
+	}
+
+	// The editor's pipeline on the CPU backend: G-buffer, full resolution reflection trace and pyramid composite,
+	// plus a normals debug view that is culled unless it is the output. Passes are added out of order on purpose.
+	struct CPUFrame
+	{
+		CPU::Scene Scene{ CreateReflectionScene() };
+		CPU::Camera Camera{ CPU::CreateLookAtCamera(CPU::Float3(0.0f, 1.5f, 6.0f), CPU::Float3(0.6f, 0.0f, 0.0f)) };
+		CPU::RenderSettings Settings{};
+
+		RenderGraph Graph{};
+		CPU::RenderGraphImages Images{};
+
+		// Scratch owned by the composite pass
+		CPU::ImagePyramid Pyramid{};
+		CPU::Image<CPU::Float2> MetalicnessRoughness{};
+
+		void Build(const std::string& output)
+		{
+			Settings.Width = Width;
+			Settings.Height = Height;
+
+			RenderGraphTextureDesc desc{};
+			desc.Width = Width;
+			desc.Height = Height;
+
+			Graph.Clear();
+
+			Graph.AddPass("Reflection Composite", [&](RenderGraphBuilder& builder)
+			{
+				builder.Read("GBuffer.Colour");
+				builder.Read("GBuffer.Material");
+				builder.Read("Reflections.Colour");
+				builder.Create("Reflections.Result", desc);
+			}, [this]() { Composite(); });
+
+			Graph.AddPass("G-Buffer", [&](RenderGraphBuilder& builder)
+			{
+				builder.Create("GBuffer.Colour", desc);
+				builder.Create("GBuffer.NormDepth", desc);
+				builder.Create("GBuffer.Material", desc);
+			}, [this]() { RenderGBuffer(); });
+
+			Graph.AddPass("Normals View", [&](RenderGraphBuilder& builder)
+			{
+				builder.Read("GBuffer.NormDepth");
+				builder.Create("Debug.Normals", desc);
+			}, [this]()
+			{
+				const auto& normDepth = Images.Get("GBuffer.NormDepth");
+				auto& view = Images.Get("Debug.Normals");
+				for (int y = 0; y < Height; ++y)
+					for (int x = 0; x < Width; ++x)
+						view.At(x, y) = CPU::Float4(normDepth.At(x, y).xyz(), 1.0f);
+			});
+
+			Graph.AddPass("Reflection Trace", [&](RenderGraphBuilder& builder)
+			{
+				builder.Read("GBuffer.NormDepth");
+				builder.Read("GBuffer.Material");
+				builder.Create("Reflections.Colour", desc);
+			}, [this]() { TraceReflections(); });
+
+			Graph.MarkOutput(output);
+			Graph.Compile();
+			Images.Realise(Graph);
+		}
+
+		void RenderGBuffer()
+		{
+			// The CPU G-buffer owns its images, so lend it the graph's for the duration of the pass
+			CPU::GBuffer gbuffer{};
+			std::swap(gbuffer.Colour, Images.Get("GBuffer.Colour"));
+			std::swap(gbuffer.NormDepth, Images.Get("GBuffer.NormDepth"));
+			std::swap(gbuffer.MaterialIndex, Images.Get("GBuffer.Material"));
+
+			CPU::RenderGBufferRows(Scene, Camera, Settings, gbuffer, 0, Height);
+
+			std::swap(gbuffer.Colour, Images.Get("GBuffer.Colour"));
+			std::swap(gbuffer.NormDepth, Images.Get("GBuffer.NormDepth"));
+			std::swap(gbuffer.MaterialIndex, Images.Get("GBuffer.Material"));
+		}
+
+		// Full resolution port of ReflectionTraceShader.hlsl, reading the G-buffer the graph lends it
+		void TraceReflections()
+		{
+			CPU::GBuffer gbuffer{};
+			std::swap(gbuffer.NormDepth, Images.Get("GBuffer.NormDepth"));
+			std::swap(gbuffer.MaterialIndex, Images.Get("GBuffer.Material"));
+
+			CPU::TraceReflectionRows(Scene, Camera, Settings, gbuffer, Images.Get("Reflections.Colour"), 0, Height);
+
+			std::swap(gbuffer.NormDepth, Images.Get("GBuffer.NormDepth"));
+			std::swap(gbuffer.MaterialIndex, Images.Get("GBuffer.Material"));
+		}
+
+		void Composite()
+		{
+			const auto& material = Images.Get("GBuffer.Material");
+			MetalicnessRoughness.Resize(Width, Height);
+			for (int y = 0; y < Height; ++y)
+				for (int x = 0; x < Width; ++x)
+					MetalicnessRoughness.At(x, y) = CPU::Float2(material.At(x, y).x, material.At(x, y).y);
+
+			const auto& reflection = Images.Get("Reflections.Colour");
+			CPU::BuildReflectionPyramid(reflection, Pyramid);
+
+			const CPU::ReflectionCompositeInput input{ &Images.Get("GBuffer.Colour"), &reflection, &MetalicnessRoughness };
+			CPU::CompositeReflectionsPyramid(input, Pyramid, Images.Get("Reflections.Result"));
+		}
+	};
+
+	void PrintGraph(const RenderGraph& graph, const CPU::RenderGraphImages& images)
+	{
+		std::printf("  order:");
+		for (const int pass : graph.GetExecutionOrder())
+			std::printf(" [%s]", graph.GetPasses()[pass].Name.c_str());
+		for (const auto& pass : graph.GetPasses())
+			if (pass.Culled)
+				std::printf(" (culled: %s)", pass.Name.c_str());
+		std::printf("\n");
+
+		for (const auto& resource : graph.GetResources())
+		{
+			if (resource.Physical < 0)
+				std::printf("  %-20s culled\n", resource.Name.c_str());
+			else
+				std::printf("  %-20s slot %d, passes %d-%d%s\n", resource.Name.c_str(), resource.Physical,
+				            resource.FirstUse, resource.LastUse, resource.Output ? " (output)" : "");
+		}
+
+		std::printf("  %zu textures in %zu slots: %.2fMB (%.2fMB unaliased)\n",
+		            graph.GetResources().size(), graph.GetPhysicalDescs().size(),
+		            static_cast<double>(images.GetAllocatedBytes()) / (1024.0 * 1024.0),
+		            static_cast<double>(images.GetUnaliasedBytes()) / (1024.0 * 1024.0));
+	}
+
+	void RunCPUFrame(const char* output)
+	{
+		CPUFrame frame{};
+		frame.Build(output);
+
+		std::printf("Output %s at %dx%d\n", output, Width, Height);
+		PrintGraph(frame.Graph, frame.Images);
+
+		const BenchmarkTiming timing = TimeIterations(3, [&]() { frame.Graph.Execute(); });
+		std::printf("  execute %.2fms\n\n", timing.MeanMs);
+	}
+
+	// Chain where every pass reads the previous two textures, with a dead branch every fourth pass
+	void RunCompileScaling(const int passCount)
+	{
+		RenderGraph graph{};
+		RenderGraphTextureDesc desc{};
+		desc.Width = 1920;
+		desc.Height = 1080;
+
+		const BenchmarkTiming build = TimeIterations(5, [&]()
+		{
+			graph.Clear();
+			for (int i = 0; i < passCount; ++i)
+			{
+				graph.AddPass("Pass", [&](RenderGraphBuilder& builder)
+				{
+					if (i > 0)
+						builder.Read("T" + std::to_string(i - 1));
+					if (i > 1)
+						builder.Read("T" + std::to_string(i - 2));
+					builder.Create("T" + std::to_string(i), desc);
+					if (i % 4 == 3)
+						builder.Create("Unused" + std::to_string(i), desc);
+				}, nullptr);
+
+				if (i % 4 == 3)
+				{
+					graph.AddPass("Dead", [&](RenderGraphBuilder& builder)
+					{
+						builder.Read("Unused" + std::to_string(i));
+						builder.Create("Dead" + std::to_string(i), desc);
+					}, nullptr);
+				}
+			}
+			graph.MarkOutput("T" + std::to_string(passCount - 1));
+		});
+
+		const BenchmarkTiming compile = TimeIterations(5, [&]() { graph.Compile(); });
+
+		int culled = 0;
+		for (const auto& pass : graph.GetPasses())
+			culled += pass.Culled ? 1 : 0;
+
+		std::printf("%6d passes: build %8.3fms  compile %8.3fms  %d culled  %zu textures -> %zu slots\n",
+		            static_cast<int>(graph.GetPasses().size()), build.MeanMs, compile.MeanMs, culled,
+		            graph.GetResources().size(), graph.GetPhysicalDescs().size());
+	}
+
+	void RenderGraphBenchmark()
+	{
+		RunCPUFrame("Reflections.Result");
+		RunCPUFrame("Debug.Normals");
+
+		RunCompileScaling(100);
+		RunCompileScaling(1000);
+		RunCompileScaling(10000);
+	}
+}
+
+REGISTER_BENCHMARK("RenderGraph", RenderGraphBenchmark);
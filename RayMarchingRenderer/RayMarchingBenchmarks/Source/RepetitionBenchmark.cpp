@@ -0,0 +1,122 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "BenchmarkScenes.h"
+#include "CPU/ObjectCulling.h"
+#include "CPU/RayMarcher.h"
+#include "CPU/SignedDistance.h"
+#include "CPU/ThreadPool.h"
+
+// G-buffer renders, with one shadowing light, of square fields of columns on
+// a ground box. Each field is one cylinder repeated on a finite grid, which a
+// step evaluates at most four copies of, and the same columns as separate
+// objects, marched with per tile lists (see TileCullingBenchmark) and, for the
+// small field, every object each step. Repetition changes how rays step past
+// the columns, not where they stop, so the two should agree on nearly every
+// pixel. The varied field shrinks each copy by a hash of its cell, so it is only
+// timed.
+namespace
+{
+	constexpr int Width = 128;
+	constexpr int Height = 72;
+	constexpr float Spacing = 2.0f;
+	constexpr int FullObjectLimit = 1000;
+
+	CPU::Object CreateColumn()
+	{
+		CPU::Object column{};
+		column.SDFType = static_cast<int>(CPU::SDFType::Cylinder);
+		column.Position = CPU::Float3(0.0f, 1.5f, 0.0f);
+		column.Parameters = CPU::Float3(0.3f, 1.5f, 0.0f);
+		return column;
+	}
+
+	CPU::Scene CreateBaseScene(const int side)
+	{
+		CPU::Scene scene{};
+		CPU::Object ground{};
+		ground.SDFType = static_cast<int>(CPU::SDFType::Box);
+		ground.Position = CPU::Float3(0.0f, -0.5f, 0.0f);
+		ground.Parameters = CPU::Float3(static_cast<float>(side) * Spacing * 0.5f + 2.0f, 0.5f, static_cast<float>(side) * Spacing * 0.5f + 2.0f);
+		scene.Objects.push_back(ground);
+
+		CPU::Light light{};
+		light.Position = CPU::Float3(8.0f, 12.0f, 10.0f);
+		scene.Lights.push_back(light);
+		return scene;
+	}
+
+	// side x side columns, side odd, as one object repeated either side of the origin
+	CPU::Scene CreateRepeatedScene(const int side, const float variation)
+	{
+		CPU::Scene scene = CreateBaseScene(side);
+		CPU::Object column = CreateColumn();
+		column.Repeat.Mode = static_cast<int>(CPU::RepetitionMode::Grid);
+		column.Repeat.Spacing = CPU::Float3(Spacing, 0.0f, Spacing);
+		column.Repeat.Limit = CPU::Float3(static_cast<float>(side / 2), 0.0f, static_cast<float>(side / 2));
+		column.Repeat.Variation = variation;
+		scene.Objects.push_back(column);
+		return scene;
+	}
+
+	CPU::Scene CreateSeparateScene(const int side)
+	{
+		CPU::Scene scene = CreateBaseScene(side);
+		const CPU::Object column = CreateColumn();
+		for (int z = -side / 2; z <= side / 2; ++z)
+		{
+			for (int x = -side / 2; x <= side / 2; ++x)
+			{
+				CPU::Object copy = column;
+				copy.Position = column.Position + CPU::Float3(static_cast<float>(x) * Spacing, 0.0f, static_cast<float>(z) * Spacing);
+				scene.Objects.push_back(copy);
+			}
+		}
+		return scene;
+	}
+
+	void RepetitionBenchmark()
+	{
+		CPU::ThreadPool pool{};
+		const CPU::Camera camera = CPU::CreateLookAtCamera(CPU::Float3(3.0f, 9.0f, 24.0f), CPU::Float3(0.0f, 0.0f, -10.0f));
+		CPU::RenderSettings settings{};
+		settings.Width = Width;
+		settings.Height = Height;
+		const float pixelAngle = 2.0f * CPU::CalculatePixelConeAngle(camera, settings);
+
+		std::printf("%-8s %11s %9s %9s %9s %9s %11s %11s %9s\n", "columns", "repeated ms", "varied ms", "tiled ms", "full ms", "speedup",
+		            "steps rep", "steps tiled", "differ");
+		for (const int side : { 11, 101 })
+		{
+			const int count = side * side;
+			const GBufferFrame repeated = RenderGBufferFrame(pool, CreateRepeatedScene(side, 0.0f), settings, camera);
+			const GBufferFrame varied = RenderGBufferFrame(pool, CreateRepeatedScene(side, 0.5f), settings, camera);
+
+			const CPU::Scene separate = CreateSeparateScene(side);
+			CPU::ObjectCulling culling{};
+			const double buildMs = TimeIterations(3, [&]() { culling = CPU::BuildObjectCulling(separate, camera, settings); }).MinMs;
+			const GBufferFrame tiled = RenderGBufferFrame(pool, separate, settings, camera, &culling);
+			const double tiledMs = tiled.Ms + buildMs;
+			const double different = CountDifferentHitPercent(repeated.Output, tiled.Output, pixelAngle);
+
+			const std::string prefix = "Repetition/" + std::to_string(count) + "/";
+			ReportMetric(prefix + "SpeedupOverTiled", "x", { tiledMs / repeated.Ms }, true);
+			ReportMetric(prefix + "DifferentPixels", "%", { different }, false);
+
+			char fullMs[16] = "-";
+			if (count <= FullObjectLimit)
+			{
+				const GBufferFrame full = RenderGBufferFrame(pool, separate, settings, camera);
+				std::snprintf(fullMs, sizeof(fullMs), "%.2f", full.Ms);
+				ReportMetric(prefix + "SpeedupOverFull", "x", { full.Ms / repeated.Ms }, true);
+			}
+
+			std::printf("%-8d %11.2f %9.2f %9.2f %9s %8.2fx %11.2f %11.2f %8.2f%%\n", count, repeated.Ms, varied.Ms, tiledMs, fullMs,
+			            tiledMs / repeated.Ms, repeated.MeanSteps, tiled.MeanSteps, different);
+		}
+	}
+}
+
+REGISTER_BENCHMARK("Repetition", RepetitionBenchmark);
@@ -0,0 +1,146 @@
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "CPU/SceneFile.h"
+
+namespace
+{
+	constexpr int ObjectCount = 100000;
+	constexpr int LightCount = 10;
+
+	// Objects scattered over a grid with varied types, operators and materials
+	CPU::SceneDocument CreateLargeDocument()
+	{
+		CPU::SceneDocument document{};
+		document.SDFLibrary = {
+			{ "Sphere", "return length(p) - param.x;" },
+			{ "Box", "float3 q = abs(p) - param.xyz; return length(max(q, 0.0)) + min(max(q.x, max(q.y, q.z)), 0.0);" },
+			{ "Torus", "float2 q = float2(length(p.xz) - param.x, p.y); return length(q) - param.y;" },
+		};
+
+		unsigned int seed = 1u;
+		const auto random = [&seed]()
+		{
+			seed = seed * 1664525u + 1013904223u;
+			return static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+		};
+
+		document.Objects.reserve(ObjectCount);
+		document.ObjectNames.reserve(ObjectCount);
+		for (int i = 0; i < ObjectCount; ++i)
+		{
+			CPU::PackedObject object{};
+			object.Position = CPU::Float3(static_cast<float>(i % 100), static_cast<float>((i / 100) % 100), static_cast<float>(i / 10000)) * CPU::Float3(3.0f);
+			object.Rotation = CPU::Float3(random(), random(), random()) * CPU::Float3(360.0f);
+			object.Scale = CPU::Float3(0.5f + random());
+			object.Parameters = CPU::Float3(1.0f, 0.5f, 0.25f);
+			object.SDFType = static_cast<uint32_t>(i % 3);
+			object.BoolOperator = i % 17 == 0 ? 2u : 0u;
+			object.Colour = CPU::Float3(random(), random(), random());
+			object.Metalicness = random();
+			object.Roughness = random();
+
+			document.Objects.push_back(object);
+			document.ObjectNames.push_back("Object " + std::to_string(i));
+		}
+
+		for (int i = 0; i < LightCount; ++i)
+		{
+			CPU::PackedLight light{};
+			light.Position = CPU::Float3(random() * 300.0f, 50.0f, random() * 30.0f);
+			document.Lights.push_back(light);
+			document.LightNames.push_back("Light " + std::to_string(i));
+		}
+
+		document.Camera.Position = CPU::Float3(150.0f, 150.0f, -40.0f);
+		document.Camera.Rotation = CPU::Float3(30.0f, 10.0f, 0.0f);
+		return document;
+	}
+
+	bool MatchesDocument(const CPU::SceneFileView& file, const CPU::SceneDocument& document)
+	{
+		if (file.GetObjects().size() != document.Objects.size() || file.GetLights().size() != document.Lights.size() ||
+		    file.GetSnippetCount() != document.SDFLibrary.size())
+			return false;
+
+		if (std::memcmp(file.GetObjects().data(), document.Objects.data(), document.Objects.size() * sizeof(CPU::PackedObject)) != 0 ||
+		    std::memcmp(file.GetLights().data(), document.Lights.data(), document.Lights.size() * sizeof(CPU::PackedLight)) != 0)
+			return false;
+
+		for (size_t i = 0; i < document.ObjectNames.size(); ++i)
+			if (file.GetObjectName(i) != document.ObjectNames[i])
+				return false;
+
+		for (size_t i = 0; i < document.SDFLibrary.size(); ++i)
+			if (file.GetSnippetName(i) != document.SDFLibrary[i].first || file.GetSnippetBody(i) != document.SDFLibrary[i].second)
+				return false;
+
+		return file.GetCamera().Rotation.x == document.Camera.Rotation.x && file.GetRenderSettings().MaxSteps == document.RenderSettings.MaxSteps;
+	}
+
+	void PrintTiming(const char* label, const BenchmarkTiming& timing)
+	{
+		std::printf("  %-34s %8.3fms (min %.3fms)\n", label, timing.MeanMs, timing.MinMs);
+	}
+
+	void SceneFileBenchmark()
+	{
+		const std::filesystem::path path = std::filesystem::temp_directory_path() / "RayMarchingBenchmark.rmscene";
+		const CPU::SceneDocument document = CreateLargeDocument();
+
+		const BenchmarkTiming write = TimeIterations(3, [&]() { CPU::WriteSceneFile(path, document); });
+		const auto fileSize = std::filesystem::file_size(path);
+
+		std::printf("%d objects, %d lights: %.2fMB\n", ObjectCount, LightCount, static_cast<double>(fileSize) / (1024.0 * 1024.0));
+		std::printf("  round trip %s\n", MatchesDocument(CPU::SceneFileView(path), document) ? "matches" : "MISMATCH");
+
+		PrintTiming("write", write);
+
+		// Open only maps and validates the header and section table, so it is independent of object count
+		PrintTiming("open (map + validate)", TimeIterations(20, [&]()
+		{
+			const CPU::SceneFileView file(path);
+			(void)file.GetObjects();
+		}));
+
+		float checksum = 0.0f;
+		PrintTiming("open + read every object in place", TimeIterations(20, [&]()
+		{
+			const CPU::SceneFileView file(path);
+			for (const CPU::PackedObject& object : file.GetObjects())
+				checksum += object.Position.x + object.Colour.y;
+		}));
+
+		std::vector<CPU::PackedObject> objects(ObjectCount);
+		PrintTiming("open + copy into packed array", TimeIterations(20, [&]()
+		{
+			const CPU::SceneFileView file(path);
+			std::memcpy(objects.data(), file.GetObjects().data(), file.GetObjects().size_bytes());
+		}));
+
+		PrintTiming("open + unpack to CPU::Scene", TimeIterations(20, [&]()
+		{
+			const CPU::SceneFileView file(path);
+			const CPU::Scene scene = CPU::CreateScene(file);
+			checksum += scene.Objects.back().Roughness;
+		}));
+
+		// Baseline: the same bytes through a buffered stream read
+		std::vector<char> buffer(fileSize);
+		PrintTiming("ifstream read of whole file", TimeIterations(20, [&]()
+		{
+			std::ifstream stream(path, std::ios::binary);
+			stream.read(buffer.data(), static_cast<std::streamsize>(fileSize));
+		}));
+
+		std::printf("  (checksum %.1f)\n", static_cast<double>(checksum));
+		std::filesystem::remove(path);
+	}
+}
+
+REGISTER_BENCHMARK("SceneFile", SceneFileBenchmark);
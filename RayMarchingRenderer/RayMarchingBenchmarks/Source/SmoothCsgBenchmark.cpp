@@ -0,0 +1,98 @@
+#include <cstdio>
+#include <string>
+
+#include "Benchmark.h"
+#include "BenchmarkScenes.h"
+#include "CPU/ObjectCulling.h"
+#include "CPU/RayMarcher.h"
+#include "CPU/SignedDistance.h"
+#include "CPU/ThreadPool.h"
+
+// G-buffer renders, with one shadowing light, of a hundred randomly placed
+// primitives over a ground box, each joined to the scene by a hard union and by
+// a smooth one. Both are marched with every object each step and with per tile
+// lists (see TileCullingBenchmark), whose bounds a smooth union grows by its
+// blend radius. The blend only costs more where two surfaces are within the
+// radius of each other, so smooth over hard is what blending costs on top of
+// the extra steps the rounder surfaces take. The tiled walk folds the objects
+// it evaluates in scene order, as the full walk does, since smooth union is not
+// associative, so only an object culled while still within a blend radius of
+// the surface moves a pixel.
+namespace
+{
+	constexpr int Width = 128;
+	constexpr int Height = 72;
+	constexpr int ObjectCount = 100;
+
+	CPU::Scene CreateBlobScene(const int boolOperator, const float blendRadius)
+	{
+		CPU::Scene scene{};
+		CPU::Object ground{};
+		ground.SDFType = static_cast<int>(CPU::SDFType::Box);
+		ground.Position = CPU::Float3(0.0f, -0.5f, 0.0f);
+		ground.Parameters = CPU::Float3(20.0f, 0.5f, 20.0f);
+		scene.Objects.push_back(ground);
+
+		for (CPU::Object object : CreatePrimitiveField(ObjectCount, 11u, { CPU::Float3(-8.0f, 0.5f, -12.0f), CPU::Float3(16.0f, 3.0f, 16.0f), 0.3f, 0.4f }))
+		{
+			object.BoolOperator = boolOperator;
+			object.BlendRadius = blendRadius;
+			scene.Objects.push_back(object);
+		}
+
+		CPU::Light light{};
+		light.Position = CPU::Float3(8.0f, 12.0f, 10.0f);
+		scene.Lights.push_back(light);
+		return scene;
+	}
+
+	void SmoothCsgBenchmark()
+	{
+		CPU::ThreadPool pool{};
+		const CPU::Camera camera = CPU::CreateLookAtCamera(CPU::Float3(0.0f, 7.0f, 12.0f), CPU::Float3(0.0f, 1.0f, -4.0f));
+		CPU::RenderSettings settings{};
+		settings.Width = Width;
+		settings.Height = Height;
+		const float pixelAngle = 2.0f * CPU::CalculatePixelConeAngle(camera, settings);
+
+		std::printf("%-10s %9s %9s %9s %9s %11s %11s %9s\n", "objects", "full ms", "tiled ms", "build ms", "speedup", "steps full", "steps tiled",
+		            "differ");
+		GBufferFrame hardFull{}, hardTiled{};
+		for (const float blendRadius : { 0.0f, 0.25f, 1.0f })
+		{
+			const bool smooth = blendRadius > 0.0f;
+			const CPU::Scene scene = CreateBlobScene(smooth ? 3 : 0, blendRadius);
+			CPU::ObjectCulling culling{};
+			const double buildMs = TimeIterations(3, [&]() { culling = CPU::BuildObjectCulling(scene, camera, settings); }).MinMs;
+			const GBufferFrame full = RenderGBufferFrame(pool, scene, settings, camera);
+			const GBufferFrame tiled = RenderGBufferFrame(pool, scene, settings, camera, &culling);
+			const double tiledMs = tiled.Ms + buildMs;
+			const double different = CountDifferentHitPercent(tiled.Output, full.Output, pixelAngle);
+
+			char name[16]{};
+			std::snprintf(name, sizeof(name), smooth ? "smooth %.2f" : "hard", blendRadius);
+			std::printf("%-10s %9.2f %9.2f %9.3f %8.2fx %11.2f %11.2f %8.2f%%\n", name, full.Ms, tiledMs, buildMs, full.Ms / tiledMs, full.MeanSteps,
+			            tiled.MeanSteps, different);
+
+			const std::string prefix = "SmoothCsg/" + std::string(name) + "/";
+			ReportMetric(prefix + "TiledSpeedup", "x", { full.Ms / tiledMs }, true);
+			ReportMetric(prefix + "DifferentPixels", "%", { different }, false);
+			if (!smooth)
+			{
+				hardFull = full;
+				hardTiled = tiled;
+				continue;
+			}
+
+			// Blending's cost over the same objects joined by hard unions, per pixel and per step
+			const double fullCost = full.Ms / hardFull.Ms;
+			const double tiledCost = tiled.Ms / hardTiled.Ms;
+			const double stepCost = (full.Ms / full.MeanSteps) / (hardFull.Ms / hardFull.MeanSteps);
+			std::printf("%-10s smooth over hard: full %.2fx, tiled %.2fx, per step %.2fx\n", "", fullCost, tiledCost, stepCost);
+			ReportMetric(prefix + "CostOverHard", "x", { fullCost }, false);
+			ReportMetric(prefix + "TiledCostOverHard", "x", { tiledCost }, false);
+		}
+	}
+}
+
+REGISTER_BENCHMARK("SmoothCsg", SmoothCsgBenchmark);
@@ -0,0 +1,62 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "CPU/SignedDistance.h"
+#include "CPU/SnippetCost.h"
+#include "CPU/SnippetPorts.h"
+
+// The snippet cost model on the CPU: evaluation rate and Lipschitz estimate of
+// the built-in primitives and the ports of the shipped fractal snippets, over
+// the standard point distribution the GPU benchmark uses. Primitives are exact
+// distances, so their estimates should come out at 1.
+namespace
+{
+	template <int Type>
+	float Primitive(const CPU::Float3& p, const CPU::Float3& param)
+	{
+		return CPU::SignedDistance(Type, p, param);
+	}
+
+	struct Snippet
+	{
+		std::string Name{};
+		CPU::SignedDistanceFunction Function{ nullptr };
+		CPU::Float3 Parameters{ 1.0f };
+	};
+
+	void SnippetCostBenchmark()
+	{
+		const std::vector<Snippet> snippets = {
+			{ "Sphere", &Primitive<0>, CPU::Float3(1.0f) },
+			{ "Box", &Primitive<1>, CPU::Float3(1.0f) },
+			{ "Torus", &Primitive<2>, CPU::Float3(1.0f, 0.25f, 0.0f) },
+			{ "Cone", &Primitive<3>, CPU::Float3(1.0f, 2.0f, 1.5f) },
+			{ "Cylinder", &Primitive<4>, CPU::Float3(0.5f, 1.0f, 0.0f) },
+			{ "Mandelbulb", &CPU::SdfMandelbulbSnippet, CPU::Float3(8.0f) },
+			{ "Juliabulb", &CPU::SdfJuliabulbSnippet, CPU::Float3(0.35f, 0.25f, -0.4f) },
+			{ "Julia", &CPU::SdfJuliaSnippet, CPU::Float3(-0.2f, 0.6f, 0.2f) },
+			{ "Sierpinski", &CPU::SdfSierpinskiSnippet, CPU::Float3(1.0f) },
+		};
+
+		std::printf("%-12s %14s %10s %12s\n", "snippet", "M evals/s", "Lipschitz", "max slope");
+		for (const Snippet& snippet : snippets)
+		{
+			// Best of a few runs for the rate; the estimate is deterministic
+			std::vector<double> rates{};
+			CPU::SnippetCost cost{};
+			for (int run = 0; run < 3; ++run)
+			{
+				cost = CPU::MeasureSnippetCost(snippet.Function, snippet.Parameters);
+				rates.push_back(static_cast<double>(cost.EvaluationsPerSecond) * 1e-6);
+			}
+
+			std::printf("%-12s %14.2f %10.3f %12.4g\n", snippet.Name.c_str(), CalculateMedian(rates), static_cast<double>(cost.Lipschitz),
+			            static_cast<double>(cost.MaxSlope));
+			ReportMetric("SnippetCost/" + snippet.Name + "/Rate", "Mevals/s", rates, true);
+		}
+	}
+}
+
+REGISTER_BENCHMARK("SnippetCost", SnippetCostBenchmark);
@@ -0,0 +1,123 @@
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "CPU/RayMarcher.h"
+#include "CPU/SnippetCost.h"
+#include "CPU/SnippetPorts.h"
+#include "CPU/ThreadPool.h"
+
+// Per-object step scales from the Lipschitz estimate, on the fractal snippet
+// ports. Each fractal's primary rays are marched unscaled and with its
+// estimated scale, and each is compared against a reference marched at a
+// quarter of that scale and threshold with many more steps. A pixel is wrong
+// when it hits where the reference misses or the other way round, or lands
+// further than DepthTolerance from it: the overshoot artifacts the scale exists
+// to remove.
+namespace
+{
+	constexpr int Width = 192;
+	constexpr int Height = 108;
+	constexpr float DepthTolerance = 0.01f;
+
+	struct Primary
+	{
+		std::vector<CPU::Ray> Rays{};
+		double MeanSteps{ 0.0 };
+	};
+
+	Primary MarchPrimary(CPU::ThreadPool& pool, const CPU::Scene& scene, const CPU::RenderSettings& settings, const CPU::Camera& camera)
+	{
+		Primary primary{};
+		primary.Rays.resize(static_cast<size_t>(Width) * Height);
+		pool.ParallelFor(Height, [&](const int y)
+		{
+			for (int x = 0; x < Width; ++x)
+			{
+				const CPU::Float2 texCoord((static_cast<float>(x) + 0.5f) / Width, (static_cast<float>(y) + 0.5f) / Height);
+				primary.Rays[static_cast<size_t>(y) * Width + x] =
+					CPU::RayMarch(scene, settings, camera.Position, CPU::CalculateRayDirection(camera, settings, texCoord));
+			}
+		});
+
+		for (const CPU::Ray& ray : primary.Rays)
+			primary.MeanSteps += ray.StepCount;
+		primary.MeanSteps /= static_cast<double>(primary.Rays.size());
+		return primary;
+	}
+
+	double CountWrongPercent(const Primary& primary, const Primary& reference)
+	{
+		size_t wrong = 0u;
+		for (size_t i = 0; i < primary.Rays.size(); ++i)
+		{
+			const CPU::Ray& ray = primary.Rays[i];
+			const CPU::Ray& truth = reference.Rays[i];
+			if (ray.Hit != truth.Hit || (ray.Hit && std::abs(ray.Depth - truth.Depth) > DepthTolerance))
+				++wrong;
+		}
+		return static_cast<double>(wrong) * 100.0 / static_cast<double>(primary.Rays.size());
+	}
+
+	void StepScaleBenchmark()
+	{
+		struct Fractal
+		{
+			std::string Name{};
+			CPU::SignedDistanceFunction Function{ nullptr };
+			CPU::Float3 Parameters{ 1.0f };
+		};
+		const std::vector<Fractal> fractals = {
+			{ "Mandelbulb", &CPU::SdfMandelbulbSnippet, CPU::Float3(8.0f, 0.0f, 0.0f) },
+			{ "Juliabulb", &CPU::SdfJuliabulbSnippet, CPU::Float3(0.35f, 0.25f, -0.4f) },
+			{ "Julia", &CPU::SdfJuliaSnippet, CPU::Float3(-0.2f, 0.6f, 0.2f) },
+			{ "Sierpinski", &CPU::SdfSierpinskiSnippet, CPU::Float3(1.0f) },
+		};
+
+		CPU::ThreadPool pool{};
+		const CPU::Camera camera = CPU::CreateLookAtCamera(CPU::Float3(0.0f, 0.6f, 2.6f), CPU::Float3(0.0f));
+		CPU::RenderSettings settings{};
+		settings.Width = Width;
+		settings.Height = Height;
+		CPU::RenderSettings referenceSettings = settings;
+		referenceSettings.MaxSteps = 4000u;
+		referenceSettings.IntersectionThreshold *= 0.25f;
+
+		std::printf("%-12s %7s %12s %12s %10s %10s\n", "fractal", "scale", "steps 1.0", "steps est.", "wrong 1.0", "wrong est.");
+		for (const Fractal& fractal : fractals)
+		{
+			CPU::Scene scene{};
+			scene.SDFLibrary.push_back(fractal.Function);
+			CPU::Object object{};
+			object.Parameters = fractal.Parameters;
+			scene.Objects.push_back(object);
+
+			// The threshold applies to the scaled distance, so each scale has a reference of its own
+			const auto march = [&](const float stepScale, double& wrongPercent)
+			{
+				scene.Objects[0].StepScale = stepScale;
+				const Primary primary = MarchPrimary(pool, scene, settings, camera);
+				scene.Objects[0].StepScale = stepScale * 0.25f;
+				const Primary reference = MarchPrimary(pool, scene, referenceSettings, camera);
+				wrongPercent = CountWrongPercent(primary, reference);
+				return primary;
+			};
+
+			CPU::EstimateStepScales(scene);
+			const float stepScale = scene.Objects[0].StepScale;
+			double unscaledWrong = 0.0, scaledWrong = 0.0;
+			const Primary unscaled = march(1.0f, unscaledWrong);
+			const Primary scaled = march(stepScale, scaledWrong);
+			std::printf("%-12s %7.3f %12.2f %12.2f %9.2f%% %9.2f%%\n", fractal.Name.c_str(), static_cast<double>(stepScale), unscaled.MeanSteps,
+			            scaled.MeanSteps, unscaledWrong, scaledWrong);
+
+			const std::string prefix = "StepScale/" + fractal.Name + "/";
+			ReportMetric(prefix + "MeanSteps", "steps/pixel", { scaled.MeanSteps }, false);
+			ReportMetric(prefix + "WrongPixels", "%", { scaledWrong }, false);
+		}
+	}
+}
+
+REGISTER_BENCHMARK("StepScale", StepScaleBenchmark);
@@ -0,0 +1,149 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "CPU/BatchRenderer.h"
+#include "CPU/SignedDistance.h"
+#include "CPU/SnippetPorts.h"
+
+// Canonical scenes and camera positions tracked for regressions. Each scene is
+// rendered several times through the batch renderer on every core; timings
+// vary between runs, step counts are deterministic.
+namespace
+{
+	struct SuiteScene
+	{
+		std::string Name{};
+		CPU::Scene Scene{};
+		CPU::PackedCamera Camera{};
+		int Width{ 256 };
+		int Height{ 144 };
+		int Repetitions{ 5 };
+	};
+
+	CPU::Light CreateLight(const CPU::Float3& position)
+	{
+		CPU::Light light{};
+		light.Position = position;
+		return light;
+	}
+
+	CPU::PackedCamera CreateCamera(const CPU::Float3& position, const CPU::Float3& rotation)
+	{
+		CPU::PackedCamera camera{};
+		camera.Position = position;
+		camera.Rotation = rotation;
+		return camera;
+	}
+
+	CPU::Object CreateObject(CPU::SDFType type, int boolOperator, const CPU::Float3& position, const CPU::Float3& parameters)
+	{
+		CPU::Object object{};
+		object.SDFType = static_cast<int>(type);
+		object.BoolOperator = boolOperator;
+		object.Position = position;
+		object.Parameters = parameters;
+		return object;
+	}
+
+	// Rounded cube with a hole bored through it, ringed by a torus, next to a cone
+	CPU::Scene CreateCSGScene()
+	{
+		CPU::Scene scene{};
+		scene.Objects.push_back(CreateObject(CPU::SDFType::Box, 0, CPU::Float3(0.0f), CPU::Float3(1.0f)));
+		scene.Objects.push_back(CreateObject(CPU::SDFType::Sphere, 1, CPU::Float3(0.0f), CPU::Float3(1.35f)));
+		scene.Objects.push_back(CreateObject(CPU::SDFType::Cylinder, 2, CPU::Float3(0.0f), CPU::Float3(0.5f, 2.0f, 0.0f)));
+		scene.Objects.push_back(CreateObject(CPU::SDFType::Torus, 0, CPU::Float3(0.0f), CPU::Float3(1.7f, 0.15f, 0.0f)));
+		scene.Objects.push_back(CreateObject(CPU::SDFType::Cone, 0, CPU::Float3(2.8f, 0.8f, 0.0f), CPU::Float3(1.0f, 2.0f, 1.5f)));
+		scene.Lights.push_back(CreateLight(CPU::Float3(3.0f, 4.0f, 4.0f)));
+		scene.Lights.push_back(CreateLight(CPU::Float3(-4.0f, 2.0f, 2.0f)));
+		return scene;
+	}
+
+	CPU::Scene CreateFractalScene(CPU::SignedDistanceFunction sdf, const CPU::Float3& parameters)
+	{
+		CPU::Scene scene{};
+		scene.SDFLibrary.push_back(sdf);
+
+		CPU::Object object{};
+		object.Parameters = parameters;
+		scene.Objects.push_back(object);
+
+		scene.Lights.push_back(CreateLight(CPU::Float3(2.0f, 3.0f, 3.0f)));
+		return scene;
+	}
+
+	// 10x10x10 grid of alternating spheres and boxes
+	CPU::Scene CreateStressScene()
+	{
+		CPU::Scene scene{};
+		for (int i = 0; i < 1000; ++i)
+		{
+			const CPU::Float3 position(static_cast<float>(i % 10), static_cast<float>((i / 10) % 10), static_cast<float>(i / 100));
+			const bool box = i % 2 == 1;
+			scene.Objects.push_back(CreateObject(box ? CPU::SDFType::Box : CPU::SDFType::Sphere, 0,
+			                                     (position - CPU::Float3(4.5f)) * CPU::Float3(2.5f), CPU::Float3(box ? 0.7f : 0.9f)));
+		}
+		scene.Lights.push_back(CreateLight(CPU::Float3(20.0f, 25.0f, 30.0f)));
+		return scene;
+	}
+
+	std::vector<SuiteScene> CreateSuiteScenes()
+	{
+		std::vector<SuiteScene> scenes{};
+		scenes.push_back({ "Default", CPU::CreateDefaultScene(), CreateCamera(CPU::Float3(0.0f, 0.0f, 5.0f), CPU::Float3(0.0f)) });
+		scenes.push_back({ "CSG", CreateCSGScene(), CreateCamera(CPU::Float3(1.5f, 2.5f, 6.0f), CPU::Float3(-20.0f, 10.0f, 0.0f)) });
+
+		const CPU::PackedCamera fractalCamera = CreateCamera(CPU::Float3(0.0f, 0.6f, 2.6f), CPU::Float3(-12.0f, 0.0f, 0.0f));
+		scenes.push_back({ "Mandelbulb", CreateFractalScene(CPU::SdfMandelbulbSnippet, CPU::Float3(8.0f, 0.0f, 0.0f)), fractalCamera });
+		scenes.push_back({ "Juliabulb", CreateFractalScene(CPU::SdfJuliabulbSnippet, CPU::Float3(0.35f, 0.25f, -0.4f)), fractalCamera });
+		scenes.push_back({ "Julia", CreateFractalScene(CPU::SdfJuliaSnippet, CPU::Float3(-0.2f, 0.6f, 0.2f)), fractalCamera });
+		// The shipped snippet folds with scale 1, which leaves a single point at the origin, so this measures misses
+		scenes.push_back({ "Sierpinski", CreateFractalScene(CPU::SdfSierpinskiSnippet, CPU::Float3(1.0f)), fractalCamera });
+
+		// Every step evaluates all 1000 objects, so this runs smaller and fewer times
+		scenes.push_back({ "Stress1000", CreateStressScene(), CreateCamera(CPU::Float3(0.0f, 8.0f, 40.0f), CPU::Float3(-12.0f, 0.0f, 0.0f)), 64, 36, 3 });
+		return scenes;
+	}
+
+	void SuiteBenchmark()
+	{
+		CPU::ThreadPool pool{};
+		CPU::BatchRenderer renderer(pool);
+		std::printf("%u threads\n", pool.GetThreadCount());
+		std::printf("%-12s %9s %8s %11s %10s %13s %7s\n", "scene", "size", "Mrays/s", "mean steps", "p99 steps", "shadow steps", "hit %");
+
+		for (const SuiteScene& suiteScene : CreateSuiteScenes())
+		{
+			CPU::BatchSettings batch{};
+			batch.Width = suiteScene.Width;
+			batch.Height = suiteScene.Height;
+			batch.FrameCount = suiteScene.Repetitions;
+			batch.FramesInFlight = 1; // Keep frames apart so each wall time is a clean sample
+
+			const auto frames = renderer.Render(suiteScene.Scene, CPU::CameraPath(suiteScene.Camera), CPU::RenderSettings{}, batch, nullptr);
+
+			const double pixels = static_cast<double>(batch.Width) * batch.Height;
+			std::vector<double> mrays{}, meanSteps{}, p99Steps{}, shadowSteps{};
+			for (const CPU::BatchFrameStats& frame : frames)
+			{
+				mrays.push_back(pixels / (frame.WallMs * 1000.0));
+				meanSteps.push_back(frame.MeanSteps);
+				p99Steps.push_back(frame.P99Steps);
+				shadowSteps.push_back(frame.MeanShadowSteps);
+			}
+
+			const std::string prefix = "Suite/" + suiteScene.Name + "/";
+			ReportMetric(prefix + "Mrays", "Mrays/s", mrays, true);
+			ReportMetric(prefix + "MeanSteps", "steps/pixel", meanSteps, false);
+			ReportMetric(prefix + "P99Steps", "steps/pixel", p99Steps, false);
+			ReportMetric(prefix + "ShadowSteps", "steps/pixel", shadowSteps, false);
+
+			std::printf("%-12s %4dx%-4d %8.4f %11.2f %10.0f %13.2f %7.1f\n", suiteScene.Name.c_str(), batch.Width, batch.Height,
+			            CalculateMedian(mrays), meanSteps[0], p99Steps[0], shadowSteps[0], frames[0].HitFraction * 100.0);
+		}
+	}
+}
+
+REGISTER_BENCHMARK("Suite", SuiteBenchmark);
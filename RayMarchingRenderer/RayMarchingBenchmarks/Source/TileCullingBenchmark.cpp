@@ -0,0 +1,93 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "BenchmarkScenes.h"
+#include "CPU/ObjectCulling.h"
+#include "CPU/RayMarcher.h"
+#include "CPU/ThreadPool.h"
+
+// G-buffer renders, with one shadowing light, of randomly placed primitives
+// on a ground box, with a box minus a sphere in front so the culling has a
+// shared prefix to keep. Each scene is rendered with every ray marching every
+// object and with primary and shadow rays walking per tile lists. Objects per
+// tile is the mean list length, the most a step evaluates besides the shared
+// objects. Culled objects change how rays step past them, not where they stop,
+// so the tiled render should differ from the full one in next to no pixels.
+// Marching every object of the largest scene takes too long, so it is only
+// rendered tiled.
+namespace
+{
+	constexpr int Width = 128;
+	constexpr int Height = 72;
+	constexpr int FullObjectLimit = 1000;
+
+	CPU::Scene CreateFieldScene(const int count)
+	{
+		CPU::Scene scene{};
+		CPU::Object carved{};
+		carved.SDFType = static_cast<int>(CPU::SDFType::Box);
+		carved.Position = CPU::Float3(0.0f, 1.0f, 12.0f);
+		scene.Objects.push_back(carved);
+		CPU::Object hole{};
+		hole.Position = CPU::Float3(0.5f, 1.5f, 12.5f);
+		hole.Parameters = CPU::Float3(0.8f);
+		hole.BoolOperator = 2;
+		scene.Objects.push_back(hole);
+
+		CPU::Object ground{};
+		ground.SDFType = static_cast<int>(CPU::SDFType::Box);
+		ground.Position = CPU::Float3(0.0f, -0.5f, 0.0f);
+		ground.Parameters = CPU::Float3(40.0f, 0.5f, 40.0f);
+		scene.Objects.push_back(ground);
+
+		// The same seed, so each scene holds the smaller ones' objects
+		const std::vector<CPU::Object> field = CreatePrimitiveField(count, 5u, { CPU::Float3(-35.0f, 0.0f, -45.0f), CPU::Float3(70.0f, 3.0f, 70.0f) });
+		scene.Objects.insert(scene.Objects.end(), field.begin(), field.end());
+
+		CPU::Light light{};
+		light.Position = CPU::Float3(8.0f, 12.0f, 10.0f);
+		scene.Lights.push_back(light);
+		return scene;
+	}
+
+	void TileCullingBenchmark()
+	{
+		CPU::ThreadPool pool{};
+		const CPU::Camera camera = CPU::CreateLookAtCamera(CPU::Float3(0.0f, 6.0f, 20.0f), CPU::Float3(0.0f, 0.0f, -5.0f));
+		CPU::RenderSettings settings{};
+		settings.Width = Width;
+		settings.Height = Height;
+		const float pixelAngle = 2.0f * CPU::CalculatePixelConeAngle(camera, settings);
+
+		std::printf("%-8s %9s %9s %9s %9s %11s %11s %11s %11s %9s\n", "objects", "per tile", "full ms", "tiled ms", "speedup", "steps full",
+		            "steps tiled", "shadow full", "shadow tile", "differ");
+		for (const int count : { 10, 100, 1000, 10000 })
+		{
+			const CPU::Scene scene = CreateFieldScene(count);
+			CPU::ObjectCulling culling{};
+			const double buildMs = TimeIterations(3, [&]() { culling = CPU::BuildObjectCulling(scene, camera, settings); }).MinMs;
+			const double perTile = static_cast<double>(culling.TileObjects.size()) / static_cast<double>(culling.TilesX * culling.TilesY);
+			const GBufferFrame tiled = RenderGBufferFrame(pool, scene, settings, camera, &culling);
+
+			const std::string prefix = "TileCulling/" + std::to_string(count) + "/";
+			ReportMetric(prefix + "TiledMs", "ms", { tiled.Ms + buildMs }, false);
+			if (count > FullObjectLimit)
+			{
+				std::printf("%-8d %9.1f %9s %9.2f %9s %11s %11.2f %11s %11.2f %9s\n", count, perTile, "-", tiled.Ms + buildMs, "-", "-",
+				            tiled.MeanSteps, "-", tiled.MeanShadowSteps, "-");
+				continue;
+			}
+
+			const GBufferFrame full = RenderGBufferFrame(pool, scene, settings, camera);
+			const double different = CountDifferentHitPercent(tiled.Output, full.Output, pixelAngle);
+			std::printf("%-8d %9.1f %9.2f %9.2f %8.2fx %11.2f %11.2f %11.2f %11.2f %8.2f%%\n", count, perTile, full.Ms, tiled.Ms + buildMs,
+			            full.Ms / (tiled.Ms + buildMs), full.MeanSteps, tiled.MeanSteps, full.MeanShadowSteps, tiled.MeanShadowSteps, different);
+			ReportMetric(prefix + "Speedup", "x", { full.Ms / (tiled.Ms + buildMs) }, true);
+			ReportMetric(prefix + "DifferentPixels", "%", { different }, false);
+		}
+	}
+}
+
+REGISTER_BENCHMARK("TileCulling", TileCullingBenchmark);
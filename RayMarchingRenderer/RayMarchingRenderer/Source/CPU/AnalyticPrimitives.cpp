@@ -0,0 +1,395 @@
+#include "CPU/AnalyticPrimitives.h"
+
+#include <limits>
+#include <utility>
+
+#include "CPU/SignedDistance.h"
+
+namespace CPU
+{
+	namespace
+	{
+		constexpr float Infinity = std::numeric_limits<float>::infinity();
+
+		// Depths at which o + d * t lies between the planes at lo and hi along one axis
+		bool ClipSlab(const float o, const float d, const float lo, const float hi, float& nearDepth, float& farDepth)
+		{
+			if (std::abs(d) < 1e-12f)
+			{
+				nearDepth = -Infinity;
+				farDepth = Infinity;
+				return o >= lo && o <= hi;
+			}
+
+			nearDepth = (lo - o) / d;
+			farDepth = (hi - o) / d;
+			if (nearDepth > farDepth)
+				std::swap(nearDepth, farDepth);
+			return true;
+		}
+
+		// Keeps the part of [nearDepth, farDepth] that is also in [lo, hi], false if nothing is left
+		bool ClipInterval(const float lo, const float hi, float& nearDepth, float& farDepth)
+		{
+			nearDepth = std::max(nearDepth, lo);
+			farDepth = std::min(farDepth, hi);
+			return nearDepth <= farDepth;
+		}
+
+		bool IntersectSphere(const Float3& o, const Float3& d, const Float3& param, float& depth, Float3& normal)
+		{
+			// Squared distance from the closest point on the line, rather than b^2 - c, keeps precision far away
+			const float b = Dot(o, d);
+			const Float3 closest = o - d * Float3(b);
+			const float h = param.x * param.x - Dot(closest, closest);
+			if (h < 0.0f || -b + std::sqrt(h) < 0.0f)
+				return false;
+
+			depth = -b - std::sqrt(h);
+			normal = (o + d * Float3(depth)) / Float3(param.x);
+			return true;
+		}
+
+		bool IntersectBox(const Float3& o, const Float3& d, const Float3& param, float& depth, Float3& normal)
+		{
+			float nearDepth = -Infinity, farDepth = Infinity;
+			int axis = 0;
+			const float origin[3] = { o.x, o.y, o.z };
+			const float direction[3] = { d.x, d.y, d.z };
+			const float extent[3] = { param.x, param.y, param.z };
+			for (int i = 0; i < 3; ++i)
+			{
+				float slabNear = 0.0f, slabFar = 0.0f;
+				if (!ClipSlab(origin[i], direction[i], -extent[i], extent[i], slabNear, slabFar))
+					return false;
+				if (slabNear > nearDepth)
+				{
+					nearDepth = slabNear;
+					axis = i;
+				}
+				farDepth = std::min(farDepth, slabFar);
+			}
+			if (nearDepth > farDepth || farDepth < 0.0f)
+				return false;
+
+			float n[3] = { 0.0f, 0.0f, 0.0f };
+			n[axis] = direction[axis] > 0.0f ? -1.0f : 1.0f;
+			depth = nearDepth;
+			normal = Float3(n[0], n[1], n[2]);
+			return true;
+		}
+
+		bool IntersectCylinder(const Float3& o, const Float3& d, const Float3& param, float& depth, Float3& normal)
+		{
+			// Capped by the slab |y| <= param.y
+			float nearDepth = 0.0f, farDepth = 0.0f;
+			if (!ClipSlab(o.y, d.y, -param.y, param.y, nearDepth, farDepth))
+				return false;
+			const float capDepth = nearDepth;
+
+			// Infinite cylinder of radius param.x about y, solved in the xz plane like the sphere
+			const float length = Length(Float2(d.x, d.z));
+			if (length > 1e-12f)
+			{
+				const Float2 u = Float2(d.x, d.z) / Float2(length);
+				const float b = Dot(Float2(o.x, o.z), u);
+				const Float2 closest = Float2(o.x, o.z) - u * Float2(b);
+				const float h = param.x * param.x - Dot(closest, closest);
+				if (h < 0.0f)
+					return false;
+				if (!ClipInterval((-b - std::sqrt(h)) / length, (-b + std::sqrt(h)) / length, nearDepth, farDepth))
+					return false;
+			}
+			else if (Dot(Float2(o.x, o.z), Float2(o.x, o.z)) > param.x * param.x)
+				return false;
+			if (farDepth < 0.0f)
+				return false;
+
+			depth = nearDepth;
+			const Float3 p = o + d * Float3(depth);
+			normal = nearDepth == capDepth ? Float3(0.0f, d.y > 0.0f ? -1.0f : 1.0f, 0.0f) : Normalize(Float3(p.x, 0.0f, p.z));
+			return true;
+		}
+
+		bool IntersectCone(const Float3& o, const Float3& d, const Float3& param, float& depth, Float3& normal)
+		{
+			// Tip at the origin, base of radius param.z * k at y = -param.z
+			const float k2 = (param.x / param.y) * (param.x / param.y);
+			float slabNear = 0.0f, slabFar = 0.0f;
+			if (!ClipSlab(o.y, d.y, -param.z, 0.0f, slabNear, slabFar))
+				return false;
+
+			// Inside the double cone where a t^2 + 2 b t + c <= 0. That is one interval or two rays, and within
+			// the slab only the lower nappe is left, so at most one of them survives clipping.
+			const float a = d.x * d.x + d.z * d.z - k2 * d.y * d.y;
+			const float b = o.x * d.x + o.z * d.z - k2 * o.y * d.y;
+			const float c = o.x * o.x + o.z * o.z - k2 * o.y * o.y;
+			float intervals[2][2] = { { Infinity, -Infinity }, { Infinity, -Infinity } };
+			if (std::abs(a) < 1e-9f)
+			{
+				if (std::abs(b) > 1e-12f)
+				{
+					const float root = -c / (2.0f * b);
+					intervals[0][0] = b > 0.0f ? -Infinity : root;
+					intervals[0][1] = b > 0.0f ? root : Infinity;
+				}
+				else if (c <= 0.0f)
+				{
+					intervals[0][0] = -Infinity;
+					intervals[0][1] = Infinity;
+				}
+			}
+			else
+			{
+				const float discriminant = b * b - a * c;
+				if (discriminant >= 0.0f)
+				{
+					const float r0 = (-b - std::sqrt(discriminant)) / a;
+					const float r1 = (-b + std::sqrt(discriminant)) / a;
+					const float lo = std::min(r0, r1), hi = std::max(r0, r1);
+					if (a > 0.0f)
+					{
+						intervals[0][0] = lo;
+						intervals[0][1] = hi;
+					}
+					else
+					{
+						intervals[0][0] = -Infinity;
+						intervals[0][1] = lo;
+						intervals[1][0] = hi;
+						intervals[1][1] = Infinity;
+					}
+				}
+				else if (a < 0.0f)
+				{
+					intervals[0][0] = -Infinity;
+					intervals[0][1] = Infinity;
+				}
+			}
+
+			for (const auto& interval : intervals)
+			{
+				float nearDepth = interval[0], farDepth = interval[1];
+				if (!ClipInterval(slabNear, slabFar, nearDepth, farDepth) || farDepth < 0.0f)
+					continue;
+
+				depth = nearDepth;
+				const Float3 p = o + d * Float3(depth);
+				normal = nearDepth == slabNear ? Float3(0.0f, d.y > 0.0f ? -1.0f : 1.0f, 0.0f) : Normalize(Float3(p.x, -k2 * p.y, p.z));
+				return true;
+			}
+			return false;
+		}
+
+		// Gradient of (|p|^2 + R^2 - r^2)^2 - 4 R^2 (x^2 + z^2), normalised
+		Float3 GetTorusNormal(const Float3& p, const Float3& param)
+		{
+			return Normalize(p * (Float3(Dot(p, p) - param.y * param.y) - Float3(param.x * param.x) * Float3(1.0f, -1.0f, 1.0f)));
+		}
+
+		// Quartic solved by resolvent cubic, after Inigo Quilez's iTorus. In double, as the coefficients
+		// lose too much to cancellation in float.
+		bool IntersectTorus(const Float3& o, const Float3& d, const Float3& param, float& depth, Float3& normal)
+		{
+			if (SignedDistance(static_cast<int>(SDFType::Torus), o, param) < 0.0f)
+			{
+				depth = 0.0f;
+				normal = GetTorusNormal(o, param);
+				return true;
+			}
+
+			// The ring is in xz, and the quartic is written with it in xy
+			const double ox = o.x, oy = o.z, oz = o.y;
+			const double dx = d.x, dy = d.z, dz = d.y;
+			const double ra2 = static_cast<double>(param.x) * param.x;
+			const double rb2 = static_cast<double>(param.y) * param.y;
+			const double m = ox * ox + oy * oy + oz * oz;
+			const double n = ox * dx + oy * dy + oz * dz;
+
+			// Bounding sphere
+			const double bound = static_cast<double>(param.x) + param.y;
+			if (n * n - m + bound * bound < 0.0)
+				return false;
+
+			const double k = (m - rb2 - ra2) * 0.5;
+			double k3 = n;
+			double k2 = n * n + ra2 * dz * dz + k;
+			double k1 = k * n + ra2 * oz * dz;
+			double k0 = k * k + ra2 * oz * oz - ra2 * rb2;
+
+			// Solve for 1 / t instead when the cubic term would vanish
+			bool inverted = false;
+			if (std::abs(k3 * (k3 * k3 - k2) + k1) < 0.01)
+			{
+				inverted = true;
+				std::swap(k1, k3);
+				k0 = 1.0 / k0;
+				k1 *= k0;
+				k2 *= k0;
+				k3 *= k0;
+			}
+
+			double c2 = 2.0 * k2 - 3.0 * k3 * k3;
+			double c1 = k3 * (k3 * k3 - k2) + k1;
+			double c0 = k3 * (k3 * (-3.0 * k3 * k3 + 4.0 * k2) - 8.0 * k1) + 4.0 * k0;
+			c2 /= 3.0;
+			c1 *= 2.0;
+			c0 /= 3.0;
+
+			const double q = c2 * c2 + c0;
+			const double r = 3.0 * c0 * c2 - c2 * c2 * c2 - c1 * c1;
+			double h = r * r - q * q * q;
+			double z = 0.0;
+			if (h < 0.0)
+			{
+				const double sq = std::sqrt(q);
+				z = 2.0 * sq * std::cos(std::acos(std::clamp(r / (sq * q), -1.0, 1.0)) / 3.0);
+			}
+			else
+			{
+				const double sq = std::cbrt(std::sqrt(h) + std::abs(r));
+				z = (r < 0.0 ? -1.0 : 1.0) * std::abs(sq + q / sq);
+			}
+			z = c2 - z;
+
+			double d1 = z - 3.0 * c2;
+			double d2 = z * z - 3.0 * c0;
+			if (std::abs(d1) < 1.0e-8)
+			{
+				if (d2 < 0.0)
+					return false;
+				d2 = std::sqrt(d2);
+			}
+			else
+			{
+				if (d1 < 0.0)
+					return false;
+				d1 = std::sqrt(d1 * 0.5);
+				d2 = c1 / d1;
+			}
+
+			double result = std::numeric_limits<double>::infinity();
+			const auto addRoots = [&](const double offset, const double discriminant)
+			{
+				if (discriminant <= 0.0)
+					return;
+				for (const double sign : { -1.0, 1.0 })
+				{
+					double t = offset + sign * std::sqrt(discriminant) - k3;
+					t = inverted ? 2.0 / t : t;
+					if (t > 0.0)
+						result = std::min(result, t);
+				}
+			};
+			addRoots(-d1, d1 * d1 - z + d2);
+			addRoots(d1, d1 * d1 - z - d2);
+			if (!std::isfinite(result))
+				return false;
+
+			depth = static_cast<float>(result);
+			normal = GetTorusNormal(o + d * Float3(depth), param);
+			return true;
+		}
+	}
+
+	bool IsAnalyticPrimitive(const Scene& scene, const Object& object)
+	{
+		// Repeated objects have more than one surface to intersect
+		if (!scene.SDFLibrary.empty() || object.Scale.x <= 0.0f || object.Repeat.Mode != static_cast<int>(RepetitionMode::None))
+			return false;
+
+		const Float3& param = object.Parameters;
+		switch (static_cast<SDFType>(object.SDFType % static_cast<int>(SDFType::Count)))
+		{
+		case SDFType::Sphere: return param.x > 0.0f;
+		case SDFType::Box: return param.x > 0.0f && param.y > 0.0f && param.z > 0.0f;
+		case SDFType::Torus:
+		case SDFType::Cylinder: return param.x > 0.0f && param.y > 0.0f;
+		case SDFType::Cone: return param.x > 0.0f && param.y > 0.0f && param.z > 0.0f;
+		default: return false;
+		}
+	}
+
+	void FindAnalyticPrimitives(Scene& scene)
+	{
+		scene.AnalyticPrimitives.clear();
+		scene.MarchedObjects.clear();
+
+		// Intersections and subtractions apply to everything before them, and smooth unions blend with it, so only
+		// objects after the last one are unioned with the rest of the scene
+		int lastBoolean = -1;
+		for (int i = 0; i < static_cast<int>(scene.Objects.size()); ++i)
+			if (scene.Objects[i].BoolOperator != 0)
+				lastBoolean = i;
+
+		for (int i = 0; i < static_cast<int>(scene.Objects.size()); ++i)
+		{
+			const Object& object = scene.Objects[i];
+			if (i <= lastBoolean || !IsAnalyticPrimitive(scene, object))
+			{
+				scene.MarchedObjects.push_back(i);
+				continue;
+			}
+
+			AnalyticPrimitive primitive{};
+			primitive.Index = i;
+			primitive.Axes[0] = Rotate(Float3(1.0f, 0.0f, 0.0f), object.Rotation);
+			primitive.Axes[1] = Rotate(Float3(0.0f, 1.0f, 0.0f), object.Rotation);
+			primitive.Axes[2] = Rotate(Float3(0.0f, 0.0f, 1.0f), object.Rotation);
+			// A little slack, so rounding never culls a grazing hit
+			primitive.BoundingRadius = GetSDFBoundingRadius(object.SDFType, object.Parameters) * object.Scale.x * 1.001f;
+			scene.AnalyticPrimitives.push_back(primitive);
+		}
+
+		if (scene.AnalyticPrimitives.empty())
+			scene.MarchedObjects.clear();
+	}
+
+	bool IntersectPrimitive(const int sdfType, const Float3& ro, const Float3& rd, const Float3& param, float& depth, Float3& normal)
+	{
+		switch (static_cast<SDFType>(sdfType % static_cast<int>(SDFType::Count)))
+		{
+		case SDFType::Sphere: return IntersectSphere(ro, rd, param, depth, normal);
+		case SDFType::Box: return IntersectBox(ro, rd, param, depth, normal);
+		case SDFType::Torus: return IntersectTorus(ro, rd, param, depth, normal);
+		case SDFType::Cone: return IntersectCone(ro, rd, param, depth, normal);
+		case SDFType::Cylinder: return IntersectCylinder(ro, rd, param, depth, normal);
+		default: return false;
+		}
+	}
+
+	AnalyticHit IntersectAnalyticPrimitives(const Scene& scene, const Float3& ro, const Float3& rd, const float maxDepth)
+	{
+		AnalyticHit hit{};
+		hit.Depth = maxDepth;
+		for (const AnalyticPrimitive& primitive : scene.AnalyticPrimitives)
+		{
+			// Bounding sphere first, which also gives a nearby origin to intersect from for precision
+			const Object& object = scene.Objects[primitive.Index];
+			const Float3 toCentre = object.Position - ro;
+			const float centreDepth = Dot(toCentre, rd);
+			const float radius = primitive.BoundingRadius;
+			if (Dot(toCentre, toCentre) - centreDepth * centreDepth > radius * radius || centreDepth + radius < 0.0f || centreDepth - radius > hit.Depth)
+				continue;
+
+			const float start = std::max(centreDepth - radius, 0.0f);
+			const Float3 p = ro + rd * Float3(start) - object.Position;
+			const Float3 localOrigin = (primitive.Axes[0] * Float3(p.x) + primitive.Axes[1] * Float3(p.y) + primitive.Axes[2] * Float3(p.z)) / Float3(object.Scale.x);
+			const Float3 localDirection = primitive.Axes[0] * Float3(rd.x) + primitive.Axes[1] * Float3(rd.y) + primitive.Axes[2] * Float3(rd.z);
+
+			float depth = 0.0f;
+			Float3 normal{};
+			if (!IntersectPrimitive(object.SDFType, localOrigin, localDirection, object.Parameters, depth, normal))
+				continue;
+
+			depth = start + std::max(depth, 0.0f) * object.Scale.x;
+			if (depth > hit.Depth)
+				continue;
+
+			hit.Depth = depth;
+			hit.Normal = Float3(Dot(primitive.Axes[0], normal), Dot(primitive.Axes[1], normal), Dot(primitive.Axes[2], normal));
+			hit.Index = primitive.Index;
+		}
+		return hit;
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "CPU/SceneData.h"
+
+// Closed form ray intersections for the built-in primitives, a port of
+// AnalyticPrimitives.hlsli. Objects unioned with everything after the last
+// intersection or subtraction can be taken out of the marched distance field
+// and hit exactly instead, with exact normals. Custom SDFs, the fractals and
+// any object a later boolean operator applies to are still marched.
+namespace CPU
+{
+	struct AnalyticHit
+	{
+		float Depth{ 0.0f };
+		Float3 Normal{ 0.0f };
+		int Index{ -1 }; // Into Scene::Objects, -1 for a miss
+	};
+
+	// Whether the object's SDF is a built-in primitive with parameters describing a closed shape. Scenes with an
+	// SDF library run snippet ports, which are never analytic.
+	[[nodiscard]] bool IsAnalyticPrimitive(const Scene& scene, const Object& object);
+
+	// Fills scene.AnalyticPrimitives with every analytic primitive that is only unioned with the rest of the scene,
+	// and scene.MarchedObjects with the others in their original order. Leaves both empty when nothing qualifies.
+	void FindAnalyticPrimitives(Scene& scene);
+
+	// Nearest entry into one of the scene's analytic primitives along the ray, in (0, maxDepth]. A ray starting
+	// inside one hits it at depth 0, as marching would.
+	[[nodiscard]] AnalyticHit IntersectAnalyticPrimitives(const Scene& scene, const Float3& ro, const Float3& rd, float maxDepth);
+
+	// Entry depth and outward normal of a unit length ray in the primitive's local space, false if it misses or
+	// the primitive is entirely behind the origin. depth is 0 or less when the ray starts inside.
+	[[nodiscard]] bool IntersectPrimitive(int sdfType, const Float3& ro, const Float3& rd, const Float3& param, float& depth, Float3& normal);
+}
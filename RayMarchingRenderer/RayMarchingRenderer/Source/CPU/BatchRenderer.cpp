@@ -0,0 +1,191 @@
+#include "CPU/BatchRenderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+
+#include "CPU/Metrics.h"
+#include "CPU/Profiler.h"
+#include "CPU/ProxyRaster.h"
+
+namespace CPU
+{
+	namespace
+	{
+		using Clock = std::chrono::steady_clock;
+
+		struct FrameSlot
+		{
+			GBuffer Output{};
+			Image<PixelCost> Costs{};
+			Image<Float4> Reflections{};
+			Camera View{};
+			ObjectCulling Culling{};
+			Image<float> ProxyDepths{};
+			BatchFrameStats Stats{};
+		};
+
+		struct BandTiming
+		{
+			Clock::time_point Start{};
+			Clock::time_point End{};
+		};
+
+		float GetFrameTime(const BatchSettings& batch, int frame)
+		{
+			if (batch.FrameCount <= 1)
+				return batch.StartTime;
+			return Lerp(batch.StartTime, batch.EndTime, static_cast<float>(frame) / static_cast<float>(batch.FrameCount - 1));
+		}
+
+		void CalculateImageStats(const FrameSlot& slot, BatchFrameStats& stats)
+		{
+			stats.Costs.Add(slot.Costs);
+
+			uint64_t hits = 0u;
+			for (int y = 0; y < slot.Output.GetHeight(); ++y)
+				for (int x = 0; x < slot.Output.GetWidth(); ++x)
+					hits += slot.Output.MaterialIndex.At(x, y).w > 0.0f ? 1u : 0u;
+
+			const CostHistogram& primary = stats.Costs.Metrics[static_cast<int>(CostMetric::PrimarySteps)];
+			stats.MeanSteps = primary.GetMean();
+			stats.P99Steps = primary.GetPercentile(0.99);
+			stats.MaxSteps = primary.Max;
+			stats.MeanShadowSteps = stats.Costs.Metrics[static_cast<int>(CostMetric::ShadowSteps)].GetMean();
+			stats.HitFraction = static_cast<double>(hits) / std::max(1.0, static_cast<double>(primary.Count));
+		}
+	}
+
+	int BatchRenderer::GetFramesInFlight(const BatchSettings& batch) const
+	{
+		if (batch.FramesInFlight > 0)
+			return std::min(batch.FramesInFlight, std::max(1, batch.FrameCount));
+
+		const int rowsPerBand = std::max(1, batch.RowsPerBand);
+		const int bandsPerFrame = (batch.Height + rowsPerBand - 1) / rowsPerBand;
+		const int wantedBands = static_cast<int>(Pool.GetThreadCount()) * 4;
+		const int frames = (wantedBands + bandsPerFrame - 1) / std::max(1, bandsPerFrame);
+		return std::clamp(frames, 1, std::max(1, batch.FrameCount));
+	}
+
+	std::vector<BatchFrameStats> BatchRenderer::Render(const Scene& scene, const CameraPath& path, const RenderSettings& settings,
+	                                                   const BatchSettings& batch, const FrameOutput& output)
+	{
+		RenderSettings frameSettings = settings;
+
+		Metrics& metrics = GetMetrics();
+		const RenderMetrics& renderMetrics = GetRenderMetrics();
+		metrics.Set(renderMetrics.SceneObjects, static_cast<double>(scene.Objects.size()));
+		metrics.Set(renderMetrics.SceneLights, static_cast<double>(scene.Lights.size()));
+		frameSettings.Width = batch.Width;
+		frameSettings.Height = batch.Height;
+
+		const int rowsPerBand = std::max(1, batch.RowsPerBand);
+		const int bandsPerFrame = (batch.Height + rowsPerBand - 1) / rowsPerBand;
+		const int framesInFlight = GetFramesInFlight(batch);
+
+		std::vector<FrameSlot> slots(framesInFlight);
+		for (FrameSlot& slot : slots)
+		{
+			slot.Output.Resize(batch.Width, batch.Height);
+			slot.Costs.Resize(batch.Width, batch.Height);
+			if (batch.Reflections)
+				slot.Reflections.Resize(batch.Width, batch.Height);
+		}
+
+		std::vector<BandTiming> bandTimings(static_cast<size_t>(framesInFlight) * bandsPerFrame);
+		std::vector<ObjectCostCounters> bandObjectCosts(batch.ObjectCosts ? bandTimings.size() : 0u);
+		std::vector<BatchFrameStats> results{};
+		results.reserve(batch.FrameCount);
+
+		for (int firstFrame = 0; firstFrame < batch.FrameCount; firstFrame += framesInFlight)
+		{
+			const int frameCount = std::min(framesInFlight, batch.FrameCount - firstFrame);
+			for (int i = 0; i < frameCount; ++i)
+			{
+				FrameSlot& slot = slots[i];
+				slot.Stats = {};
+				slot.Stats.Frame = firstFrame + i;
+				slot.Stats.Time = GetFrameTime(batch, firstFrame + i);
+				slot.Stats.Costs = CreateCostHistograms(frameSettings.MaxSteps, static_cast<int>(scene.Lights.size()), HistogramBins);
+				slot.View = CreateCamera(path.Sample(slot.Stats.Time));
+				if (batch.TileCulling)
+					slot.Culling = BuildObjectCulling(scene, slot.View, frameSettings);
+				if (batch.ProxyRaster)
+					RasteriseProxyDepths(scene, slot.View, frameSettings, slot.ProxyDepths);
+			}
+
+			// Bands of all frames in flight form one pool of work, so threads never idle at a frame boundary
+			Pool.ParallelFor(frameCount * bandsPerFrame, [&](const int band)
+			{
+				PROFILE_ZONE("Band");
+				FrameSlot& slot = slots[band / bandsPerFrame];
+				const int rowBegin = (band % bandsPerFrame) * rowsPerBand;
+				const int rowEnd = std::min(rowBegin + rowsPerBand, batch.Height);
+
+				// Counted per band so threads never share counters
+				std::optional<ObjectCostScope> objectCosts{};
+				if (batch.ObjectCosts)
+				{
+					bandObjectCosts[band].Reset(scene.Objects.size());
+					objectCosts.emplace(bandObjectCosts[band]);
+				}
+
+				bandTimings[band].Start = Clock::now();
+				{
+					PROFILE_ZONE("G-Buffer Rows");
+					RenderGBufferRows(scene, slot.View, frameSettings, slot.Output, rowBegin, rowEnd, &slot.Costs,
+					                  batch.TileCulling ? &slot.Culling : nullptr, batch.ProxyRaster ? &slot.ProxyDepths : nullptr);
+				}
+				if (batch.Reflections)
+				{
+					PROFILE_ZONE("Reflection Rows");
+					TraceReflectionRows(scene, slot.View, frameSettings, slot.Output, slot.Reflections, rowBegin, rowEnd, &slot.Costs);
+				}
+				bandTimings[band].End = Clock::now();
+			});
+
+			for (int i = 0; i < frameCount; ++i)
+			{
+				Clock::time_point start = Clock::time_point::max();
+				Clock::time_point end = Clock::time_point::min();
+				double cpuMs = 0.0;
+				for (int band = i * bandsPerFrame; band < (i + 1) * bandsPerFrame; ++band)
+				{
+					start = std::min(start, bandTimings[band].Start);
+					end = std::max(end, bandTimings[band].End);
+					cpuMs += std::chrono::duration<double, std::milli>(bandTimings[band].End - bandTimings[band].Start).count();
+				}
+
+				slots[i].Stats.WallMs = std::chrono::duration<double, std::milli>(end - start).count();
+				slots[i].Stats.CpuMs = cpuMs;
+
+				if (batch.ObjectCosts)
+				{
+					slots[i].Stats.ObjectCosts.Reset(scene.Objects.size());
+					for (int band = i * bandsPerFrame; band < (i + 1) * bandsPerFrame; ++band)
+						slots[i].Stats.ObjectCosts.Merge(bandObjectCosts[band]);
+				}
+			}
+
+			// Stats and output (usually image writes) for each frame in parallel
+			Pool.ParallelFor(frameCount, [&](const int i)
+			{
+				PROFILE_ZONE("Frame Stats and Output");
+				CalculateImageStats(slots[i], slots[i].Stats);
+				metrics.Add(renderMetrics.Frames);
+				metrics.Observe(renderMetrics.FrameSeconds, slots[i].Stats.WallMs * 1e-3);
+				metrics.Set(renderMetrics.StepsPerPixel, slots[i].Stats.MeanSteps);
+				metrics.Set(renderMetrics.ShadowStepsPerPixel, slots[i].Stats.MeanShadowSteps);
+				metrics.Set(renderMetrics.ResidentBytes, static_cast<double>(GetProcessResidentBytes()));
+				if (output)
+					output(slots[i].Stats.Frame, slots[i].Output, slots[i].Costs);
+			});
+
+			for (int i = 0; i < frameCount; ++i)
+				results.push_back(slots[i].Stats);
+		}
+
+		return results;
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "CPU/CameraPath.h"
+#include "CPU/ObjectCosts.h"
+#include "CPU/RayMarcher.h"
+#include "CPU/ThreadPool.h"
+
+// Offline rendering of a camera path on the CPU path, used by the batch
+// render tool. Frames are split into row bands that are scheduled across the
+// thread pool; several frames are kept in flight at once when a single frame
+// has too few bands to keep every thread busy.
+namespace CPU
+{
+	struct BatchSettings
+	{
+		int Width{ 1280 };
+		int Height{ 720 };
+		int FrameCount{ 1 };
+		// Path time of the first and last frame
+		float StartTime{ 0.0f };
+		float EndTime{ 0.0f };
+		// 0 picks enough frames to give every thread several bands
+		int FramesInFlight{ 0 };
+		int RowsPerBand{ 8 };
+		// Also trace full resolution reflection rays so their cost is counted. Frames stay the G-buffer colour.
+		bool Reflections{ false };
+		// Count the scene evaluations each object was nearest in, see CPU/ObjectCosts.h
+		bool ObjectCosts{ false };
+		// Primary and shadow rays walk per tile object lists, see CPU/ObjectCulling.h. Reflection rays still march every object.
+		bool TileCulling{ false };
+		// Primary rays start marching at rasterised proxy depths, see CPU/ProxyRaster.h
+		bool ProxyRaster{ false };
+	};
+
+	struct BatchFrameStats
+	{
+		int Frame{ 0 };
+		float Time{ 0.0f };
+		// From the first band starting to the last finishing; overlaps other frames when several are in flight
+		double WallMs{ 0.0 };
+		// Sum of band times over all threads
+		double CpuMs{ 0.0 };
+		// Primary ray steps per pixel
+		double MeanSteps{ 0.0 };
+		uint32_t P99Steps{ 0u };
+		uint32_t MaxSteps{ 0u };
+		// Shadow ray SDF evaluations per pixel, summed over lights
+		double MeanShadowSteps{ 0.0 };
+		double HitFraction{ 0.0 };
+		// Every cost counter, with exact bins for step counts
+		CostHistograms Costs{};
+		// Only counted when BatchSettings::ObjectCosts is set
+		ObjectCostCounters ObjectCosts{};
+	};
+
+	class BatchRenderer
+	{
+	public:
+		// Called once per finished frame, possibly from several threads at once for different frames
+		using FrameOutput = std::function<void(int frame, const GBuffer& gbuffer, const Image<PixelCost>& costs)>;
+
+		// Bins per metric in each frame's cost histograms
+		static constexpr int HistogramBins = 4096;
+
+		explicit BatchRenderer(ThreadPool& pool) : Pool(pool) {}
+
+		[[nodiscard]] int GetFramesInFlight(const BatchSettings& batch) const;
+
+		// Renders every frame of the batch and returns their stats in frame order
+		std::vector<BatchFrameStats> Render(const Scene& scene, const CameraPath& path, const RenderSettings& settings,
+		                                    const BatchSettings& batch, const FrameOutput& output);
+
+	private:
+		ThreadPool& Pool;
+	};
+}
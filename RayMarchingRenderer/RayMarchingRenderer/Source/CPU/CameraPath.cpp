@@ -0,0 +1,97 @@
+#include "CPU/CameraPath.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace CPU
+{
+	namespace
+	{
+		Float3 CatmullRom(const Float3& p0, const Float3& p1, const Float3& p2, const Float3& p3, float t)
+		{
+			const float t2 = t * t;
+			const float t3 = t2 * t;
+			return (p1 * Float3(2.0f) + (p2 - p0) * Float3(t) +
+			        (p0 * Float3(2.0f) - p1 * Float3(5.0f) + p2 * Float3(4.0f) - p3) * Float3(t2) +
+			        (p1 * Float3(3.0f) - p0 - p2 * Float3(3.0f) + p3) * Float3(t3)) * Float3(0.5f);
+		}
+	}
+
+	CameraPath::CameraPath(const PackedCamera& camera)
+	{
+		Keys.push_back({ 0.0f, camera });
+	}
+
+	CameraPath CameraPath::Load(const std::filesystem::path& path)
+	{
+		std::ifstream file(path);
+		if (!file)
+			throw std::runtime_error("Camera path \"" + path.string() + "\" could not be opened");
+
+		CameraPath cameraPath{};
+		std::string line{};
+		for (int lineNumber = 1; std::getline(file, line); ++lineNumber)
+		{
+			const size_t first = line.find_first_not_of(" \t\r");
+			if (first == std::string::npos || line[first] == '#')
+				continue;
+
+			CameraKey key{};
+			std::istringstream stream(line);
+			stream >> key.Time >> key.Camera.Position.x >> key.Camera.Position.y >> key.Camera.Position.z
+			       >> key.Camera.Rotation.x >> key.Camera.Rotation.y >> key.Camera.Rotation.z;
+			if (!stream)
+				throw std::runtime_error("Camera path \"" + path.string() + "\" line " + std::to_string(lineNumber) + " is malformed");
+
+			float fovDegrees = 0.0f;
+			if (stream >> fovDegrees)
+				key.Camera.FOV = fovDegrees * 0.01745329f;
+
+			if (!cameraPath.Keys.empty() && key.Time < cameraPath.Keys.back().Time)
+				throw std::runtime_error("Camera path \"" + path.string() + "\" line " + std::to_string(lineNumber) + " goes back in time");
+
+			cameraPath.AddKey(key);
+		}
+
+		if (cameraPath.Keys.empty())
+			throw std::runtime_error("Camera path \"" + path.string() + "\" has no keys");
+
+		return cameraPath;
+	}
+
+	void CameraPath::AddKey(const CameraKey& key)
+	{
+		Keys.push_back(key);
+	}
+
+	PackedCamera CameraPath::Sample(const float time) const
+	{
+		if (Keys.empty())
+			return {};
+		if (time <= Keys.front().Time)
+			return Keys.front().Camera;
+		if (time >= Keys.back().Time)
+			return Keys.back().Camera;
+
+		size_t next = 1;
+		while (Keys[next].Time < time)
+			++next;
+
+		const CameraKey& a = Keys[next - 1];
+		const CameraKey& b = Keys[next];
+		const float span = b.Time - a.Time;
+		const float t = span > 0.0f ? (time - a.Time) / span : 1.0f;
+
+		// End keys are repeated so the spline passes through the first and last positions
+		const Float3& before = Keys[next > 1 ? next - 2 : next - 1].Camera.Position;
+		const Float3& after = Keys[next + 1 < Keys.size() ? next + 1 : next].Camera.Position;
+
+		PackedCamera camera{};
+		camera.Position = CatmullRom(before, a.Camera.Position, b.Camera.Position, after, t);
+		camera.Rotation = Lerp(a.Camera.Rotation, b.Camera.Rotation, t);
+		camera.FOV = Lerp(a.Camera.FOV, b.Camera.FOV, t);
+		return camera;
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <filesystem>
+#include <vector>
+
+#include "CPU/SceneFile.h"
+
+// Keyframed camera animation for offline rendering. Positions follow a
+// Catmull-Rom spline through the keys; rotation and FOV are interpolated
+// linearly. Rotations are in degrees, as in the editor.
+namespace CPU
+{
+	struct CameraKey
+	{
+		float Time{ 0.0f };
+		PackedCamera Camera{};
+	};
+
+	class CameraPath
+	{
+	public:
+		CameraPath() = default;
+		// A path that holds a single camera for any time
+		explicit CameraPath(const PackedCamera& camera);
+
+		// Text file, one key per line: time px py pz rx ry rz [fov in degrees].
+		// Blank lines and lines starting with # are ignored; keys must be in time order.
+		// Throws std::runtime_error on a missing file or malformed line.
+		[[nodiscard]] static CameraPath Load(const std::filesystem::path& path);
+
+		// Keys must be added in increasing time order
+		void AddKey(const CameraKey& key);
+
+		[[nodiscard]] PackedCamera Sample(float time) const;
+		[[nodiscard]] float GetStartTime() const { return Keys.empty() ? 0.0f : Keys.front().Time; }
+		[[nodiscard]] float GetEndTime() const { return Keys.empty() ? 0.0f : Keys.back().Time; }
+		[[nodiscard]] const std::vector<CameraKey>& GetKeys() const { return Keys; }
+
+	private:
+		std::vector<CameraKey> Keys{};
+	};
+}
@@ -0,0 +1,217 @@
+#include "CPU/CostCounters.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace CPU
+{
+	namespace
+	{
+		constexpr const char* MetricNames[CostMetricCount] = {
+			"primary_steps",
+			"normal_evaluations",
+			"shadow_steps",
+			"reflection_steps",
+			"sdf_evaluations",
+			"light0_shadow_steps",
+			"light1_shadow_steps",
+			"light2_shadow_steps",
+			"light3_shadow_steps",
+			"light4_shadow_steps",
+			"light5_shadow_steps",
+			"light6_shadow_steps",
+			"light7_shadow_steps",
+			"light8_shadow_steps",
+			"light9_shadow_steps"
+		};
+
+		constexpr const char* MetricLabels[CostMetricCount] = {
+			"Primary Steps",
+			"Normal Evaluations",
+			"Shadow Steps",
+			"Reflection Steps",
+			"SDF Evaluations",
+			"Shadow Steps (Light 0)",
+			"Shadow Steps (Light 1)",
+			"Shadow Steps (Light 2)",
+			"Shadow Steps (Light 3)",
+			"Shadow Steps (Light 4)",
+			"Shadow Steps (Light 5)",
+			"Shadow Steps (Light 6)",
+			"Shadow Steps (Light 7)",
+			"Shadow Steps (Light 8)",
+			"Shadow Steps (Light 9)"
+		};
+		static_assert(MaxCostLights == 10, "Add metric names for the new lights");
+
+		// Most a single pixel can cost, counting the primary ray and one reflection ray, each shaded by every light
+		uint32_t GetMetricRange(const int metric, const uint32_t maxSteps, const int lightCount)
+		{
+			const uint32_t lights = static_cast<uint32_t>(std::max(1, lightCount));
+			switch (static_cast<CostMetric>(std::min(metric, static_cast<int>(CostMetric::LightShadowSteps))))
+			{
+			case CostMetric::NormalEvaluations:
+				return 2u;
+			case CostMetric::ShadowSteps:
+				return maxSteps * lights * 2u;
+			case CostMetric::SDFEvaluations:
+				return (maxSteps + 1u) * (lights + 1u) * 2u + 12u;
+			default:
+				return maxSteps;
+			}
+		}
+	}
+
+	const char* GetCostMetricName(const int metric)
+	{
+		return MetricNames[metric];
+	}
+
+	const char* GetCostMetricLabel(const int metric)
+	{
+		return MetricLabels[metric];
+	}
+
+	int FindCostMetric(const char* name)
+	{
+		for (int i = 0; i < CostMetricCount; ++i)
+			if (std::strcmp(MetricNames[i], name) == 0)
+				return i;
+		return -1;
+	}
+
+	uint32_t GetCostValue(const PixelCost& cost, const int metric)
+	{
+		switch (static_cast<CostMetric>(metric))
+		{
+		case CostMetric::PrimarySteps:
+			return cost.PrimarySteps;
+		case CostMetric::NormalEvaluations:
+			return cost.NormalEvaluations;
+		case CostMetric::ShadowSteps:
+			return cost.ShadowSteps;
+		case CostMetric::ReflectionSteps:
+			return cost.ReflectionSteps;
+		case CostMetric::SDFEvaluations:
+			return cost.SDFEvaluations;
+		default:
+			return cost.LightShadowSteps[metric - static_cast<int>(CostMetric::LightShadowSteps)];
+		}
+	}
+
+	void CostHistogram::Add(const uint32_t value)
+	{
+		++Bins[std::min<size_t>(value / BinWidth, Bins.size() - 1u)];
+		++Count;
+		Sum += value;
+		Max = std::max(Max, value);
+	}
+
+	void CostHistogram::Merge(const CostHistogram& other)
+	{
+		for (size_t i = 0; i < Bins.size() && i < other.Bins.size(); ++i)
+			Bins[i] += other.Bins[i];
+		Count += other.Count;
+		Sum += other.Sum;
+		Max = std::max(Max, other.Max);
+	}
+
+	double CostHistogram::GetMean() const
+	{
+		return Count > 0u ? static_cast<double>(Sum) / static_cast<double>(Count) : 0.0;
+	}
+
+	uint32_t CostHistogram::GetPercentile(const double fraction) const
+	{
+		const auto rank = static_cast<uint64_t>(std::ceil(static_cast<double>(Count) * fraction));
+		uint64_t seen = 0u;
+		for (size_t i = 0; i < Bins.size(); ++i)
+		{
+			seen += Bins[i];
+			if (seen >= std::max<uint64_t>(rank, 1u))
+				return std::min(static_cast<uint32_t>(i) * BinWidth + BinWidth - 1u, Max);
+		}
+		return Max;
+	}
+
+	void CostHistograms::Add(const PixelCost& cost)
+	{
+		for (int i = 0; i < CostMetricCount; ++i)
+			Metrics[i].Add(GetCostValue(cost, i));
+	}
+
+	void CostHistograms::Add(const Image<PixelCost>& costs)
+	{
+		for (int y = 0; y < costs.GetHeight(); ++y)
+			for (int x = 0; x < costs.GetWidth(); ++x)
+				Add(costs.At(x, y));
+	}
+
+	void CostHistograms::Merge(const CostHistograms& other)
+	{
+		for (int i = 0; i < CostMetricCount; ++i)
+			Metrics[i].Merge(other.Metrics[i]);
+	}
+
+	CostHistograms CreateCostHistograms(const uint32_t maxSteps, const int lightCount, const int maxBins)
+	{
+		CostHistograms histograms{};
+		for (int i = 0; i < CostMetricCount; ++i)
+		{
+			const uint32_t values = GetMetricRange(i, maxSteps, lightCount) + 1u;
+			const uint32_t bins = static_cast<uint32_t>(std::max(1, maxBins));
+			CostHistogram& histogram = histograms.Metrics[i];
+			histogram.BinWidth = (values + bins - 1u) / bins;
+			histogram.Bins.assign((values + histogram.BinWidth - 1u) / histogram.BinWidth, 0u);
+		}
+		return histograms;
+	}
+
+	void WriteCostHistogramsJson(const std::filesystem::path& path, const CostHistograms& histograms)
+	{
+		std::ofstream file(path);
+		if (!file)
+			throw std::runtime_error("Histogram file \"" + path.string() + "\" could not be opened for writing");
+
+		file << "{\n  \"version\": 1,\n  \"metrics\": [\n";
+		for (int i = 0; i < CostMetricCount; ++i)
+		{
+			const CostHistogram& histogram = histograms.Metrics[i];
+
+			// Trailing empty bins are left out
+			size_t binCount = histogram.Bins.size();
+			while (binCount > 0u && histogram.Bins[binCount - 1u] == 0u)
+				--binCount;
+
+			file << "    { \"name\": \"" << GetCostMetricName(i) << "\", \"pixels\": " << histogram.Count << ", \"sum\": " << histogram.Sum
+			     << ", \"mean\": " << histogram.GetMean() << ", \"p50\": " << histogram.GetPercentile(0.5) << ", \"p90\": " << histogram.GetPercentile(0.9)
+			     << ", \"p99\": " << histogram.GetPercentile(0.99) << ", \"max\": " << histogram.Max << ", \"bin_width\": " << histogram.BinWidth
+			     << ", \"bins\": [";
+			for (size_t bin = 0; bin < binCount; ++bin)
+				file << (bin > 0u ? ", " : "") << histogram.Bins[bin];
+			file << "] }" << (i + 1 < CostMetricCount ? "," : "") << '\n';
+		}
+		file << "  ]\n}\n";
+
+		if (!file)
+			throw std::runtime_error("Failed writing histogram file \"" + path.string() + "\"");
+	}
+
+	Float3 CalculateHeatmapColour(const float t)
+	{
+		const float s = Saturate(t) * 4.0f;
+		return Float3(Saturate(1.5f - std::abs(s - 3.0f)), Saturate(1.5f - std::abs(s - 2.0f)), Saturate(1.5f - std::abs(s - 1.0f)));
+	}
+
+	void RenderCostHeatmap(const Image<PixelCost>& costs, const int metric, const float maxValue, Image<Float4>& output)
+	{
+		output.Resize(costs.GetWidth(), costs.GetHeight());
+		const float scale = 1.0f / std::max(maxValue, 1.0f);
+		for (int y = 0; y < costs.GetHeight(); ++y)
+			for (int x = 0; x < costs.GetWidth(); ++x)
+				output.At(x, y) = Float4(CalculateHeatmapColour(static_cast<float>(GetCostValue(costs.At(x, y), metric)) * scale), 1.0f);
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "CPU/Image.h"
+
+// Per-pixel cost instrumentation, shared by the CPU renderer and the GPU cost
+// counters (CostCounters.hlsli). A pixel's cost is the marching work done for
+// it; GPU reflection rays traced at reduced resolution are spread evenly over
+// the pixels they cover.
+namespace CPU
+{
+	// RAYMARCH_MAX_LIGHTS. Lights past this still count towards the totals.
+	inline constexpr int MaxCostLights = 10;
+
+	struct PixelCost
+	{
+		uint32_t PrimarySteps{ 0u };      // Camera ray steps, as used for ambient occlusion
+		uint32_t NormalEvaluations{ 0u }; // CalculateNormal calls, 1 SDF evaluation and one object's gradient each
+		uint32_t ShadowSteps{ 0u };       // Shadow ray SDF evaluations, summed over lights
+		uint32_t ReflectionSteps{ 0u };   // Reflection ray steps
+		uint32_t SDFEvaluations{ 0u };    // Every scene distance evaluation, including all of the above
+		std::array<uint16_t, MaxCostLights> LightShadowSteps{};
+	};
+
+	enum class CostMetric : int
+	{
+		PrimarySteps = 0,
+		NormalEvaluations,
+		ShadowSteps,
+		ReflectionSteps,
+		SDFEvaluations,
+		LightShadowSteps, // First of MaxCostLights per light metrics
+		Count = LightShadowSteps + MaxCostLights
+	};
+	inline constexpr int CostMetricCount = static_cast<int>(CostMetric::Count);
+
+	// Identifier used in files and on the command line, e.g. "primary_steps" or "light2_shadow_steps"
+	[[nodiscard]] const char* GetCostMetricName(int metric);
+	// Label for the GUI, e.g. "Shadow Steps (Light 2)"
+	[[nodiscard]] const char* GetCostMetricLabel(int metric);
+	// -1 if there is no metric of that name
+	[[nodiscard]] int FindCostMetric(const char* name);
+
+	[[nodiscard]] uint32_t GetCostValue(const PixelCost& cost, int metric);
+
+	// Linear bins of equal width from zero; the last bin also holds everything above it
+	struct CostHistogram
+	{
+		uint32_t BinWidth{ 1u };
+		std::vector<uint64_t> Bins{};
+		uint64_t Count{ 0u };
+		uint64_t Sum{ 0u };
+		uint32_t Max{ 0u };
+
+		void Add(uint32_t value);
+		void Merge(const CostHistogram& other);
+
+		[[nodiscard]] double GetMean() const;
+		// Smallest value at or below which fraction of the samples lie, to the resolution of a bin
+		[[nodiscard]] uint32_t GetPercentile(double fraction) const;
+	};
+
+	struct CostHistograms
+	{
+		std::array<CostHistogram, CostMetricCount> Metrics{};
+
+		void Add(const PixelCost& cost);
+		void Add(const Image<PixelCost>& costs);
+		// Both must have been created with the same settings
+		void Merge(const CostHistograms& other);
+	};
+
+	// Bins cover the most a pixel can cost with these settings, using at most maxBins bins per metric.
+	// Step counts have exact single value bins when maxBins allows it.
+	[[nodiscard]] CostHistograms CreateCostHistograms(uint32_t maxSteps, int lightCount, int maxBins);
+
+	// Throws std::runtime_error if the file can't be written
+	void WriteCostHistogramsJson(const std::filesystem::path& path, const CostHistograms& histograms);
+
+	// Blue (cheap) to red (maxValue and above), the same ramp as CostHeatmapShader.hlsl
+	[[nodiscard]] Float3 CalculateHeatmapColour(float t);
+	void RenderCostHeatmap(const Image<PixelCost>& costs, int metric, float maxValue, Image<Float4>& output);
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "CPU/Math.h"
+
+// Forward mode automatic differentiation for the SDFs: a value carried with
+// its gradient with respect to the point the SDF is evaluated at, so one
+// evaluation gives the distance and the surface normal together. Where a
+// function has no derivative (the crease of a min, the centre of a sphere)
+// the gradient is one-sided or zero rather than NaN.
+namespace CPU
+{
+	struct Dual
+	{
+		float Value{ 0.0f };
+		Float3 Gradient{ 0.0f };
+
+		constexpr Dual() = default;
+		constexpr Dual(float value) : Value(value) {}
+		constexpr Dual(float value, const Float3& gradient) : Value(value), Gradient(gradient) {}
+
+		constexpr Dual operator+(const Dual& o) const { return { Value + o.Value, Gradient + o.Gradient }; }
+		constexpr Dual operator-(const Dual& o) const { return { Value - o.Value, Gradient - o.Gradient }; }
+		constexpr Dual operator*(const Dual& o) const { return { Value * o.Value, Gradient * Float3(o.Value) + o.Gradient * Float3(Value) }; }
+		constexpr Dual operator/(const Dual& o) const
+		{
+			return { Value / o.Value, (Gradient * Float3(o.Value) - o.Gradient * Float3(Value)) / Float3(o.Value * o.Value) };
+		}
+		constexpr Dual operator-() const { return { -Value, -Gradient }; }
+	};
+
+	// The coordinates of p as the variables to differentiate by
+	inline void MakeDualPoint(const Float3& p, Dual& x, Dual& y, Dual& z)
+	{
+		x = Dual(p.x, Float3(1.0f, 0.0f, 0.0f));
+		y = Dual(p.y, Float3(0.0f, 1.0f, 0.0f));
+		z = Dual(p.z, Float3(0.0f, 0.0f, 1.0f));
+	}
+
+	inline Dual Sqrt(const Dual& a)
+	{
+		const float root = std::sqrt(a.Value);
+		return { root, root > 0.0f ? a.Gradient / Float3(2.0f * root) : Float3(0.0f) };
+	}
+
+	inline Dual Abs(const Dual& a) { return a.Value < 0.0f ? -a : a; }
+	inline Dual Min(const Dual& a, const Dual& b) { return b.Value < a.Value ? b : a; }
+	inline Dual Max(const Dual& a, const Dual& b) { return b.Value > a.Value ? b : a; }
+	inline Dual Clamp(const Dual& a, const float lo, const float hi) { return Min(Max(a, Dual(lo)), Dual(hi)); }
+
+	inline Dual Length(const Dual& x, const Dual& y) { return Sqrt(x * x + y * y); }
+	inline Dual Length(const Dual& x, const Dual& y, const Dual& z) { return Sqrt(x * x + y * y + z * z); }
+}
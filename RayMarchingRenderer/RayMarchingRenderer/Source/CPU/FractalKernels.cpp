@@ -0,0 +1,350 @@
+#include "CPU/FractalKernels.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RAYMARCH_FRACTAL_SSE2 1
+#include <emmintrin.h>
+#else
+#define RAYMARCH_FRACTAL_SSE2 0
+#endif
+
+namespace CPU
+{
+	namespace
+	{
+		constexpr int MandelbulbIterations = 4;
+		constexpr float MandelbulbBailout = 256.0f;
+		constexpr int JuliaIterations = 11;
+		constexpr float JuliaBailout = 4.0f;
+		constexpr int SierpinskiIterations = 8;
+		constexpr int MengerIterations = 4;
+		// Circumradius of the tetrahedron each Sierpinski level folds onto, in that level's space
+		constexpr float SierpinskiBound = 1.73205081f;
+
+		constexpr float Ln2 = 0.693147181f;
+		constexpr float Sqrt2 = 1.41421356f;
+
+		// Single lane. Masks are bools, so the kernels below read the same for both widths.
+		float Sqrt(const float x) { return std::sqrt(x); }
+		float Abs(const float x) { return std::abs(x); }
+		float Min(const float a, const float b) { return a < b ? a : b; }
+		float Max(const float a, const float b) { return a > b ? a : b; }
+		float Floor(const float x) { return std::floor(x); }
+		float Select(const bool mask, const float a, const float b) { return mask ? a : b; }
+		bool And(const bool a, const bool b) { return a && b; }
+		bool Any(const bool mask) { return mask; }
+
+		// x = mantissa * 2^exponent with mantissa in [sqrt(0.5), sqrt(2))
+		void SplitExponent(const float x, float& mantissa, float& exponent)
+		{
+			uint32_t bits = 0u;
+			std::memcpy(&bits, &x, sizeof(bits));
+			int e = static_cast<int>((bits >> 23u) & 0xFFu) - 127;
+			bits = (bits & 0x007FFFFFu) | 0x3F800000u;
+			std::memcpy(&mantissa, &bits, sizeof(bits));
+			if (mantissa > Sqrt2)
+			{
+				mantissa *= 0.5f;
+				++e;
+			}
+			exponent = static_cast<float>(e);
+		}
+
+#if RAYMARCH_FRACTAL_SSE2
+		// Four lanes in one SSE2 register
+		struct Lanes
+		{
+			__m128 V;
+
+			Lanes(const __m128 v) : V(v) {}
+			Lanes(const float v) : V(_mm_set1_ps(v)) {}
+		};
+
+		struct LaneMask
+		{
+			__m128 V;
+		};
+
+		Lanes operator+(const Lanes a, const Lanes b) { return _mm_add_ps(a.V, b.V); }
+		Lanes operator-(const Lanes a, const Lanes b) { return _mm_sub_ps(a.V, b.V); }
+		Lanes operator*(const Lanes a, const Lanes b) { return _mm_mul_ps(a.V, b.V); }
+		Lanes operator/(const Lanes a, const Lanes b) { return _mm_div_ps(a.V, b.V); }
+		Lanes operator-(const Lanes a) { return _mm_sub_ps(_mm_setzero_ps(), a.V); }
+		LaneMask operator<(const Lanes a, const Lanes b) { return { _mm_cmplt_ps(a.V, b.V) }; }
+		LaneMask operator<=(const Lanes a, const Lanes b) { return { _mm_cmple_ps(a.V, b.V) }; }
+		LaneMask operator>=(const Lanes a, const Lanes b) { return { _mm_cmpge_ps(a.V, b.V) }; }
+
+		Lanes Sqrt(const Lanes x) { return _mm_sqrt_ps(x.V); }
+		Lanes Abs(const Lanes x) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), x.V); }
+		Lanes Min(const Lanes a, const Lanes b) { return _mm_min_ps(a.V, b.V); }
+		Lanes Max(const Lanes a, const Lanes b) { return _mm_max_ps(a.V, b.V); }
+		Lanes Select(const LaneMask mask, const Lanes a, const Lanes b) { return _mm_or_ps(_mm_and_ps(mask.V, a.V), _mm_andnot_ps(mask.V, b.V)); }
+		LaneMask And(const LaneMask a, const LaneMask b) { return { _mm_and_ps(a.V, b.V) }; }
+		bool Any(const LaneMask mask) { return _mm_movemask_ps(mask.V) != 0; }
+
+		// SSE2 has no floor, so truncate and step down where that rounded up. Inputs stay well inside int range.
+		Lanes Floor(const Lanes x)
+		{
+			const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(x.V));
+			return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, x.V), _mm_set1_ps(1.0f)));
+		}
+
+		void SplitExponent(const Lanes x, Lanes& mantissa, Lanes& exponent)
+		{
+			const __m128i bits = _mm_castps_si128(x.V);
+			const __m128i e = _mm_sub_epi32(_mm_and_si128(_mm_srli_epi32(bits, 23), _mm_set1_epi32(0xFF)), _mm_set1_epi32(127));
+			const __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000)));
+			const __m128 above = _mm_cmpgt_ps(m, _mm_set1_ps(Sqrt2));
+			mantissa = _mm_or_ps(_mm_and_ps(above, _mm_mul_ps(m, _mm_set1_ps(0.5f))), _mm_andnot_ps(above, m));
+			exponent = _mm_add_ps(_mm_cvtepi32_ps(e), _mm_and_ps(above, _mm_set1_ps(1.0f)));
+		}
+#endif
+
+		// log(m * 2^e) = e ln 2 + 2 atanh(t) with t = (m - 1) / (m + 1), |t| <= 0.172, to the t^7 term
+		template <typename T>
+		T Log(const T x)
+		{
+			T mantissa(0.0f), exponent(0.0f);
+			SplitExponent(x, mantissa, exponent);
+			const T t = (mantissa - T(1.0f)) / (mantissa + T(1.0f));
+			const T t2 = t * t;
+			const T series = T(2.0f) * t * (T(1.0f) + t2 * (T(1.0f / 3.0f) + t2 * (T(1.0f / 5.0f) + t2 * T(1.0f / 7.0f))));
+			return exponent * T(Ln2) + series;
+		}
+
+		// w^8 in the power 8 polynomial form (no acos, atan or pow)
+		template <typename T>
+		void Power8(const T x, const T y, const T z, T& outX, T& outY, T& outZ)
+		{
+			const T x2 = x * x, x4 = x2 * x2;
+			const T y2 = y * y, y4 = y2 * y2;
+			const T z2 = z * z, z4 = z2 * z2;
+
+			const T k3 = x2 + z2;
+			const T k3Squared = k3 * k3;
+			const T k2 = T(1.0f) / Sqrt(k3Squared * k3Squared * k3Squared * k3);
+			const T k1 = x4 + y4 + z4 - T(6.0f) * y2 * z2 - T(6.0f) * x2 * y2 + T(2.0f) * z2 * x2;
+			const T k4 = x2 - y2 + z2;
+
+			outX = T(64.0f) * x * y * z * (x2 - z2) * k4 * (x4 - T(6.0f) * x2 * z2 + z4) * k1 * k2;
+			outY = T(-16.0f) * y2 * k3 * k4 * k4 + k1 * k1;
+			outZ = T(-8.0f) * y * k4 * (x4 * x4 - T(28.0f) * x4 * x2 * z2 + T(70.0f) * x4 * z4 - T(28.0f) * x2 * z2 * z4 + z4 * z4) * k1 * k2;
+		}
+
+		// Escape time bulb, w -> w^8 + c with c = p for the mandelbulb and param for the juliabulb.
+		// Lanes that escape, or whose next iteration would only add detail under the footprint, keep
+		// their values while the others iterate on.
+		template <typename T>
+		T Bulb(const T px, const T py, const T pz, const T cx, const T cy, const T cz, const float dzOffset, const float footprint)
+		{
+			T wx = px, wy = py, wz = pz;
+			T m = wx * wx + wy * wy + wz * wz;
+			T dz(1.0f);
+			auto active = m >= T(0.0f);
+
+			for (int i = 0; i < MandelbulbIterations; ++i)
+			{
+				// |w|^7 = m^3.5
+				const T dzNext = T(8.0f) * m * m * m * Sqrt(m) * dz + T(dzOffset);
+				T nx(0.0f), ny(0.0f), nz(0.0f);
+				Power8(wx, wy, wz, nx, ny, nz);
+
+				wx = Select(active, nx + cx, wx);
+				wy = Select(active, ny + cy, wy);
+				wz = Select(active, nz + cz, wz);
+				dz = Select(active, dzNext, dz);
+
+				m = wx * wx + wy * wy + wz * wz;
+				active = And(active, And(m <= T(MandelbulbBailout), dz * T(footprint) <= T(1.0f)));
+				if (!Any(active))
+					break;
+			}
+
+			return T(0.25f) * Log(m) * Sqrt(m) / dz;
+		}
+
+		template <typename T>
+		T QuaternionJulia(const T px, const T py, const T pz, const Float3& c, const float footprint)
+		{
+			T zx = px, zy = py, zz = pz, zw(0.0f);
+			T md2(1.0f);
+			T mz2 = zx * zx + zy * zy + zz * zz;
+			auto active = mz2 >= T(0.0f);
+
+			for (int i = 0; i < JuliaIterations; ++i)
+			{
+				// |dz| -> 2 |z| |dz|, kept squared
+				md2 = Select(active, md2 * T(4.0f) * mz2, md2);
+				const T nx = zx * zx - zy * zy - zz * zz - zw * zw + T(c.x);
+				const T ny = T(2.0f) * zx * zy + T(c.y);
+				const T nz = T(2.0f) * zx * zz + T(c.z);
+				const T nw = T(2.0f) * zx * zw;
+
+				zx = Select(active, nx, zx);
+				zy = Select(active, ny, zy);
+				zz = Select(active, nz, zz);
+				zw = Select(active, nw, zw);
+
+				mz2 = zx * zx + zy * zy + zz * zz + zw * zw;
+				active = And(active, And(mz2 <= T(JuliaBailout), md2 * T(footprint * footprint) <= T(1.0f)));
+				if (!Any(active))
+					break;
+			}
+
+			return T(0.25f) * Sqrt(mz2 / md2) * Log(mz2);
+		}
+
+		// Stops at the first level whose tetrahedra are all smaller than the footprint and takes the distance to
+		// those as solids, shrunk to the points the last iteration measures to. They contain every one of those
+		// points, so the coarser estimate stays under the full one.
+		template <typename T>
+		T Sierpinski(T x, T y, T z, const float footprint)
+		{
+			float scale = 1.0f;
+			for (int i = 0; i < SierpinskiIterations; ++i)
+			{
+				if (SierpinskiBound < footprint * scale)
+				{
+					// Distance to the tetrahedron x + y - z, x - y + z, -x + y + z, -x - y - z <= shrink
+					const T planes = Max(Max(x + y - z, x - y + z), Max(-x + y + z, -x - y - z));
+					const float shrink = 1.0f - scale / static_cast<float>(1 << SierpinskiIterations);
+					return (planes - T(shrink)) * T(1.0f / (SierpinskiBound * scale));
+				}
+
+				// Fold across the planes x + y = 0, x + z = 0 and y + z = 0
+				const auto xy = x + y < T(0.0f);
+				const T foldX = Select(xy, -y, x);
+				y = Select(xy, -x, y);
+				x = foldX;
+
+				const auto xz = x + z < T(0.0f);
+				const T foldZ = Select(xz, -x, z);
+				x = Select(xz, -z, x);
+				z = foldZ;
+
+				const auto yz = y + z < T(0.0f);
+				const T foldY = Select(yz, -z, y);
+				z = Select(yz, -y, z);
+				y = foldY;
+
+				x = x * T(2.0f) - T(1.0f);
+				y = y * T(2.0f) - T(1.0f);
+				z = z * T(2.0f) - T(1.0f);
+				scale *= 2.0f;
+			}
+
+			return Sqrt(x * x + y * y + z * z) * T(1.0f / scale);
+		}
+
+		// Holes narrower than the footprint are left filled in, which only ever shortens the distance
+		template <typename T>
+		T Menger(const T x, const T y, const T z, const float footprint)
+		{
+			const T qx = Abs(x) - T(1.0f), qy = Abs(y) - T(1.0f), qz = Abs(z) - T(1.0f);
+			const T ox = Max(qx, T(0.0f)), oy = Max(qy, T(0.0f)), oz = Max(qz, T(0.0f));
+			T d = Sqrt(ox * ox + oy * oy + oz * oz) + Min(Max(qx, Max(qy, qz)), T(0.0f));
+
+			// Carve a cross out of every cell at each scale
+			float s = 1.0f;
+			for (int i = 0; i < MengerIterations && footprint * s * 3.0f <= 1.0f; ++i)
+			{
+				const auto cell = [s](const T v)
+				{
+					const T scaled = v * T(s);
+					return scaled - T(2.0f) * Floor(scaled * T(0.5f)) - T(1.0f);
+				};
+				const T ax = cell(x), ay = cell(y), az = cell(z);
+				s *= 3.0f;
+
+				const T rx = Abs(T(1.0f) - T(3.0f) * Abs(ax));
+				const T ry = Abs(T(1.0f) - T(3.0f) * Abs(ay));
+				const T rz = Abs(T(1.0f) - T(3.0f) * Abs(az));
+				const T da = Max(rx, ry), db = Max(ry, rz), dc = Max(rz, rx);
+				d = Max(d, (Min(da, Min(db, dc)) - T(1.0f)) / T(s));
+			}
+
+			return d;
+		}
+
+		template <typename Kernel>
+		void EvaluateBatch(const Float3* points, const size_t count, float* distances, const Kernel& kernel)
+		{
+			size_t i = 0;
+#if RAYMARCH_FRACTAL_SSE2
+			for (; i + 4u <= count; i += 4u)
+			{
+				const Float3* p = points + i;
+				const Lanes x(_mm_setr_ps(p[0].x, p[1].x, p[2].x, p[3].x));
+				const Lanes y(_mm_setr_ps(p[0].y, p[1].y, p[2].y, p[3].y));
+				const Lanes z(_mm_setr_ps(p[0].z, p[1].z, p[2].z, p[3].z));
+				_mm_storeu_ps(distances + i, kernel(x, y, z).V);
+			}
+#endif
+			for (; i < count; ++i)
+				distances[i] = kernel(points[i].x, points[i].y, points[i].z);
+		}
+	}
+
+	float FastLog(const float x)
+	{
+		return Log(x);
+	}
+
+	float SdfMandelbulb(const Float3& p, const Float3&, const float footprint)
+	{
+		return Bulb(p.x, p.y, p.z, p.x, p.y, p.z, 1.0f, footprint);
+	}
+
+	float SdfJuliabulb(const Float3& p, const Float3& param, const float footprint)
+	{
+		return Bulb(p.x, p.y, p.z, param.x, param.y, param.z, 0.0f, footprint);
+	}
+
+	float SdfQuaternionJulia(const Float3& p, const Float3& param, const float footprint)
+	{
+		return QuaternionJulia(p.x, p.y, p.z, param, footprint);
+	}
+
+	float SdfSierpinski(const Float3& p, const Float3&, const float footprint)
+	{
+		return Sierpinski(p.x, p.y, p.z, footprint);
+	}
+
+	float SdfMenger(const Float3& p, const Float3&, const float footprint)
+	{
+		return Menger(p.x, p.y, p.z, footprint);
+	}
+
+	void SdfMandelbulbBatch(const Float3* points, const size_t count, const Float3&, const float footprint, float* distances)
+	{
+		EvaluateBatch(points, count, distances, [footprint](const auto x, const auto y, const auto z) { return Bulb(x, y, z, x, y, z, 1.0f, footprint); });
+	}
+
+	void SdfJuliabulbBatch(const Float3* points, const size_t count, const Float3& param, const float footprint, float* distances)
+	{
+		EvaluateBatch(points, count, distances, [&param, footprint](const auto x, const auto y, const auto z)
+		{
+			using T = std::remove_const_t<decltype(x)>;
+			return Bulb(x, y, z, T(param.x), T(param.y), T(param.z), 0.0f, footprint);
+		});
+	}
+
+	void SdfQuaternionJuliaBatch(const Float3* points, const size_t count, const Float3& param, const float footprint, float* distances)
+	{
+		EvaluateBatch(points, count, distances, [&param, footprint](const auto x, const auto y, const auto z) { return QuaternionJulia(x, y, z, param, footprint); });
+	}
+
+	void SdfSierpinskiBatch(const Float3* points, const size_t count, const Float3&, const float footprint, float* distances)
+	{
+		EvaluateBatch(points, count, distances, [footprint](const auto x, const auto y, const auto z) { return Sierpinski(x, y, z, footprint); });
+	}
+
+	void SdfMengerBatch(const Float3* points, const size_t count, const Float3&, const float footprint, float* distances)
+	{
+		EvaluateBatch(points, count, distances, [footprint](const auto x, const auto y, const auto z) { return Menger(x, y, z, footprint); });
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+
+#include "CPU/SceneData.h"
+
+// Built-in fractal distance estimators, the CPU side of the fractal SDF types.
+// Unlike the example snippets they are trig free: the mandelbulb and juliabulb
+// use the power 8 polynomial form, so the only transcendental left is the log
+// of the final distance estimate, which FastLog approximates. Each kernel is
+// written once over a lane type and built both for single points and four
+// points per SSE2 instruction (scalar on CPUs without SSE2).
+//
+// footprint is the radius of the ray's pixel cone at p, in the kernel's space.
+// Iterations whose detail would be smaller than that are skipped, so distant
+// fractals cost a fraction of close ones. 0 always runs every iteration.
+namespace CPU
+{
+	// Natural log of a positive normal float. The series is truncated below 3e-8 absolute, so the
+	// error is that plus a couple of ulp of the result. Zero and denormals give about -88.
+	[[nodiscard]] float FastLog(float x);
+
+	// Power 8 mandelbulb, param is unused
+	[[nodiscard]] float SdfMandelbulb(const Float3& p, const Float3& param, float footprint);
+	// Power 8 juliabulb, param is the constant added each iteration
+	[[nodiscard]] float SdfJuliabulb(const Float3& p, const Float3& param, float footprint);
+	// Quaternion Julia set z -> z^2 + c with c = (param, 0)
+	[[nodiscard]] float SdfQuaternionJulia(const Float3& p, const Float3& param, float footprint);
+	// Sierpinski tetrahedron folded at scale 2, param is unused
+	[[nodiscard]] float SdfSierpinski(const Float3& p, const Float3& param, float footprint);
+	// Menger sponge in a unit box, param is unused
+	[[nodiscard]] float SdfMenger(const Float3& p, const Float3& param, float footprint);
+
+	// The same kernels over count points. Results match the single point versions.
+	void SdfMandelbulbBatch(const Float3* points, size_t count, const Float3& param, float footprint, float* distances);
+	void SdfJuliabulbBatch(const Float3* points, size_t count, const Float3& param, float footprint, float* distances);
+	void SdfQuaternionJuliaBatch(const Float3* points, size_t count, const Float3& param, float footprint, float* distances);
+	void SdfSierpinskiBatch(const Float3* points, size_t count, const Float3& param, float footprint, float* distances);
+	void SdfMengerBatch(const Float3* points, size_t count, const Float3& param, float footprint, float* distances);
+}
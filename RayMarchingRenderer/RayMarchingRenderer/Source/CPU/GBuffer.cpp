@@ -0,0 +1,234 @@
+#include "CPU/GBuffer.h"
+
+#include <bit>
+#include <cstdio>
+
+namespace CPU
+{
+	std::vector<GBufferTargetDesc> GetCompactGBufferLayout(const GBufferDepthFormat depthFormat)
+	{
+		return {
+			{ "Colour", "R16G16B16A16_FLOAT", 8 },
+			{ "Normal", "R16G16_SNORM", 4 },
+			depthFormat == GBufferDepthFormat::Float32 ? GBufferTargetDesc{ "Depth", "R32_FLOAT", 4 } : GBufferTargetDesc{ "Depth", "R16_UNORM", 2 },
+			{ "Material", "R8G8B8A8_UNORM", 4 },
+			{ "Reflection", "R16G16B16A16_FLOAT", 8 }
+		};
+	}
+
+	std::vector<GBufferTargetDesc> GetLegacyGBufferLayout()
+	{
+		return {
+			{ "Colour", "R32G32B32A32_FLOAT", 16 },
+			{ "NormDepth", "R32G32B32A32_FLOAT", 16 },
+			{ "Reflection", "R32G32B32A32_FLOAT", 16 },
+			{ "MetalRough", "R32G32_FLOAT", 8 }
+		};
+	}
+
+	int GetBytesPerPixel(const std::vector<GBufferTargetDesc>& layout)
+	{
+		int total = 0;
+		for (const auto& target : layout)
+			total += target.BytesPerPixel;
+		return total;
+	}
+
+	std::string FormatGBufferBudget(const std::vector<GBufferTargetDesc>& layout, const int width, const int height)
+	{
+		const double pixels = static_cast<double>(width) * height;
+		const double toMB = 1.0 / (1024.0 * 1024.0);
+
+		std::string report;
+		char line[128];
+		for (const auto& target : layout)
+		{
+			std::snprintf(line, sizeof(line), "%-10s %-20s %2d B/px %8.2f MB\n",
+			              target.Name.c_str(), target.Format.c_str(), target.BytesPerPixel, target.BytesPerPixel * pixels * toMB);
+			report += line;
+		}
+
+		const int total = GetBytesPerPixel(layout);
+		std::snprintf(line, sizeof(line), "%-10s %-20s %2d B/px %8.2f MB (%dx%d)\n", "Total", "", total, total * pixels * toMB, width, height);
+		report += line;
+
+		return report;
+	}
+
+	// Round to nearest even, as D3D requires for float -> half conversion.
+	// Adapted from Fabian Giesen's float_to_half_fast3_rtne.
+	uint16_t FloatToHalf(const float value)
+	{
+		constexpr uint32_t f32Infinity = 255u << 23;
+		constexpr uint32_t f16Max = (127u + 16u) << 23;
+		constexpr uint32_t denormMagic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+		uint32_t bits = std::bit_cast<uint32_t>(value);
+		const uint32_t sign = bits & 0x80000000u;
+		bits ^= sign;
+
+		uint16_t result;
+		if (bits >= f16Max)
+		{
+			// Overflow to infinity, NaN stays NaN
+			result = bits > f32Infinity ? 0x7E00u : 0x7C00u;
+		}
+		else if (bits < (113u << 23))
+		{
+			// Denormal, the FP adder does the rounding
+			const float denormal = std::bit_cast<float>(bits) + std::bit_cast<float>(denormMagic);
+			result = static_cast<uint16_t>(std::bit_cast<uint32_t>(denormal) - denormMagic);
+		}
+		else
+		{
+			const uint32_t mantissaOdd = (bits >> 13) & 1u;
+			bits += (static_cast<uint32_t>(15 - 127) << 23) + 0xFFFu;
+			bits += mantissaOdd;
+			result = static_cast<uint16_t>(bits >> 13);
+		}
+
+		return static_cast<uint16_t>(result | (sign >> 16));
+	}
+
+	float HalfToFloat(const uint16_t value)
+	{
+		constexpr uint32_t magic = (254u - 15u) << 23;
+		constexpr uint32_t wasInfNaN = (127u + 16u) << 23;
+
+		// Exponent/mantissa shifted into place, then rescaled so denormals come out right
+		const float scaled = std::bit_cast<float>((value & 0x7FFFu) << 13) * std::bit_cast<float>(magic);
+		uint32_t bits = std::bit_cast<uint32_t>(scaled);
+		if (scaled >= std::bit_cast<float>(wasInfNaN))
+			bits |= 255u << 23;
+		bits |= static_cast<uint32_t>(value & 0x8000u) << 16;
+
+		return std::bit_cast<float>(bits);
+	}
+
+	int16_t FloatToSnorm16(const float value)
+	{
+		const float clamped = std::isnan(value) ? 0.0f : std::clamp(value, -1.0f, 1.0f);
+		return static_cast<int16_t>(std::lround(clamped * 32767.0f));
+	}
+
+	float Snorm16ToFloat(const int16_t value)
+	{
+		return std::max(static_cast<float>(value) / 32767.0f, -1.0f);
+	}
+
+	uint16_t FloatToUnorm16(const float value)
+	{
+		const float clamped = std::isnan(value) ? 0.0f : Saturate(value);
+		return static_cast<uint16_t>(std::lround(clamped * 65535.0f));
+	}
+
+	float Unorm16ToFloat(const uint16_t value)
+	{
+		return static_cast<float>(value) / 65535.0f;
+	}
+
+	uint8_t FloatToUnorm8(const float value)
+	{
+		const float clamped = std::isnan(value) ? 0.0f : Saturate(value);
+		return static_cast<uint8_t>(std::lround(clamped * 255.0f));
+	}
+
+	float Unorm8ToFloat(const uint8_t value)
+	{
+		return static_cast<float>(value) / 255.0f;
+	}
+
+	namespace
+	{
+		float SignNotZero(float v) { return v >= 0.0f ? 1.0f : -1.0f; }
+	}
+
+	Float2 OctahedralEncode(const Float3& n)
+	{
+		const float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+		if (l1 <= 0.0f)
+			return Float2(0.0f); // Misses have no normal
+
+		Float2 e(n.x / l1, n.y / l1);
+		if (n.z < 0.0f)
+			e = Float2((1.0f - std::abs(e.y)) * SignNotZero(e.x), (1.0f - std::abs(e.x)) * SignNotZero(e.y));
+		return e;
+	}
+
+	Float3 OctahedralDecode(const Float2& e)
+	{
+		Float3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+		if (n.z < 0.0f)
+			n = Float3((1.0f - std::abs(e.y)) * SignNotZero(e.x), (1.0f - std::abs(e.x)) * SignNotZero(e.y), n.z);
+		return Normalize(n);
+	}
+
+	size_t CompactGBuffer::GetSizeInBytes() const
+	{
+		const auto bytes = [](const auto& image) { return static_cast<size_t>(image.GetWidth()) * image.GetHeight() * sizeof(*image.Data()); };
+		return bytes(Colour) + bytes(Normal) + bytes(Depth32) + bytes(Depth16) + bytes(Material);
+	}
+
+	void PackGBuffer(const GBuffer& input, const GBufferDepthFormat depthFormat, CompactGBuffer& output)
+	{
+		const int width = input.GetWidth();
+		const int height = input.GetHeight();
+
+		output.DepthFormat = depthFormat;
+		output.Colour.Resize(width, height);
+		output.Normal.Resize(width, height);
+		output.Material.Resize(width, height);
+		output.Depth32.Resize(depthFormat == GBufferDepthFormat::Float32 ? width : 0, depthFormat == GBufferDepthFormat::Float32 ? height : 0);
+		output.Depth16.Resize(depthFormat == GBufferDepthFormat::Unorm16 ? width : 0, depthFormat == GBufferDepthFormat::Unorm16 ? height : 0);
+
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				const Float4& colour = input.Colour.At(x, y);
+				output.Colour.At(x, y) = { FloatToHalf(colour.x), FloatToHalf(colour.y), FloatToHalf(colour.z), FloatToHalf(colour.w) };
+
+				// Shader writes these values, storage conversion happens on output
+				const Float4& normDepth = input.NormDepth.At(x, y);
+				const Float2 octNormal = OctahedralEncode(normDepth.xyz() * Float3(2.0f) - Float3(1.0f));
+				output.Normal.At(x, y) = { FloatToSnorm16(octNormal.x), FloatToSnorm16(octNormal.y) };
+
+				const float depth = Saturate(normDepth.w);
+				if (depthFormat == GBufferDepthFormat::Float32)
+					output.Depth32.At(x, y) = depth;
+				else
+					output.Depth16.At(x, y) = FloatToUnorm16(depth);
+
+				const Float4& material = input.MaterialIndex.At(x, y);
+				output.Material.At(x, y) = { FloatToUnorm8(material.x), FloatToUnorm8(material.y),
+				                             FloatToUnorm8(EncodeObjectIndex(static_cast<int>(material.z))), 0 };
+			}
+		}
+	}
+
+	void UnpackGBuffer(const CompactGBuffer& input, GBuffer& output)
+	{
+		const int width = input.Colour.GetWidth();
+		const int height = input.Colour.GetHeight();
+		output.Resize(width, height);
+
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				const PackedColour& colour = input.Colour.At(x, y);
+				output.Colour.At(x, y) = Float4(HalfToFloat(colour.R), HalfToFloat(colour.G), HalfToFloat(colour.B), HalfToFloat(colour.A));
+
+				const PackedNormal& normal = input.Normal.At(x, y);
+				const Float3 n = OctahedralDecode(Float2(Snorm16ToFloat(normal.X), Snorm16ToFloat(normal.Y)));
+				const float depth = input.DepthFormat == GBufferDepthFormat::Float32 ? input.Depth32.At(x, y) : Unorm16ToFloat(input.Depth16.At(x, y));
+				output.NormDepth.At(x, y) = Float4(n * Float3(0.5f) + Float3(0.5f), depth);
+
+				const PackedMaterial& material = input.Material.At(x, y);
+				const int index = DecodeObjectIndex(Unorm8ToFloat(material.Index));
+				output.MaterialIndex.At(x, y) = Float4(Unorm8ToFloat(material.Metalicness), Unorm8ToFloat(material.Roughness),
+				                                       static_cast<float>(index), index >= 0 ? 1.0f : 0.0f);
+			}
+		}
+	}
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CPU/Image.h"
+#include "CPU/RayMarcher.h"
+
+// Compact G-buffer layout shared with RenderPassDefault and GBufferPacking.hlsli.
+//
+//   Colour   R16G16B16A16_FLOAT  HDR colour in half precision
+//   Normal   R16G16_SNORM        Octahedral encoded world normal
+//   Depth    R32_FLOAT/R16_UNORM Depth / MaxDist
+//   Material R8G8B8A8_UNORM      Metalicness, roughness, (object index + 1) / 255, unused
+//
+// Reflections traced from it are stored as R16G16B16A16_FLOAT colour and depth.
+//
+// The GPU relies on the output merger and texture units for the float <->
+// storage conversions; the functions below reproduce them bit for bit.
+namespace CPU
+{
+	enum class GBufferDepthFormat
+	{
+		Float32,
+		Unorm16
+	};
+
+	struct GBufferTargetDesc
+	{
+		std::string Name;
+		std::string Format;
+		int BytesPerPixel{ 0 };
+	};
+
+	// Primary pass targets in SV_Target order, followed by the reflection trace target
+	[[nodiscard]] std::vector<GBufferTargetDesc> GetCompactGBufferLayout(GBufferDepthFormat depthFormat);
+	// The original layout: three R32G32B32A32_FLOAT targets and an R32G32_FLOAT one
+	[[nodiscard]] std::vector<GBufferTargetDesc> GetLegacyGBufferLayout();
+	[[nodiscard]] int GetBytesPerPixel(const std::vector<GBufferTargetDesc>& layout);
+
+	// Human readable per-target and total byte budget at the given resolution
+	[[nodiscard]] std::string FormatGBufferBudget(const std::vector<GBufferTargetDesc>& layout, int width, int height);
+
+	// Storage conversions
+	[[nodiscard]] uint16_t FloatToHalf(float value);
+	[[nodiscard]] float HalfToFloat(uint16_t value);
+	[[nodiscard]] int16_t FloatToSnorm16(float value);
+	[[nodiscard]] float Snorm16ToFloat(int16_t value);
+	[[nodiscard]] uint16_t FloatToUnorm16(float value);
+	[[nodiscard]] float Unorm16ToFloat(uint16_t value);
+	[[nodiscard]] uint8_t FloatToUnorm8(float value);
+	[[nodiscard]] float Unorm8ToFloat(uint8_t value);
+
+	// Octahedral normal mapping into [-1, 1]^2 (Cigolle et al. 2014)
+	[[nodiscard]] Float2 OctahedralEncode(const Float3& n);
+	[[nodiscard]] Float3 OctahedralDecode(const Float2& e);
+
+	// Object index -1 (miss) to 254 stored exactly in an 8 bit UNORM channel. Higher indices saturate and would
+	// merge objects in the bilateral upsample, so RAYMARCH_MAX_OBJECTS is held to this.
+	inline constexpr int MaxEncodedObjectIndex = 254;
+	[[nodiscard]] inline float EncodeObjectIndex(int index) { return static_cast<float>(index + 1) / 255.0f; }
+	[[nodiscard]] inline int DecodeObjectIndex(float encoded) { return static_cast<int>(std::lround(encoded * 255.0f)) - 1; }
+
+	struct PackedColour
+	{
+		uint16_t R{ 0 }, G{ 0 }, B{ 0 }, A{ 0 };
+	};
+
+	struct PackedNormal
+	{
+		int16_t X{ 0 }, Y{ 0 };
+	};
+
+	struct PackedMaterial
+	{
+		uint8_t Metalicness{ 0 }, Roughness{ 0 }, Index{ 0 }, Unused{ 0 };
+	};
+
+	// Storage identical in size and bit layout to the GPU render targets.
+	// Only the depth image matching DepthFormat is populated.
+	struct CompactGBuffer
+	{
+		GBufferDepthFormat DepthFormat{ GBufferDepthFormat::Float32 };
+
+		Image<PackedColour> Colour{};
+		Image<PackedNormal> Normal{};
+		Image<float> Depth32{};
+		Image<uint16_t> Depth16{};
+		Image<PackedMaterial> Material{};
+
+		[[nodiscard]] size_t GetSizeInBytes() const;
+	};
+
+	void PackGBuffer(const GBuffer& input, GBufferDepthFormat depthFormat, CompactGBuffer& output);
+
+	// Reconstructs the full precision layout the reflection passes consumed before packing
+	void UnpackGBuffer(const CompactGBuffer& input, GBuffer& output);
+}
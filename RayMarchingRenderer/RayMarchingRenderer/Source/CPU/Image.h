@@ -0,0 +1,66 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "CPU/Math.h"
+
+namespace CPU
+{
+	// Row-major 2D pixel buffer, the CPU equivalent of a Texture2D.
+	template <typename T>
+	class Image
+	{
+	public:
+		Image() = default;
+		Image(int width, int height) : Width(width), Height(height), Pixels(static_cast<size_t>(width) * height) {}
+		Image(int width, int height, const T& value) : Width(width), Height(height), Pixels(static_cast<size_t>(width) * height, value) {}
+
+		void Resize(int width, int height)
+		{
+			Width = width;
+			Height = height;
+			Pixels.assign(static_cast<size_t>(width) * height, T{});
+		}
+
+		[[nodiscard]] int GetWidth() const { return Width; }
+		[[nodiscard]] int GetHeight() const { return Height; }
+		[[nodiscard]] bool Empty() const { return Pixels.empty(); }
+
+		[[nodiscard]] T& At(int x, int y) { return Pixels[static_cast<size_t>(y) * Width + x]; }
+		[[nodiscard]] const T& At(int x, int y) const { return Pixels[static_cast<size_t>(y) * Width + x]; }
+
+		// Texel load with clamp addressing, matching out-of-range Texture2D reads closely enough for filtering.
+		[[nodiscard]] const T& Load(int x, int y) const
+		{
+			return At(std::clamp(x, 0, Width - 1), std::clamp(y, 0, Height - 1));
+		}
+
+		[[nodiscard]] T* Data() { return Pixels.data(); }
+		[[nodiscard]] const T* Data() const { return Pixels.data(); }
+
+	private:
+		int Width{ 0 };
+		int Height{ 0 };
+		std::vector<T> Pixels{};
+	};
+
+	// Bilinear sample with clamp addressing. uv is in [0, 1] texture space, texel centres at (i + 0.5) / size.
+	template <typename T>
+	[[nodiscard]] T SampleBilinear(const Image<T>& image, float u, float v)
+	{
+		const float x = u * image.GetWidth() - 0.5f;
+		const float y = v * image.GetHeight() - 0.5f;
+		const float fx = std::floor(x);
+		const float fy = std::floor(y);
+		const int x0 = static_cast<int>(fx);
+		const int y0 = static_cast<int>(fy);
+		const T tx(x - fx);
+		const T ty(y - fy);
+		const T one(1.0f);
+
+		const T top = image.Load(x0, y0) * (one - tx) + image.Load(x0 + 1, y0) * tx;
+		const T bottom = image.Load(x0, y0 + 1) * (one - tx) + image.Load(x0 + 1, y0 + 1) * tx;
+		return top * (one - ty) + bottom * ty;
+	}
+}
@@ -0,0 +1,69 @@
+#include "CPU/ImageFile.h"
+
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace CPU
+{
+	namespace
+	{
+		void WritePPM(std::ofstream& file, const Image<Float4>& image)
+		{
+			file << "P6\n" << image.GetWidth() << ' ' << image.GetHeight() << "\n255\n";
+
+			std::vector<uint8_t> row(static_cast<size_t>(image.GetWidth()) * 3u);
+			for (int y = 0; y < image.GetHeight(); ++y)
+			{
+				for (int x = 0; x < image.GetWidth(); ++x)
+				{
+					const Float4& c = image.At(x, y);
+					row[x * 3 + 0] = static_cast<uint8_t>(Saturate(c.x) * 255.0f + 0.5f);
+					row[x * 3 + 1] = static_cast<uint8_t>(Saturate(c.y) * 255.0f + 0.5f);
+					row[x * 3 + 2] = static_cast<uint8_t>(Saturate(c.z) * 255.0f + 0.5f);
+				}
+				file.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size()));
+			}
+		}
+
+		void WritePFM(std::ofstream& file, const Image<Float4>& image)
+		{
+			// Negative scale marks little endian; rows are stored bottom to top
+			file << "PF\n" << image.GetWidth() << ' ' << image.GetHeight() << "\n-1.0\n";
+
+			std::vector<float> row(static_cast<size_t>(image.GetWidth()) * 3u);
+			for (int y = image.GetHeight() - 1; y >= 0; --y)
+			{
+				for (int x = 0; x < image.GetWidth(); ++x)
+				{
+					const Float4& c = image.At(x, y);
+					row[x * 3 + 0] = c.x;
+					row[x * 3 + 1] = c.y;
+					row[x * 3 + 2] = c.z;
+				}
+				file.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size() * sizeof(float)));
+			}
+		}
+	}
+
+	void WriteImage(const std::filesystem::path& path, const Image<Float4>& image)
+	{
+		const std::string extension = path.extension().string();
+		if (extension != ".ppm" && extension != ".pfm")
+			throw std::runtime_error("Image \"" + path.string() + "\" must be .ppm or .pfm");
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file)
+			throw std::runtime_error("Image \"" + path.string() + "\" could not be opened for writing");
+
+		if (extension == ".ppm")
+			WritePPM(file, image);
+		else
+			WritePFM(file, image);
+
+		if (!file)
+			throw std::runtime_error("Image \"" + path.string() + "\" write failed");
+	}
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <filesystem>
+
+#include "CPU/Image.h"
+
+// Uncompressed image output for offline rendering, picked by extension:
+//   .ppm  8 bit binary PPM, colour saturated as the viewport displays it
+//   .pfm  32 bit float PFM, full HDR range
+namespace CPU
+{
+	// Throws std::runtime_error on an unknown extension or write failure
+	void WriteImage(const std::filesystem::path& path, const Image<Float4>& image);
+}
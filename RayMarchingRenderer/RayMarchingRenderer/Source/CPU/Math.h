@@ -0,0 +1,106 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+
+// Minimal HLSL-style vector maths used by the CPU reference path.
+// Kept free of Windows/DirectX headers so it can be built headlessly.
+namespace CPU
+{
+	struct Float2
+	{
+		float x{ 0.0f };
+		float y{ 0.0f };
+
+		constexpr Float2() = default;
+		constexpr Float2(float v) : x(v), y(v) {}
+		constexpr Float2(float x, float y) : x(x), y(y) {}
+
+		constexpr Float2 operator+(const Float2& o) const { return { x + o.x, y + o.y }; }
+		constexpr Float2 operator-(const Float2& o) const { return { x - o.x, y - o.y }; }
+		constexpr Float2 operator*(const Float2& o) const { return { x * o.x, y * o.y }; }
+		constexpr Float2 operator/(const Float2& o) const { return { x / o.x, y / o.y }; }
+		constexpr Float2 operator-() const { return { -x, -y }; }
+		Float2& operator+=(const Float2& o) { x += o.x; y += o.y; return *this; }
+		Float2& operator*=(const Float2& o) { x *= o.x; y *= o.y; return *this; }
+	};
+
+	struct Float3
+	{
+		float x{ 0.0f };
+		float y{ 0.0f };
+		float z{ 0.0f };
+
+		constexpr Float3() = default;
+		constexpr Float3(float v) : x(v), y(v), z(v) {}
+		constexpr Float3(float x, float y, float z) : x(x), y(y), z(z) {}
+
+		constexpr Float3 operator+(const Float3& o) const { return { x + o.x, y + o.y, z + o.z }; }
+		constexpr Float3 operator-(const Float3& o) const { return { x - o.x, y - o.y, z - o.z }; }
+		constexpr Float3 operator*(const Float3& o) const { return { x * o.x, y * o.y, z * o.z }; }
+		constexpr Float3 operator/(const Float3& o) const { return { x / o.x, y / o.y, z / o.z }; }
+		constexpr Float3 operator-() const { return { -x, -y, -z }; }
+		Float3& operator+=(const Float3& o) { x += o.x; y += o.y; z += o.z; return *this; }
+		Float3& operator-=(const Float3& o) { x -= o.x; y -= o.y; z -= o.z; return *this; }
+		Float3& operator*=(const Float3& o) { x *= o.x; y *= o.y; z *= o.z; return *this; }
+		Float3& operator/=(const Float3& o) { x /= o.x; y /= o.y; z /= o.z; return *this; }
+	};
+
+	struct Float4
+	{
+		float x{ 0.0f };
+		float y{ 0.0f };
+		float z{ 0.0f };
+		float w{ 0.0f };
+
+		constexpr Float4() = default;
+		constexpr Float4(float v) : x(v), y(v), z(v), w(v) {}
+		constexpr Float4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+		constexpr Float4(const Float3& v, float w) : x(v.x), y(v.y), z(v.z), w(w) {}
+
+		[[nodiscard]] constexpr Float3 xyz() const { return { x, y, z }; }
+
+		constexpr Float4 operator+(const Float4& o) const { return { x + o.x, y + o.y, z + o.z, w + o.w }; }
+		constexpr Float4 operator-(const Float4& o) const { return { x - o.x, y - o.y, z - o.z, w - o.w }; }
+		constexpr Float4 operator*(const Float4& o) const { return { x * o.x, y * o.y, z * o.z, w * o.w }; }
+		constexpr Float4 operator/(const Float4& o) const { return { x / o.x, y / o.y, z / o.z, w / o.w }; }
+		Float4& operator+=(const Float4& o) { x += o.x; y += o.y; z += o.z; w += o.w; return *this; }
+		Float4& operator*=(const Float4& o) { x *= o.x; y *= o.y; z *= o.z; w *= o.w; return *this; }
+	};
+
+	inline constexpr float PI = 3.14159265f;
+
+	[[nodiscard]] constexpr float Dot(const Float2& a, const Float2& b) { return a.x * b.x + a.y * b.y; }
+	[[nodiscard]] constexpr float Dot(const Float3& a, const Float3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	[[nodiscard]] constexpr float Dot(const Float4& a, const Float4& b) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
+
+	[[nodiscard]] inline float Length(const Float2& v) { return std::sqrt(Dot(v, v)); }
+	[[nodiscard]] inline float Length(const Float3& v) { return std::sqrt(Dot(v, v)); }
+	[[nodiscard]] inline float Length(const Float4& v) { return std::sqrt(Dot(v, v)); }
+
+	[[nodiscard]] inline float Distance(const Float3& a, const Float3& b) { return Length(a - b); }
+
+	[[nodiscard]] inline Float3 Normalize(const Float3& v)
+	{
+		const float len = Length(v);
+		return len > 0.0f ? v / Float3(len) : Float3(0.0f);
+	}
+
+	[[nodiscard]] constexpr Float3 Cross(const Float3& a, const Float3& b)
+	{
+		return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	}
+
+	[[nodiscard]] constexpr Float3 Reflect(const Float3& i, const Float3& n) { return i - n * Float3(2.0f * Dot(i, n)); }
+
+	[[nodiscard]] constexpr float Saturate(float v) { return std::clamp(v, 0.0f, 1.0f); }
+	[[nodiscard]] constexpr float Lerp(float a, float b, float t) { return a + (b - a) * t; }
+	[[nodiscard]] constexpr Float3 Lerp(const Float3& a, const Float3& b, float t) { return a + (b - a) * Float3(t); }
+	[[nodiscard]] constexpr Float4 Lerp(const Float4& a, const Float4& b, float t) { return a + (b - a) * Float4(t); }
+
+	[[nodiscard]] inline Float2 Abs(const Float2& v) { return { std::abs(v.x), std::abs(v.y) }; }
+	[[nodiscard]] inline Float3 Abs(const Float3& v) { return { std::abs(v.x), std::abs(v.y), std::abs(v.z) }; }
+	[[nodiscard]] inline Float2 Max(const Float2& v, float m) { return { std::max(v.x, m), std::max(v.y, m) }; }
+	[[nodiscard]] inline Float3 Max(const Float3& v, float m) { return { std::max(v.x, m), std::max(v.y, m), std::max(v.z, m) }; }
+	[[nodiscard]] inline Float3 Min(const Float3& a, const Float3& b) { return { std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z) }; }
+	[[nodiscard]] inline Float3 Max(const Float3& a, const Float3& b) { return { std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z) }; }
+}
@@ -0,0 +1,451 @@
+#include "CPU/Metrics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <WinSock2.h>
+#include <Windows.h>
+#include <Psapi.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "Ws2_32.lib")
+#endif
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace CPU
+{
+	namespace
+	{
+		constexpr double SummaryQuantiles[] = { 0.5, 0.9, 0.99 };
+
+#ifdef _WIN32
+		using Socket = SOCKET;
+		const Socket NoSocket = INVALID_SOCKET;
+
+		void CloseSocket(const Socket socket)
+		{
+			closesocket(socket);
+		}
+
+		void DisableSigPipe(Socket) {}
+		constexpr int SendFlags = 0;
+#else
+		using Socket = int;
+		constexpr Socket NoSocket = -1;
+
+		void CloseSocket(const Socket socket)
+		{
+			close(socket);
+		}
+
+		// A scraper hanging up mid-response must fail the send rather than raise SIGPIPE and kill the node
+#ifdef MSG_NOSIGNAL
+		void DisableSigPipe(Socket) {}
+		constexpr int SendFlags = MSG_NOSIGNAL;
+#else
+		void DisableSigPipe(const Socket socket)
+		{
+			const int enable = 1;
+			setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+		}
+		constexpr int SendFlags = 0;
+#endif
+#endif
+
+		[[nodiscard]] bool IsValidName(const std::string& name)
+		{
+			if (name.empty() || (name[0] >= '0' && name[0] <= '9'))
+				return false;
+			return std::all_of(name.begin(), name.end(), [](const char c)
+			{
+				return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == ':';
+			});
+		}
+
+		void AppendHelp(std::string& text, const std::string& help)
+		{
+			for (const char c : help)
+			{
+				if (c == '\\')
+					text += "\\\\";
+				else if (c == '\n')
+					text += "\\n";
+				else
+					text += c;
+			}
+		}
+
+		void AppendValue(std::string& text, const double value)
+		{
+			if (std::isnan(value))
+				text += "NaN";
+			else if (std::isinf(value))
+				text += value > 0.0 ? "+Inf" : "-Inf";
+			else
+			{
+				char number[32]{};
+				std::snprintf(number, sizeof(number), "%.9g", value);
+				text += number;
+			}
+		}
+
+		Socket OpenListener(const uint16_t port)
+		{
+#ifdef _WIN32
+			WSADATA data{};
+			if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+				throw std::runtime_error("Metrics port " + std::to_string(port) + ": sockets unavailable");
+#endif
+			const Socket listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+			if (listener == NoSocket)
+				throw std::runtime_error("Metrics port " + std::to_string(port) + ": socket could not be created");
+
+			// Loopback only, the scraper runs on the node
+			sockaddr_in address{};
+			address.sin_family = AF_INET;
+			address.sin_port = htons(port);
+			address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			if (bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 8) != 0)
+			{
+				CloseSocket(listener);
+				throw std::runtime_error("Metrics port " + std::to_string(port) + " could not be opened");
+			}
+
+			return listener;
+		}
+	}
+
+	MetricId Metrics::Register(const std::string& name, const std::string& help, const MetricType type)
+	{
+		if (!IsValidName(name))
+			throw std::invalid_argument("\"" + name + "\" is not a valid metric name");
+
+		const std::lock_guard lock(Mutex);
+		const int count = Count.load(std::memory_order_relaxed);
+		for (int i = 0; i < count; ++i)
+		{
+			if (Entries[i].Name != name)
+				continue;
+			if (Entries[i].Type != type)
+				throw std::invalid_argument("Metric \"" + name + "\" is already registered with another type");
+			return i;
+		}
+
+		if (count >= MaxMetrics)
+			throw std::invalid_argument("Metric \"" + name + "\" exceeds the limit of " + std::to_string(MaxMetrics) + " metrics");
+
+		Metric& metric = Entries[count];
+		metric.Name = name;
+		metric.Help = help;
+		metric.Type = type;
+		if (type == MetricType::Summary)
+			metric.Samples = std::make_unique<std::atomic<double>[]>(MetricsSummaryWindow);
+
+		// Published after it is filled in, so Write never sees a half registered metric
+		Count.store(count + 1, std::memory_order_release);
+		return count;
+	}
+
+	MetricId Metrics::AddCounter(const std::string& name, const std::string& help)
+	{
+		return Register(name, help, MetricType::Counter);
+	}
+
+	MetricId Metrics::AddGauge(const std::string& name, const std::string& help)
+	{
+		return Register(name, help, MetricType::Gauge);
+	}
+
+	MetricId Metrics::AddSummary(const std::string& name, const std::string& help)
+	{
+		return Register(name, help, MetricType::Summary);
+	}
+
+	void Metrics::Add(const MetricId id, const double amount)
+	{
+		Entries[id].Value.fetch_add(amount, std::memory_order_relaxed);
+	}
+
+	void Metrics::Set(const MetricId id, const double value)
+	{
+		Entries[id].Value.store(value, std::memory_order_relaxed);
+	}
+
+	void Metrics::Observe(const MetricId id, const double value)
+	{
+		Metric& metric = Entries[id];
+		const uint64_t index = metric.Observations.fetch_add(1u, std::memory_order_relaxed);
+		metric.Samples[index % MetricsSummaryWindow].store(value, std::memory_order_relaxed);
+		metric.Value.fetch_add(value, std::memory_order_relaxed);
+	}
+
+	double Metrics::GetValue(const MetricId id) const
+	{
+		return Entries[id].Value.load(std::memory_order_relaxed);
+	}
+
+	void Metrics::Write(std::string& text) const
+	{
+		std::vector<double> samples{};
+		const int count = Count.load(std::memory_order_acquire);
+		for (int i = 0; i < count; ++i)
+		{
+			const Metric& metric = Entries[i];
+			static constexpr const char* TypeNames[] = { "counter", "gauge", "summary" };
+
+			text += "# HELP " + metric.Name + ' ';
+			AppendHelp(text, metric.Help);
+			text += "\n# TYPE " + metric.Name + ' ' + TypeNames[static_cast<int>(metric.Type)] + '\n';
+
+			if (metric.Type != MetricType::Summary)
+			{
+				text += metric.Name + ' ';
+				AppendValue(text, metric.Value.load(std::memory_order_relaxed));
+				text += '\n';
+				continue;
+			}
+
+			// Quantiles over the most recent observations, count and sum over all of them
+			const uint64_t observations = metric.Observations.load(std::memory_order_relaxed);
+			samples.resize(static_cast<size_t>(std::min<uint64_t>(observations, MetricsSummaryWindow)));
+			for (size_t s = 0; s < samples.size(); ++s)
+				samples[s] = metric.Samples[s].load(std::memory_order_relaxed);
+			std::sort(samples.begin(), samples.end());
+
+			for (const double quantile : SummaryQuantiles)
+			{
+				char label[32]{};
+				std::snprintf(label, sizeof(label), "{quantile=\"%g\"} ", quantile);
+				text += metric.Name + label;
+				AppendValue(text, samples.empty() ? std::nan("") : samples[static_cast<size_t>(quantile * static_cast<double>(samples.size() - 1u) + 0.5)]);
+				text += '\n';
+			}
+
+			text += metric.Name + "_sum ";
+			AppendValue(text, metric.Value.load(std::memory_order_relaxed));
+			text += '\n' + metric.Name + "_count " + std::to_string(observations) + '\n';
+		}
+	}
+
+	Metrics& GetMetrics()
+	{
+		static Metrics metrics;
+		return metrics;
+	}
+
+	const RenderMetrics& GetRenderMetrics()
+	{
+		static const RenderMetrics renderMetrics = []()
+		{
+			Metrics& metrics = GetMetrics();
+			RenderMetrics m{};
+			m.Frames = metrics.AddCounter("raymarch_frames_total", "Frames rendered");
+			m.FrameSeconds = metrics.AddSummary("raymarch_frame_seconds", "Time between frames, or batch frame wall time");
+			m.StepsPerPixel = metrics.AddGauge("raymarch_steps_per_pixel", "Mean primary ray steps per pixel of the last measured frame");
+			m.ShadowStepsPerPixel = metrics.AddGauge("raymarch_shadow_steps_per_pixel", "Mean shadow ray steps per pixel of the last measured frame");
+			m.ShaderCompileSeconds = metrics.AddSummary("raymarch_shader_compile_seconds", "Shader compile latency");
+			m.ShaderCompileFailures = metrics.AddCounter("raymarch_shader_compile_failures_total", "Shader compiles that failed");
+			m.SceneObjects = metrics.AddGauge("raymarch_scene_objects", "Ray marched objects in the scene");
+			m.SceneLights = metrics.AddGauge("raymarch_scene_lights", "Lights in the scene");
+			m.RenderTargetBytes = metrics.AddGauge("raymarch_render_target_bytes", "Memory held by pooled render targets");
+			m.ResidentBytes = metrics.AddGauge("raymarch_process_resident_bytes", "Physical memory in use by the process");
+			return m;
+		}();
+		return renderMetrics;
+	}
+
+	uint64_t GetProcessResidentBytes()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters{};
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+			return counters.WorkingSetSize;
+		return 0u;
+#else
+		// Kept open and read into the stack, as this is called every frame. Second field of statm is the resident page count.
+		static const int statm = open("/proc/self/statm", O_RDONLY | O_CLOEXEC);
+		static const uint64_t pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+		if (statm < 0)
+			return 0u;
+
+		char text[128]{};
+		const ssize_t length = pread(statm, text, sizeof(text) - 1u, 0);
+		if (length <= 0)
+			return 0u;
+
+		char* end = nullptr;
+		(void)std::strtoull(text, &end, 10);
+		const char* residentText = end;
+		const unsigned long long resident = std::strtoull(residentText, &end, 10);
+		return end != residentText ? resident * pageSize : 0u;
+#endif
+	}
+
+	MetricsExporter::MetricsExporter(const Metrics& metrics, MetricsExportSettings settings)
+		: Source(metrics), Settings(std::move(settings))
+	{
+		Settings.IntervalSeconds = std::max(Settings.IntervalSeconds, 0.1);
+		if (Settings.Port != 0u)
+			Listener = static_cast<intptr_t>(OpenListener(Settings.Port));
+
+		Text.reserve(16384u);
+		Thread = std::thread([this]() { Run(); });
+	}
+
+	MetricsExporter::~MetricsExporter()
+	{
+		{
+			const std::lock_guard lock(Mutex);
+			Stopping = true;
+		}
+		Wake.notify_all();
+		Thread.join();
+
+		if (Listener != -1)
+		{
+			CloseSocket(static_cast<Socket>(Listener));
+#ifdef _WIN32
+			WSACleanup();
+#endif
+		}
+	}
+
+	std::string MetricsExporter::GetLastError() const
+	{
+		const std::lock_guard lock(Mutex);
+		return LastError;
+	}
+
+	void MetricsExporter::Run()
+	{
+		using Clock = std::chrono::steady_clock;
+		const auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(Settings.IntervalSeconds));
+
+		auto nextPublish = Clock::now();
+		while (true)
+		{
+			if (Clock::now() >= nextPublish)
+			{
+				Publish();
+				nextPublish += interval;
+			}
+
+			if (Listener == -1)
+			{
+				std::unique_lock lock(Mutex);
+				if (Wake.wait_until(lock, nextPublish, [this]() { return Stopping; }))
+					break;
+				continue;
+			}
+
+			{
+				const std::lock_guard lock(Mutex);
+				if (Stopping)
+					break;
+			}
+
+			// Short waits so a stop request is seen promptly, as a socket wait can't be woken by the condition variable
+			const Socket listener = static_cast<Socket>(Listener);
+			fd_set readable{};
+			FD_ZERO(&readable);
+			FD_SET(listener, &readable);
+			const auto wait = std::min(nextPublish - Clock::now(), std::chrono::duration_cast<Clock::duration>(std::chrono::milliseconds(100)));
+			timeval timeout{};
+			timeout.tv_usec = static_cast<long>(std::max<long long>(0, std::chrono::duration_cast<std::chrono::microseconds>(wait).count()));
+			if (select(static_cast<int>(listener + 1), &readable, nullptr, nullptr, &timeout) > 0)
+				Serve();
+		}
+
+		Publish();
+	}
+
+	void MetricsExporter::Publish()
+	{
+		Source.Write(Text.erase());
+		if (Settings.Path.empty())
+		{
+			PublishCount.fetch_add(1u, std::memory_order_relaxed);
+			return;
+		}
+
+		// Written beside the target and renamed over it, so a scraper never reads half a file
+		std::filesystem::path temporary = Settings.Path;
+		temporary += ".tmp";
+		std::string error{};
+		{
+			std::ofstream file(temporary, std::ios::binary);
+			file.write(Text.data(), static_cast<std::streamsize>(Text.size()));
+			if (!file)
+				error = "Metrics file \"" + temporary.string() + "\" could not be written";
+		}
+
+		std::error_code renameError{};
+		if (error.empty())
+		{
+			std::filesystem::rename(temporary, Settings.Path, renameError);
+			if (renameError)
+				error = "Metrics file \"" + Settings.Path.string() + "\": " + renameError.message();
+		}
+
+		if (error.empty())
+			PublishCount.fetch_add(1u, std::memory_order_relaxed);
+
+		const std::lock_guard lock(Mutex);
+		LastError = error;
+	}
+
+	void MetricsExporter::Serve()
+	{
+		const Socket client = accept(static_cast<Socket>(Listener), nullptr, nullptr);
+		if (client == NoSocket)
+			return;
+
+		// Whatever was asked for gets the metrics; the request is read so the client sees a clean close
+#ifdef _WIN32
+		const DWORD receiveTimeout = 1000u;
+		setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&receiveTimeout), sizeof(receiveTimeout));
+#else
+		const timeval receiveTimeout{ 1, 0 };
+		setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &receiveTimeout, sizeof(receiveTimeout));
+#endif
+		DisableSigPipe(client);
+		char request[1024]{};
+		(void)recv(client, request, sizeof(request), 0);
+
+		Source.Write(Text.erase());
+		char header[160]{};
+		const int headerSize = std::snprintf(header, sizeof(header),
+		                                     "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+		                                     Text.size());
+		send(client, header, headerSize, SendFlags);
+		for (size_t sent = 0; sent < Text.size();)
+		{
+			const int result = send(client, Text.data() + sent, static_cast<int>(Text.size() - sent), SendFlags);
+			if (result <= 0)
+				break;
+			sent += static_cast<size_t>(result);
+		}
+
+		CloseSocket(client);
+		RequestCount.fetch_add(1u, std::memory_order_relaxed);
+	}
+}
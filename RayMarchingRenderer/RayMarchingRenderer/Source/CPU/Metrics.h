@@ -0,0 +1,139 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Live metrics for long-running render nodes, published in the Prometheus text
+// exposition format. Metrics are registered up front (registration allocates);
+// recording a value afterwards is a lock-free store into preallocated storage,
+// so it never allocates on the frame path. A MetricsExporter publishes the
+// registry periodically from its own thread.
+namespace CPU
+{
+	using MetricId = int;
+
+	inline constexpr int MaxMetrics = 64;
+	// Most recent observations a summary computes its quantiles over
+	inline constexpr int MetricsSummaryWindow = 1024;
+
+	enum class MetricType : int
+	{
+		Counter = 0, // Only goes up, e.g. frames rendered
+		Gauge,       // Current value, e.g. objects in the scene
+		Summary      // Observations reported as quantiles, a sum and a count, e.g. frame time
+	};
+
+	class Metrics
+	{
+	public:
+		Metrics() = default;
+		Metrics(const Metrics&) = delete;
+		Metrics& operator=(const Metrics&) = delete;
+
+		// Registering a name again returns the existing metric. Throws std::invalid_argument if
+		// the name isn't a valid Prometheus name, is registered with another type, or the registry is full.
+		MetricId AddCounter(const std::string& name, const std::string& help);
+		MetricId AddGauge(const std::string& name, const std::string& help);
+		MetricId AddSummary(const std::string& name, const std::string& help);
+
+		// Safe from any thread and never allocate
+		void Add(MetricId id, double amount = 1.0);
+		void Set(MetricId id, double value);
+		void Observe(MetricId id, double value);
+
+		[[nodiscard]] double GetValue(MetricId id) const;
+
+		// Appends every metric in the text exposition format
+		void Write(std::string& text) const;
+
+	private:
+		struct Metric
+		{
+			std::string Name{};
+			std::string Help{};
+			MetricType Type{ MetricType::Gauge };
+			std::atomic<double> Value{ 0.0 }; // Counter or gauge value, summary sum
+			std::atomic<uint64_t> Observations{ 0u };
+			std::unique_ptr<std::atomic<double>[]> Samples{}; // Summary ring of MetricsSummaryWindow
+		};
+
+		MetricId Register(const std::string& name, const std::string& help, MetricType type);
+
+		std::mutex Mutex{}; // Registration only
+		std::array<Metric, MaxMetrics> Entries{};
+		std::atomic<int> Count{ 0 };
+	};
+
+	// Process-wide registry the renderer and batch tool record into
+	[[nodiscard]] Metrics& GetMetrics();
+
+	// Metrics every render node publishes, registered in GetMetrics() on first use
+	struct RenderMetrics
+	{
+		MetricId Frames{ -1 };
+		MetricId FrameSeconds{ -1 };
+		MetricId StepsPerPixel{ -1 };
+		MetricId ShadowStepsPerPixel{ -1 };
+		MetricId ShaderCompileSeconds{ -1 };
+		MetricId ShaderCompileFailures{ -1 };
+		MetricId SceneObjects{ -1 };
+		MetricId SceneLights{ -1 };
+		MetricId RenderTargetBytes{ -1 };
+		MetricId ResidentBytes{ -1 };
+	};
+	[[nodiscard]] const RenderMetrics& GetRenderMetrics();
+
+	// Physical memory in use by this process, 0 if unknown. Never allocates, so can be sampled every frame.
+	[[nodiscard]] uint64_t GetProcessResidentBytes();
+
+	struct MetricsExportSettings
+	{
+		// Rewritten atomically every interval, for the node exporter's textfile collector. Empty to skip.
+		std::filesystem::path Path{};
+		// Loopback HTTP port serving the metrics on every request, for scraping directly. 0 to skip.
+		uint16_t Port{ 0u };
+		double IntervalSeconds{ 5.0 };
+	};
+
+	// Publishes a registry from a background thread until destroyed, then once more
+	// so the file holds the final values. Throws std::runtime_error if the port can't be opened.
+	class MetricsExporter
+	{
+	public:
+		MetricsExporter(const Metrics& metrics, MetricsExportSettings settings);
+		MetricsExporter(const MetricsExporter&) = delete;
+		MetricsExporter& operator=(const MetricsExporter&) = delete;
+		~MetricsExporter();
+
+		[[nodiscard]] const MetricsExportSettings& GetSettings() const { return Settings; }
+		[[nodiscard]] uint64_t GetPublishCount() const { return PublishCount.load(std::memory_order_relaxed); }
+		[[nodiscard]] uint64_t GetRequestCount() const { return RequestCount.load(std::memory_order_relaxed); }
+		// Most recent file write failure, empty if none
+		[[nodiscard]] std::string GetLastError() const;
+
+	private:
+		void Run();
+		void Publish();
+		void Serve();
+
+		const Metrics& Source;
+		MetricsExportSettings Settings{};
+		std::string Text{};
+
+		intptr_t Listener{ -1 };
+		std::atomic<uint64_t> PublishCount{ 0u };
+		std::atomic<uint64_t> RequestCount{ 0u };
+
+		mutable std::mutex Mutex{};
+		std::condition_variable Wake{};
+		bool Stopping{ false };
+		std::string LastError{};
+		std::thread Thread{};
+	};
+}
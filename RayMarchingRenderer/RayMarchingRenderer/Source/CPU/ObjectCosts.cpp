@@ -0,0 +1,228 @@
+#include "CPU/ObjectCosts.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <stdexcept>
+
+#include "CPU/SignedDistance.h"
+
+namespace CPU
+{
+	namespace
+	{
+		thread_local ObjectCostCounters* ActiveCounters = nullptr;
+
+		std::string EscapeJson(const std::string& text)
+		{
+			std::string escaped;
+			escaped.reserve(text.size());
+			for (const char c : text)
+			{
+				if (c == '"' || c == '\\')
+					escaped += '\\';
+				if (static_cast<unsigned char>(c) >= 0x20u)
+					escaped += c;
+			}
+			return escaped;
+		}
+
+		template <typename Entry, typename Less>
+		void SortCosts(std::vector<Entry>& entries, const bool ascending, const Less& less)
+		{
+			std::stable_sort(entries.begin(), entries.end(), [&](const Entry& a, const Entry& b)
+			{
+				return ascending ? less(a, b) : less(b, a);
+			});
+		}
+	}
+
+	void ObjectCostCounters::Reset(const size_t objectCount)
+	{
+		SceneEvaluations = 0u;
+		Nearest.assign(objectCount, 0u);
+	}
+
+	void ObjectCostCounters::Merge(const ObjectCostCounters& other)
+	{
+		SceneEvaluations += other.SceneEvaluations;
+		if (Nearest.size() < other.Nearest.size())
+			Nearest.resize(other.Nearest.size(), 0u);
+		for (size_t i = 0; i < other.Nearest.size(); ++i)
+			Nearest[i] += other.Nearest[i];
+	}
+
+	ObjectCostScope::ObjectCostScope(ObjectCostCounters& counters)
+		: Previous(ActiveCounters)
+	{
+		ActiveCounters = &counters;
+	}
+
+	ObjectCostScope::~ObjectCostScope()
+	{
+		ActiveCounters = Previous;
+	}
+
+	ObjectCostCounters* GetActiveObjectCostCounters()
+	{
+		return ActiveCounters;
+	}
+
+	ObjectCostReport CreateObjectCostReport(const ObjectCostCounters& counters, const std::vector<ObjectCostSource>& objects, const std::string& unit)
+	{
+		ObjectCostReport report{};
+		report.Unit = unit;
+		report.SceneEvaluations = counters.SceneEvaluations;
+
+		for (int i = 0; i < static_cast<int>(objects.size()); ++i)
+		{
+			const ObjectCostSource& source = objects[i];
+
+			ObjectCostEntry entry{};
+			entry.Object = i;
+			entry.Name = source.Name;
+			entry.SDFType = source.SDFType;
+			entry.TypeName = source.TypeName;
+			entry.Evaluations = counters.SceneEvaluations;
+			entry.Nearest = i < static_cast<int>(counters.Nearest.size()) ? counters.Nearest[i] : 0u;
+			entry.UnitCost = source.UnitCost;
+			entry.EstimatedCost = static_cast<double>(entry.Evaluations) * entry.UnitCost;
+			report.TotalCost += entry.EstimatedCost;
+			report.Objects.push_back(entry);
+
+			auto type = std::find_if(report.Types.begin(), report.Types.end(), [&](const TypeCostEntry& t) { return t.SDFType == source.SDFType; });
+			if (type == report.Types.end())
+			{
+				TypeCostEntry typeEntry{};
+				typeEntry.SDFType = source.SDFType;
+				typeEntry.TypeName = source.TypeName;
+				type = report.Types.insert(std::upper_bound(report.Types.begin(), report.Types.end(), source.SDFType,
+				                                            [](const int sdfType, const TypeCostEntry& t) { return sdfType < t.SDFType; }),
+				                           typeEntry);
+			}
+			++type->Objects;
+			type->Evaluations += entry.Evaluations;
+			type->Nearest += entry.Nearest;
+			type->EstimatedCost += entry.EstimatedCost;
+		}
+
+		const double total = std::max(report.TotalCost, 1e-30);
+		for (ObjectCostEntry& entry : report.Objects)
+			entry.Share = entry.EstimatedCost / total;
+		for (TypeCostEntry& type : report.Types)
+			type.Share = type.EstimatedCost / total;
+
+		return report;
+	}
+
+	void SortObjectCosts(std::vector<ObjectCostEntry>& entries, const ObjectCostColumn column, const bool ascending)
+	{
+		SortCosts(entries, ascending, [column](const ObjectCostEntry& a, const ObjectCostEntry& b)
+		{
+			switch (column)
+			{
+			case ObjectCostColumn::Name: return a.Name < b.Name;
+			case ObjectCostColumn::Type: return a.TypeName < b.TypeName;
+			case ObjectCostColumn::Evaluations: return a.Evaluations < b.Evaluations;
+			case ObjectCostColumn::Nearest: return a.Nearest < b.Nearest;
+			case ObjectCostColumn::UnitCost: return a.UnitCost < b.UnitCost;
+			case ObjectCostColumn::EstimatedCost: return a.EstimatedCost < b.EstimatedCost;
+			default: return a.Object < b.Object;
+			}
+		});
+	}
+
+	void SortTypeCosts(std::vector<TypeCostEntry>& entries, const ObjectCostColumn column, const bool ascending)
+	{
+		SortCosts(entries, ascending, [column](const TypeCostEntry& a, const TypeCostEntry& b)
+		{
+			switch (column)
+			{
+			case ObjectCostColumn::Name:
+			case ObjectCostColumn::Type: return a.TypeName < b.TypeName;
+			case ObjectCostColumn::Evaluations: return a.Evaluations < b.Evaluations;
+			case ObjectCostColumn::Nearest: return a.Nearest < b.Nearest;
+			case ObjectCostColumn::UnitCost:
+			case ObjectCostColumn::EstimatedCost: return a.EstimatedCost < b.EstimatedCost;
+			default: return a.SDFType < b.SDFType;
+			}
+		});
+	}
+
+	std::vector<double> MeasureObjectUnitCosts(const Scene& scene, const int evaluations)
+	{
+		using Clock = std::chrono::steady_clock;
+
+		std::vector<double> unitCosts{};
+		unitCosts.reserve(scene.Objects.size());
+
+		// Same points for every object relative to its position and scale, so types compare fairly
+		std::vector<Float3> offsets(std::max(1, evaluations));
+		uint32_t state = 0x9E3779B9u;
+		const auto random = [&state]()
+		{
+			state = state * 1664525u + 1013904223u;
+			return static_cast<float>(state >> 8u) / static_cast<float>(1u << 24u) * 4.0f - 2.0f;
+		};
+		for (Float3& offset : offsets)
+		{
+			offset.x = random();
+			offset.y = random();
+			offset.z = random();
+		}
+
+		for (const Object& object : scene.Objects)
+		{
+			std::vector<Float3> points(offsets.size());
+			for (size_t i = 0; i < offsets.size(); ++i)
+				points[i] = object.Position + offsets[i] * Float3(object.Scale.x);
+
+			// Best of a few runs, to skip past interruptions
+			double best = 0.0;
+			volatile float sink = 0.0f;
+			for (int run = 0; run < 3; ++run)
+			{
+				const auto start = Clock::now();
+				float sum = 0.0f;
+				for (const Float3& p : points)
+					sum += GetDistanceToObject(scene, object, p);
+				const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / static_cast<double>(points.size());
+				sink = sink + sum;
+				best = run == 0 ? ns : std::min(best, ns);
+			}
+			unitCosts.push_back(best);
+		}
+
+		return unitCosts;
+	}
+
+	void WriteObjectCostsJson(const std::filesystem::path& path, const ObjectCostReport& report)
+	{
+		std::ofstream file(path);
+		if (!file)
+			throw std::runtime_error("Object cost file \"" + path.string() + "\" could not be opened for writing");
+
+		file << "{\n  \"version\": 1,\n  \"unit\": \"" << EscapeJson(report.Unit) << "\",\n  \"scene_evaluations\": " << report.SceneEvaluations
+		     << ",\n  \"total_cost\": " << report.TotalCost << ",\n  \"objects\": [\n";
+		for (size_t i = 0; i < report.Objects.size(); ++i)
+		{
+			const ObjectCostEntry& entry = report.Objects[i];
+			file << "    { \"object\": " << entry.Object << ", \"name\": \"" << EscapeJson(entry.Name) << "\", \"sdf_type\": " << entry.SDFType
+			     << ", \"type_name\": \"" << EscapeJson(entry.TypeName) << "\", \"evaluations\": " << entry.Evaluations << ", \"nearest\": " << entry.Nearest
+			     << ", \"unit_cost\": " << entry.UnitCost << ", \"estimated_cost\": " << entry.EstimatedCost << ", \"share\": " << entry.Share << " }"
+			     << (i + 1 < report.Objects.size() ? "," : "") << '\n';
+		}
+		file << "  ],\n  \"types\": [\n";
+		for (size_t i = 0; i < report.Types.size(); ++i)
+		{
+			const TypeCostEntry& type = report.Types[i];
+			file << "    { \"sdf_type\": " << type.SDFType << ", \"type_name\": \"" << EscapeJson(type.TypeName) << "\", \"objects\": " << type.Objects
+			     << ", \"evaluations\": " << type.Evaluations << ", \"nearest\": " << type.Nearest << ", \"estimated_cost\": " << type.EstimatedCost
+			     << ", \"share\": " << type.Share << " }" << (i + 1 < report.Types.size() ? "," : "") << '\n';
+		}
+		file << "  ]\n}\n";
+
+		if (!file)
+			throw std::runtime_error("Failed writing object cost file \"" + path.string() + "\"");
+	}
+}
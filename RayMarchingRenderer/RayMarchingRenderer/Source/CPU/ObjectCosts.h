@@ -0,0 +1,112 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "CPU/SceneData.h"
+
+// Attribution of scene distance cost to objects and SDF types. Every scene
+// evaluation evaluates every object, so an object's cost is the number of
+// scene evaluations times what one evaluation of it costs. What is counted
+// per object is how many evaluations it was the nearest in, i.e. which
+// objects the rays are spending their steps next to. The GPU counterpart is
+// COST_ADD_NEAREST in CostCounters.hlsli.
+namespace CPU
+{
+	struct ObjectCostCounters
+	{
+		uint64_t SceneEvaluations{ 0u };
+		// Indexed by object, evaluations in which the object supplied the scene distance
+		std::vector<uint64_t> Nearest{};
+
+		void Reset(size_t objectCount);
+		void Merge(const ObjectCostCounters& other);
+	};
+
+	// Counts every GetDistanceToScene call made on this thread into counters while alive
+	class ObjectCostScope
+	{
+	public:
+		explicit ObjectCostScope(ObjectCostCounters& counters);
+		ObjectCostScope(const ObjectCostScope&) = delete;
+		ObjectCostScope(ObjectCostScope&&) = delete;
+		ObjectCostScope& operator=(const ObjectCostScope&) = delete;
+		ObjectCostScope& operator=(ObjectCostScope&&) = delete;
+		~ObjectCostScope();
+
+	private:
+		ObjectCostCounters* Previous{ nullptr };
+	};
+
+	// Counters of the innermost ObjectCostScope on this thread, null when not counting
+	[[nodiscard]] ObjectCostCounters* GetActiveObjectCostCounters();
+
+	struct ObjectCostEntry
+	{
+		int Object{ 0 };
+		std::string Name{};
+		int SDFType{ 0 };
+		std::string TypeName{};
+		uint64_t Evaluations{ 0u };
+		uint64_t Nearest{ 0u };
+		double UnitCost{ 0.0 };      // Cost of one evaluation, in ObjectCostReport::Unit
+		double EstimatedCost{ 0.0 }; // Evaluations * UnitCost
+		double Share{ 0.0 };         // Fraction of the scene's estimated cost
+	};
+
+	struct TypeCostEntry
+	{
+		int SDFType{ 0 };
+		std::string TypeName{};
+		int Objects{ 0 };
+		uint64_t Evaluations{ 0u };
+		uint64_t Nearest{ 0u };
+		double EstimatedCost{ 0.0 };
+		double Share{ 0.0 };
+	};
+
+	struct ObjectCostReport
+	{
+		std::string Unit{};
+		uint64_t SceneEvaluations{ 0u };
+		double TotalCost{ 0.0 };
+		std::vector<ObjectCostEntry> Objects{};
+		std::vector<TypeCostEntry> Types{}; // Only types in use, in type order
+	};
+
+	// What an object is called in the report
+	struct ObjectCostSource
+	{
+		std::string Name{};
+		int SDFType{ 0 };
+		std::string TypeName{};
+		double UnitCost{ 0.0 };
+	};
+
+	// One source per object, in scene order. Objects are listed in scene order.
+	[[nodiscard]] ObjectCostReport CreateObjectCostReport(const ObjectCostCounters& counters, const std::vector<ObjectCostSource>& objects, const std::string& unit);
+
+	enum class ObjectCostColumn : int
+	{
+		Object = 0,
+		Name,
+		Type,
+		Evaluations,
+		Nearest,
+		UnitCost,
+		EstimatedCost,
+		Count
+	};
+
+	// Stable sort, so ties keep their previous order
+	void SortObjectCosts(std::vector<ObjectCostEntry>& entries, ObjectCostColumn column, bool ascending);
+	void SortTypeCosts(std::vector<TypeCostEntry>& entries, ObjectCostColumn column, bool ascending);
+
+	// Nanoseconds per evaluation of each object on this CPU, timed at points
+	// spread around the object within a few times its scale
+	[[nodiscard]] std::vector<double> MeasureObjectUnitCosts(const Scene& scene, int evaluations = 4096);
+
+	// Throws std::runtime_error if the file can't be written
+	void WriteObjectCostsJson(const std::filesystem::path& path, const ObjectCostReport& report);
+}
@@ -0,0 +1,264 @@
+#include "CPU/ObjectCulling.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "CPU/ObjectCosts.h"
+#include "CPU/RayMarcher.h"
+
+namespace CPU
+{
+	namespace
+	{
+		constexpr float Infinity = std::numeric_limits<float>::infinity();
+
+		// Range of image plane coordinates, over the focal length f, covered by the circle of radius r about (a, z),
+		// with a across the view and z along it. Bounded by the tangents from the eye; false when the circle is
+		// entirely behind it.
+		bool ProjectCircle(const float a, const float z, const float r, const float f, float& lo, float& hi)
+		{
+			lo = -Infinity;
+			hi = Infinity;
+			const float distance = std::sqrt(a * a + z * z);
+			if (distance <= r)
+				return true;
+
+			const float theta = std::atan2(a, z);
+			const float alpha = std::asin(r / distance);
+			if (theta - alpha >= 0.5f * PI || theta + alpha <= -0.5f * PI)
+				return false;
+			if (theta - alpha > -0.5f * PI)
+				lo = f * std::tan(theta - alpha);
+			if (theta + alpha < 0.5f * PI)
+				hi = f * std::tan(theta + alpha);
+			return true;
+		}
+
+		// Tiles [first, last] whose pixel centres coordinates lo to hi can cover, with pixel = coordinate * scale + bias
+		bool GetTileRange(const float lo, const float hi, const float scale, const float bias, const int tileSize, const int tiles, int& first, int& last)
+		{
+			const float limit = static_cast<float>(tiles * tileSize);
+			const float pixelLo = std::clamp(std::floor(std::min(lo * scale, hi * scale) + bias), -1.0f, limit);
+			const float pixelHi = std::clamp(std::ceil(std::max(lo * scale, hi * scale) + bias), -1.0f, limit);
+			if (pixelHi < 0.0f || pixelLo >= limit)
+				return false;
+
+			first = std::max(static_cast<int>(pixelLo), 0) / tileSize;
+			last = std::min(static_cast<int>(pixelHi) / tileSize, tiles - 1);
+			return true;
+		}
+	}
+
+	ObjectCulling BuildObjectCulling(const Scene& scene, const Camera& camera, const RenderSettings& settings, const int tileSize)
+	{
+		ObjectCulling culling{};
+		culling.TileSize = std::max(tileSize, 1);
+		culling.TilesX = (std::max(settings.Width, 0) + culling.TileSize - 1) / culling.TileSize;
+		culling.TilesY = (std::max(settings.Height, 0) + culling.TileSize - 1) / culling.TileSize;
+		culling.Bounds.resize(scene.Objects.size());
+
+		// Analytic primitives are intersected rather than marched, so only shadow rays walk them
+		std::vector<bool> analytic(scene.Objects.size(), false);
+		for (const AnalyticPrimitive& primitive : scene.AnalyticPrimitives)
+			analytic[primitive.Index] = true;
+
+		// Earlier objects feed an intersection or subtraction, so they matter wherever it does
+		size_t firstUnion = 0;
+		for (size_t i = 0; i < scene.Objects.size(); ++i)
+			if (!IsUnionOperator(scene.Objects[i].BoolOperator))
+				firstUnion = i + 1;
+
+		const float maxThreshold = GetMaxIntersectionThreshold(settings);
+
+		std::vector<CulledObject> candidates{};
+		for (size_t i = 0; i < scene.Objects.size(); ++i)
+		{
+			const Object& object = scene.Objects[i];
+			ObjectBound& bound = culling.Bounds[i];
+			bound.Centre = object.Position;
+			bound.StepScale = object.StepScale;
+			bound.Radius = Infinity;
+			if (i >= firstUnion && scene.SDFLibrary.empty() && object.Scale.x > 0.0f && object.StepScale > 0.0f)
+				// A little slack, so rounding never culls a grazing hit. Repeated copies are no larger than the object, and
+				// a smooth union only moves the surface where the object's distance is within the blend radius.
+				bound.Radius = (GetSDFBoundingRadius(object.SDFType, object.Parameters) * object.Scale.x + GetRepetitionExtent(object.Repeat)) * 1.001f +
+				               (maxThreshold + (object.BoolOperator == 3 ? std::max(object.BlendRadius, 0.0f) : 0.0f)) / object.StepScale;
+
+			if (!std::isfinite(bound.Radius))
+			{
+				culling.Shared.push_back(static_cast<int>(i));
+				continue;
+			}
+			if (analytic[i])
+				continue;
+
+			// Every ray from the eye travels at least this far before entering the bound, and leaves it by FarDepth
+			const float distance = Distance(camera.Position, bound.Centre);
+			candidates.push_back({ static_cast<int>(i), std::max(distance - bound.Radius, 0.0f), distance + bound.Radius });
+			culling.SmoothUnions = culling.SmoothUnions || object.BoolOperator == 3;
+		}
+
+		// Binned in depth order, so every tile's list comes out sorted
+		std::stable_sort(candidates.begin(), candidates.end(),
+		                 [](const CulledObject& a, const CulledObject& b) { return a.NearDepth < b.NearDepth; });
+
+		const int tileCount = culling.TilesX * culling.TilesY;
+		std::vector<std::vector<CulledObject>> tiles(tileCount);
+		// Inverse of CalculateRayDirection: a view space point (x, y, z) is on the ray through image plane
+		// coordinates (f x / z, f y / z), and pixel centres are at u = (2 (px + 0.5) / Width - 1) aspect and
+		// v = 1 - 2 (py + 0.5) / Height
+		const float f = std::tan(-camera.FOV);
+		const float aspect = static_cast<float>(settings.Width) / static_cast<float>(std::max(settings.Height, 1));
+		for (const CulledObject& candidate : candidates)
+		{
+			const ObjectBound& bound = culling.Bounds[candidate.Index];
+			const Float3 offset = bound.Centre - camera.Position;
+			const float x = Dot(offset, camera.Right);
+			const float y = Dot(offset, camera.Up);
+			const float z = Dot(offset, camera.Forward);
+
+			int firstX = 0, lastX = culling.TilesX - 1, firstY = 0, lastY = culling.TilesY - 1;
+			// A field of view of 90 degrees or less points f behind the eye, where the tangents don't apply
+			if (f > 0.0f)
+			{
+				float uLo, uHi, vLo, vHi;
+				if (!ProjectCircle(x, z, bound.Radius, f, uLo, uHi) || !ProjectCircle(y, z, bound.Radius, f, vLo, vHi))
+					continue;
+				const float halfWidth = 0.5f * static_cast<float>(settings.Width);
+				const float halfHeight = 0.5f * static_cast<float>(settings.Height);
+				if (!GetTileRange(uLo, uHi, halfWidth / aspect, halfWidth - 0.5f, culling.TileSize, culling.TilesX, firstX, lastX) ||
+				    !GetTileRange(vLo, vHi, -halfHeight, halfHeight - 0.5f, culling.TileSize, culling.TilesY, firstY, lastY))
+					continue;
+			}
+
+			for (int tileY = firstY; tileY <= lastY; ++tileY)
+				for (int tileX = firstX; tileX <= lastX; ++tileX)
+					tiles[tileY * culling.TilesX + tileX].push_back(candidate);
+		}
+
+		culling.TileOffsets.resize(tileCount + 1);
+		for (int i = 0; i < tileCount; ++i)
+		{
+			culling.TileOffsets[i] = static_cast<uint32_t>(culling.TileObjects.size());
+			culling.TileObjects.insert(culling.TileObjects.end(), tiles[i].begin(), tiles[i].end());
+		}
+		culling.TileOffsets[tileCount] = static_cast<uint32_t>(culling.TileObjects.size());
+		return culling;
+	}
+
+	ObjectWalk GetTileWalk(const ObjectCulling& culling, const int x, const int y)
+	{
+		const int tile = (y / culling.TileSize) * culling.TilesX + x / culling.TileSize;
+		return { culling.Shared, std::span<const CulledObject>(culling.TileObjects.data() + culling.TileOffsets[tile],
+		                                                      culling.TileOffsets[tile + 1] - culling.TileOffsets[tile]),
+		         culling.SmoothUnions };
+	}
+
+	void GatherShadowObjects(const ObjectCulling& culling, const Float3& ro, const Float3& lightPosition, const float sharpness,
+	                         std::vector<CulledObject>& objects)
+	{
+		objects.clear();
+		const float length = Distance(ro, lightPosition);
+		const Float3 rd = length > 0.0f ? (lightPosition - ro) / Float3(length) : Float3(0.0f);
+		const float clearance = sharpness > 0.0f ? length / sharpness : 0.0f;
+
+		for (size_t i = 0; i < culling.Bounds.size(); ++i)
+		{
+			const ObjectBound& bound = culling.Bounds[i];
+			if (!std::isfinite(bound.Radius))
+				continue;
+
+			// Objects are scaled by StepScale, so the clearance they need grows by its inverse
+			const Float3 offset = bound.Centre - ro;
+			const float closest = std::clamp(Dot(offset, rd), 0.0f, length);
+			if (Distance(bound.Centre, ro + rd * Float3(closest)) >= bound.Radius + clearance / bound.StepScale)
+				continue;
+
+			const float distance = Length(offset);
+			objects.push_back({ static_cast<int>(i), std::max(distance - bound.Radius, 0.0f), distance + bound.Radius });
+		}
+
+		std::sort(objects.begin(), objects.end(), [](const CulledObject& a, const CulledObject& b) { return a.NearDepth < b.NearDepth; });
+	}
+
+	SceneDistanceInfo GetDistanceToCulledObjects(const Scene& scene, const ObjectWalk& walk, const Float3& p, const float depth, const float maxDist,
+	                                             const float footprint)
+	{
+		// Index and distance of every object a scene order walk evaluates, folded once culling is done
+		thread_local std::vector<std::pair<int, float>> evaluated{};
+		evaluated.clear();
+
+		float dist = maxDist;
+		float prevDist = maxDist;
+		int index = 0;
+
+		// As GetDistanceToScene
+		for (const int objectIndex : walk.Shared)
+		{
+			const Object& object = scene.Objects[objectIndex];
+			const float objectDist = GetDistanceToObject(scene, object, p, footprint);
+			dist = CombineDistance(object, dist, objectDist);
+			if (walk.SceneOrder)
+				evaluated.emplace_back(objectIndex, objectDist);
+
+			if (prevDist != dist)
+				index = objectIndex;
+			prevDist = dist;
+		}
+
+		// The rest are unions. One whose bound starts further along than depth + dist is further from p than dist,
+		// and so is one whose bound the ray has already left. Smooth unions' bounds hold their blend radius, so the
+		// same goes for them.
+		for (const CulledObject& culled : walk.Culled)
+		{
+			if (culled.NearDepth >= depth + dist)
+				break;
+			if (culled.FarDepth < depth)
+				continue;
+
+			const Object& object = scene.Objects[culled.Index];
+			const float objectDist = GetDistanceToObject(scene, object, p, footprint);
+			if (walk.SceneOrder)
+			{
+				// A union never raises the distance, so the nearest so far still bounds the folded one for the tests
+				evaluated.emplace_back(culled.Index, objectDist);
+				dist = std::min(dist, objectDist);
+				continue;
+			}
+
+			const float combined = CombineDistance(object, dist, objectDist);
+			if (combined != dist)
+			{
+				dist = combined;
+				index = culled.Index;
+			}
+		}
+
+		if (walk.SceneOrder)
+		{
+			std::sort(evaluated.begin(), evaluated.end());
+			dist = maxDist;
+			prevDist = maxDist;
+			index = 0;
+			for (const auto& [objectIndex, objectDist] : evaluated)
+			{
+				dist = CombineDistance(scene.Objects[objectIndex], dist, objectDist);
+				if (prevDist != dist)
+					index = objectIndex;
+				prevDist = dist;
+			}
+		}
+
+		if (ObjectCostCounters* counters = GetActiveObjectCostCounters())
+		{
+			++counters->SceneEvaluations;
+			if (index < static_cast<int>(counters->Nearest.size()))
+				++counters->Nearest[index];
+		}
+
+		return { dist, index };
+	}
+}
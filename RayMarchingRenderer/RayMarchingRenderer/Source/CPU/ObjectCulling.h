@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "CPU/SceneData.h"
+#include "CPU/SignedDistance.h"
+
+// Screen space culling of the objects rays evaluate, like the light lists of
+// clustered forward shading. Each object's bounding sphere is projected onto
+// tiles of the screen, and each tile lists the objects that overlap it sorted
+// by the nearest depth along any ray they can be reached at. A primary ray
+// never leaves its tile's frustum, so objects outside it cannot change where
+// the ray stops, and walking the list in depth order it stops evaluating once
+// the remaining objects start further away than the distance it already has.
+// Shadow rays leave the frustum, so each gathers its own list from the bounds
+// instead (GatherShadowObjects).
+//
+// Only objects unioned with the rest of the scene can be culled. Everything up
+// to the last intersection or subtraction, smooth or not, and objects without
+// a bound (the fractal types and snippet ports), are evaluated by every ray in
+// scene order. Smooth unions are culled with their bounds grown by the blend
+// radius. Smooth union is not associative, so when a scene has any, the
+// objects a step does not cull are folded in scene order, and a point's
+// surface is the same whichever tile it is in.
+namespace CPU
+{
+	struct CulledObject
+	{
+		int Index{ 0 };           // Into Scene::Objects
+		float NearDepth{ 0.0f }; // No ray from the list's origin reaches the object's bound before this depth
+		float FarDepth{ 0.0f };  // or is still inside it after this one
+	};
+
+	// The objects one ray evaluates: Shared in scene order, then Culled in NearDepth order
+	struct ObjectWalk
+	{
+		std::span<const int> Shared{};
+		std::span<const CulledObject> Culled{};
+		bool SceneOrder{ false }; // Fold what is evaluated in scene order, for smooth unions
+	};
+
+	// World space bounding sphere of an object, grown by the largest hit threshold over its StepScale so that no
+	// ray hits the object outside it
+	struct ObjectBound
+	{
+		Float3 Centre{ 0.0f };
+		float Radius{ 0.0f };
+		float StepScale{ 1.0f };
+	};
+
+	// One frame's object bounds and per tile lists
+	struct ObjectCulling
+	{
+		std::vector<int> Shared{};
+		// Per object in Scene::Objects, with an infinite radius for those in Shared
+		std::vector<ObjectBound> Bounds{};
+
+		int TileSize{ 16 };
+		int TilesX{ 0 };
+		int TilesY{ 0 };
+		// Tile (x, y)'s objects are TileObjects[TileOffsets[i], TileOffsets[i + 1]) with i = y * TilesX + x
+		std::vector<uint32_t> TileOffsets{};
+		std::vector<CulledObject> TileObjects{};
+		// Some culled object is a smooth union, so walks fold in scene order
+		bool SmoothUnions{ false };
+	};
+
+	// Bounds every object and lists the ones the primary rays of camera march per tile. Scene::AnalyticPrimitives are
+	// left to shadow rays, so FindAnalyticPrimitives must run first when they are used.
+	[[nodiscard]] ObjectCulling BuildObjectCulling(const Scene& scene, const Camera& camera, const RenderSettings& settings, int tileSize = 16);
+
+	// The list the primary ray through pixel (x, y) walks
+	[[nodiscard]] ObjectWalk GetTileWalk(const ObjectCulling& culling, int x, int y);
+
+	// Fills objects with those the shadow ray from ro to lightPosition can be stopped or darkened by, in NearDepth
+	// order. Soft shadows darken by sharpness * distance / depth, so an object whose bound stays the ray's length
+	// over sharpness clear of it never lowers the result below 1.
+	void GatherShadowObjects(const ObjectCulling& culling, const Float3& ro, const Float3& lightPosition, float sharpness,
+	                         std::vector<CulledObject>& objects);
+
+	// GetDistanceToScene over the walk's objects at p, depth along a ray from the walk's origin
+	[[nodiscard]] SceneDistanceInfo GetDistanceToCulledObjects(const Scene& scene, const ObjectWalk& walk, const Float3& p, float depth,
+	                                                           float maxDist, float footprint = 0.0f);
+}
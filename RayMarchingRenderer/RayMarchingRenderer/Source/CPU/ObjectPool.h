@@ -0,0 +1,153 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Pooled storage for objects that are created and destroyed often. Slots are
+// allocated a chunk at a time and never move, so pointers stay valid until
+// the object is destroyed, and freed slots are reused newest first while they
+// are still warm. Each slot counts how many objects it has held, and a handle
+// remembers the count it was made with, so a handle to a destroyed object
+// resolves to nullptr rather than to whatever reused its slot.
+namespace CPU
+{
+	struct PoolHandle
+	{
+		static constexpr uint32_t NoIndex = UINT32_MAX;
+
+		uint32_t Index{ NoIndex };
+		uint32_t Generation{ 0u };
+
+		[[nodiscard]] bool IsNull() const { return Index == NoIndex; }
+		[[nodiscard]] bool operator==(const PoolHandle&) const = default;
+	};
+
+	struct PoolCounters
+	{
+		size_t ChunkAllocations{ 0u };
+		size_t Created{ 0u };
+		size_t Destroyed{ 0u };
+		size_t PeakLive{ 0u };
+	};
+
+	template <typename T, size_t ChunkSize = 64u>
+	class ObjectPool
+	{
+	public:
+		ObjectPool() = default;
+		ObjectPool(const ObjectPool&) = delete;
+		ObjectPool(ObjectPool&&) = delete;
+		ObjectPool& operator=(const ObjectPool&) = delete;
+		ObjectPool& operator=(ObjectPool&&) = delete;
+		~ObjectPool() { Clear(); }
+
+		template <typename... Args>
+		T* Create(Args&&... args)
+		{
+			if (FreeHead == PoolHandle::NoIndex)
+				AddChunk();
+
+			const uint32_t index = FreeHead;
+			Slot& slot = GetSlot(index);
+			// Constructed before the slot is taken, so a throwing constructor leaves the pool as it was
+			T* object = ::new (static_cast<void*>(slot.Storage)) T(std::forward<Args>(args)...);
+			FreeHead = slot.NextFree;
+			slot.Live = true;
+
+			++Counters.Created;
+			Counters.PeakLive = std::max(Counters.PeakLive, GetLiveCount());
+			return object;
+		}
+
+		// Does nothing for nullptr, or an object already destroyed, which would otherwise run its destructor again
+		// and thread the slot onto the free list twice, handing it to two later Creates
+		void Destroy(T* object)
+		{
+			if (!object)
+				return;
+
+			Slot& slot = GetSlot(object);
+			assert(slot.Live && "Object destroyed twice");
+			if (!slot.Live)
+				return;
+
+			object->~T();
+			slot.Live = false;
+			++slot.Generation;
+			slot.NextFree = FreeHead;
+			FreeHead = slot.Index;
+			++Counters.Destroyed;
+		}
+
+		// Destroys every live object, last slot first
+		void Clear()
+		{
+			for (size_t i = Chunks.size() * ChunkSize; i-- > 0u;)
+				if (Slot& slot = GetSlot(static_cast<uint32_t>(i)); slot.Live)
+					Destroy(std::launder(reinterpret_cast<T*>(slot.Storage)));
+		}
+
+		// object must be live in this pool
+		[[nodiscard]] PoolHandle GetHandle(const T* object) const
+		{
+			const Slot& slot = GetSlot(object);
+			return { slot.Index, slot.Generation };
+		}
+
+		// nullptr once the object the handle was made for is destroyed
+		[[nodiscard]] T* Get(const PoolHandle handle) const
+		{
+			if (handle.Index >= Chunks.size() * ChunkSize)
+				return nullptr;
+
+			Slot& slot = GetSlot(handle.Index);
+			return slot.Live && slot.Generation == handle.Generation ? std::launder(reinterpret_cast<T*>(slot.Storage)) : nullptr;
+		}
+
+		[[nodiscard]] size_t GetLiveCount() const { return Counters.Created - Counters.Destroyed; }
+		[[nodiscard]] size_t GetCapacity() const { return Chunks.size() * ChunkSize; }
+		[[nodiscard]] const PoolCounters& GetCounters() const { return Counters; }
+
+	private:
+		struct Slot
+		{
+			alignas(T) std::byte Storage[sizeof(T)];
+			uint32_t Index{ 0u };
+			uint32_t Generation{ 0u };
+			uint32_t NextFree{ PoolHandle::NoIndex };
+			bool Live{ false };
+		};
+
+		std::vector<std::unique_ptr<Slot[]>> Chunks{};
+		uint32_t FreeHead{ PoolHandle::NoIndex };
+		PoolCounters Counters{};
+
+		[[nodiscard]] Slot& GetSlot(const uint32_t index) const { return Chunks[index / ChunkSize][index % ChunkSize]; }
+		// The slot holding object, recovered from its address
+		[[nodiscard]] static Slot& GetSlot(const T* object)
+		{
+			return *reinterpret_cast<Slot*>(reinterpret_cast<std::byte*>(const_cast<T*>(object)) - offsetof(Slot, Storage));
+		}
+
+		void AddChunk()
+		{
+			const uint32_t first = static_cast<uint32_t>(Chunks.size() * ChunkSize);
+			Chunks.push_back(std::make_unique<Slot[]>(ChunkSize));
+			++Counters.ChunkAllocations;
+
+			// Threaded in order, so a new chunk fills front to back
+			Slot* slots = Chunks.back().get();
+			for (size_t i = 0; i < ChunkSize; ++i)
+			{
+				slots[i].Index = first + static_cast<uint32_t>(i);
+				slots[i].NextFree = i + 1 < ChunkSize ? first + static_cast<uint32_t>(i) + 1u : FreeHead;
+			}
+			FreeHead = first;
+		}
+	};
+}
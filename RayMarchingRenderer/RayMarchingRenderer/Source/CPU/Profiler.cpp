@@ -0,0 +1,245 @@
+#include "CPU/Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+namespace CPU
+{
+	namespace
+	{
+		using Clock = std::chrono::steady_clock;
+
+		static_assert((ProfileEventsPerThread & (ProfileEventsPerThread - 1u)) == 0u, "Ring size must be a power of two");
+
+		// Single writer ring. The owning thread fills a slot and then publishes it by
+		// advancing Head; readers copy a range and drop whatever was overwritten meanwhile.
+		// Slots are read while the writer may be refilling them, so every field is
+		// written and read through relaxed atomics, and Head alone tells torn copies apart.
+		struct ThreadBuffer
+		{
+			std::unique_ptr<ProfileEvent[]> Events{ std::make_unique<ProfileEvent[]>(ProfileEventsPerThread) };
+			std::atomic<uint64_t> Head{ 0u };
+			uint32_t Id{ 0u };
+			uint32_t Depth{ 0u }; // Only touched by the owning thread
+			std::string Name{};   // Guarded by Registry::Mutex
+		};
+
+		struct Registry
+		{
+			std::mutex Mutex{};
+			// Buffers outlive their threads, so zones of finished workers can still be exported
+			std::vector<std::unique_ptr<ThreadBuffer>> Buffers{};
+		};
+
+		Registry& GetRegistry()
+		{
+			static Registry registry;
+			return registry;
+		}
+
+		const Clock::time_point ClockStart = Clock::now();
+		std::atomic<bool> Enabled{ false };
+
+		// Frame starts, written by the main thread only
+		constexpr size_t FrameHistory = 4u;
+		uint64_t FrameStarts[FrameHistory]{};
+		uint64_t FrameCount{ 0u };
+
+		thread_local ThreadBuffer* LocalBuffer = nullptr;
+		// Name given before the thread's first zone, so threads that never record cost nothing
+		thread_local std::string LocalName{};
+
+		ThreadBuffer& GetLocalBuffer()
+		{
+			if (!LocalBuffer)
+			{
+				Registry& registry = GetRegistry();
+				const std::lock_guard lock(registry.Mutex);
+				auto buffer = std::make_unique<ThreadBuffer>();
+				buffer->Id = static_cast<uint32_t>(registry.Buffers.size());
+				buffer->Name = LocalName.empty() ? "Thread " + std::to_string(buffer->Id) : LocalName;
+				LocalBuffer = buffer.get();
+				registry.Buffers.push_back(std::move(buffer));
+			}
+			return *LocalBuffer;
+		}
+
+		static_assert(std::atomic_ref<uint64_t>::required_alignment <= alignof(uint64_t) &&
+		              std::atomic_ref<const char*>::required_alignment <= alignof(const char*),
+		              "ProfileEvent fields must be usable through atomic_ref");
+
+		void StoreEvent(ProfileEvent& slot, const ProfileEvent& event)
+		{
+			std::atomic_ref(slot.Name).store(event.Name, std::memory_order_relaxed);
+			std::atomic_ref(slot.Start).store(event.Start, std::memory_order_relaxed);
+			std::atomic_ref(slot.End).store(event.End, std::memory_order_relaxed);
+			std::atomic_ref(slot.Depth).store(event.Depth, std::memory_order_relaxed);
+		}
+
+		ProfileEvent LoadEvent(ProfileEvent& slot)
+		{
+			return { std::atomic_ref(slot.Name).load(std::memory_order_relaxed), std::atomic_ref(slot.Start).load(std::memory_order_relaxed),
+			         std::atomic_ref(slot.End).load(std::memory_order_relaxed), std::atomic_ref(slot.Depth).load(std::memory_order_relaxed) };
+		}
+
+		void Snapshot(const ThreadBuffer& buffer, const uint64_t start, const uint64_t end, std::vector<ProfileEvent>& events)
+		{
+			const uint64_t head = buffer.Head.load(std::memory_order_acquire);
+			const uint64_t oldest = head > ProfileEventsPerThread ? head - ProfileEventsPerThread : 0u;
+
+			// Zones are recorded as they finish, so walking back from the newest can stop at the first that ends before start
+			uint64_t first = head;
+			while (first > oldest &&
+			       std::atomic_ref(buffer.Events[(first - 1u) & (ProfileEventsPerThread - 1u)].End).load(std::memory_order_relaxed) > start)
+				--first;
+
+			std::vector<ProfileEvent> copied{};
+			copied.reserve(static_cast<size_t>(head - first));
+			for (uint64_t i = first; i < head; ++i)
+				copied.push_back(LoadEvent(buffer.Events[i & (ProfileEventsPerThread - 1u)]));
+
+			// Drop whatever the writer lapped while it was copied, including the slot it is filling now. A copy that saw
+			// any of a refill also sees, after the fence, the Head the writer had before it began.
+			std::atomic_thread_fence(std::memory_order_acquire);
+			const uint64_t after = buffer.Head.load(std::memory_order_relaxed);
+			const uint64_t valid = after >= ProfileEventsPerThread ? after - ProfileEventsPerThread + 1u : 0u;
+			for (uint64_t i = std::max(first, valid); i < head; ++i)
+			{
+				const ProfileEvent& event = copied[static_cast<size_t>(i - first)];
+				if (event.Start < end)
+					events.push_back(event);
+			}
+		}
+
+		std::string EscapeJson(const char* text)
+		{
+			std::string escaped;
+			for (; *text; ++text)
+			{
+				if (*text == '"' || *text == '\\')
+					escaped += '\\';
+				if (static_cast<unsigned char>(*text) >= 0x20u)
+					escaped += *text;
+			}
+			return escaped;
+		}
+	}
+
+	bool IsProfilerEnabled()
+	{
+		return Enabled.load(std::memory_order_relaxed);
+	}
+
+	void SetProfilerEnabled(const bool enabled)
+	{
+		Enabled.store(enabled, std::memory_order_relaxed);
+	}
+
+	uint64_t GetProfilerTime()
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - ClockStart).count());
+	}
+
+	void SetProfilerThreadName(const std::string& name)
+	{
+		LocalName = name;
+		if (!LocalBuffer)
+			return;
+
+		const std::lock_guard lock(GetRegistry().Mutex);
+		LocalBuffer->Name = name;
+	}
+
+	void MarkProfilerFrame()
+	{
+		FrameStarts[FrameCount % FrameHistory] = GetProfilerTime();
+		++FrameCount;
+	}
+
+	bool GetLastProfilerFrame(uint64_t& start, uint64_t& end)
+	{
+		if (FrameCount < 2u)
+			return false;
+
+		start = FrameStarts[(FrameCount - 2u) % FrameHistory];
+		end = FrameStarts[(FrameCount - 1u) % FrameHistory];
+		return true;
+	}
+
+	std::vector<ProfileThread> CaptureProfile(const uint64_t start, const uint64_t end)
+	{
+		Registry& registry = GetRegistry();
+		const std::lock_guard lock(registry.Mutex);
+
+		std::vector<ProfileThread> threads(registry.Buffers.size());
+		for (size_t i = 0; i < registry.Buffers.size(); ++i)
+		{
+			threads[i].Id = registry.Buffers[i]->Id;
+			threads[i].Name = registry.Buffers[i]->Name;
+			Snapshot(*registry.Buffers[i], start, end, threads[i].Events);
+		}
+		return threads;
+	}
+
+	void WriteChromeTrace(const std::filesystem::path& path, const std::vector<ProfileThread>& threads)
+	{
+		std::ofstream file(path);
+		if (!file)
+			throw std::runtime_error("Trace file \"" + path.string() + "\" could not be opened for writing");
+
+		// Complete ("X") events in microseconds, plus a name for each thread
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		bool first = true;
+		char number[64]{};
+		for (const ProfileThread& thread : threads)
+		{
+			file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.Id
+			     << ",\"args\":{\"name\":\"" << EscapeJson(thread.Name.c_str()) << "\"}}";
+			first = false;
+
+			for (const ProfileEvent& event : thread.Events)
+			{
+				std::snprintf(number, sizeof(number), "%.3f,\"dur\":%.3f", static_cast<double>(event.Start) * 1e-3,
+				              static_cast<double>(event.End - event.Start) * 1e-3);
+				file << ",\n{\"name\":\"" << EscapeJson(event.Name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread.Id << ",\"ts\":" << number << '}';
+			}
+		}
+		file << "\n]}\n";
+
+		if (!file)
+			throw std::runtime_error("Failed writing trace file \"" + path.string() + "\"");
+	}
+
+	ProfileZone::ProfileZone(const char* name)
+	{
+		if (!IsProfilerEnabled())
+			return;
+
+		++GetLocalBuffer().Depth;
+		Name = name;
+		Start = GetProfilerTime();
+	}
+
+	ProfileZone::~ProfileZone()
+	{
+		// A zone open when the profiler was switched on or off still closes consistently
+		if (!Name)
+			return;
+
+		const uint64_t end = GetProfilerTime();
+		ThreadBuffer& buffer = *LocalBuffer;
+		--buffer.Depth;
+
+		// The fence orders the slot's refill after the Head store that published its previous zone, for Snapshot
+		const uint64_t head = buffer.Head.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		StoreEvent(buffer.Events[head & (ProfileEventsPerThread - 1u)], { Name, Start, end, buffer.Depth });
+		buffer.Head.store(head + 1u, std::memory_order_release);
+	}
+}
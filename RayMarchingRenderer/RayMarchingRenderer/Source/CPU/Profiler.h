@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Hierarchical scoped-zone CPU profiler. Each thread records finished zones
+// into its own lock-free ring buffer, so recording never waits on another
+// thread; readers take snapshots for the flame view and Chrome trace export.
+// Zones are switched on at run time with SetProfilerEnabled and removed
+// entirely by building with RAYMARCH_PROFILER=0.
+#ifndef RAYMARCH_PROFILER
+#define RAYMARCH_PROFILER 1
+#endif
+
+namespace CPU
+{
+	// Zones kept per thread; older zones are overwritten
+	inline constexpr size_t ProfileEventsPerThread = size_t{ 1 } << 15u;
+
+	struct ProfileEvent
+	{
+		const char* Name{ nullptr }; // Must outlive the profiler, usually a string literal
+		uint64_t Start{ 0u };        // Nanoseconds on the profiler clock
+		uint64_t End{ 0u };
+		uint32_t Depth{ 0u };        // Zones open on the thread when this one began
+	};
+
+	struct ProfileThread
+	{
+		uint32_t Id{ 0u }; // Order the thread first recorded in
+		std::string Name{};
+		std::vector<ProfileEvent> Events{}; // In order of finishing
+	};
+
+	[[nodiscard]] bool IsProfilerEnabled();
+	void SetProfilerEnabled(bool enabled);
+
+	// Nanoseconds since the profiler clock started
+	[[nodiscard]] uint64_t GetProfilerTime();
+
+	// Shown for the calling thread in traces and the flame view
+	void SetProfilerThreadName(const std::string& name);
+
+	// Marks the start of a frame on the calling thread, which should be the main thread
+	void MarkProfilerFrame();
+	// Start and end of the most recent finished frame, false before two frames have been marked
+	[[nodiscard]] bool GetLastProfilerFrame(uint64_t& start, uint64_t& end);
+
+	// Zones overlapping [start, end) of every thread that has recorded any
+	[[nodiscard]] std::vector<ProfileThread> CaptureProfile(uint64_t start = 0u, uint64_t end = UINT64_MAX);
+
+	// Chrome trace event JSON, for chrome://tracing and ui.perfetto.dev. Throws std::runtime_error if the file can't be written.
+	void WriteChromeTrace(const std::filesystem::path& path, const std::vector<ProfileThread>& threads);
+
+	// Times its scope when the profiler is enabled. Use through PROFILE_ZONE.
+	class ProfileZone
+	{
+	public:
+		explicit ProfileZone(const char* name);
+		ProfileZone(const ProfileZone&) = delete;
+		ProfileZone(ProfileZone&&) = delete;
+		ProfileZone& operator=(const ProfileZone&) = delete;
+		ProfileZone& operator=(ProfileZone&&) = delete;
+		~ProfileZone();
+
+	private:
+		const char* Name{ nullptr };
+		uint64_t Start{ 0u };
+	};
+}
+
+#if RAYMARCH_PROFILER
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) const CPU::ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name)
+#endif
@@ -0,0 +1,243 @@
+#include "CPU/ProxyRaster.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "CPU/RayMarcher.h"
+#include "CPU/SignedDistance.h"
+
+namespace CPU
+{
+	namespace
+	{
+		// A ray entering a proxy is at least this far from the eye there, since the eye being closer to a
+		// proxy counts as inside it
+		constexpr float NearMargin = 1e-3f;
+		// Distance from an edge, in pixels, a pixel centre still counts as covered at, and the fraction taken off
+		// every depth, so rounding never starts a ray past a surface
+		constexpr float EdgeTolerance = 0.01f;
+		constexpr float DepthSlack = 1e-3f;
+
+		// Corners of a box by bit: x (1), y (2), z (4). Faces by the axis they face along, negative first.
+		constexpr int BoxFaces[6][4] = { { 0, 2, 6, 4 }, { 1, 3, 7, 5 }, { 0, 1, 5, 4 }, { 2, 3, 7, 6 }, { 0, 1, 3, 2 }, { 4, 5, 7, 6 } };
+
+		struct ScreenVertex
+		{
+			float X{ 0.0f };
+			float Y{ 0.0f };
+			float InverseZ{ 0.0f };
+		};
+
+		class ProxyRasteriser
+		{
+		public:
+			ProxyRasteriser(const Camera& camera, const RenderSettings& settings, Image<float>& depths)
+				: View(camera), Depths(depths), Width(settings.Width), Height(settings.Height)
+			{
+				Focal = std::tan(-camera.FOV);
+				Aspect = static_cast<float>(Width) / static_cast<float>(std::max(Height, 1));
+				// View z over depth is smallest along the rays through the corners
+				NearPlane = NearMargin * Focal / std::sqrt(Aspect * Aspect + 1.0f + Focal * Focal);
+			}
+
+			// Rasterises the face of a box, as world space corners, that looks towards the eye
+			void RasteriseFace(const Float3 (&corners)[8], const int (&face)[4])
+			{
+				Float3 polygon[4]{};
+				for (int i = 0; i < 4; ++i)
+				{
+					const Float3 offset = corners[face[i]] - View.Position;
+					polygon[i] = Float3(Dot(offset, View.Right), Dot(offset, View.Up), Dot(offset, View.Forward));
+				}
+
+				// Clipped to z >= NearPlane, a quad gains at most one vertex
+				ScreenVertex clipped[5]{};
+				int count = 0;
+				for (int i = 0; i < 4; ++i)
+				{
+					const Float3& a = polygon[i];
+					const Float3& b = polygon[(i + 1) % 4];
+					if (a.z >= NearPlane)
+						clipped[count++] = Project(a);
+					if ((a.z >= NearPlane) != (b.z >= NearPlane))
+					{
+						const float t = (NearPlane - a.z) / (b.z - a.z);
+						clipped[count++] = Project(Float3(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, NearPlane));
+					}
+				}
+
+				for (int i = 2; i < count; ++i)
+					RasteriseTriangle(clipped[0], clipped[i - 1], clipped[i]);
+			}
+
+		private:
+			const Camera& View;
+			Image<float>& Depths;
+			int Width{ 0 };
+			int Height{ 0 };
+			float Focal{ 1.0f };
+			float Aspect{ 1.0f };
+			float NearPlane{ 0.0f };
+
+			// Inverse of CalculateRayDirection, to pixels whose centres are at integer coordinates
+			[[nodiscard]] ScreenVertex Project(const Float3& view) const
+			{
+				const float halfWidth = 0.5f * static_cast<float>(Width);
+				const float halfHeight = 0.5f * static_cast<float>(Height);
+				const float u = Focal * view.x / view.z;
+				const float v = Focal * view.y / view.z;
+				return { u * halfWidth / Aspect + halfWidth - 0.5f, halfHeight - v * halfHeight - 0.5f, 1.0f / view.z };
+			}
+
+			// Depth along the ray through pixel (x, y) per unit of view z
+			[[nodiscard]] float GetDepthScale(const int x, const int y) const
+			{
+				const float u = (2.0f * (static_cast<float>(x) + 0.5f) / static_cast<float>(Width) - 1.0f) * Aspect;
+				const float v = 1.0f - 2.0f * (static_cast<float>(y) + 0.5f) / static_cast<float>(Height);
+				return std::sqrt(u * u + v * v + Focal * Focal) / Focal;
+			}
+
+			void RasteriseTriangle(const ScreenVertex& a, const ScreenVertex& b, const ScreenVertex& c)
+			{
+				const float area = (b.X - a.X) * (c.Y - a.Y) - (b.Y - a.Y) * (c.X - a.X);
+				// Edge on, where the box's other faces cover its outline
+				if (std::abs(area) < 1e-12f)
+					return;
+
+				const float minX = std::min({ a.X, b.X, c.X }) - EdgeTolerance;
+				const float maxX = std::max({ a.X, b.X, c.X }) + EdgeTolerance;
+				const float minY = std::min({ a.Y, b.Y, c.Y }) - EdgeTolerance;
+				const float maxY = std::max({ a.Y, b.Y, c.Y }) + EdgeTolerance;
+				if (maxX < 0.0f || maxY < 0.0f || minX > static_cast<float>(Width - 1) || minY > static_cast<float>(Height - 1))
+					return;
+				// Clamped before converting, as vertices clipped near the eye project far off screen
+				const int x0 = static_cast<int>(std::ceil(std::max(minX, 0.0f)));
+				const int x1 = static_cast<int>(std::floor(std::min(maxX, static_cast<float>(Width - 1))));
+				const int y0 = static_cast<int>(std::ceil(std::max(minY, 0.0f)));
+				const int y1 = static_cast<int>(std::floor(std::min(maxY, static_cast<float>(Height - 1))));
+
+				// Edge functions over the edge's length are distances in pixels, positive inside either winding
+				const float sign = area > 0.0f ? 1.0f : -1.0f;
+				const ScreenVertex* vertices[3] = { &a, &b, &c };
+				float edgeScale[3]{};
+				for (int i = 0; i < 3; ++i)
+				{
+					const ScreenVertex& from = *vertices[(i + 1) % 3];
+					const ScreenVertex& to = *vertices[(i + 2) % 3];
+					edgeScale[i] = sign / std::sqrt((to.X - from.X) * (to.X - from.X) + (to.Y - from.Y) * (to.Y - from.Y));
+				}
+
+				for (int y = y0; y <= y1; ++y)
+				{
+					for (int x = x0; x <= x1; ++x)
+					{
+						const float px = static_cast<float>(x);
+						const float py = static_cast<float>(y);
+						float weights[3]{};
+						bool inside = true;
+						for (int i = 0; i < 3; ++i)
+						{
+							const ScreenVertex& from = *vertices[(i + 1) % 3];
+							const ScreenVertex& to = *vertices[(i + 2) % 3];
+							weights[i] = (to.X - from.X) * (py - from.Y) - (to.Y - from.Y) * (px - from.X);
+							inside = inside && weights[i] * edgeScale[i] >= -EdgeTolerance;
+						}
+						if (!inside)
+							continue;
+
+						// 1 / z is affine in screen space
+						const float inverseZ = (weights[0] * a.InverseZ + weights[1] * b.InverseZ + weights[2] * c.InverseZ) / area;
+						const float depth = inverseZ > 0.0f ? GetDepthScale(x, y) / inverseZ * (1.0f - DepthSlack) : 0.0f;
+						float& stored = Depths.At(x, y);
+						stored = std::min(stored, depth);
+					}
+				}
+			}
+		};
+	}
+
+	void RasteriseProxyDepths(const Scene& scene, const Camera& camera, const RenderSettings& settings, Image<float>& depths)
+	{
+		depths = Image<float>(settings.Width, settings.Height, settings.MaxDist);
+
+		// A field of view of 90 degrees or less puts the image plane behind the eye, which the projection can't take
+		if (std::tan(-camera.FOV) <= 0.0f)
+		{
+			depths = Image<float>(settings.Width, settings.Height, 0.0f);
+			return;
+		}
+
+		std::vector<bool> analytic(scene.Objects.size(), false);
+		for (const AnalyticPrimitive& primitive : scene.AnalyticPrimitives)
+			analytic[primitive.Index] = true;
+
+		const float maxThreshold = GetMaxIntersectionThreshold(settings);
+		ProxyRasteriser rasteriser(camera, settings, depths);
+		for (size_t i = 0; i < scene.Objects.size(); ++i)
+		{
+			const Object& object = scene.Objects[i];
+			if (analytic[i] || !IsUnionOperator(object.BoolOperator))
+				continue;
+
+			Float3 lo{}, hi{};
+			if (!scene.SDFLibrary.empty() || object.Scale.x <= 0.0f || object.StepScale <= 0.0f ||
+			    !GetSDFLocalBounds(object.SDFType, object.Parameters, lo, hi))
+			{
+				depths = Image<float>(settings.Width, settings.Height, 0.0f);
+				return;
+			}
+
+			// Repetition lays copies out before the object's scale
+			if (object.Repeat.Mode != static_cast<int>(RepetitionMode::None))
+			{
+				const Float3 scale(object.Scale.x);
+				lo *= scale;
+				hi *= scale;
+				if (!GetRepeatedBounds(object.Repeat, lo, hi))
+				{
+					depths = Image<float>(settings.Width, settings.Height, 0.0f);
+					return;
+				}
+				lo /= scale;
+				hi /= scale;
+			}
+
+			// Grown in local space, where it is scaled down with the object. A little slack, as for the bounding spheres,
+			// and a smooth union's blend radius, within which it can add to the surface.
+			const float blend = object.BoolOperator == 3 ? std::max(object.BlendRadius, 0.0f) : 0.0f;
+			const Float3 grow(((maxThreshold + blend) / object.StepScale) / object.Scale.x + 1e-3f * Length(hi - lo));
+			lo -= grow;
+			hi += grow;
+
+			// The eye inside, or too near to clip safely, sees the proxy everywhere
+			const Float3 eye = Rotate(Translate(camera.Position, object.Position), object.Rotation) / Float3(object.Scale.x);
+			const Float3 margin(NearMargin / object.Scale.x);
+			const Float3 outside = Max(lo - margin - eye, eye - hi - margin);
+			if (std::max({ outside.x, outside.y, outside.z }) <= 0.0f)
+			{
+				depths = Image<float>(settings.Width, settings.Height, 0.0f);
+				return;
+			}
+
+			Float3 corners[8]{};
+			for (int corner = 0; corner < 8; ++corner)
+			{
+				const Float3 local((corner & 1) ? hi.x : lo.x, (corner & 2) ? hi.y : lo.y, (corner & 4) ? hi.z : lo.z);
+				corners[corner] = object.Position + InverseRotate(local * Float3(object.Scale.x), object.Rotation);
+			}
+
+			// Only the faces the eye is outside of can be where a ray enters
+			const float eyeAxes[3] = { eye.x, eye.y, eye.z };
+			const float loAxes[3] = { lo.x, lo.y, lo.z };
+			const float hiAxes[3] = { hi.x, hi.y, hi.z };
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				if (eyeAxes[axis] < loAxes[axis])
+					rasteriser.RasteriseFace(corners, BoxFaces[axis * 2]);
+				if (eyeAxes[axis] > hiAxes[axis])
+					rasteriser.RasteriseFace(corners, BoxFaces[axis * 2 + 1]);
+			}
+		}
+	}
+}
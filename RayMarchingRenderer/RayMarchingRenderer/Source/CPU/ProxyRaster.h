@@ -0,0 +1,25 @@
+#pragma once
+#include "CPU/Image.h"
+#include "CPU/SceneData.h"
+
+// Hybrid rasterisation for the primary rays. Every marched object unioned
+// with the scene gets a proxy, the box around its surface in its local space
+// grown by the largest hit threshold, and the proxies are rasterised into the
+// depth along each pixel's ray at which it first enters one. No ray can hit
+// anything before that, so marching starts there, and a pixel no proxy covers
+// is not marched at all. Intersected and subtracted objects, smooth or not,
+// only ever take away from the unioned ones, so they need no proxy. Smooth
+// unions' proxies are grown by the blend radius. A unioned object without a
+// bound (the fractal types and snippet ports) covers every pixel from 0.
+//
+// The rasteriser is in software, so the CPU path measures what a depth
+// prepass would save: front faces clipped at a near plane, then edge functions
+// at the pixel centres the primary rays pass through, with depth interpolated
+// perspective correctly.
+namespace CPU
+{
+	// Fills depths, sized to settings.Width x settings.Height, for the primary rays of camera, settings.MaxDist
+	// where a ray enters no proxy. Skips Scene::AnalyticPrimitives, which RayMarch intersects in closed form, so
+	// FindAnalyticPrimitives must run first when they are used.
+	void RasteriseProxyDepths(const Scene& scene, const Camera& camera, const RenderSettings& settings, Image<float>& depths);
+}
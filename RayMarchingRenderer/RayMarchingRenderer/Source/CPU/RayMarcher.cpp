@@ -0,0 +1,311 @@
+#include "CPU/RayMarcher.h"
+
+#include "CPU/AnalyticPrimitives.h"
+
+namespace CPU
+{
+	namespace
+	{
+		// Offset along the normal for rays leaving a hit at depth along cone, clear of the threshold the hit was
+		// found at and of the one the new ray starts with
+		float GetSurfaceOffset(const RenderSettings& settings, const RayCone& cone, const float depth, const float secondaryScale)
+		{
+			const RayCone secondary{ cone.Angle, cone.Offset + depth };
+			return 2.0f * std::max(GetIntersectionThreshold(settings, settings.ConeThresholdScale, cone, depth),
+			                       GetIntersectionThreshold(settings, secondaryScale, secondary, 0.0f));
+		}
+	}
+
+	float GetIntersectionThreshold(const RenderSettings& settings, const float coneScale, const RayCone& cone, const float depth)
+	{
+		if (coneScale <= 0.0f)
+			return settings.IntersectionThreshold;
+		return std::clamp(cone.GetRadius(depth) * coneScale, settings.MinThreshold, settings.MaxThreshold);
+	}
+
+	float GetMaxIntersectionThreshold(const RenderSettings& settings)
+	{
+		const bool coneThresholds = settings.ConeThresholdScale > 0.0f || settings.SecondaryConeThresholdScale > 0.0f;
+		return std::max(settings.IntersectionThreshold, coneThresholds ? settings.MaxThreshold : 0.0f);
+	}
+
+	Float3 CalculateNormal(const Scene& scene, const Float3& p, const float maxDist, const float footprint, const float offset)
+	{
+		if (scene.Objects.empty())
+			return Float3(0.0f, 1.0f, 0.0f);
+
+		return Normalize(GetSceneGradient(scene, p, maxDist, footprint, offset));
+	}
+
+	Ray RayMarch(const Scene& scene, const RenderSettings& settings, const Float3& ro, const Float3& rd, const RayCone& cone, PixelCost* cost,
+	             const ObjectWalk* walk, const float startDepth)
+	{
+		Ray ray{};
+		ray.Cone = cone;
+
+		// Analytic primitives are hit exactly, so marching only looks for the other objects in front of them
+		const AnalyticHit analytic = IntersectAnalyticPrimitives(scene, ro, rd, settings.MaxDist);
+
+		// Nothing to march between the start and the analytic hit
+		ray.Depth = startDepth;
+		const bool skip = startDepth > 0.0f && startDepth >= analytic.Depth;
+
+		// Step along ray direction
+		for (; !skip && ray.StepCount < settings.MaxSteps; ++ray.StepCount)
+		{
+			const float footprint = cone.GetRadius(ray.Depth) * settings.FootprintScale;
+			const Float3 p = ro + rd * Float3(ray.Depth);
+			const SceneDistanceInfo distInfo = walk ? GetDistanceToCulledObjects(scene, *walk, p, ray.Depth, settings.MaxDist, footprint)
+			                                        : GetDistanceToMarchedObjects(scene, p, settings.MaxDist, footprint);
+			if (cost)
+				++cost->SDFEvaluations;
+
+			// If distance less than threshold, ray has intersected
+			const float threshold = GetIntersectionThreshold(settings, settings.ConeThresholdScale, cone, ray.Depth);
+			if (distInfo.Distance < threshold)
+			{
+				ray.Hit = true;
+				ray.HitPosition = ro + rd * Float3(ray.Depth);
+				ray.HitNormal = CalculateNormal(scene, ray.HitPosition, settings.MaxDist, footprint, 0.5f * threshold);
+				ray.HitIndex = distInfo.Index;
+				if (cost)
+				{
+					++cost->NormalEvaluations;
+					++cost->SDFEvaluations;
+				}
+				return ray;
+			}
+
+			// Increment total depth by distance to scene
+			ray.Depth += distInfo.Distance;
+			if (ray.Depth > analytic.Depth)
+				break;
+		}
+
+		if (analytic.Index >= 0)
+		{
+			ray.Hit = true;
+			ray.Depth = analytic.Depth;
+			ray.HitPosition = ro + rd * Float3(ray.Depth);
+			ray.HitNormal = analytic.Normal;
+			ray.HitIndex = analytic.Index;
+		}
+		return ray;
+	}
+
+	float ShadowMarch(const Scene& scene, const RenderSettings& settings, const Float3& ro, const Light& light, const RayCone& cone, uint32_t* evaluations,
+	                  const ObjectCulling* culling)
+	{
+		float result = 1.0f;
+
+		const Float3 rd = Normalize(light.Position - ro);
+
+		// Marching would stop on any analytic primitive between here and the light
+		if (IntersectAnalyticPrimitives(scene, ro, rd, std::min(Distance(ro, light.Position), settings.MaxDist)).Index >= 0)
+			return 0.0f;
+
+		thread_local std::vector<CulledObject> shadowObjects{};
+		ObjectWalk walk{};
+		if (culling)
+		{
+			GatherShadowObjects(*culling, ro, light.Position, light.ShadowSharpness, shadowObjects);
+			walk = { culling->Shared, shadowObjects, culling->SmoothUnions };
+		}
+
+		float depth = 0.0f;
+		uint32_t count = 0u;
+		for (unsigned int i = 0; i < settings.MaxSteps; ++i)
+		{
+			const Float3 p = ro + rd * Float3(depth);
+			const float footprint = cone.GetRadius(depth) * settings.FootprintScale;
+			const SceneDistanceInfo distInfo = culling ? GetDistanceToCulledObjects(scene, walk, p, depth, settings.MaxDist, footprint)
+			                                           : GetDistanceToScene(scene, p, settings.MaxDist, footprint);
+			++count;
+
+			// If ray is able to become close to light, there is no shadow.
+			if (Dot(Normalize(light.Position - p), rd) < 0.0f)
+				break;
+
+			// If distance less than threshold, ray has intersected
+			if (distInfo.Distance < GetIntersectionThreshold(settings, settings.SecondaryConeThresholdScale, cone, depth))
+			{
+				result = 0.0f;
+				break;
+			}
+
+			// Soft shadowing
+			result = std::min(result, light.ShadowSharpness * distInfo.Distance / depth);
+
+			// Increment total depth by distance to light
+			depth += distInfo.Distance;
+			if (depth > settings.MaxDist)
+				break;
+		}
+
+		if (evaluations)
+			*evaluations += count;
+		return result;
+	}
+
+	Float3 CalculateLightColour(const Scene& scene, const RenderSettings& settings, const Camera& camera, const Ray& ray, PixelCost* cost,
+	                            const ObjectCulling* culling)
+	{
+		Float3 lightCol(0.0f);
+		const Float3 rd = Normalize(ray.HitPosition - camera.Position);
+		const Object& object = scene.Objects[ray.HitIndex];
+		// Shadow rays carry on the cone from the hit
+		const RayCone shadowCone{ ray.Cone.Angle, ray.Cone.Offset + ray.Depth };
+		const float shadowOffset = GetSurfaceOffset(settings, ray.Cone, ray.Depth, settings.SecondaryConeThresholdScale);
+
+		// Unused GPU light slots have zero colour, so only scene lights are evaluated here
+		for (size_t i = 0; i < scene.Lights.size(); ++i)
+		{
+			const Light& light = scene.Lights[i];
+			const Float3 lightDir = Normalize(light.Position - ray.HitPosition);
+			const float diffuse = Saturate(Dot(ray.HitNormal, lightDir));
+
+			float specular = 0.0f;
+			float shadowAmount = 1.0f;
+			if (diffuse > 0.0f)
+			{
+				const float specularPower = (1.0f - object.Roughness) * 256.0f + 2.0f;
+				// pow of a negative base is NaN on the GPU, which saturate() turns into 0
+				const float rdDotRef = Dot(rd, Reflect(ray.HitNormal, lightDir));
+				specular = rdDotRef > 0.0f ? Saturate(std::pow(rdDotRef, specularPower)) : 0.0f;
+				uint32_t shadowSteps = 0u;
+				shadowAmount = ShadowMarch(scene, settings, ray.HitPosition + ray.HitNormal * Float3(shadowOffset), light, shadowCone, &shadowSteps,
+				                           culling);
+				if (cost)
+				{
+					cost->ShadowSteps += shadowSteps;
+					cost->SDFEvaluations += shadowSteps;
+					if (i < cost->LightShadowSteps.size())
+						cost->LightShadowSteps[i] = static_cast<uint16_t>(std::min(cost->LightShadowSteps[i] + shadowSteps, 0xFFFFu));
+				}
+			}
+
+			const float d = Distance(ray.HitPosition, light.Position);
+			const float attenuation = 1.0f / (light.ConstantAttenuation + light.LinearAttenuation * d + light.QuadraticAttenuation * d * d);
+
+			lightCol += light.Colour * Float3((diffuse * shadowAmount + specular) * attenuation);
+		}
+
+		return lightCol;
+	}
+
+	Float4 CalculateSkyColour(const Float3& dir)
+	{
+		const float t = Saturate(dir.y * 0.5f + 0.5f);
+		return Float4(Lerp(Float3(0.9f, 0.9f, 0.85f), Float3(0.35f, 0.55f, 0.9f), t), 1.0f);
+	}
+
+	Float3 CalculateRayDirection(const Camera& camera, const RenderSettings& settings, const Float2& texCoord)
+	{
+		const float aspectRatio = static_cast<float>(settings.Width) / static_cast<float>(settings.Height);
+		Float2 uv = texCoord;
+		uv.y = 1.0f - uv.y; // Flip UV on Y axis
+		uv = uv * Float2(2.0f) - Float2(1.0f); // Move UV to (-1, 1) range
+		uv.x *= aspectRatio; // Apply viewport aspect ratio
+
+		return Normalize(camera.Right * Float3(uv.x) + camera.Up * Float3(uv.y) + camera.Forward * Float3(std::tan(-camera.FOV)));
+	}
+
+	float CalculatePixelConeAngle(const Camera& camera, const RenderSettings& settings)
+	{
+		// The image plane spans 2 units over Height pixels at tan(-FOV) from the eye
+		return 1.0f / (static_cast<float>(settings.Height) * std::abs(std::tan(-camera.FOV)));
+	}
+
+	void RenderGBufferRows(const Scene& scene, const Camera& camera, const RenderSettings& settings, GBuffer& output, const int rowBegin, const int rowEnd,
+	                       Image<PixelCost>* costs, const ObjectCulling* culling, const Image<float>* proxyDepths)
+	{
+		const RayCone primaryCone{ CalculatePixelConeAngle(camera, settings) };
+		for (int y = rowBegin; y < rowEnd; ++y)
+		{
+			for (int x = 0; x < settings.Width; ++x)
+			{
+				const Float2 texCoord((static_cast<float>(x) + 0.5f) / static_cast<float>(settings.Width),
+				                      (static_cast<float>(y) + 0.5f) / static_cast<float>(settings.Height));
+				const Float3 rd = CalculateRayDirection(camera, settings, texCoord);
+
+				Float4 finalColour = CalculateSkyColour(rd);
+
+				// Misses keep a zero material, as ObjectsList[-1] reads zero on the GPU
+				PixelCost cost{};
+				const ObjectWalk walk = culling ? GetTileWalk(*culling, x, y) : ObjectWalk{};
+				const Ray ray = RayMarch(scene, settings, camera.Position, rd, primaryCone, &cost, culling ? &walk : nullptr,
+				                         proxyDepths ? proxyDepths->At(x, y) : 0.0f);
+				cost.PrimarySteps = ray.StepCount;
+				Object material{};
+				if (ray.Hit)
+				{
+					material = scene.Objects[ray.HitIndex];
+					const Float3 lightCol = CalculateLightColour(scene, settings, camera, ray, &cost, culling);
+
+					// Ambient Occlusion
+					const float ao = 1.0f - static_cast<float>(ray.StepCount) / (static_cast<float>(settings.MaxSteps) / settings.AmbientOcclusionStrength);
+
+					finalColour = Float4(material.Colour * (Float3(0.2f) + lightCol) * Float3(ao), 1.0f);
+				}
+
+				output.Colour.At(x, y) = finalColour;
+				output.NormDepth.At(x, y) = Float4(ray.HitNormal * Float3(0.5f) + Float3(0.5f), ray.Depth / settings.MaxDist);
+				output.MaterialIndex.At(x, y) = Float4(material.Metalicness, material.Roughness, static_cast<float>(ray.HitIndex), ray.Hit ? 1.0f : 0.0f);
+				if (costs)
+					costs->At(x, y) = cost;
+			}
+		}
+	}
+
+	void RenderGBuffer(const Scene& scene, const Camera& camera, const RenderSettings& settings, GBuffer& output)
+	{
+		output.Resize(settings.Width, settings.Height);
+		RenderGBufferRows(scene, camera, settings, output, 0, settings.Height);
+	}
+
+	void TraceReflectionRows(const Scene& scene, const Camera& camera, const RenderSettings& settings, const GBuffer& gbuffer, Image<Float4>& output,
+	                         const int rowBegin, const int rowEnd, Image<PixelCost>* costs)
+	{
+		// Reflection, with render settings of lower fidelity
+		RenderSettings reflectionSettings = settings;
+		reflectionSettings.MaxSteps /= 2;
+		reflectionSettings.ConeThresholdScale = settings.SecondaryConeThresholdScale;
+		const float coneAngle = CalculatePixelConeAngle(camera, settings);
+
+		for (int y = rowBegin; y < rowEnd; ++y)
+		{
+			for (int x = 0; x < settings.Width; ++x)
+			{
+				const Float2 texCoord((static_cast<float>(x) + 0.5f) / static_cast<float>(settings.Width),
+				                      (static_cast<float>(y) + 0.5f) / static_cast<float>(settings.Height));
+				const Float3 rd = CalculateRayDirection(camera, settings, texCoord);
+				const Float4 material = gbuffer.MaterialIndex.At(x, y);
+
+				Float4 result(CalculateSkyColour(rd).xyz(), settings.MaxDist);
+				if (material.w > 0.0f && material.x > 0.0f)
+				{
+					const Float4 normDepth = gbuffer.NormDepth.At(x, y);
+					const Float3 normal = Normalize(normDepth.xyz() * Float3(2.0f) - Float3(1.0f));
+					const Float3 hitPosition = camera.Position + rd * Float3(normDepth.w * settings.MaxDist);
+					const Float3 refDir = Reflect(rd, normal);
+
+					PixelCost* cost = costs ? &costs->At(x, y) : nullptr;
+					// The reflected cone carries on from the primary hit
+					const float depth = normDepth.w * settings.MaxDist;
+					const float offset = GetSurfaceOffset(settings, RayCone{ coneAngle }, depth, reflectionSettings.ConeThresholdScale);
+					const Ray ray = RayMarch(scene, reflectionSettings, hitPosition + normal * Float3(offset), refDir, RayCone{ coneAngle, depth }, cost);
+					if (cost)
+						cost->ReflectionSteps += ray.StepCount;
+
+					Float3 colour = CalculateSkyColour(refDir).xyz();
+					if (ray.Hit)
+						colour = scene.Objects[ray.HitIndex].Colour * (Float3(0.2f) + CalculateLightColour(scene, reflectionSettings, camera, ray, cost));
+
+					result = Float4(colour, ray.Depth);
+				}
+
+				output.At(x, y) = result;
+			}
+		}
+	}
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+
+#include "CPU/CostCounters.h"
+#include "CPU/Image.h"
+#include "CPU/ObjectCulling.h"
+#include "CPU/SceneData.h"
+#include "CPU/SignedDistance.h"
+
+// CPU reference of the primary pass in PixelShader.hlsl and RayMarching.hlsli.
+// Produces the same full precision G-buffer the GPU writes before packing, so
+// passes and storage formats can be validated without a D3D11 device.
+namespace CPU
+{
+	// Cone a pixel sweeps out along a ray path. Its radius at depth t along the current ray is
+	// (Offset + t) * Angle, with Offset the path length before the ray's origin.
+	struct RayCone
+	{
+		float Angle{ 0.0f };
+		float Offset{ 0.0f };
+
+		[[nodiscard]] float GetRadius(const float depth) const { return (Offset + depth) * Angle; }
+	};
+
+	struct Ray
+	{
+		bool Hit{ false };
+		Float3 HitPosition{ 0.0f };
+		Float3 HitNormal{ 0.0f };
+		int HitIndex{ -1 };
+		float Depth{ 0.0f };
+		uint32_t StepCount{ 0u };
+		RayCone Cone{};
+	};
+
+	// Unpacked G-buffer, one Image per PS_OUTPUT member
+	struct GBuffer
+	{
+		Image<Float4> Colour{};        // HDR colour, alpha 1
+		Image<Float4> NormDepth{};     // World normal (xyz), depth / MaxDist (w)
+		Image<Float4> MaterialIndex{}; // Metalicness, roughness, object index, hit
+
+		void Resize(int width, int height)
+		{
+			Colour.Resize(width, height);
+			NormDepth.Resize(width, height);
+			MaterialIndex.Resize(width, height);
+		}
+
+		[[nodiscard]] int GetWidth() const { return Colour.GetWidth(); }
+		[[nodiscard]] int GetHeight() const { return Colour.GetHeight(); }
+	};
+
+	// Distance below which a ray at depth along cone has hit, from IntersectionThreshold or the cone's radius
+	// times coneScale (settings.ConeThresholdScale for primary rays) when that is above 0
+	[[nodiscard]] float GetIntersectionThreshold(const RenderSettings& settings, float coneScale, const RayCone& cone, float depth);
+	// Largest threshold any primary, reflection or shadow ray hits at
+	[[nodiscard]] float GetMaxIntersectionThreshold(const RenderSettings& settings);
+
+	// Surface normal at p from one scene evaluation and the gradient of the object it finds nearest, or of the objects
+	// blended there (see GetSceneGradient). offset spaces the taps objects without an exact gradient fall back to;
+	// RayMarch uses half the hit threshold.
+	[[nodiscard]] Float3 CalculateNormal(const Scene& scene, const Float3& p, float maxDist, float footprint = 0.0f, float offset = 0.005f);
+	// The cone's radius, times settings.FootprintScale, is passed to the SDFs at every step. Scene::AnalyticPrimitives
+	// are intersected exactly rather than marched, and steps only count the rest of the scene.
+	// cost, when given, receives the SDF and normal evaluations; the caller decides what the steps count towards.
+	// walk, when given, replaces the marched objects with a list culled for this ray (see CPU/ObjectCulling.h).
+	// Marching starts at startDepth, which nothing may be hit before (see CPU/ProxyRaster.h).
+	[[nodiscard]] Ray RayMarch(const Scene& scene, const RenderSettings& settings, const Float3& ro, const Float3& rd, const RayCone& cone = {},
+	                           PixelCost* cost = nullptr, const ObjectWalk* walk = nullptr, float startDepth = 0.0f);
+	// Hits at settings.SecondaryConeThresholdScale. evaluations, when given, is incremented by the number of
+	// scene distance evaluations. culling, when given, limits the march to the objects GatherShadowObjects finds.
+	[[nodiscard]] float ShadowMarch(const Scene& scene, const RenderSettings& settings, const Float3& ro, const Light& light, const RayCone& cone = {},
+	                                uint32_t* evaluations = nullptr, const ObjectCulling* culling = nullptr);
+	[[nodiscard]] Float3 CalculateLightColour(const Scene& scene, const RenderSettings& settings, const Camera& camera, const Ray& ray, PixelCost* cost = nullptr,
+	                                          const ObjectCulling* culling = nullptr);
+
+	// Analytic stand-in for the skybox cubemap, which the CPU path does not load
+	[[nodiscard]] Float4 CalculateSkyColour(const Float3& dir);
+
+	// Primary ray direction through a viewport texture coordinate
+	[[nodiscard]] Float3 CalculateRayDirection(const Camera& camera, const RenderSettings& settings, const Float2& texCoord);
+	// Half the angle one pixel subtends at the centre of the view, the primary rays' cone angle
+	[[nodiscard]] float CalculatePixelConeAngle(const Camera& camera, const RenderSettings& settings);
+
+	// Renders rows [rowBegin, rowEnd) of the G-buffer, which must already be sized to settings.Width x settings.Height.
+	// costs, when given and sized the same, receives the work done for each pixel. culling and proxyDepths, when
+	// given, must have been built for the same camera and settings. Primary and shadow rays walk culling's lists, and
+	// primary rays start marching at proxyDepths.
+	void RenderGBufferRows(const Scene& scene, const Camera& camera, const RenderSettings& settings, GBuffer& output, int rowBegin, int rowEnd,
+	                       Image<PixelCost>* costs = nullptr, const ObjectCulling* culling = nullptr, const Image<float>* proxyDepths = nullptr);
+	void RenderGBuffer(const Scene& scene, const Camera& camera, const RenderSettings& settings, GBuffer& output);
+
+	// Full resolution port of ReflectionTraceShader.hlsl for rows [rowBegin, rowEnd) of a rendered G-buffer.
+	// output receives reflection colour and depth, costs (when given) has the reflection work added.
+	void TraceReflectionRows(const Scene& scene, const Camera& camera, const RenderSettings& settings, const GBuffer& gbuffer, Image<Float4>& output,
+	                         int rowBegin, int rowEnd, Image<PixelCost>* costs = nullptr);
+}
@@ -0,0 +1,138 @@
+#include "CPU/ReflectionComposite.h"
+
+namespace
+{
+	CPU::Float3 Composite(const CPU::Float3& colour, const CPU::Float3& reflection, float metalicness)
+	{
+		return CPU::Lerp(colour, CPU::Lerp(colour, reflection, 0.6f), metalicness);
+	}
+
+	CPU::Float4 SampleTrilinear(const CPU::ImagePyramid& pyramid, float u, float v, float lod)
+	{
+		const int level0 = static_cast<int>(lod);
+		const int level1 = std::min(level0 + 1, static_cast<int>(pyramid.size()) - 1);
+		const float t = lod - static_cast<float>(level0);
+
+		const CPU::Float4 a = CPU::SampleBilinear(pyramid[level0], u, v);
+		if (t <= 0.0f || level0 == level1)
+			return a;
+
+		return CPU::Lerp(a, CPU::SampleBilinear(pyramid[level1], u, v), t);
+	}
+}
+
+void CPU::CompositeReflectionsDirectional(const ReflectionCompositeInput& input, Image<Float4>& output)
+{
+	static constexpr float PI2 = 6.283185f;
+	static constexpr int directions = 16;
+	static constexpr int quality = 6;
+
+	const Image<Float4>& reflection = *input.ReflectionColDepth;
+	const int width = reflection.GetWidth();
+	const int height = reflection.GetHeight();
+	output.Resize(width, height);
+
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			const Float3 colour = input.Colour->At(x, y).xyz();
+			const Float2 metalRough = input.MetalicnessRoughness->At(x, y);
+
+			Float3 blurredReflection = reflection.At(x, y).xyz();
+			if (metalRough.x != 0.0f)
+			{
+				const float newSize = metalRough.y * ReflectionBlurSize;
+				for (int d = 0; d < directions; ++d)
+				{
+					const float angle = PI2 * static_cast<float>(d) / directions;
+					const float cs = std::cos(angle);
+					const float sn = std::sin(angle);
+					for (int q = 1; q <= quality; ++q)
+					{
+						const float i = static_cast<float>(q) / quality;
+
+						// Texture2D operator[] truncates the coordinate and returns zero when out of range
+						const int sx = static_cast<int>(x + cs * newSize * i);
+						const int sy = static_cast<int>(y + sn * newSize * i);
+						if (sx >= 0 && sy >= 0 && sx < width && sy < height)
+							blurredReflection += reflection.At(sx, sy).xyz();
+					}
+				}
+
+				blurredReflection /= Float3(quality * directions - 15.0f);
+			}
+
+			output.At(x, y) = Float4(Composite(colour, blurredReflection, metalRough.x), 1.0f);
+		}
+	}
+}
+
+void CPU::BuildReflectionPyramid(const Image<Float4>& reflection, ImagePyramid& pyramid)
+{
+	// Level count and sizes follow D3D11 mip rules: halve (rounding down) until 1x1
+	int levels = 1;
+	for (int size = std::max(reflection.GetWidth(), reflection.GetHeight()); size > 1; size /= 2)
+		++levels;
+
+	pyramid.resize(levels);
+	pyramid[0] = reflection;
+
+	for (int level = 1; level < levels; ++level)
+	{
+		const Image<Float4>& src = pyramid[level - 1];
+		Image<Float4>& dst = pyramid[level];
+
+		const int width = std::max(1, src.GetWidth() / 2);
+		const int height = std::max(1, src.GetHeight() / 2);
+		if (dst.GetWidth() != width || dst.GetHeight() != height)
+			dst.Resize(width, height);
+
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				const int sx = x * 2;
+				const int sy = y * 2;
+				dst.At(x, y) = (src.Load(sx, sy) + src.Load(sx + 1, sy) + src.Load(sx, sy + 1) + src.Load(sx + 1, sy + 1)) * Float4(0.25f);
+			}
+		}
+	}
+}
+
+void CPU::CompositeReflectionsPyramid(const ReflectionCompositeInput& input, const ImagePyramid& pyramid, Image<Float4>& output)
+{
+	const Image<Float4>& reflection = pyramid[0];
+	const int width = reflection.GetWidth();
+	const int height = reflection.GetHeight();
+	const float maxLod = static_cast<float>(pyramid.size() - 1);
+	output.Resize(width, height);
+
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			const Float3 colour = input.Colour->At(x, y).xyz();
+			const Float2 metalRough = input.MetalicnessRoughness->At(x, y);
+
+			Float3 blurredReflection = reflection.At(x, y).xyz();
+			if (metalRough.x != 0.0f)
+			{
+				const float radius = metalRough.y * ReflectionBlurSize;
+				const float lod = std::clamp(std::log2(std::max(radius, 1.0f)), 0.0f, maxLod);
+				const float u = (x + 0.5f) / width;
+				const float v = (y + 0.5f) / height;
+				const float ou = 0.5f * radius / width;
+				const float ov = 0.5f * radius / height;
+
+				const Float4 sum = SampleTrilinear(pyramid, u - ou, v - ov, lod) +
+				                   SampleTrilinear(pyramid, u + ou, v - ov, lod) +
+				                   SampleTrilinear(pyramid, u - ou, v + ov, lod) +
+				                   SampleTrilinear(pyramid, u + ou, v + ov, lod);
+				blurredReflection = sum.xyz() * Float3(0.25f);
+			}
+
+			output.At(x, y) = Float4(Composite(colour, blurredReflection, metalRough.x), 1.0f);
+		}
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+
+#include "CPU/Image.h"
+
+// CPU ports of ReflectionShader.hlsl, used to validate and benchmark the
+// reflection composite without a D3D11 device.
+namespace CPU
+{
+	// Box-filtered mip chain of the reflection colour buffer, level 0 being full resolution.
+	using ImagePyramid = std::vector<Image<Float4>>;
+
+	struct ReflectionCompositeInput
+	{
+		const Image<Float4>* Colour{ nullptr };
+		const Image<Float4>* ReflectionColDepth{ nullptr };
+		const Image<Float2>* MetalicnessRoughness{ nullptr };
+	};
+
+	// Blur radius in pixels at roughness 1, shared by both composite methods.
+	inline constexpr float ReflectionBlurSize = 50.0f;
+
+	// Original 16 direction x 6 quality disc blur: 96 texture reads per metallic pixel regardless of roughness.
+	// Algorithm from: https://xorshaders.weebly.com/tutorials/blur-shaders-5-part-2
+	void CompositeReflectionsDirectional(const ReflectionCompositeInput& input, Image<Float4>& output);
+
+	// Equivalent of ID3D11DeviceContext::GenerateMips on the reflection colour target.
+	void BuildReflectionPyramid(const Image<Float4>& reflection, ImagePyramid& pyramid);
+
+	// Roughness-matched pyramid lookup: 4 trilinear taps per metallic pixel.
+	void CompositeReflectionsPyramid(const ReflectionCompositeInput& input, const ImagePyramid& pyramid, Image<Float4>& output);
+}
@@ -0,0 +1,46 @@
+#include "CPU/RenderGraphImages.h"
+
+namespace CPU
+{
+	void RenderGraphImages::Realise(const RenderGraph& graph)
+	{
+		Graph = &graph;
+
+		const auto& descs = graph.GetPhysicalDescs();
+		Images.resize(descs.size());
+		for (size_t i = 0; i < descs.size(); ++i)
+		{
+			const int width = static_cast<int>(descs[i].Width);
+			const int height = static_cast<int>(descs[i].Height);
+			if (Images[i].GetWidth() != width || Images[i].GetHeight() != height)
+				Images[i].Resize(width, height);
+		}
+	}
+
+	Image<Float4>& RenderGraphImages::Get(const RenderGraphResource resource)
+	{
+		return Images[Graph->GetPhysicalIndex(resource)];
+	}
+
+	Image<Float4>& RenderGraphImages::Get(const std::string& name)
+	{
+		return Get(Graph->Find(name));
+	}
+
+	size_t RenderGraphImages::GetAllocatedBytes() const
+	{
+		size_t bytes = 0u;
+		for (const auto& image : Images)
+			bytes += static_cast<size_t>(image.GetWidth()) * image.GetHeight() * sizeof(Float4);
+		return bytes;
+	}
+
+	size_t RenderGraphImages::GetUnaliasedBytes() const
+	{
+		size_t bytes = 0u;
+		for (const auto& resource : Graph->GetResources())
+			if (resource.Physical >= 0)
+				bytes += static_cast<size_t>(resource.Desc.Width) * resource.Desc.Height * sizeof(Float4);
+		return bytes;
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "CPU/Image.h"
+#include "Rendering/RenderGraph.h"
+
+// CPU backend of a compiled RenderGraph, so graphs can be executed and
+// measured without a D3D11 device. Each physical slot is one full precision
+// Image; texture formats only decide which textures may alias.
+namespace CPU
+{
+	class RenderGraphImages
+	{
+	public:
+		// Sizes an image for every physical slot of graph, keeping existing allocations where possible
+		void Realise(const RenderGraph& graph);
+
+		[[nodiscard]] Image<Float4>& Get(RenderGraphResource resource);
+		[[nodiscard]] Image<Float4>& Get(const std::string& name);
+
+		// Memory used by the physical slots, and what one image per texture would have used
+		[[nodiscard]] size_t GetAllocatedBytes() const;
+		[[nodiscard]] size_t GetUnaliasedBytes() const;
+
+	private:
+		const RenderGraph* Graph{ nullptr };
+		std::vector<Image<Float4>> Images{};
+	};
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include <vector>
+
+#include "CPU/Math.h"
+
+// CPU mirrors of the scene constant buffers in RayMarching.hlsli. Defaults
+// match the component defaults so an empty-constructed scene renders the same
+// as the editor's start-up scene.
+namespace CPU
+{
+	struct RenderSettings
+	{
+		int Width{ 0 };
+		int Height{ 0 };
+		unsigned int MaxSteps{ 300u };
+		float MaxDist{ 500.0f };
+		float IntersectionThreshold{ 0.01f };
+		float AmbientOcclusionStrength{ 3.0f };
+		float FootprintScale{ 1.0f }; // Multiplies the pixel cone footprint SDFs drop detail below, 0 keeps all of it
+		// Hit threshold from the ray's pixel cone: its radius times ConeThresholdScale, clamped to
+		// [MinThreshold, MaxThreshold]. 0 uses IntersectionThreshold at every depth.
+		float ConeThresholdScale{ 0.0f };
+		float SecondaryConeThresholdScale{ 0.0f }; // ConeThresholdScale for reflection and shadow rays
+		float MinThreshold{ 0.0005f };
+		float MaxThreshold{ 0.25f };
+	};
+
+	// Orthonormal view basis, equivalent to the rows of CameraComponent::GetViewMatrix
+	struct Camera
+	{
+		Float3 Position{ 0.0f, 0.0f, 5.0f };
+		Float3 Right{ -1.0f, 0.0f, 0.0f };
+		Float3 Up{ 0.0f, 1.0f, 0.0f };
+		Float3 Forward{ 0.0f, 0.0f, -1.0f };
+		float FOV{ PI * 0.5f * 1.25f };
+	};
+
+	// Copies of an object laid out in its rotated frame, so one evaluation covers them all (see GetDistanceToObject)
+	struct Repetition
+	{
+		int Mode{ 0 };          // 0: None, 1: Grid, 2: Radial, 3: Mirror
+		// Grid: cell size per axis, 0 leaves the axis unrepeated. Radial: x is the ring's radius. Mirror: offset of
+		// the copies from each mirror plane.
+		Float3 Spacing{ 0.0f };
+		// Grid: copies either side of the object per axis, 0 repeats forever. Radial: x is the number of copies.
+		// Mirror: the axes mirrored across, where non-zero.
+		Float3 Limit{ 0.0f };
+		float Variation{ 0.0f }; // Largest fraction a hash of each copy's cell shrinks it by
+	};
+
+	struct Object
+	{
+		Float3 Position{ 0.0f };
+		Float3 Rotation{ 0.0f };
+		Float3 Scale{ 1.0f };
+		Float3 Parameters{ 1.0f };
+		int SDFType{ 0 };
+		int BoolOperator{ 0 }; // 0: Union, 1: Intersect, 2: Subtract, 3-5: the same blended over BlendRadius
+		float BlendRadius{ 0.0f }; // Largest difference between distances the smooth operators blend, 0 is a hard edge
+		float StepScale{ 1.0f }; // Multiplies the distance, below 1 for SDFs that overestimate (see EstimateStepScales)
+
+		Float3 Colour{ 1.0f };
+		float Metalicness{ 0.0f };
+		float Roughness{ 0.0f };
+
+		Repetition Repeat{};
+	};
+
+	struct Light
+	{
+		Float3 Position{ 0.0f };
+		Float3 Colour{ 1.0f };
+		float ShadowSharpness{ 32.0f };
+		float ConstantAttenuation{ 0.5f };
+		float LinearAttenuation{ 0.1f };
+		float QuadraticAttenuation{ 0.01f };
+	};
+
+	// CPU port of an SDF snippet, float sdf<Name>(float3 p, float3 param, float footprint), without the footprint
+	using SignedDistanceFunction = float (*)(const Float3& p, const Float3& param);
+
+	// Object RayMarch intersects in closed form rather than marches, with its rotation prepared (see FindAnalyticPrimitives)
+	struct AnalyticPrimitive
+	{
+		int Index{ 0 };               // Into Scene::Objects
+		Float3 Axes[3]{};             // The object's rotation applied to each world axis, its local space basis
+		float BoundingRadius{ 0.0f }; // About the object's position, in world space
+	};
+
+	// Objects [First, First + Count) of Scene::Objects, every one unioned with the scene, inside one bounding sphere
+	// (see BuildObjectGroups)
+	struct ObjectGroup
+	{
+		Float3 Centre{ 0.0f };
+		float Radius{ 0.0f };
+		float StepScale{ 1.0f }; // Smallest of the objects'
+		int First{ 0 };
+		int Count{ 0 };
+	};
+
+	struct Scene
+	{
+		std::vector<Object> Objects{};
+		std::vector<Light> Lights{};
+		// Indexed by Object::SDFType, wrapping like the editor's snippet list. Empty uses the built-in primitives.
+		std::vector<SignedDistanceFunction> SDFLibrary{};
+
+		// Objects primary and reflection rays intersect in closed form, and the rest they march. Both empty
+		// marches every object. Filled by FindAnalyticPrimitives, which must run again after objects change.
+		std::vector<AnalyticPrimitive> AnalyticPrimitives{};
+		std::vector<int> MarchedObjects{};
+
+		// Groups GetDistanceToScene skips whole when their bound is further than the distance it has, nested or apart,
+		// by First and then outermost first. Empty evaluates every object. Stale once objects move.
+		std::vector<ObjectGroup> Groups{};
+	};
+
+	// Camera looking from position towards target, matching XMMatrixLookAtLH
+	[[nodiscard]] inline Camera CreateLookAtCamera(const Float3& position, const Float3& target, const Float3& up = Float3(0.0f, 1.0f, 0.0f))
+	{
+		Camera camera{};
+		camera.Position = position;
+		camera.Forward = Normalize(target - position);
+		camera.Right = Normalize(Cross(up, camera.Forward));
+		camera.Up = Cross(camera.Forward, camera.Right);
+		return camera;
+	}
+
+	// The editor's start-up scene: a unit sphere at the origin lit by a single light
+	[[nodiscard]] inline Scene CreateDefaultScene()
+	{
+		Scene scene{};
+		scene.Objects.push_back({});
+
+		Light light{};
+		light.Position = Float3(1.0f, 2.0f, 4.0f);
+		scene.Lights.push_back(light);
+
+		return scene;
+	}
+}
@@ -0,0 +1,513 @@
+#include "CPU/SceneFile.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "CPU/SignedDistance.h"
+#include "CPU/TransformHierarchy.h"
+
+namespace CPU
+{
+	namespace
+	{
+		constexpr uint64_t SectionAlignment = 16u;
+
+		[[nodiscard]] uint64_t AlignUp(uint64_t value)
+		{
+			return (value + SectionAlignment - 1u) & ~(SectionAlignment - 1u);
+		}
+
+		[[nodiscard]] std::runtime_error SceneFileError(const std::filesystem::path& path, const std::string& message)
+		{
+			return std::runtime_error("Scene file \"" + path.string() + "\": " + message);
+		}
+
+		// Builds the Strings section while the writer records where each string landed
+		struct StringTable
+		{
+			std::string Bytes{};
+
+			SceneFileString Add(const std::string& string)
+			{
+				const SceneFileString entry{ static_cast<uint32_t>(Bytes.size()), static_cast<uint32_t>(string.size()) };
+				Bytes += string;
+				return entry;
+			}
+		};
+
+		struct PendingSection
+		{
+			SceneSection Type{};
+			uint32_t ElementSize{ 0u };
+			uint64_t Count{ 0u };
+			const void* Data{ nullptr };
+		};
+
+		template <typename T>
+		[[nodiscard]] std::span<const T> GetSection(const std::byte* data, const SceneFileSection& section)
+		{
+			return { reinterpret_cast<const T*>(data + section.Offset), static_cast<size_t>(section.Count) };
+		}
+
+		[[nodiscard]] uint32_t GetElementSize(const SceneSection type)
+		{
+			switch (type)
+			{
+			case SceneSection::RenderSettings: return sizeof(PackedRenderSettings);
+			case SceneSection::Camera: return sizeof(PackedCamera);
+			case SceneSection::Objects: return sizeof(PackedObject);
+			case SceneSection::Lights: return sizeof(PackedLight);
+			case SceneSection::ObjectNames:
+			case SceneSection::LightNames: return sizeof(SceneFileString);
+			case SceneSection::SDFLibrary: return sizeof(SceneFileSnippet);
+			case SceneSection::Strings: return 1u;
+			case SceneSection::SnippetCosts: return sizeof(SnippetCost);
+			case SceneSection::Repetitions: return sizeof(PackedRepetition);
+			case SceneSection::Parents: return sizeof(int32_t);
+			default: return 0u;
+			}
+		}
+
+		// Adds scene's objects to hierarchy, each after its parent and relative to it, and returns each one's node. An
+		// object whose parent is on a cycle with it is a root.
+		std::vector<int> AddObjectNodes(const SceneFileView& file, const Scene& scene, TransformHierarchy& hierarchy)
+		{
+			std::vector<int> nodes(scene.Objects.size(), TransformHierarchy::NoParent);
+			std::vector<uint8_t> visited(scene.Objects.size(), 0u);
+			std::vector<int> chain{};
+			for (size_t i = 0; i < scene.Objects.size(); ++i)
+			{
+				// Up to the first ancestor already added, then added back down
+				chain.clear();
+				int object = static_cast<int>(i);
+				while (object != -1 && !visited[object])
+				{
+					visited[object] = 1u;
+					chain.push_back(object);
+					object = file.GetParent(object);
+				}
+				// Stopped at one on the chain, not yet added, so the chain is a cycle
+				if (object != -1 && nodes[object] == TransformHierarchy::NoParent)
+					object = -1;
+
+				for (auto child = chain.rbegin(); child != chain.rend(); ++child)
+				{
+					const Object& world = scene.Objects[*child];
+					Transform local{ world.Position, world.Rotation, world.Scale.x };
+					if (object != -1)
+					{
+						const Object& parent = scene.Objects[object];
+						local = GetRelativeTransform({ parent.Position, parent.Rotation, parent.Scale.x }, local);
+					}
+
+					// In the object's own space, where its repetition is laid out over its scale
+					float radius = std::numeric_limits<float>::infinity();
+					if (world.Scale.x > 0.0f)
+						radius = GetSDFBoundingRadius(world.SDFType, world.Parameters) + GetRepetitionExtent(world.Repeat) / world.Scale.x;
+
+					nodes[*child] = hierarchy.AddNode(object != -1 ? nodes[object] : TransformHierarchy::NoParent, local, radius);
+					object = *child;
+				}
+			}
+			hierarchy.Update();
+			return nodes;
+		}
+
+		// Used when a file has no settings or camera section
+		const PackedRenderSettings DefaultRenderSettings{};
+		const PackedCamera DefaultCamera{};
+	}
+
+	void WriteSceneFile(const std::filesystem::path& path, const SceneDocument& document)
+	{
+		StringTable strings{};
+
+		std::vector<SceneFileString> objectNames{};
+		objectNames.reserve(document.ObjectNames.size());
+		for (const std::string& name : document.ObjectNames)
+			objectNames.push_back(strings.Add(name));
+
+		std::vector<SceneFileString> lightNames{};
+		lightNames.reserve(document.LightNames.size());
+		for (const std::string& name : document.LightNames)
+			lightNames.push_back(strings.Add(name));
+
+		std::vector<SceneFileSnippet> snippets{};
+		snippets.reserve(document.SDFLibrary.size());
+		for (const auto& [name, body] : document.SDFLibrary)
+			snippets.push_back({ strings.Add(name), strings.Add(body) });
+
+		const PendingSection pending[] = {
+			{ SceneSection::RenderSettings, sizeof(PackedRenderSettings), 1u, &document.RenderSettings },
+			{ SceneSection::Camera, sizeof(PackedCamera), 1u, &document.Camera },
+			{ SceneSection::Objects, sizeof(PackedObject), document.Objects.size(), document.Objects.data() },
+			{ SceneSection::Lights, sizeof(PackedLight), document.Lights.size(), document.Lights.data() },
+			{ SceneSection::ObjectNames, sizeof(SceneFileString), objectNames.size(), objectNames.data() },
+			{ SceneSection::LightNames, sizeof(SceneFileString), lightNames.size(), lightNames.data() },
+			{ SceneSection::SDFLibrary, sizeof(SceneFileSnippet), snippets.size(), snippets.data() },
+			{ SceneSection::Strings, 1u, strings.Bytes.size(), strings.Bytes.data() },
+			{ SceneSection::SnippetCosts, sizeof(SnippetCost), document.SnippetCosts.size(), document.SnippetCosts.data() },
+			{ SceneSection::Repetitions, sizeof(PackedRepetition), document.Repetitions.size(), document.Repetitions.data() },
+			{ SceneSection::Parents, sizeof(int32_t), document.Parents.size(), document.Parents.data() },
+		};
+		constexpr size_t sectionCount = std::size(pending);
+
+		SceneFileHeader header{};
+		header.SectionCount = static_cast<uint32_t>(sectionCount);
+
+		SceneFileSection table[sectionCount]{};
+		uint64_t offset = AlignUp(sizeof(SceneFileHeader) + sizeof(table));
+		for (size_t i = 0; i < sectionCount; ++i)
+		{
+			table[i].Type = static_cast<uint32_t>(pending[i].Type);
+			table[i].ElementSize = pending[i].ElementSize;
+			table[i].Offset = offset;
+			table[i].Count = pending[i].Count;
+			offset = AlignUp(offset + pending[i].Count * pending[i].ElementSize);
+		}
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file)
+			throw SceneFileError(path, "could not be opened for writing");
+
+		constexpr char padding[SectionAlignment]{};
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(table), sizeof(table));
+		uint64_t written = sizeof(header) + sizeof(table);
+		for (size_t i = 0; i < sectionCount; ++i)
+		{
+			file.write(padding, static_cast<std::streamsize>(table[i].Offset - written));
+			const uint64_t bytes = pending[i].Count * pending[i].ElementSize;
+			file.write(static_cast<const char*>(pending[i].Data), static_cast<std::streamsize>(bytes));
+			written = table[i].Offset + bytes;
+		}
+
+		if (!file)
+			throw SceneFileError(path, "write failed");
+	}
+
+	MappedFile::MappedFile(const std::filesystem::path& path)
+	{
+#ifdef _WIN32
+		const HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			throw SceneFileError(path, "could not be opened");
+		FileHandle = file;
+
+		LARGE_INTEGER size{};
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+		{
+			Close();
+			throw SceneFileError(path, "is empty");
+		}
+
+		MappingHandle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		const void* view = MappingHandle ? MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		if (!view)
+		{
+			Close();
+			throw SceneFileError(path, "could not be mapped");
+		}
+
+		Data = static_cast<const std::byte*>(view);
+		Size = static_cast<size_t>(size.QuadPart);
+#else
+		const int file = open(path.c_str(), O_RDONLY);
+		if (file < 0)
+			throw SceneFileError(path, "could not be opened");
+
+		struct stat status{};
+		if (fstat(file, &status) != 0 || status.st_size == 0)
+		{
+			close(file);
+			throw SceneFileError(path, "is empty");
+		}
+
+		// The mapping keeps the file alive, so the descriptor isn't needed past this point
+		void* view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+		close(file);
+		if (view == MAP_FAILED)
+			throw SceneFileError(path, "could not be mapped");
+
+		Data = static_cast<const std::byte*>(view);
+		Size = static_cast<size_t>(status.st_size);
+#endif
+	}
+
+	MappedFile::MappedFile(MappedFile&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Close();
+			std::swap(Data, other.Data);
+			std::swap(Size, other.Size);
+#ifdef _WIN32
+			std::swap(FileHandle, other.FileHandle);
+			std::swap(MappingHandle, other.MappingHandle);
+#endif
+		}
+
+		return *this;
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	void MappedFile::Close()
+	{
+#ifdef _WIN32
+		if (Data)
+			UnmapViewOfFile(Data);
+		if (MappingHandle)
+			CloseHandle(MappingHandle);
+		if (FileHandle)
+			CloseHandle(FileHandle);
+		FileHandle = nullptr;
+		MappingHandle = nullptr;
+#else
+		if (Data)
+			munmap(const_cast<std::byte*>(Data), Size);
+#endif
+		Data = nullptr;
+		Size = 0u;
+	}
+
+	SceneFileView::SceneFileView(const std::filesystem::path& path)
+		: File(path), RenderSettings(&DefaultRenderSettings), Camera(&DefaultCamera)
+	{
+		const std::byte* data = File.GetData();
+		const uint64_t size = File.GetSize();
+
+		if (size < sizeof(SceneFileHeader))
+			throw SceneFileError(path, "is truncated");
+
+		Header = reinterpret_cast<const SceneFileHeader*>(data);
+		if (Header->Magic != SceneFileMagic)
+			throw SceneFileError(path, "is not a scene file");
+		if (Header->Version == 0u || Header->Version > SceneFileVersion)
+			throw SceneFileError(path, "has unsupported version " + std::to_string(Header->Version));
+		if (sizeof(SceneFileHeader) + static_cast<uint64_t>(Header->SectionCount) * sizeof(SceneFileSection) > size)
+			throw SceneFileError(path, "section table is truncated");
+
+		const auto sections = std::span(reinterpret_cast<const SceneFileSection*>(data + sizeof(SceneFileHeader)), Header->SectionCount);
+		for (const SceneFileSection& section : sections)
+		{
+			const auto type = static_cast<SceneSection>(section.Type);
+			const uint32_t elementSize = GetElementSize(type);
+			if (elementSize == 0u)
+				continue;
+
+			if (section.ElementSize != elementSize)
+				throw SceneFileError(path, "section " + std::to_string(section.Type) + " has an unexpected record size");
+			if (section.Offset % SectionAlignment != 0u || section.Offset > size ||
+			    section.Count > (size - section.Offset) / elementSize)
+				throw SceneFileError(path, "section " + std::to_string(section.Type) + " is out of bounds");
+
+			switch (type)
+			{
+			case SceneSection::RenderSettings:
+				if (section.Count > 0u)
+					RenderSettings = GetSection<PackedRenderSettings>(data, section).data();
+				break;
+			case SceneSection::Camera:
+				if (section.Count > 0u)
+					Camera = GetSection<PackedCamera>(data, section).data();
+				break;
+			case SceneSection::Objects: Objects = GetSection<PackedObject>(data, section); break;
+			case SceneSection::Lights: Lights = GetSection<PackedLight>(data, section); break;
+			case SceneSection::ObjectNames: ObjectNames = GetSection<SceneFileString>(data, section); break;
+			case SceneSection::LightNames: LightNames = GetSection<SceneFileString>(data, section); break;
+			case SceneSection::SDFLibrary: Snippets = GetSection<SceneFileSnippet>(data, section); break;
+			case SceneSection::SnippetCosts: SnippetCosts = GetSection<SnippetCost>(data, section); break;
+			case SceneSection::Repetitions: Repetitions = GetSection<PackedRepetition>(data, section); break;
+			case SceneSection::Parents: Parents = GetSection<int32_t>(data, section); break;
+			case SceneSection::Strings:
+				Strings = std::string_view(reinterpret_cast<const char*>(data + section.Offset), static_cast<size_t>(section.Count));
+				break;
+			default: break;
+			}
+		}
+	}
+
+	std::string_view SceneFileView::GetObjectName(size_t index) const
+	{
+		return index < ObjectNames.size() ? GetString(ObjectNames[index]) : std::string_view{};
+	}
+
+	std::string_view SceneFileView::GetLightName(size_t index) const
+	{
+		return index < LightNames.size() ? GetString(LightNames[index]) : std::string_view{};
+	}
+
+	int SceneFileView::GetParent(const size_t index) const
+	{
+		if (index >= Parents.size() || Parents[index] < 0 || static_cast<size_t>(Parents[index]) >= Objects.size() ||
+		    static_cast<size_t>(Parents[index]) == index)
+			return -1;
+		return Parents[index];
+	}
+
+	std::string_view SceneFileView::GetString(const SceneFileString& string) const
+	{
+		// Strings are checked when read rather than at load, so opening a large scene stays O(sections)
+		if (static_cast<uint64_t>(string.Offset) + string.Length > Strings.size())
+			throw std::runtime_error("Scene file string is out of bounds");
+
+		return Strings.substr(string.Offset, string.Length);
+	}
+
+	PackedObject PackObject(const Object& object)
+	{
+		PackedObject packed{};
+		packed.Position = object.Position;
+		packed.Rotation = object.Rotation;
+		packed.Scale = object.Scale;
+		packed.Parameters = object.Parameters;
+		packed.SDFType = static_cast<uint32_t>(object.SDFType);
+		packed.BoolOperator = static_cast<uint32_t>(object.BoolOperator);
+		packed.Colour = object.Colour;
+		packed.Metalicness = object.Metalicness;
+		packed.Roughness = object.Roughness;
+		packed.BlendRadius = object.BlendRadius;
+		return packed;
+	}
+
+	Object UnpackObject(const PackedObject& object)
+	{
+		Object unpacked{};
+		unpacked.Position = object.Position;
+		unpacked.Rotation = object.Rotation;
+		unpacked.Scale = object.Scale;
+		unpacked.Parameters = object.Parameters;
+		unpacked.SDFType = static_cast<int>(object.SDFType);
+		unpacked.BoolOperator = static_cast<int>(object.BoolOperator);
+		unpacked.Colour = object.Colour;
+		unpacked.Metalicness = object.Metalicness;
+		unpacked.Roughness = object.Roughness;
+		unpacked.BlendRadius = object.BlendRadius;
+		return unpacked;
+	}
+
+	PackedRepetition PackRepetition(const Repetition& repetition)
+	{
+		PackedRepetition packed{};
+		packed.Spacing = repetition.Spacing;
+		packed.Mode = static_cast<uint32_t>(repetition.Mode);
+		packed.Limit = repetition.Limit;
+		packed.Variation = repetition.Variation;
+		return packed;
+	}
+
+	Repetition UnpackRepetition(const PackedRepetition& repetition)
+	{
+		Repetition unpacked{};
+		unpacked.Spacing = repetition.Spacing;
+		unpacked.Mode = static_cast<int>(repetition.Mode);
+		unpacked.Limit = repetition.Limit;
+		unpacked.Variation = repetition.Variation;
+		return unpacked;
+	}
+
+	PackedLight PackLight(const Light& light)
+	{
+		PackedLight packed{};
+		packed.Position = light.Position;
+		packed.Colour = light.Colour;
+		packed.ShadowSharpness = light.ShadowSharpness;
+		packed.ConstantAttenuation = light.ConstantAttenuation;
+		packed.LinearAttenuation = light.LinearAttenuation;
+		packed.QuadraticAttenuation = light.QuadraticAttenuation;
+		return packed;
+	}
+
+	Light UnpackLight(const PackedLight& light)
+	{
+		Light unpacked{};
+		unpacked.Position = light.Position;
+		unpacked.Colour = light.Colour;
+		unpacked.ShadowSharpness = light.ShadowSharpness;
+		unpacked.ConstantAttenuation = light.ConstantAttenuation;
+		unpacked.LinearAttenuation = light.LinearAttenuation;
+		unpacked.QuadraticAttenuation = light.QuadraticAttenuation;
+		return unpacked;
+	}
+
+	Scene CreateScene(const SceneFileView& file)
+	{
+		Scene scene{};
+
+		scene.Objects.reserve(file.GetObjects().size());
+		for (const PackedObject& object : file.GetObjects())
+		{
+			scene.Objects.push_back(UnpackObject(object));
+			scene.Objects.back().Repeat = UnpackRepetition(file.GetRepetition(scene.Objects.size() - 1));
+		}
+
+		scene.Lights.reserve(file.GetLights().size());
+		for (const PackedLight& light : file.GetLights())
+			scene.Lights.push_back(UnpackLight(light));
+
+		bool hasParents = false;
+		for (size_t i = 0; i < scene.Objects.size() && !hasParents; ++i)
+			hasParents = file.GetParent(i) != -1;
+		if (hasParents)
+		{
+			// Objects keep the world transforms the file holds; the hierarchy only supplies the group bounds
+			TransformHierarchy hierarchy{};
+			const std::vector<int> nodes = AddObjectNodes(file, scene, hierarchy);
+			BuildObjectGroups(hierarchy, nodes, scene);
+		}
+
+		return scene;
+	}
+
+	Camera CreateCamera(const PackedCamera& camera)
+	{
+		// Same construction as CameraComponent::GetViewMatrix: pitch and yaw rotate Vector3::Forward, roll rotates up
+		const Float3 radians = camera.Rotation * Float3(0.01745329f);
+		const Float3 forward(-std::cos(radians.x) * std::sin(radians.y), std::sin(radians.x), -std::cos(radians.x) * std::cos(radians.y));
+		const Float3 up(-std::sin(radians.z), std::cos(radians.z), 0.0f);
+
+		Camera result = CreateLookAtCamera(camera.Position, camera.Position + forward, up);
+		result.FOV = camera.FOV;
+		return result;
+	}
+
+	RenderSettings CreateRenderSettings(const PackedRenderSettings& settings, int width, int height)
+	{
+		RenderSettings result{};
+		result.Width = width;
+		result.Height = height;
+		result.MaxSteps = settings.MaxSteps;
+		result.MaxDist = settings.MaxDist;
+		result.IntersectionThreshold = settings.IntersectionThreshold;
+		result.AmbientOcclusionStrength = settings.AmbientOcclusionStrength;
+		return result;
+	}
+}
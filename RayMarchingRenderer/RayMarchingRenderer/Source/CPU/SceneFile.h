@@ -0,0 +1,245 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "CPU/SceneData.h"
+#include "CPU/SnippetCost.h"
+
+// Binary scene format (.rmscene). A header and section table are followed by
+// 16 byte aligned sections, each a flat array of fixed size records. Object
+// and light records match the GPU constant buffer layouts byte for byte, so a
+// memory mapped file is used in place with no per-field parsing.
+//
+// Versioning: readers skip section types they don't know, so new data is added
+// as new sections. Changing an existing record layout bumps SceneFileVersion.
+// All values are little endian.
+namespace CPU
+{
+	inline constexpr uint32_t SceneFileMagic = 0x43534D52u; // "RMSC"
+	inline constexpr uint32_t SceneFileVersion = 1u;
+
+	// Layout of ObjectsList entries in RayMarching.hlsli
+	struct PackedObject
+	{
+		Float3 Position{ 0.0f };
+		float pW{ 0.0f };
+		Float3 Rotation{ 0.0f };
+		float rW{ 0.0f };
+		Float3 Scale{ 1.0f };
+		float sW{ 0.0f };
+		Float3 Parameters{ 1.0f };
+		uint32_t SDFType{ 0u };
+		uint32_t BoolOperator{ 0u };
+
+		Float3 Colour{ 1.0f };
+		float Metalicness{ 0.0f };
+		float Roughness{ 0.0f };
+
+		float PADDING{}; // ObjectsList has StepScale here, which is measured rather than stored
+		float BlendRadius{ 0.0f };
+	};
+	static_assert(sizeof(PackedObject) == 96);
+
+	// Layout of LightsList entries in RayMarching.hlsli
+	struct PackedLight
+	{
+		Float3 Position{ 0.0f };
+		float pW{ 0.0f };
+		Float3 Colour{ 1.0f };
+		float ShadowSharpness{ 32.0f };
+		float ConstantAttenuation{ 0.5f };
+		float LinearAttenuation{ 0.1f };
+		float QuadraticAttenuation{ 0.01f };
+
+		float PADDING{};
+	};
+	static_assert(sizeof(PackedLight) == 48);
+
+	// Layout of RepetitionsList entries in RayMarching.hlsli, as Repetition
+	struct PackedRepetition
+	{
+		Float3 Spacing{ 0.0f };
+		uint32_t Mode{ 0u };
+		Float3 Limit{ 0.0f };
+		float Variation{ 0.0f };
+	};
+	static_assert(sizeof(PackedRepetition) == 32);
+
+	// Render settings without the viewport resolution, which belongs to the editor rather than the scene
+	struct PackedRenderSettings
+	{
+		uint32_t MaxSteps{ 300u };
+		float MaxDist{ 500.0f };
+		float IntersectionThreshold{ 0.01f };
+		float AmbientOcclusionStrength{ 3.0f };
+	};
+
+	// Camera transform as edited in the GUI, rotation in degrees
+	struct PackedCamera
+	{
+		Float3 Position{ 0.0f, 0.0f, 5.0f };
+		float FOV{ PI * 0.5f * 1.25f };
+		Float3 Rotation{ 0.0f };
+		float PADDING{};
+	};
+
+	enum class SceneSection : uint32_t
+	{
+		RenderSettings = 0, // 1 PackedRenderSettings
+		Camera,             // 1 PackedCamera
+		Objects,            // PackedObject per object
+		Lights,             // PackedLight per light
+		ObjectNames,        // SceneFileString per object
+		LightNames,         // SceneFileString per light
+		SDFLibrary,         // SceneFileSnippet per SDF type, in SDFType order
+		Strings,            // UTF-8 bytes referenced by SceneFileString
+		SnippetCosts,       // SnippetCost per snippet and param measured
+		Repetitions,        // PackedRepetition per object, or none when no object is repeated
+		Parents,            // int32_t per object, the index of the object its transform is relative to or -1, or none
+		Count
+	};
+
+	struct SceneFileHeader
+	{
+		uint32_t Magic{ SceneFileMagic };
+		uint32_t Version{ SceneFileVersion };
+		uint32_t SectionCount{ 0u };
+		uint32_t Flags{ 0u };
+	};
+
+	// Follows the header, one per section
+	struct SceneFileSection
+	{
+		uint32_t Type{ 0u };
+		uint32_t ElementSize{ 0u };
+		uint64_t Offset{ 0u };
+		uint64_t Count{ 0u };
+	};
+
+	// Range of the Strings section
+	struct SceneFileString
+	{
+		uint32_t Offset{ 0u };
+		uint32_t Length{ 0u };
+	};
+
+	// User SDF snippet: the function name suffix and body of float sdf<Name>(float3 p, float3 param, float footprint)
+	struct SceneFileSnippet
+	{
+		SceneFileString Name{};
+		SceneFileString Body{};
+	};
+
+	// Everything a scene file holds, in an editable form for writing
+	struct SceneDocument
+	{
+		PackedRenderSettings RenderSettings{};
+		PackedCamera Camera{};
+		std::vector<PackedObject> Objects{};
+		std::vector<std::string> ObjectNames{};
+		std::vector<PackedLight> Lights{};
+		std::vector<std::string> LightNames{};
+		std::vector<std::pair<std::string, std::string>> SDFLibrary{};
+		std::vector<SnippetCost> SnippetCosts{};
+		std::vector<PackedRepetition> Repetitions{}; // Empty, or one per object
+		std::vector<int32_t> Parents{};              // Empty, or one per object
+	};
+
+	// Throws std::runtime_error if the file can't be written
+	void WriteSceneFile(const std::filesystem::path& path, const SceneDocument& document);
+
+	// Read-only memory map of a whole file
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		explicit MappedFile(const std::filesystem::path& path);
+		MappedFile(const MappedFile&) = delete;
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+		~MappedFile();
+
+		[[nodiscard]] const std::byte* GetData() const { return Data; }
+		[[nodiscard]] size_t GetSize() const { return Size; }
+
+	private:
+		void Close();
+
+		const std::byte* Data{ nullptr };
+		size_t Size{ 0u };
+#ifdef _WIN32
+		void* FileHandle{ nullptr };
+		void* MappingHandle{ nullptr };
+#endif
+	};
+
+	// Validated view of a mapped scene file. Accessors point into the mapping,
+	// so nothing is copied until the caller asks for it.
+	class SceneFileView
+	{
+	public:
+		// Throws std::runtime_error if the file is missing, truncated, or of an unsupported version
+		explicit SceneFileView(const std::filesystem::path& path);
+
+		[[nodiscard]] uint32_t GetVersion() const { return Header->Version; }
+		[[nodiscard]] size_t GetFileSize() const { return File.GetSize(); }
+
+		[[nodiscard]] const PackedRenderSettings& GetRenderSettings() const { return *RenderSettings; }
+		[[nodiscard]] const PackedCamera& GetCamera() const { return *Camera; }
+		[[nodiscard]] std::span<const PackedObject> GetObjects() const { return Objects; }
+		[[nodiscard]] std::span<const PackedLight> GetLights() const { return Lights; }
+
+		// Empty when the file has no name for the entry
+		[[nodiscard]] std::string_view GetObjectName(size_t index) const;
+		[[nodiscard]] std::string_view GetLightName(size_t index) const;
+
+		[[nodiscard]] size_t GetSnippetCount() const { return Snippets.size(); }
+		[[nodiscard]] std::string_view GetSnippetName(size_t index) const { return GetString(Snippets[index].Name); }
+		[[nodiscard]] std::string_view GetSnippetBody(size_t index) const { return GetString(Snippets[index].Body); }
+		// Empty for files written before snippets were measured
+		[[nodiscard]] std::span<const SnippetCost> GetSnippetCosts() const { return SnippetCosts; }
+		// Unrepeated for files without repetitions and objects past the end of them
+		[[nodiscard]] PackedRepetition GetRepetition(size_t index) const { return index < Repetitions.size() ? Repetitions[index] : PackedRepetition{}; }
+		// -1 for files without a hierarchy, objects past the end of it and parents that aren't another object.
+		// Objects always hold world transforms, so a reader can ignore this.
+		[[nodiscard]] int GetParent(size_t index) const;
+
+	private:
+		[[nodiscard]] std::string_view GetString(const SceneFileString& string) const;
+
+		MappedFile File{};
+		const SceneFileHeader* Header{ nullptr };
+
+		const PackedRenderSettings* RenderSettings{ nullptr };
+		const PackedCamera* Camera{ nullptr };
+		std::span<const PackedObject> Objects{};
+		std::span<const PackedLight> Lights{};
+		std::span<const SceneFileString> ObjectNames{};
+		std::span<const SceneFileString> LightNames{};
+		std::span<const SceneFileSnippet> Snippets{};
+		std::span<const SnippetCost> SnippetCosts{};
+		std::span<const PackedRepetition> Repetitions{};
+		std::span<const int32_t> Parents{};
+		std::string_view Strings{};
+	};
+
+	[[nodiscard]] PackedObject PackObject(const Object& object);
+	[[nodiscard]] Object UnpackObject(const PackedObject& object);
+	[[nodiscard]] PackedRepetition PackRepetition(const Repetition& repetition);
+	[[nodiscard]] Repetition UnpackRepetition(const PackedRepetition& repetition);
+	[[nodiscard]] PackedLight PackLight(const Light& light);
+	[[nodiscard]] Light UnpackLight(const PackedLight& light);
+
+	// CPU reference scene, camera and settings of a scene file. A file with parents also gets Scene::Groups for
+	// every subtree of two or more objects.
+	[[nodiscard]] Scene CreateScene(const SceneFileView& file);
+	[[nodiscard]] Camera CreateCamera(const PackedCamera& camera);
+	[[nodiscard]] RenderSettings CreateRenderSettings(const PackedRenderSettings& settings, int width, int height);
+}
@@ -0,0 +1,612 @@
+#include "CPU/SignedDistance.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "CPU/Dual.h"
+#include "CPU/FractalKernels.h"
+#include "CPU/ObjectCosts.h"
+
+namespace CPU
+{
+	namespace
+	{
+		float Sign(float v) { return static_cast<float>((v > 0.0f) - (v < 0.0f)); }
+
+		float SdfSphere(const Float3& p, const Float3& param)
+		{
+			return Length(p) - param.x;
+		}
+
+		float SdfBox(const Float3& p, const Float3& param)
+		{
+			const Float3 q = Abs(p) - param;
+			return Length(Max(q, 0.0f)) + std::min(std::max(q.x, std::max(q.y, q.z)), 0.0f);
+		}
+
+		float SdfTorus(const Float3& p, const Float3& param)
+		{
+			const Float2 q(Length(Float2(p.x, p.z)) - param.x, p.y);
+			return Length(q) - param.y;
+		}
+
+		float SdfCone(const Float3& p, const Float3& param)
+		{
+			const Float2 q = Float2(param.z) * Float2(param.x / param.y, -1.0f);
+			const Float2 w(Length(Float2(p.x, p.z)), p.y);
+			const Float2 a = w - q * Float2(std::clamp(Dot(w, q) / Dot(q, q), 0.0f, 1.0f));
+			const Float2 b = w - q * Float2(std::clamp(w.x / q.x, 0.0f, 1.0f), 1.0f);
+			const float k = Sign(q.y);
+			const float d = std::min(Dot(a, a), Dot(b, b));
+			const float s = std::max(k * (w.x * q.y - w.y * q.x), k * (w.y - q.y));
+			return std::sqrt(d) * Sign(s);
+		}
+
+		float SdfCylinder(const Float3& p, const Float3& param)
+		{
+			const Float2 d = Abs(Float2(Length(Float2(p.x, p.z)), p.y)) - Float2(param.x, param.y);
+			return std::min(std::max(d.x, d.y), 0.0f) + Length(Max(d, 0.0f));
+		}
+
+		// The primitives again over dual numbers, for their gradients. Each follows its float version line by line.
+		Dual SdfSphere(const Dual& x, const Dual& y, const Dual& z, const Float3& param)
+		{
+			return Length(x, y, z) - param.x;
+		}
+
+		Dual SdfBox(const Dual& x, const Dual& y, const Dual& z, const Float3& param)
+		{
+			const Dual qx = Abs(x) - param.x;
+			const Dual qy = Abs(y) - param.y;
+			const Dual qz = Abs(z) - param.z;
+			return Length(Max(qx, 0.0f), Max(qy, 0.0f), Max(qz, 0.0f)) + Min(Max(qx, Max(qy, qz)), 0.0f);
+		}
+
+		Dual SdfTorus(const Dual& x, const Dual& y, const Dual& z, const Float3& param)
+		{
+			return Length(Length(x, z) - param.x, y) - param.y;
+		}
+
+		Dual SdfCone(const Dual& x, const Dual& y, const Dual& z, const Float3& param)
+		{
+			const Float2 q = Float2(param.z) * Float2(param.x / param.y, -1.0f);
+			const Dual wx = Length(x, z);
+			const Dual& wy = y;
+			const Dual t = Clamp((wx * q.x + wy * q.y) / Dot(q, q), 0.0f, 1.0f);
+			const Dual ax = wx - t * q.x;
+			const Dual ay = wy - t * q.y;
+			const Dual bx = wx - Clamp(wx / q.x, 0.0f, 1.0f) * q.x;
+			const Dual by = wy - q.y;
+			const float k = Sign(q.y);
+			const Dual d = Min(ax * ax + ay * ay, bx * bx + by * by);
+			const float s = std::max(k * (wx.Value * q.y - wy.Value * q.x), k * (wy.Value - q.y));
+			return Sqrt(d) * Sign(s);
+		}
+
+		Dual SdfCylinder(const Dual& x, const Dual& y, const Dual& z, const Float3& param)
+		{
+			const Dual dx = Abs(Length(x, z)) - param.x;
+			const Dual dy = Abs(y) - param.y;
+			return Min(Max(dx, dy), 0.0f) + Length(Max(dx, 0.0f), Max(dy, 0.0f));
+		}
+
+		// Central differences, offset either side of p on each axis. Four taps at the corners of a tetrahedron take
+		// fewer evaluations, but land further from p, and on the fractals stray several degrees further from the
+		// true gradient (see NormalsBenchmark).
+		void GetCentralTaps(const Float3& p, const float offset, Float3 (&taps)[6])
+		{
+			taps[0] = p + Float3(offset, 0.0f, 0.0f);
+			taps[1] = p - Float3(offset, 0.0f, 0.0f);
+			taps[2] = p + Float3(0.0f, offset, 0.0f);
+			taps[3] = p - Float3(0.0f, offset, 0.0f);
+			taps[4] = p + Float3(0.0f, 0.0f, offset);
+			taps[5] = p - Float3(0.0f, 0.0f, offset);
+		}
+
+		// Scaled to the gradient itself, so blends can mix it with the exact ones
+		Float3 GetCentralGradient(const float (&distances)[6], const float offset)
+		{
+			return Float3(distances[0] - distances[1], distances[2] - distances[3], distances[4] - distances[5]) / Float3(2.0f * offset);
+		}
+
+		template <typename Function>
+		Float3 GetCentralGradient(const Function& f, const Float3& p, const float offset)
+		{
+			Float3 taps[6]{};
+			GetCentralTaps(p, offset, taps);
+			float distances[6]{};
+			for (int i = 0; i < 6; ++i)
+				distances[i] = f(taps[i]);
+			return GetCentralGradient(distances, offset);
+		}
+
+		// Rotate2D from the template, applied as mul(row vector, matrix)
+		void Rotate2D(float& a, float& b, float r)
+		{
+			const float s = std::sin(r);
+			const float c = std::cos(r);
+			const float x = a * c + b * s;
+			const float y = -a * s + b * c;
+			a = x;
+			b = y;
+		}
+
+		// Folds the objects getIndex maps [0, count) to, in that order, as the generated GetDistanceToScene does.
+		// groups, when given, are over [0, count) itself.
+		template <typename GetIndex>
+		SceneDistanceInfo CombineObjects(const Scene& scene, const Float3& p, const float maxDist, const float footprint, const int count,
+		                                 const GetIndex& getIndex, const std::vector<ObjectGroup>* groups = nullptr)
+		{
+			float dist = maxDist;
+			float prevDist = maxDist;
+			int index = 0;
+
+			size_t group = 0;
+			for (int i = 0; i < count; ++i)
+			{
+				// Every object in a group is unioned and at least its distance from the bound away, scaled by the
+				// smallest step scale, so one further than dist changes neither it nor the index. Groups inside a
+				// skipped one start before where it ends, so they are passed over with it.
+				if (groups)
+				{
+					for (; group < groups->size() && (*groups)[group].First <= i; ++group)
+					{
+						const ObjectGroup& skipped = (*groups)[group];
+						const float boundDist = Distance(p, skipped.Centre) - skipped.Radius;
+						if (skipped.First == i && boundDist >= 0.0f && boundDist * skipped.StepScale >= dist)
+							i = skipped.First + skipped.Count;
+					}
+					if (i >= count)
+						break;
+				}
+
+				const int objectIndex = getIndex(i);
+				const Object& object = scene.Objects[objectIndex];
+				dist = CombineDistance(object, dist, GetDistanceToObject(scene, object, p, footprint));
+
+				// Index follows whichever object last changed the distance
+				if (prevDist != dist)
+					index = objectIndex;
+				prevDist = dist;
+			}
+
+			if (ObjectCostCounters* counters = GetActiveObjectCostCounters())
+			{
+				++counters->SceneEvaluations;
+				if (index < static_cast<int>(counters->Nearest.size()))
+					++counters->Nearest[index];
+			}
+
+			return { dist, index };
+		}
+
+		constexpr int MaxRepeatedCopies = 8;
+		// Keeps cell ids well inside int, far past any distance a ray reaches
+		constexpr float MaxCell = 16777216.0f;
+		// Repetition::Variation is clamped below 1, so no copy shrinks to nothing
+		constexpr float MaxVariation = 0.9f;
+
+		// Copy of a repeated object near a point, in the object's rotated but unscaled frame
+		struct RepeatedCopy
+		{
+			Float3 Point{};      // Relative to the copy's origin
+			float Scale{ 1.0f }; // Of the copy, over the object's
+			Float3 Flip{ 1.0f }; // Sign the mirror took each axis by
+			float Angle{ 0.0f }; // Rotation about y that took the point into the copy's sector
+		};
+
+		float GetAxis(const Float3& v, const int axis) { return axis == 0 ? v.x : axis == 1 ? v.y : v.z; }
+		float& GetAxis(Float3& v, const int axis) { return axis == 0 ? v.x : axis == 1 ? v.y : v.z; }
+
+		// Hash of a copy's cell to [0, 1), as HashCell in the template
+		float HashCell(const int x, const int y, const int z)
+		{
+			uint32_t h = static_cast<uint32_t>(x) * 73856093u ^ static_cast<uint32_t>(y) * 19349663u ^ static_cast<uint32_t>(z) * 83492791u;
+			h ^= h >> 16;
+			h *= 0x7feb352du;
+			h ^= h >> 15;
+			h *= 0x846ca68bu;
+			h ^= h >> 16;
+			return static_cast<float>(h >> 8) / 16777216.0f;
+		}
+
+		float GetCopyScale(const Repetition& repetition, const int x, const int y, const int z)
+		{
+			if (repetition.Variation <= 0.0f)
+				return 1.0f;
+
+			return 1.0f - std::min(repetition.Variation, MaxVariation) * HashCell(x, y, z);
+		}
+
+		// Copies that can be nearest to local, a point in the object's rotated frame, as GetRepeatedCopies in the template
+		int GetRepeatedCopies(const Repetition& repetition, const Float3& local, RepeatedCopy (&copies)[MaxRepeatedCopies])
+		{
+			switch (static_cast<RepetitionMode>(repetition.Mode))
+			{
+			case RepetitionMode::Grid:
+			{
+				// Nearest cell on each axis and the neighbour on local's side of it, clamped to the limit when there is one
+				int cells[2][3]{};
+				int neighbours = 0;
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					const float spacing = GetAxis(repetition.Spacing, axis);
+					if (spacing <= 0.0f)
+						continue;
+
+					const float q = std::clamp(GetAxis(local, axis) / spacing, -MaxCell, MaxCell);
+					float cell = std::round(q);
+					float next = cell + (q >= cell ? 1.0f : -1.0f);
+					if (const float limit = std::floor(GetAxis(repetition.Limit, axis)); limit > 0.0f)
+					{
+						cell = std::clamp(cell, -limit, limit);
+						next = std::clamp(next, -limit, limit);
+					}
+
+					cells[0][axis] = static_cast<int>(cell);
+					cells[1][axis] = static_cast<int>(next);
+					if (cells[1][axis] != cells[0][axis])
+						neighbours |= 1 << axis;
+				}
+
+				int count = 0;
+				for (int mask = 0; mask < MaxRepeatedCopies; ++mask)
+				{
+					if ((mask & ~neighbours) != 0)
+						continue;
+
+					const int x = cells[mask & 1][0];
+					const int y = cells[(mask >> 1) & 1][1];
+					const int z = cells[(mask >> 2) & 1][2];
+					RepeatedCopy& copy = copies[count++];
+					copy.Point = local - Float3(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z)) * Max(repetition.Spacing, 0.0f);
+					copy.Scale = GetCopyScale(repetition, x, y, z);
+				}
+				return count;
+			}
+			case RepetitionMode::Radial:
+			{
+				// Copies around y, the first on +x, and the nearest sector's neighbour on local's side of it
+				const int sectors = std::max(static_cast<int>(repetition.Limit.x), 1);
+				const float angle = 2.0f * PI / static_cast<float>(sectors);
+				const float q = std::atan2(local.z, local.x) / angle;
+				const float nearest = std::round(q);
+				const float candidates[2] = { nearest, nearest + (q >= nearest ? 1.0f : -1.0f) };
+
+				const int count = sectors > 1 ? 2 : 1;
+				for (int i = 0; i < count; ++i)
+				{
+					RepeatedCopy& copy = copies[i];
+					copy.Angle = candidates[i] * angle;
+					copy.Point = local;
+					Rotate2D(copy.Point.x, copy.Point.z, copy.Angle);
+					copy.Point.x -= repetition.Spacing.x;
+					// Sectors wrap, so their cells do too
+					const int sector = (static_cast<int>(candidates[i]) % sectors + sectors) % sectors;
+					copy.Scale = GetCopyScale(repetition, sector, 0, 0);
+				}
+				return count;
+			}
+			case RepetitionMode::Mirror:
+			{
+				RepeatedCopy& copy = copies[0];
+				copy.Point = local;
+				int sides[3]{};
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					if (GetAxis(repetition.Limit, axis) == 0.0f)
+						continue;
+
+					float& point = GetAxis(copy.Point, axis);
+					sides[axis] = point < 0.0f ? 1 : 0;
+					GetAxis(copy.Flip, axis) = point < 0.0f ? -1.0f : 1.0f;
+					point = std::abs(point) - GetAxis(repetition.Spacing, axis);
+				}
+				copy.Scale = GetCopyScale(repetition, sides[0], sides[1], sides[2]);
+				return 1;
+			}
+			default:
+				copies[0].Point = local;
+				return 1;
+			}
+		}
+
+		// GetDistanceToObject of one copy, local relative to its origin and scale the copy's over the world's
+		float GetDistanceToCopy(const Scene& scene, const Object& object, const Float3& local, const float scale, const float footprint)
+		{
+			const Float3 q = local / Float3(scale);
+			if (scene.SDFLibrary.empty())
+				return SignedDistance(object.SDFType, q, object.Parameters, footprint / scale) * scale * object.StepScale;
+
+			return scene.SDFLibrary[object.SDFType % scene.SDFLibrary.size()](q, object.Parameters) * scale * object.StepScale;
+		}
+	}
+
+	float SignedDistance(const int sdfType, const Float3& p, const Float3& param, const float footprint)
+	{
+		// Snippet index wraps like SDFManagerComponent::GenerateSignedDistanceFunction
+		switch (static_cast<SDFType>(sdfType % static_cast<int>(SDFType::Count)))
+		{
+		case SDFType::Sphere: return SdfSphere(p, param);
+		case SDFType::Box: return SdfBox(p, param);
+		case SDFType::Torus: return SdfTorus(p, param);
+		case SDFType::Cone: return SdfCone(p, param);
+		case SDFType::Cylinder: return SdfCylinder(p, param);
+		case SDFType::Mandelbulb: return SdfMandelbulb(p, param, footprint);
+		case SDFType::Juliabulb: return SdfJuliabulb(p, param, footprint);
+		case SDFType::QuaternionJulia: return SdfQuaternionJulia(p, param, footprint);
+		case SDFType::Sierpinski: return SdfSierpinski(p, param, footprint);
+		case SDFType::Menger: return SdfMenger(p, param, footprint);
+		default: return SdfSphere(p, param);
+		}
+	}
+
+	void SignedDistanceBatch(const int sdfType, const Float3* points, const size_t count, const Float3& param, const float footprint, float* distances)
+	{
+		switch (static_cast<SDFType>(sdfType % static_cast<int>(SDFType::Count)))
+		{
+		case SDFType::Mandelbulb: SdfMandelbulbBatch(points, count, param, footprint, distances); break;
+		case SDFType::Juliabulb: SdfJuliabulbBatch(points, count, param, footprint, distances); break;
+		case SDFType::QuaternionJulia: SdfQuaternionJuliaBatch(points, count, param, footprint, distances); break;
+		case SDFType::Sierpinski: SdfSierpinskiBatch(points, count, param, footprint, distances); break;
+		case SDFType::Menger: SdfMengerBatch(points, count, param, footprint, distances); break;
+		default:
+			// Primitives are a handful of instructions, not worth a vector path
+			for (size_t i = 0; i < count; ++i)
+				distances[i] = SignedDistance(sdfType, points[i], param, footprint);
+			break;
+		}
+	}
+
+	Float3 SignedDistanceGradient(const int sdfType, const Float3& p, const Float3& param, const float footprint, const float offset)
+	{
+		Dual x, y, z;
+		MakeDualPoint(p, x, y, z);
+		switch (static_cast<SDFType>(sdfType % static_cast<int>(SDFType::Count)))
+		{
+		case SDFType::Sphere: return SdfSphere(x, y, z, param).Gradient;
+		case SDFType::Box: return SdfBox(x, y, z, param).Gradient;
+		case SDFType::Torus: return SdfTorus(x, y, z, param).Gradient;
+		case SDFType::Cone: return SdfCone(x, y, z, param).Gradient;
+		case SDFType::Cylinder: return SdfCylinder(x, y, z, param).Gradient;
+		default:
+		{
+			// Dual numbers through the fractal iterations would cost about as much as these taps, which the batch
+			// kernels take four at a time
+			Float3 taps[6]{};
+			GetCentralTaps(p, offset, taps);
+			float distances[6]{};
+			SignedDistanceBatch(sdfType, taps, 6u, param, footprint, distances);
+			return GetCentralGradient(distances, offset);
+		}
+		}
+	}
+
+	float GetSDFBoundingRadius(const int sdfType, const Float3& param)
+	{
+		switch (static_cast<SDFType>(sdfType % static_cast<int>(SDFType::Count)))
+		{
+		case SDFType::Sphere: return param.x;
+		case SDFType::Box: return Length(param);
+		case SDFType::Torus: return param.x + param.y;
+		case SDFType::Cone: return param.z * std::sqrt(1.0f + (param.x / param.y) * (param.x / param.y));
+		case SDFType::Cylinder: return Length(Float2(param.x, param.y));
+		default: return std::numeric_limits<float>::infinity();
+		}
+	}
+
+	bool GetSDFLocalBounds(const int sdfType, const Float3& param, Float3& lo, Float3& hi)
+	{
+		const Float3 a = Abs(param);
+		switch (static_cast<SDFType>(sdfType % static_cast<int>(SDFType::Count)))
+		{
+		case SDFType::Sphere: hi = Float3(a.x); break;
+		case SDFType::Box: hi = a; break;
+		case SDFType::Torus: hi = Float3(a.x + a.y, a.y, a.x + a.y); break;
+		case SDFType::Cone:
+		{
+			// Tip at the origin, base at y = -param.z
+			const float radius = a.z * a.x / a.y;
+			lo = Float3(-radius, -a.z, -radius);
+			hi = Float3(radius, 0.0f, radius);
+			return std::isfinite(radius);
+		}
+		case SDFType::Cylinder: hi = Float3(a.x, a.y, a.x); break;
+		default: return false;
+		}
+		lo = -hi;
+		return true;
+	}
+
+	const char* GetSDFTypeName(const int sdfType)
+	{
+		static constexpr const char* names[static_cast<int>(SDFType::Count)] = { "Sphere", "Box", "Torus", "Cone", "Cylinder", "Mandelbulb",
+		                                                                         "Juliabulb", "QuaternionJulia", "Sierpinski", "Menger" };
+		return names[sdfType % static_cast<int>(SDFType::Count)];
+	}
+
+	Float3 Rotate(Float3 p, const Float3& r)
+	{
+		Rotate2D(p.y, p.z, r.x);
+		Rotate2D(p.x, p.z, r.y);
+		Rotate2D(p.x, p.y, r.z);
+		return p;
+	}
+
+	Float3 InverseRotate(Float3 p, const Float3& r)
+	{
+		Rotate2D(p.x, p.y, -r.z);
+		Rotate2D(p.x, p.z, -r.y);
+		Rotate2D(p.y, p.z, -r.x);
+		return p;
+	}
+
+	bool HasSmoothOperators(const Scene& scene)
+	{
+		return std::ranges::any_of(scene.Objects, [](const Object& object) { return object.BoolOperator >= 3; });
+	}
+
+	float GetRepetitionExtent(const Repetition& repetition)
+	{
+		Float3 extent(0.0f);
+		switch (static_cast<RepetitionMode>(repetition.Mode))
+		{
+		case RepetitionMode::Grid:
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				const float spacing = GetAxis(repetition.Spacing, axis);
+				const float limit = std::floor(GetAxis(repetition.Limit, axis));
+				if (spacing <= 0.0f)
+					continue;
+				if (limit <= 0.0f)
+					return std::numeric_limits<float>::infinity();
+				GetAxis(extent, axis) = spacing * limit;
+			}
+			return Length(extent);
+		case RepetitionMode::Radial: return std::abs(repetition.Spacing.x);
+		case RepetitionMode::Mirror:
+			for (int axis = 0; axis < 3; ++axis)
+				if (GetAxis(repetition.Limit, axis) != 0.0f)
+					GetAxis(extent, axis) = std::abs(GetAxis(repetition.Spacing, axis));
+			return Length(extent);
+		default: return 0.0f;
+		}
+	}
+
+	bool GetRepeatedBounds(const Repetition& repetition, Float3& lo, Float3& hi)
+	{
+		switch (static_cast<RepetitionMode>(repetition.Mode))
+		{
+		case RepetitionMode::Grid:
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				const float spacing = GetAxis(repetition.Spacing, axis);
+				const float limit = std::floor(GetAxis(repetition.Limit, axis));
+				if (spacing <= 0.0f)
+					continue;
+				if (limit <= 0.0f)
+					return false;
+				GetAxis(lo, axis) -= spacing * limit;
+				GetAxis(hi, axis) += spacing * limit;
+			}
+			return true;
+		case RepetitionMode::Radial:
+		{
+			// Any rotation about y of the copy's box, moved out along x by the ring's radius
+			const float x = std::max(std::abs(lo.x + repetition.Spacing.x), std::abs(hi.x + repetition.Spacing.x));
+			const float z = std::max(std::abs(lo.z), std::abs(hi.z));
+			const float radius = Length(Float2(x, z));
+			lo = Float3(-radius, lo.y, -radius);
+			hi = Float3(radius, hi.y, radius);
+			return true;
+		}
+		case RepetitionMode::Mirror:
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				if (GetAxis(repetition.Limit, axis) == 0.0f)
+					continue;
+				const float spacing = GetAxis(repetition.Spacing, axis);
+				const float extent = std::max(std::abs(GetAxis(lo, axis) + spacing), std::abs(GetAxis(hi, axis) + spacing));
+				GetAxis(lo, axis) = -extent;
+				GetAxis(hi, axis) = extent;
+			}
+			return true;
+		default: return true;
+		}
+	}
+
+	float GetDistanceToObject(const Scene& scene, const Object& object, const Float3& p, const float footprint)
+	{
+		const Float3 local = Rotate(Translate(p, object.Position), object.Rotation);
+		if (object.Repeat.Mode == static_cast<int>(RepetitionMode::None))
+			return GetDistanceToCopy(scene, object, local, object.Scale.x, footprint);
+
+		RepeatedCopy copies[MaxRepeatedCopies]{};
+		const int count = GetRepeatedCopies(object.Repeat, local, copies);
+		float dist = std::numeric_limits<float>::infinity();
+		for (int i = 0; i < count; ++i)
+			dist = std::min(dist, GetDistanceToCopy(scene, object, copies[i].Point, object.Scale.x * copies[i].Scale, footprint));
+		return dist;
+	}
+
+	Float3 GetObjectGradient(const Scene& scene, const Object& object, const Float3& p, const float footprint, const float offset)
+	{
+		RepeatedCopy copies[MaxRepeatedCopies]{};
+		const int count = GetRepeatedCopies(object.Repeat, Rotate(Translate(p, object.Position), object.Rotation), copies);
+
+		// The nearest copy's, taken back through the repetition
+		int nearest = 0;
+		float nearestDist = std::numeric_limits<float>::infinity();
+		for (int i = 0; count > 1 && i < count; ++i)
+		{
+			const float dist = GetDistanceToCopy(scene, object, copies[i].Point, object.Scale.x * copies[i].Scale, footprint);
+			if (dist < nearestDist)
+			{
+				nearest = i;
+				nearestDist = dist;
+			}
+		}
+
+		const RepeatedCopy& copy = copies[nearest];
+		const float scale = object.Scale.x * copy.Scale;
+		const Float3 q = copy.Point / Float3(scale);
+		Float3 gradient{};
+		if (scene.SDFLibrary.empty())
+			gradient = SignedDistanceGradient(object.SDFType, q, object.Parameters, footprint / scale, offset / scale);
+		else
+		{
+			const SignedDistanceFunction& sdf = scene.SDFLibrary[object.SDFType % scene.SDFLibrary.size()];
+			gradient = GetCentralGradient([&](const Float3& r) { return sdf(r, object.Parameters); }, q, offset / scale);
+		}
+
+		gradient *= copy.Flip;
+		if (copy.Angle != 0.0f)
+			Rotate2D(gradient.x, gradient.z, -copy.Angle);
+		return InverseRotate(gradient, object.Rotation);
+	}
+
+	SceneDistanceInfo GetDistanceToScene(const Scene& scene, const Float3& p, const float maxDist, const float footprint)
+	{
+		return CombineObjects(scene, p, maxDist, footprint, static_cast<int>(scene.Objects.size()), [](const int i) { return i; },
+		                      scene.Groups.empty() ? nullptr : &scene.Groups);
+	}
+
+	SceneDistanceInfo GetDistanceToMarchedObjects(const Scene& scene, const Float3& p, const float maxDist, const float footprint)
+	{
+		if (scene.AnalyticPrimitives.empty())
+			return GetDistanceToScene(scene, p, maxDist, footprint);
+
+		return CombineObjects(scene, p, maxDist, footprint, static_cast<int>(scene.MarchedObjects.size()),
+		                      [&scene](const int i) { return scene.MarchedObjects[i]; });
+	}
+
+	Float3 GetSceneGradient(const Scene& scene, const Float3& p, const float maxDist, const float footprint, const float offset)
+	{
+		// Blends mix the gradients of the objects they join by how much each moves the result, by the chain rule
+		// through each operator. Only objects that move it need their gradient.
+		if (HasSmoothOperators(scene))
+		{
+			float dist = maxDist;
+			Float3 gradient(0.0f, 1.0f, 0.0f);
+			for (const Object& object : scene.Objects)
+			{
+				const float objectDist = GetDistanceToObject(scene, object, p, footprint);
+				if (const float weight = GetCombineWeight(object, dist, objectDist); weight > 0.0f)
+				{
+					const Float3 objectGradient = GetObjectGradient(scene, object, p, footprint, offset);
+					gradient = Lerp(gradient, IsSubtractOperator(object.BoolOperator) ? -objectGradient : objectGradient, weight);
+				}
+				dist = CombineDistance(object, dist, objectDist);
+			}
+			return gradient;
+		}
+
+		// Otherwise the scene distance near p is the distance to the object that last set it, negated when that
+		// object was subtracted, so the scene's gradient is that object's
+		const SceneDistanceInfo info = GetDistanceToScene(scene, p, maxDist, footprint);
+		const Object& object = scene.Objects[info.Index];
+		const Float3 gradient = GetObjectGradient(scene, object, p, footprint, offset);
+		return IsSubtractOperator(object.BoolOperator) ? -gradient : gradient;
+	}
+}
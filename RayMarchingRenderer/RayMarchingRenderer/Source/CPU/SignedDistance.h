@@ -0,0 +1,141 @@
+#pragma once
+#include <cstddef>
+
+#include "CPU/SceneData.h"
+
+// CPU ports of the built-in SDF snippets in SDFManagerComponent and of the
+// scene distance function generated from SceneDistanceTemplate.hlsli. The
+// fractal types run the kernels in FractalKernels.h.
+namespace CPU
+{
+	// Indices match the default SDFManagerComponent snippet order
+	enum class SDFType : int
+	{
+		Sphere = 0,
+		Box,
+		Torus,
+		Cone,
+		Cylinder,
+		Mandelbulb,
+		Juliabulb,
+		QuaternionJulia,
+		Sierpinski,
+		Menger,
+		Count
+	};
+
+	// Values of Repetition::Mode
+	enum class RepetitionMode : int
+	{
+		None = 0,
+		Grid,
+		Radial,
+		Mirror,
+		Count
+	};
+
+	struct SceneDistanceInfo
+	{
+		float Distance{ 0.0f };
+		int Index{ 0 };
+	};
+
+	// footprint is the ray's pixel cone radius at p, which the fractal types drop detail below
+	[[nodiscard]] float SignedDistance(int sdfType, const Float3& p, const Float3& param, float footprint = 0.0f);
+	// SignedDistance of count points with one param and footprint, vectorised for the fractal types
+	void SignedDistanceBatch(int sdfType, const Float3* points, size_t count, const Float3& param, float footprint, float* distances);
+	// Unnormalised gradient of SignedDistance at p. Exact for the primitives, by forward mode differentiation, and
+	// from central differences offset either side of p for the fractal types.
+	[[nodiscard]] Float3 SignedDistanceGradient(int sdfType, const Float3& p, const Float3& param, float footprint, float offset);
+	// Radius of a sphere about the local origin containing a built-in type's surface. Infinite for the fractal
+	// types, whose distance estimates are only bounds near the set.
+	[[nodiscard]] float GetSDFBoundingRadius(int sdfType, const Float3& param);
+	// Local space box [lo, hi] containing a built-in type's surface, false for the fractal types as above
+	[[nodiscard]] bool GetSDFLocalBounds(int sdfType, const Float3& param, Float3& lo, Float3& hi);
+	// Furthest a repeated object's copies are from its position, before scaling by Scale.x. Infinite for a grid
+	// repeating forever along an axis.
+	[[nodiscard]] float GetRepetitionExtent(const Repetition& repetition);
+	// Grows [lo, hi], a copy's box in the object's rotated frame, to contain every copy, false when they go on
+	// forever. The box must contain the copy's origin, which Repetition::Variation shrinks it towards.
+	[[nodiscard]] bool GetRepeatedBounds(const Repetition& repetition, Float3& lo, Float3& hi);
+	// Snippet name of a built-in type, wrapping like SignedDistance
+	[[nodiscard]] const char* GetSDFTypeName(int sdfType);
+
+	// Polynomial smooth minimum. It only differs from min(a, b) where they are within radius of each other, so a
+	// smooth union can only move the surface within radius of both operands.
+	[[nodiscard]] inline float SmoothUnion(const float a, const float b, const float radius)
+	{
+		const float h = radius - std::abs(a - b);
+		if (h <= 0.0f)
+			return std::min(a, b);
+		return std::min(a, b) - h * h * 0.25f / radius;
+	}
+	[[nodiscard]] inline float SmoothIntersection(const float a, const float b, const float radius) { return -SmoothUnion(-a, -b, radius); }
+	// Derivative of SmoothUnion(a, b, radius) by b, 1 or 0 outside the blend
+	[[nodiscard]] inline float GetSmoothUnionWeight(const float a, const float b, const float radius)
+	{
+		const float h = radius - std::abs(a - b);
+		if (h <= 0.0f)
+			return b < a ? 1.0f : 0.0f;
+		const float t = h * 0.5f / radius;
+		return b < a ? 1.0f - t : t;
+	}
+
+	// Unions only ever add to the scene, so they can be bounded and culled. The rest can remove from anything before them.
+	[[nodiscard]] inline bool IsUnionOperator(const int boolOperator) { return boolOperator == 0 || boolOperator == 3; }
+	// Subtractions enter the scene negated
+	[[nodiscard]] inline bool IsSubtractOperator(const int boolOperator) { return boolOperator == 2 || boolOperator == 5; }
+	// Folds an object's distance into the scene's by its BoolOperator, as the generated GetDistanceToScene
+	[[nodiscard]] inline float CombineDistance(const Object& object, const float dist, const float objectDist)
+	{
+		switch (object.BoolOperator)
+		{
+		case 1: return std::max(dist, objectDist);
+		case 2: return std::max(dist, -objectDist);
+		case 3: return SmoothUnion(dist, objectDist, object.BlendRadius);
+		case 4: return SmoothIntersection(dist, objectDist, object.BlendRadius);
+		case 5: return SmoothIntersection(dist, -objectDist, object.BlendRadius);
+		default: return std::min(dist, objectDist);
+		}
+	}
+	// Share of CombineDistance's result that follows objectDist, the weight of the object's gradient in the scene's
+	[[nodiscard]] inline float GetCombineWeight(const Object& object, const float dist, const float objectDist)
+	{
+		switch (object.BoolOperator)
+		{
+		case 1: return objectDist > dist ? 1.0f : 0.0f;
+		case 2: return -objectDist > dist ? 1.0f : 0.0f;
+		case 3: return GetSmoothUnionWeight(dist, objectDist, object.BlendRadius);
+		case 4: return GetSmoothUnionWeight(-dist, -objectDist, object.BlendRadius);
+		case 5: return GetSmoothUnionWeight(-dist, objectDist, object.BlendRadius);
+		default: return objectDist < dist ? 1.0f : 0.0f;
+		}
+	}
+	// Whether any object blends, which leaves the scene's gradient a mix of several objects'
+	[[nodiscard]] bool HasSmoothOperators(const Scene& scene);
+
+	[[nodiscard]] Float3 Rotate(Float3 p, const Float3& r);
+	[[nodiscard]] Float3 InverseRotate(Float3 p, const Float3& r);
+	[[nodiscard]] inline Float3 Translate(const Float3& p, const Float3& t) { return p - t; }
+
+	// Distance to a single object in its local space, scaled back to world space and by its step scale.
+	// footprint is in world space. Snippet ports in Scene::SDFLibrary don't take one. A repeated object takes the
+	// nearest of the copies in the cell (or sector, or mirrored half) p is in and in the neighbouring one towards
+	// p on each repeated axis, at most 8, which is exact while every copy fits in its own cell.
+	[[nodiscard]] float GetDistanceToObject(const Scene& scene, const Object& object, const Float3& p, float footprint = 0.0f);
+
+	// Unnormalised world space gradient of GetDistanceToObject, as SignedDistanceGradient. Snippet ports in
+	// Scene::SDFLibrary are opaque, so they always take the taps, offset apart in world space.
+	[[nodiscard]] Float3 GetObjectGradient(const Scene& scene, const Object& object, const Float3& p, float footprint, float offset);
+
+	// Same combination and index selection as the generated GetDistanceToScene. Scene::Groups whose bounds are further
+	// than the distance so far are skipped whole, which leaves both as they were.
+	[[nodiscard]] SceneDistanceInfo GetDistanceToScene(const Scene& scene, const Float3& p, float maxDist, float footprint = 0.0f);
+	// The same over Scene::MarchedObjects only, as the generated GetDistanceToMarchedObjects. Every object when the
+	// scene has no analytic primitives.
+	[[nodiscard]] SceneDistanceInfo GetDistanceToMarchedObjects(const Scene& scene, const Float3& p, float maxDist, float footprint = 0.0f);
+	// Unnormalised gradient of GetDistanceToScene, as the generated GetSceneGradient. The nearest object's gradient,
+	// or when the scene has smooth operators, the gradients of the objects that move the distance at p mixed by
+	// GetCombineWeight. offset spaces the taps of objects without an exact gradient.
+	[[nodiscard]] Float3 GetSceneGradient(const Scene& scene, const Float3& p, float maxDist, float footprint, float offset);
+}
@@ -0,0 +1,154 @@
+#include "CPU/SnippetCost.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <tuple>
+
+namespace CPU
+{
+	namespace
+	{
+		// Integer hash with good avalanche, matched by SnippetHash in SnippetBenchmark.hlsli
+		[[nodiscard]] uint32_t HashPoint(uint32_t x)
+		{
+			x ^= x >> 16u;
+			x *= 0x7FEB352Du;
+			x ^= x >> 15u;
+			x *= 0x846CA68Bu;
+			x ^= x >> 16u;
+			return x;
+		}
+
+		[[nodiscard]] float ToUnit(const uint32_t x)
+		{
+			return static_cast<float>(x >> 8u) * (1.0f / static_cast<float>(1u << 24u)) * 2.0f - 1.0f;
+		}
+	}
+
+	uint64_t HashSnippet(const std::string_view name, const std::string_view body)
+	{
+		// FNV-1a over the name, a separator and the body
+		uint64_t hash = 0xCBF29CE484222325ull;
+		const auto add = [&hash](const std::string_view text)
+		{
+			for (const char c : text)
+			{
+				hash ^= static_cast<unsigned char>(c);
+				hash *= 0x100000001B3ull;
+			}
+		};
+		add(name);
+		add(std::string_view("\0", 1));
+		add(body);
+		return hash == 0u ? 1u : hash;
+	}
+
+	uint64_t HashSnippetMeasurement(const uint64_t snippetHash, const Float3& parameters)
+	{
+		uint64_t hash = snippetHash;
+		for (const float parameter : { parameters.x, parameters.y, parameters.z })
+		{
+			uint32_t bits = 0u;
+			std::memcpy(&bits, &parameter, sizeof(bits));
+			hash = (hash ^ bits) * 0x100000001B3ull;
+		}
+		return hash == 0u ? 1u : hash;
+	}
+
+	float GetSnippetStepScale(const float lipschitz)
+	{
+		if (!(lipschitz > SnippetLipschitzTolerance))
+			return 1.0f;
+		return std::max(1.0f / lipschitz, MinSnippetStepScale);
+	}
+
+	Float3 GetSnippetBenchmarkPoint(const uint32_t index)
+	{
+		return Float3(ToUnit(HashPoint(index * 3u)), ToUnit(HashPoint(index * 3u + 1u)), ToUnit(HashPoint(index * 3u + 2u))) *
+		       Float3(SnippetBenchmarkExtent);
+	}
+
+	uint32_t GetSnippetSlopeBin(const float slope)
+	{
+		const float bin = (std::log2(std::max(slope, 1e-30f)) - static_cast<float>(SnippetSlopeMinLog2)) * static_cast<float>(SnippetSlopeBinsPerOctave);
+		return static_cast<uint32_t>(std::clamp(bin, 0.0f, static_cast<float>(SnippetSlopeBins - 1u)));
+	}
+
+	float GetSnippetLipschitz(const uint32_t (&histogram)[SnippetSlopeBins], const float maxSlope)
+	{
+		uint64_t total = 0u;
+		for (const uint32_t count : histogram)
+			total += count;
+		if (total == 0u)
+			return 0.0f;
+
+		const double target = static_cast<double>(total) * SnippetLipschitzQuantile;
+		uint64_t below = 0u;
+		uint32_t bin = 0u;
+		for (; bin < SnippetSlopeBins - 1u; ++bin)
+		{
+			below += histogram[bin];
+			if (static_cast<double>(below) >= target)
+				break;
+		}
+		const float upper = std::exp2(static_cast<float>(SnippetSlopeMinLog2) + static_cast<float>(bin + 1u) / static_cast<float>(SnippetSlopeBinsPerOctave));
+		return std::min(upper, maxSlope);
+	}
+
+	SnippetCost MeasureSnippetCost(const SignedDistanceFunction sdf, const Float3& parameters, const uint32_t pointCount)
+	{
+		using Clock = std::chrono::steady_clock;
+
+		SnippetCost cost{};
+		cost.Parameters = parameters;
+
+		const auto start = Clock::now();
+		volatile float sink = 0.0f;
+		float sum = 0.0f;
+		for (uint32_t i = 0; i < pointCount; ++i)
+			sum += sdf(GetSnippetBenchmarkPoint(i), parameters);
+		sink = sink + sum;
+		const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		cost.EvaluationsPerSecond = static_cast<float>(static_cast<double>(pointCount) / std::max(seconds, 1e-9));
+
+		uint32_t histogram[SnippetSlopeBins]{};
+		const float h = SnippetGradientStep;
+		for (uint32_t i = 0; i < pointCount; ++i)
+		{
+			const Float3 p = GetSnippetBenchmarkPoint(i);
+			const Float3 gradient(sdf(p + Float3(h, 0.0f, 0.0f), parameters) - sdf(p - Float3(h, 0.0f, 0.0f), parameters),
+			                      sdf(p + Float3(0.0f, h, 0.0f), parameters) - sdf(p - Float3(0.0f, h, 0.0f), parameters),
+			                      sdf(p + Float3(0.0f, 0.0f, h), parameters) - sdf(p - Float3(0.0f, 0.0f, h), parameters));
+			const float slope = Length(gradient) / (2.0f * h);
+			// Points where the snippet returns NaN or infinity say nothing about its slope
+			if (!std::isfinite(slope))
+				continue;
+			cost.MaxSlope = std::max(cost.MaxSlope, slope);
+			++histogram[GetSnippetSlopeBin(slope)];
+		}
+		cost.Lipschitz = GetSnippetLipschitz(histogram, cost.MaxSlope);
+
+		return cost;
+	}
+
+	void EstimateStepScales(Scene& scene, const uint32_t pointCount)
+	{
+		std::map<std::tuple<SignedDistanceFunction, float, float, float>, float> scales{};
+		for (Object& object : scene.Objects)
+		{
+			object.StepScale = 1.0f;
+			if (scene.SDFLibrary.empty())
+				continue;
+
+			const SignedDistanceFunction sdf = scene.SDFLibrary[object.SDFType % scene.SDFLibrary.size()];
+			const auto key = std::make_tuple(sdf, object.Parameters.x, object.Parameters.y, object.Parameters.z);
+			auto scale = scales.find(key);
+			if (scale == scales.end())
+				scale = scales.emplace(key, GetSnippetStepScale(MeasureSnippetCost(sdf, object.Parameters, pointCount).Lipschitz)).first;
+			object.StepScale = scale->second;
+		}
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+#include "CPU/SceneData.h"
+
+// Cost model of user SDF snippets: how many evaluations per second a snippet
+// sustains and an estimate of its Lipschitz constant, the steepest slope of the
+// distance it returns. A snippet with a constant above 1 overestimates distance
+// somewhere, so sphere tracing can step through its surface. Both are measured
+// over the same object space points on the GPU (SnippetBenchmark.hlsli) and on
+// the CPU for snippet ports.
+//
+// Fractal distance estimators jump where the escape iteration count changes, so
+// the steepest slope found is dominated by a handful of points straddling a
+// jump. The estimate is therefore a high quantile of the slopes, taken from a
+// log scale histogram so the GPU can build it with atomics.
+namespace CPU
+{
+	// Points are spread uniformly over [-extent, extent] on each axis
+	inline constexpr float SnippetBenchmarkExtent = 2.0f;
+	// Central difference spacing of the gradient the Lipschitz estimate is taken from
+	inline constexpr float SnippetGradientStep = 1e-3f;
+
+	// Slope histogram, eighth octave bins from 2^SnippetSlopeMinLog2. The first and last bins also take everything beyond them.
+	inline constexpr uint32_t SnippetSlopeBins = 64u;
+	inline constexpr uint32_t SnippetSlopeBinsPerOctave = 8u;
+	inline constexpr int SnippetSlopeMinLog2 = -2;
+	// Fraction of slopes at or below the Lipschitz estimate
+	inline constexpr float SnippetLipschitzQuantile = 0.99f;
+	// Estimates up to this are true SDFs within measurement noise and march at full steps
+	inline constexpr float SnippetLipschitzTolerance = 1.05f;
+	// Smallest step scale applied. A snippet that is discontinuous rather than steep gains nothing from smaller
+	// steps, and as the intersection threshold applies to the scaled distance its surface would also thicken.
+	inline constexpr float MinSnippetStepScale = 0.25f;
+
+	// Stored in scene files with Hash identifying the name and body it was measured for, and Parameters the param
+	struct SnippetCost
+	{
+		uint64_t Hash{ 0u }; // 0 when not measured
+		float EvaluationsPerSecond{ 0.0f };
+		float Lipschitz{ 0.0f }; // SnippetLipschitzQuantile of the gradient lengths found
+		Float3 Parameters{ 1.0f }; // param the snippet was measured with
+		float MaxSlope{ 0.0f }; // Largest gradient length found
+	};
+	static_assert(sizeof(SnippetCost) == 32);
+
+	// Never 0, so a measured cost is never mistaken for an empty one
+	[[nodiscard]] uint64_t HashSnippet(std::string_view name, std::string_view body);
+	// Identifies a measurement of a snippet with one param, as the estimate depends on both
+	[[nodiscard]] uint64_t HashSnippetMeasurement(uint64_t snippetHash, const Float3& parameters);
+
+	// Multiplier on an object's distance that makes it a lower bound again: 1 / Lipschitz, clamped
+	[[nodiscard]] float GetSnippetStepScale(float lipschitz);
+
+	// Point index of the standard distribution
+	[[nodiscard]] Float3 GetSnippetBenchmarkPoint(uint32_t index);
+
+	// Histogram bin of a finite slope, matched by GetSlopeBin in SnippetBenchmark.hlsli
+	[[nodiscard]] uint32_t GetSnippetSlopeBin(float slope);
+	// Upper edge of the bin the quantile falls in, capped at the largest slope so a snippet with one slope
+	// everywhere reports exactly that. 0 for an empty histogram.
+	[[nodiscard]] float GetSnippetLipschitz(const uint32_t (&histogram)[SnippetSlopeBins], float maxSlope);
+
+	// Measures a C++ port of a snippet on this thread, with the same points and estimator as the GPU. Hash is left 0.
+	[[nodiscard]] SnippetCost MeasureSnippetCost(SignedDistanceFunction sdf, const Float3& parameters, uint32_t pointCount = 1u << 16u);
+
+	// Sets every object's StepScale from its scene SDF library function measured with its param, measuring each pair once.
+	// Built-in primitives are exact and keep a scale of 1.
+	void EstimateStepScales(Scene& scene, uint32_t pointCount = 1u << 16u);
+}
@@ -0,0 +1,103 @@
+#include "CPU/SnippetPorts.h"
+
+namespace CPU
+{
+	float SdfMandelbulbSnippet(const Float3& p, const Float3& param)
+	{
+		Float3 z = p;
+		float r = 0.0f;
+		float dr = 1.0f;
+		for (int i = 0; i < 5; ++i)
+		{
+			r = Length(z);
+			if (r > 100.0f)
+				break;
+
+			float theta = std::acos(z.z / r);
+			float phi = std::atan2(z.y, z.x);
+
+			dr = param.x * std::pow(r, param.x - 1.0f) * dr + 1.0f;
+
+			r = std::pow(r, param.x);
+			theta *= param.x;
+			phi *= param.x;
+
+			z = Float3(r) * Float3(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta));
+			z += p;
+		}
+
+		return 0.5f * std::log(r) * r / dr;
+	}
+
+	float SdfJuliabulbSnippet(const Float3& p, const Float3& param)
+	{
+		Float3 orbit = p;
+		float dz = 1.0f;
+
+		for (int i = 0; i < 4; ++i)
+		{
+			float r = Length(orbit);
+			float o = std::acos(orbit.z / r);
+			float a = std::atan(orbit.y / orbit.x);
+
+			dz = 8.0f * r * r * r * r * r * r * r * dz;
+
+			r = r * r * r * r * r * r * r * r;
+			o = 8.0f * o;
+			a = 8.0f * a;
+
+			// float3 + float4(param, 0.5) truncates to float3 in HLSL
+			orbit = Float3(r * std::sin(o) * std::cos(a), r * std::sin(o) * std::sin(a), r * std::cos(o)) + param;
+
+			if (Dot(orbit, orbit) > 4.0f)
+				break;
+		}
+
+		const float z = Length(orbit);
+		return 0.5f * z * std::log(z) / dz;
+	}
+
+	float SdfJuliaSnippet(const Float3& p, const Float3& param)
+	{
+		Float4 z(p, 0.0f);
+		float md2 = 1.0f;
+		float mz2 = Dot(z, z);
+
+		for (int i = 0; i < 11; ++i)
+		{
+			md2 *= 4.0f * mz2;
+			const Float4 qsqr(z.x * z.x - z.y * z.y - z.z * z.z - z.w * z.w,
+			                  2.0f * z.x * z.y,
+			                  2.0f * z.x * z.z,
+			                  2.0f * z.x * z.w);
+			z = qsqr + Float4(param, 0.0f);
+
+			mz2 = Dot(z, z);
+
+			if (mz2 > 4.0f)
+				break;
+		}
+
+		return 0.25f * std::sqrt(mz2 / md2) * std::log(mz2);
+	}
+
+	float SdfSierpinskiSnippet(const Float3& p, const Float3&)
+	{
+		constexpr float scale = 1.0f;
+		constexpr float offset = 1.0f;
+		constexpr int iterations = 8;
+
+		Float3 q = p;
+		int n = 0;
+		while (n < iterations)
+		{
+			if (q.x + q.y < 0.0f) { const float x = q.x; q.x = -q.y; q.y = -x; }
+			if (q.x + q.z < 0.0f) { const float x = q.x; q.x = -q.z; q.z = -x; }
+			if (q.y + q.z < 0.0f) { const float y = q.y; q.y = -q.z; q.z = -y; }
+			q = q * Float3(scale) - Float3(offset * (scale - 1.0f));
+			++n;
+		}
+
+		return Length(q) * std::pow(scale, -static_cast<float>(n));
+	}
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include "CPU/SceneData.h"
+
+// Line by line C++ ports of the example fractal snippets shipped next to the
+// solution (mandelbulb_fractal.txt etc.), for use in Scene::SDFLibrary. They
+// keep the snippets' quirks, such as the juliabulb's atan(y / x), so CPU
+// measurements reflect what the GPU runs when those snippets are pasted in.
+namespace CPU
+{
+	// param.x is the power
+	[[nodiscard]] float SdfMandelbulbSnippet(const Float3& p, const Float3& param);
+	// param is added to the orbit each iteration
+	[[nodiscard]] float SdfJuliabulbSnippet(const Float3& p, const Float3& param);
+	// Quaternion Julia set, param is c.xyz
+	[[nodiscard]] float SdfJuliaSnippet(const Float3& p, const Float3& param);
+	[[nodiscard]] float SdfSierpinskiSnippet(const Float3& p, const Float3& param);
+}
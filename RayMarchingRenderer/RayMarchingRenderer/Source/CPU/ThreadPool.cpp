@@ -0,0 +1,102 @@
+#include "CPU/ThreadPool.h"
+
+#include <algorithm>
+#include <string>
+
+#include "CPU/Profiler.h"
+
+namespace CPU
+{
+	ThreadPool::ThreadPool(unsigned int threadCount)
+	{
+		if (threadCount == 0u)
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+		Workers.reserve(threadCount - 1u);
+		for (unsigned int i = 1u; i < threadCount; ++i)
+			Workers.emplace_back([this, i]()
+			{
+				SetProfilerThreadName("Worker " + std::to_string(i));
+				WorkerLoop();
+			});
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard lock(Mutex);
+			Stopping = true;
+		}
+		WorkAvailable.notify_all();
+
+		for (std::thread& worker : Workers)
+			worker.join();
+	}
+
+	void ThreadPool::ParallelFor(const int count, const std::function<void(int)>& func)
+	{
+		if (count <= 0)
+			return;
+
+		{
+			std::lock_guard lock(Mutex);
+			Job = &func;
+			JobCount = count;
+			NextIndex.store(0, std::memory_order_relaxed);
+			JobException = nullptr;
+			BusyWorkers = static_cast<unsigned int>(Workers.size());
+			++Generation;
+		}
+		WorkAvailable.notify_all();
+
+		RunJob();
+
+		std::unique_lock lock(Mutex);
+		WorkFinished.wait(lock, [this]() { return BusyWorkers == 0u; });
+		Job = nullptr;
+
+		if (JobException)
+			std::rethrow_exception(JobException);
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		unsigned long long seenGeneration = 0u;
+		while (true)
+		{
+			{
+				std::unique_lock lock(Mutex);
+				WorkAvailable.wait(lock, [&]() { return Stopping || Generation != seenGeneration; });
+				if (Stopping)
+					return;
+				seenGeneration = Generation;
+			}
+
+			RunJob();
+
+			std::lock_guard lock(Mutex);
+			if (--BusyWorkers == 0u)
+				WorkFinished.notify_one();
+		}
+	}
+
+	void ThreadPool::RunJob()
+	{
+		PROFILE_ZONE("ParallelFor");
+		for (int i = NextIndex.fetch_add(1, std::memory_order_relaxed); i < JobCount; i = NextIndex.fetch_add(1, std::memory_order_relaxed))
+		{
+			try
+			{
+				(*Job)(i);
+			}
+			catch (...)
+			{
+				// Skip the remaining indices and report the first failure to the caller
+				std::lock_guard lock(Mutex);
+				if (!JobException)
+					JobException = std::current_exception();
+				NextIndex.store(JobCount, std::memory_order_relaxed);
+			}
+		}
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data parallel loops on the CPU path. The
+// calling thread takes part in each loop, so a pool of N threads keeps N
+// cores busy with N - 1 workers.
+namespace CPU
+{
+	class ThreadPool
+	{
+	public:
+		// threadCount of 0 uses every hardware thread
+		explicit ThreadPool(unsigned int threadCount = 0u);
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		~ThreadPool();
+
+		[[nodiscard]] unsigned int GetThreadCount() const { return static_cast<unsigned int>(Workers.size()) + 1u; }
+
+		// Calls func(i) for every i in [0, count), handing out indices one at a time so uneven
+		// work balances itself. Returns once all calls have finished and rethrows the first
+		// exception thrown by any of them. Not reentrant.
+		void ParallelFor(int count, const std::function<void(int)>& func);
+
+	private:
+		void WorkerLoop();
+		void RunJob();
+
+		std::vector<std::thread> Workers{};
+
+		std::mutex Mutex{};
+		std::condition_variable WorkAvailable{};
+		std::condition_variable WorkFinished{};
+		unsigned long long Generation{ 0u };
+		unsigned int BusyWorkers{ 0u };
+		bool Stopping{ false };
+
+		const std::function<void(int)>* Job{ nullptr };
+		int JobCount{ 0 };
+		std::atomic<int> NextIndex{ 0 };
+		std::exception_ptr JobException{};
+	};
+}
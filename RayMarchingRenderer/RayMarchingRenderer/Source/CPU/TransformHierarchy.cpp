@@ -0,0 +1,355 @@
+#include "CPU/TransformHierarchy.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <limits>
+
+#include "CPU/SignedDistance.h"
+
+namespace CPU
+{
+	namespace
+	{
+		constexpr float Infinity = std::numeric_limits<float>::infinity();
+
+		// Rotate's matrix, its columns the rotated axes
+		RotationMatrix GetRotationMatrix(const Float3& rotation)
+		{
+			RotationMatrix matrix{};
+			matrix.Columns[0] = Rotate(Float3(1.0f, 0.0f, 0.0f), rotation);
+			matrix.Columns[1] = Rotate(Float3(0.0f, 1.0f, 0.0f), rotation);
+			matrix.Columns[2] = Rotate(Float3(0.0f, 0.0f, 1.0f), rotation);
+			return matrix;
+		}
+
+		// a times b, b applied first
+		RotationMatrix Multiply(const RotationMatrix& a, const RotationMatrix& b)
+		{
+			RotationMatrix product{};
+			for (int i = 0; i < 3; ++i)
+			{
+				const Float3& column = b.Columns[i];
+				product.Columns[i] = a.Columns[0] * Float3(column.x) + a.Columns[1] * Float3(column.y) + a.Columns[2] * Float3(column.z);
+			}
+			return product;
+		}
+
+		RotationMatrix Transpose(const RotationMatrix& matrix)
+		{
+			const Float3 (&c)[3] = matrix.Columns;
+			RotationMatrix transposed{};
+			transposed.Columns[0] = Float3(c[0].x, c[1].x, c[2].x);
+			transposed.Columns[1] = Float3(c[0].y, c[1].y, c[2].y);
+			transposed.Columns[2] = Float3(c[0].z, c[1].z, c[2].z);
+			return transposed;
+		}
+
+		// The transpose times p, InverseRotate
+		Float3 MultiplyTransposed(const RotationMatrix& matrix, const Float3& p)
+		{
+			return Float3(Dot(matrix.Columns[0], p), Dot(matrix.Columns[1], p), Dot(matrix.Columns[2], p));
+		}
+
+		// Rotate applies x, then y, then z, so the matrix is Rz Ry Rx with Rx = [1 0 0; 0 c s; 0 -s c] and so on.
+		// Its bottom row is (-sin y, -cos y sin x, cos y cos x) and its first column (cos z cos y, -sin z cos y, -sin y).
+		// z comes from the top two rows with x taken out, which stays accurate near gimbal lock, where x goes to 0.
+		Float3 GetEulerAngles(const RotationMatrix& matrix)
+		{
+			const Float3 (&c)[3] = matrix.Columns;
+			const float x = std::atan2(-c[1].z, c[2].z);
+			const float y = std::atan2(-c[0].z, std::sqrt(c[0].x * c[0].x + c[0].y * c[0].y));
+			const float s = std::sin(x);
+			const float k = std::cos(x);
+			return Float3(x, y, std::atan2(k * c[1].x + s * c[2].x, k * c[1].y + s * c[2].y));
+		}
+
+		BoundingSphere Merge(const BoundingSphere& a, const BoundingSphere& b)
+		{
+			if (b.Radius < 0.0f)
+				return a;
+			if (a.Radius < 0.0f)
+				return b;
+			if (std::isinf(a.Radius) || std::isinf(b.Radius))
+				return { a.Centre, Infinity };
+
+			const float distance = Distance(a.Centre, b.Centre);
+			if (distance + b.Radius <= a.Radius)
+				return a;
+			if (distance + a.Radius <= b.Radius)
+				return b;
+
+			const float radius = 0.5f * (distance + a.Radius + b.Radius);
+			return { a.Centre + (b.Centre - a.Centre) * Float3((radius - a.Radius) / distance), radius };
+		}
+	}
+
+	Transform ComposeTransforms(const Transform& parent, const Transform& local)
+	{
+		const RotationMatrix parentRotation = GetRotationMatrix(parent.Rotation);
+		Transform world{};
+		world.Position = parent.Position + MultiplyTransposed(parentRotation, local.Position) * Float3(parent.Scale);
+		world.Rotation = GetEulerAngles(Multiply(GetRotationMatrix(local.Rotation), parentRotation));
+		world.Scale = parent.Scale * local.Scale;
+		return world;
+	}
+
+	Transform GetRelativeTransform(const Transform& parent, const Transform& world)
+	{
+		const RotationMatrix parentRotation = GetRotationMatrix(parent.Rotation);
+		Transform local{};
+		local.Position = Rotate(world.Position - parent.Position, parent.Rotation) / Float3(parent.Scale);
+		local.Rotation = GetEulerAngles(Multiply(GetRotationMatrix(world.Rotation), Transpose(parentRotation)));
+		local.Scale = world.Scale / parent.Scale;
+		return local;
+	}
+
+	int TransformHierarchy::AddNode(const int parent, const Transform& local, const float radius)
+	{
+		const int node = static_cast<int>(Parents.size());
+		Parents.push_back(parent);
+		FirstChildren.push_back(NoParent);
+		LastChildren.push_back(NoParent);
+		NextSiblings.push_back(NoParent);
+		Depths.push_back(parent == NoParent ? 0 : Depths[parent] + 1);
+		if (parent != NoParent)
+		{
+			if (LastChildren[parent] == NoParent)
+				FirstChildren[parent] = node;
+			else
+				NextSiblings[LastChildren[parent]] = node;
+			LastChildren[parent] = node;
+		}
+
+		Locals.push_back(local);
+		LocalRotations.push_back(GetRotationMatrix(local.Rotation));
+		Worlds.push_back(local);
+		WorldRotations.push_back(LocalRotations.back());
+		Radii.push_back(radius);
+		GroupBounds.emplace_back();
+
+		Dirty.push_back(0u);
+		Refit.push_back(0u);
+		MarkDirty(node);
+		return node;
+	}
+
+	void TransformHierarchy::SetLocal(const int node, const Transform& local)
+	{
+		Locals[node] = local;
+		LocalRotations[node] = GetRotationMatrix(local.Rotation);
+		MarkDirty(node);
+	}
+
+	void TransformHierarchy::SetRadius(const int node, const float radius)
+	{
+		Radii[node] = radius;
+		MarkDirty(node);
+	}
+
+	void TransformHierarchy::MarkDirty(const int node)
+	{
+		if (Dirty[node])
+			return;
+		Dirty[node] = 1u;
+		DirtyNodes.push_back(node);
+	}
+
+	void TransformHierarchy::Update()
+	{
+		UpdatedTransforms = 0u;
+		UpdatedBounds = 0u;
+
+		// A dirty node under another is recomputed with the other's subtree
+		std::erase_if(DirtyNodes, [this](const int node)
+		{
+			for (int ancestor = Parents[node]; ancestor != NoParent; ancestor = Parents[ancestor])
+				if (Dirty[ancestor])
+					return true;
+			return false;
+		});
+
+		Ancestors.clear();
+		for (const int root : DirtyNodes)
+		{
+			// Parents before children, without a stack
+			Subtree.clear();
+			for (int node = root;;)
+			{
+				Subtree.push_back(node);
+				if (FirstChildren[node] != NoParent)
+				{
+					node = FirstChildren[node];
+					continue;
+				}
+				while (node != root && NextSiblings[node] == NoParent)
+					node = Parents[node];
+				if (node == root)
+					break;
+				node = NextSiblings[node];
+			}
+
+			for (const int node : Subtree)
+			{
+				UpdateWorld(node);
+				Dirty[node] = 0u;
+			}
+			for (auto node = Subtree.rbegin(); node != Subtree.rend(); ++node)
+				RefitBound(*node);
+			UpdatedTransforms += Subtree.size();
+
+			// Each ancestor is refit once, however many of its subtrees moved
+			for (int ancestor = Parents[root]; ancestor != NoParent && !Refit[ancestor]; ancestor = Parents[ancestor])
+			{
+				Refit[ancestor] = 1u;
+				Ancestors.push_back(ancestor);
+			}
+		}
+		DirtyNodes.clear();
+
+		// Deepest first, so every child is refit before its parent
+		std::ranges::sort(Ancestors, [this](const int a, const int b) { return Depths[a] > Depths[b]; });
+		for (const int ancestor : Ancestors)
+		{
+			RefitBound(ancestor);
+			Refit[ancestor] = 0u;
+		}
+		UpdatedBounds = UpdatedTransforms + Ancestors.size();
+	}
+
+	void TransformHierarchy::UpdateWorld(const int node)
+	{
+		const int parent = Parents[node];
+		if (parent == NoParent)
+		{
+			Worlds[node] = Locals[node];
+			WorldRotations[node] = LocalRotations[node];
+			return;
+		}
+
+		const Transform& parentWorld = Worlds[parent];
+		const RotationMatrix& parentRotation = WorldRotations[parent];
+		WorldRotations[node] = Multiply(LocalRotations[node], parentRotation);
+
+		Transform& world = Worlds[node];
+		world.Position = parentWorld.Position + MultiplyTransposed(parentRotation, Locals[node].Position) * Float3(parentWorld.Scale);
+		world.Rotation = GetEulerAngles(WorldRotations[node]);
+		world.Scale = parentWorld.Scale * Locals[node].Scale;
+	}
+
+	void TransformHierarchy::RefitBound(const int node)
+	{
+		BoundingSphere bound{};
+		if (const float radius = Radii[node]; radius >= 0.0f)
+			bound = { Worlds[node].Position, std::isinf(radius) ? Infinity : radius * std::abs(Worlds[node].Scale) };
+		for (int child = FirstChildren[node]; child != NoParent; child = NextSiblings[child])
+			bound = Merge(bound, GroupBounds[child]);
+		GroupBounds[node] = bound;
+	}
+
+	std::vector<int> TransformHierarchy::GetDepthFirstOrder() const
+	{
+		std::vector<int> order{};
+		order.reserve(Parents.size());
+		for (int root = 0; root < static_cast<int>(Parents.size()); ++root)
+		{
+			if (Parents[root] != NoParent)
+				continue;
+
+			for (int node = root;;)
+			{
+				order.push_back(node);
+				if (FirstChildren[node] != NoParent)
+				{
+					node = FirstChildren[node];
+					continue;
+				}
+				while (node != root && NextSiblings[node] == NoParent)
+					node = Parents[node];
+				if (node == root)
+					break;
+				node = NextSiblings[node];
+			}
+		}
+		return order;
+	}
+
+	void ApplyWorldTransforms(const TransformHierarchy& hierarchy, const std::span<const int> objectNodes, const std::span<Object> objects)
+	{
+		for (size_t i = 0; i < objects.size() && i < objectNodes.size(); ++i)
+		{
+			const Transform& world = hierarchy.GetWorld(objectNodes[i]);
+			objects[i].Position = world.Position;
+			objects[i].Rotation = world.Rotation;
+			objects[i].Scale = Float3(world.Scale);
+		}
+	}
+
+	void BuildObjectGroups(const TransformHierarchy& hierarchy, const std::span<const int> objectNodes, Scene& scene)
+	{
+		scene.Groups.clear();
+		// Snippet ports have no bound
+		if (!scene.SDFLibrary.empty())
+			return;
+
+		// The objects in each node's subtree
+		struct Range
+		{
+			int First{ INT_MAX };
+			int Last{ -1 };
+			int Count{ 0 };
+			float StepScale{ Infinity };
+			bool Bounded{ true };
+		};
+		std::vector<Range> ranges(hierarchy.GetNodeCount());
+		for (size_t i = 0; i < scene.Objects.size() && i < objectNodes.size(); ++i)
+		{
+			const Object& object = scene.Objects[i];
+			const int node = objectNodes[i];
+			Range& range = ranges[node];
+			range.First = std::min(range.First, static_cast<int>(i));
+			range.Last = std::max(range.Last, static_cast<int>(i));
+			++range.Count;
+			range.StepScale = std::min(range.StepScale, object.StepScale);
+
+			// Skipping an object only leaves the distance as it was when its distance is no nearer, which an
+			// intersection or subtraction can't promise. The node's radius must bound it as ObjectCulling would.
+			const BoundingSphere& bound = hierarchy.GetGroupBound(node);
+			const float radius = GetSDFBoundingRadius(object.SDFType, object.Parameters) * object.Scale.x + GetRepetitionExtent(object.Repeat);
+			range.Bounded = range.Bounded && object.BoolOperator == 0 && object.Scale.x > 0.0f && object.StepScale > 0.0f && std::isfinite(radius) &&
+			                bound.Radius >= 0.0f && Distance(bound.Centre, object.Position) + radius <= bound.Radius * 1.001f;
+		}
+
+		const std::vector<int> order = hierarchy.GetDepthFirstOrder();
+		for (auto node = order.rbegin(); node != order.rend(); ++node)
+		{
+			const int parent = hierarchy.GetParent(*node);
+			if (parent == TransformHierarchy::NoParent)
+				continue;
+
+			const Range& child = ranges[*node];
+			Range& range = ranges[parent];
+			range.First = std::min(range.First, child.First);
+			range.Last = std::max(range.Last, child.Last);
+			range.Count += child.Count;
+			range.StepScale = std::min(range.StepScale, child.StepScale);
+			range.Bounded = range.Bounded && child.Bounded;
+		}
+
+		for (const int node : order)
+		{
+			const Range& range = ranges[node];
+			const BoundingSphere& bound = hierarchy.GetGroupBound(node);
+			if (range.Count < 2 || !range.Bounded || range.Last - range.First + 1 != range.Count || !std::isfinite(bound.Radius))
+				continue;
+
+			// A little slack, so rounding never skips a group a ray is about to hit
+			scene.Groups.push_back({ bound.Centre, bound.Radius * 1.001f, range.StepScale, range.First, range.Count });
+		}
+
+		std::ranges::stable_sort(scene.Groups, [](const ObjectGroup& a, const ObjectGroup& b)
+		{
+			return a.First != b.First ? a.First < b.First : a.Count > b.Count;
+		});
+	}
+}
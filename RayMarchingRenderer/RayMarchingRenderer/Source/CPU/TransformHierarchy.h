@@ -0,0 +1,108 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "CPU/SceneData.h"
+
+// Parent/child transforms for scene objects. Each node's transform is local to
+// its parent's, and the world transforms are cached: moving a node only marks
+// it dirty, and Update recomputes the dirty subtrees and nothing else. Every
+// node also keeps a bounding sphere of its subtree, refit from its children on
+// the way back up, so a ray marcher can skip a whole group that is further
+// away than the distance it already has (see Scene::Groups).
+namespace CPU
+{
+	// Position, Euler rotation as Rotate and InverseRotate take it, and uniform scale, as an Object's
+	struct Transform
+	{
+		Float3 Position{ 0.0f };
+		Float3 Rotation{ 0.0f };
+		float Scale{ 1.0f };
+	};
+
+	// local, given relative to parent, in parent's space
+	[[nodiscard]] Transform ComposeTransforms(const Transform& parent, const Transform& local);
+	// world relative to parent, so that ComposeTransforms(parent, GetRelativeTransform(parent, world)) is world
+	[[nodiscard]] Transform GetRelativeTransform(const Transform& parent, const Transform& world);
+
+	// Rotate as a matrix, its columns the rotated axes, so Rotate(p) is the matrix times p
+	struct RotationMatrix
+	{
+		Float3 Columns[3]{ Float3(1.0f, 0.0f, 0.0f), Float3(0.0f, 1.0f, 0.0f), Float3(0.0f, 0.0f, 1.0f) };
+	};
+
+	struct BoundingSphere
+	{
+		Float3 Centre{ 0.0f };
+		float Radius{ -1.0f }; // Below 0 bounds nothing, infinite bounds everything
+	};
+
+	class TransformHierarchy
+	{
+	public:
+		static constexpr int NoParent = -1;
+
+		// Adds a node under parent, which must already exist, after its other children. radius bounds the node's
+		// own content about its origin in its local space, scaled with it; below 0 for none, infinite when unbounded.
+		int AddNode(int parent, const Transform& local, float radius = -1.0f);
+		void SetLocal(int node, const Transform& local);
+		void SetRadius(int node, float radius);
+
+		// Recomputes the world transforms of every subtree under a node changed since the last update, then the
+		// bounds of those subtrees and of their ancestors
+		void Update();
+
+		[[nodiscard]] size_t GetNodeCount() const { return Parents.size(); }
+		[[nodiscard]] int GetParent(const int node) const { return Parents[node]; }
+		[[nodiscard]] const Transform& GetLocal(const int node) const { return Locals[node]; }
+		// As of the last Update
+		[[nodiscard]] const Transform& GetWorld(const int node) const { return Worlds[node]; }
+		[[nodiscard]] const BoundingSphere& GetGroupBound(const int node) const { return GroupBounds[node]; }
+
+		// Nodes whose world transform or bound the last Update recomputed
+		[[nodiscard]] size_t GetUpdatedNodeCount() const { return UpdatedTransforms; }
+		[[nodiscard]] size_t GetRefitNodeCount() const { return UpdatedBounds; }
+
+		// Every node, each before its children and each subtree contiguous, children in the order they were added
+		[[nodiscard]] std::vector<int> GetDepthFirstOrder() const;
+
+	private:
+		std::vector<int> Parents{};
+		std::vector<int> FirstChildren{};
+		std::vector<int> LastChildren{};
+		std::vector<int> NextSiblings{};
+		std::vector<int> Depths{};
+
+		std::vector<Transform> Locals{};
+		std::vector<RotationMatrix> LocalRotations{};
+		std::vector<Transform> Worlds{};
+		std::vector<RotationMatrix> WorldRotations{};
+		std::vector<float> Radii{};
+		std::vector<BoundingSphere> GroupBounds{};
+
+		// Nodes changed since the last update, and scratch space for it
+		std::vector<uint8_t> Dirty{};
+		std::vector<int> DirtyNodes{};
+		std::vector<uint8_t> Refit{};
+		std::vector<int> Subtree{};
+		std::vector<int> Ancestors{};
+
+		size_t UpdatedTransforms{ 0u };
+		size_t UpdatedBounds{ 0u };
+
+		void MarkDirty(int node);
+		void UpdateWorld(int node);
+		void RefitBound(int node);
+	};
+
+	// Sets the transforms of objects[i] to the world transform of node objectNodes[i]. Object::Scale is uniform, so
+	// every component takes the world scale.
+	void ApplyWorldTransforms(const TransformHierarchy& hierarchy, std::span<const int> objectNodes, std::span<Object> objects);
+
+	// Sets Scene::Groups from the group bounds of every node whose subtree holds two or more of scene's objects,
+	// scene.Objects[i] being at node objectNodes[i]. Only subtrees whose objects are next to each other in the scene,
+	// are all unioned with it and whose nodes' radii bound them (GetSDFBoundingRadius, and the repetition's extent
+	// over the scale) make a group. Objects must be at their nodes' world transforms.
+	void BuildObjectGroups(const TransformHierarchy& hierarchy, std::span<const int> objectNodes, Scene& scene);
+}
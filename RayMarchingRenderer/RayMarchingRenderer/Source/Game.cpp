@@ -1,6 +1,10 @@
 #include "pch.h"
 #include "Game.h"
 
+#include <chrono>
+#include <format>
+#include <string_view>
+
 #include "Game/Components/CameraComponent.h"
 #include "Game/Components/MaterialComponent.h"
 #include "Game/Components/MeshRendererComponent.h"
@@ -9,8 +13,12 @@
 #include "Game/Components/RayMarchObjectComponent.h"
 #include "Game/Components/SDFManagerComponent.h"
 #include "Game/Components/RayMarchLightComponent.h"
+#include "Game/SceneSerialisation.h"
+#include "Rendering/RenderPassCostView.h"
 #include "Rendering/RenderPassDefault.h"
 #include "Rendering/RenderPassReflections.h"
+#include "Rendering/RenderPassReflectionTrace.h"
+#include "Rendering/RenderTargetPool.h"
 
 extern void ExitGame() noexcept;
 
@@ -18,14 +26,48 @@ using namespace DirectX;
 
 using Microsoft::WRL::ComPtr;
 
+namespace
+{
+	// Render graph textures that can be shown in the viewport. Passes that don't contribute to the selected one are culled.
+	struct ViewportOutput
+	{
+		const char* Label;
+		const char* Texture;
+	};
+
+	constexpr ViewportOutput ViewportOutputs[] = {
+		{ "Final", "Reflections.Result" },
+		{ "G-Buffer Colour", "GBuffer.Colour" },
+		{ "Cost Heatmap", "Debug.CostHeatmap" }
+	};
+
+	// Stable colour per zone name, so a zone keeps its colour from frame to frame
+	ImU32 GetZoneColour(const char* name)
+	{
+		const size_t hash = std::hash<std::string_view>{}(name);
+		const float hue = static_cast<float>(hash % 1024u) / 1024.0f;
+		return ImColor::HSV(hue, 0.55f, 0.65f);
+	}
+}
+
 Game::Game() noexcept(false)
 {
 	DX::DeviceResources::Instance()->RegisterDeviceNotify(this);
 }
 
+Game::~Game()
+{
+	// Newest first, while the device their resources belong to is still up
+	for (auto go = GameObjects.rbegin(); go != GameObjects.rend(); ++go)
+		GameObject::Destroy(*go);
+	GameObjects.clear();
+}
+
 // Initialize the Direct3D resources required to run.
 void Game::Initialize(HWND window, int width, int height)
 {
+	CPU::SetProfilerThreadName("Main");
+
 	DX::DeviceResources::Instance()->SetWindow(window, width, height);
 
 	DX::DeviceResources::Instance()->CreateDeviceResources();
@@ -54,33 +96,40 @@ void Game::Initialize(HWND window, int width, int height)
 	ImGui_ImplWin32_Init(window);
 	ImGui_ImplDX11_Init(DX::DeviceResources::Instance()->GetD3DDevice(), DX::DeviceResources::Instance()->GetD3DDeviceContext());
 
-	// Create and Initialise render pipeline
-	RenderPipeline.push_back(std::make_unique<RenderPassDefault>(GameObjects));
-	RenderPipeline.push_back(std::make_unique<RenderPassReflections>(reinterpret_cast<RenderPassDefault*>(RenderPipeline[0].get())));
+	// Create and Initialise render pipeline. Execution order comes from the render graph, not this list.
+	auto gbufferPass = std::make_unique<RenderPassDefault>(GameObjects);
+	auto reflectionTrace = std::make_unique<RenderPassReflectionTrace>();
+	auto costView = std::make_unique<RenderPassCostView>(GameObjects, *gbufferPass, *reflectionTrace);
+	RenderPipeline.push_back(std::move(gbufferPass));
+	RenderPipeline.push_back(std::move(reflectionTrace));
+	RenderPipeline.push_back(std::make_unique<RenderPassReflections>());
+	RenderPipeline.push_back(std::move(costView));
 	for (const auto& rp : RenderPipeline)
 		rp->Initialise();
+	BuildRenderGraph();
 
 	// Create GameObjects
-	GameObjects.push_back(new GameObject("Ray March Manager"));
+	// Components update and render in the order they are added, so the scene is packed before the quad is drawn
+	GameObjects.push_back(GameObject::Create("Ray March Manager"));
 	const auto manager = GameObjects[0];
-	manager->AddComponent(new MeshRendererComponent());
-	manager->AddComponent(new RayMarchingManagerComponent(GameObjects));
-	manager->AddComponent(new SDFManagerComponent());
+	manager->AddComponent<RayMarchingManagerComponent>(GameObjects);
+	manager->AddComponent<SDFManagerComponent>();
+	manager->AddComponent<MeshRendererComponent>();
 
-	GameObjects.push_back(new GameObject("Camera"));
+	GameObjects.push_back(GameObject::Create("Camera"));
 	const auto cam = GameObjects[1];
-	cam->AddComponent(new CameraComponent());
+	cam->AddComponent<CameraComponent>();
 	TransformComponent* camTransf = cam->GetComponent<TransformComponent>();
 	camTransf->SetPosition(SimpleMath::Vector3(0.0f, 0.0f, 5.0f));
 
-	GameObjects.push_back(new GameObject("Sphere"));
+	GameObjects.push_back(GameObject::Create("Sphere"));
 	const auto rmObj = GameObjects[2];
-	rmObj->AddComponent(new RayMarchObjectComponent());
-	rmObj->AddComponent(new MaterialComponent());
+	rmObj->AddComponent<RayMarchObjectComponent>();
+	rmObj->AddComponent<MaterialComponent>();
 
-	GameObjects.push_back(new GameObject("Light"));
+	GameObjects.push_back(GameObject::Create("Light"));
 	const auto rmLight = GameObjects[3];
-	rmLight->AddComponent(new RayMarchLightComponent());
+	rmLight->AddComponent<RayMarchLightComponent>();
 	TransformComponent* lightTransf = rmLight->GetComponent<TransformComponent>();
 	lightTransf->SetPosition(SimpleMath::Vector3(1.0f, 2.0f, 4.0f));
 
@@ -93,6 +142,18 @@ void Game::Initialize(HWND window, int width, int height)
 // Executes the basic game loop.
 void Game::Tick()
 {
+	CPU::MarkProfilerFrame();
+
+	// Time between frames, including the wait on present
+	const uint64_t now = CPU::GetProfilerTime();
+	const CPU::RenderMetrics& metrics = CPU::GetRenderMetrics();
+	if (LastTickTime != 0u)
+		CPU::GetMetrics().Observe(metrics.FrameSeconds, static_cast<double>(now - LastTickTime) * 1e-9);
+	LastTickTime = now;
+	CPU::GetMetrics().Add(metrics.Frames);
+	CPU::GetMetrics().Set(metrics.RenderTargetBytes, static_cast<double>(RenderTargetPool::Instance()->GetAllocatedBytes()));
+	CPU::GetMetrics().Set(metrics.ResidentBytes, static_cast<double>(CPU::GetProcessResidentBytes()));
+
 	m_timer.Tick([&]() {
 		Update(m_timer);
 	});
@@ -103,6 +164,8 @@ void Game::Tick()
 // Updates the world.
 void Game::Update(DX::StepTimer const& timer)
 {
+	PROFILE_ZONE("Game::Update");
+
 	const float elapsedTime = static_cast<float>(timer.GetElapsedSeconds());
 
 	for (const auto& go : GameObjects)
@@ -120,6 +183,8 @@ void Game::Render()
 		return;
 	}
 
+	PROFILE_ZONE("Game::Render");
+
 	ImGui_ImplDX11_NewFrame();
 	ImGui_ImplWin32_NewFrame();
 	ImGui::NewFrame();
@@ -127,8 +192,10 @@ void Game::Render()
 	DX::DeviceResources::Instance()->PIXBeginEvent(L"Render");
 
 	// Render pipeline stages
-	for (const auto& rp : RenderPipeline)
-		rp->Render();
+	{
+		PROFILE_ZONE("Render Graph");
+		Graph.Execute();
+	}
 
 	ClearAndSetRenderTarget();
 
@@ -144,35 +211,61 @@ void Game::Render()
 		staticVpSize = curVpSize;
 		DX::DeviceResources::Instance()->SetViewportSize(curVpSize);
 
-		for (const auto& rp : RenderPipeline)
-			rp->Initialise();
+		// Only targets are refitted here, shaders are never recompiled on resize
+		BuildRenderGraph();
 	}
-	ImGui::Image(reinterpret_cast<RenderPassReflections*>(RenderPipeline[1].get())->GetSRV(),
-	             ImGui::GetContentRegionAvail());
+
+	// Targets are bucket sized, so only show the region that was rendered to
+	const RenderTarget& output = GraphTargets.Get(ViewportOutputs[ViewportOutputIndex].Texture);
+	const ImVec2 uvMax(static_cast<float>(curVpSize.right) / static_cast<float>(output.GetWidth()),
+	                   static_cast<float>(curVpSize.bottom) / static_cast<float>(output.GetHeight()));
+	ImGui::Image(output.GetSRV(), ImGui::GetContentRegionAvail(), ImVec2(0.0f, 0.0f), uvMax);
 	ImGui::End();
 	ImGui::PopStyleVar();
 
-	for (const auto& rp : RenderPipeline)
-		rp->RenderGUI();
+	{
+		PROFILE_ZONE("GUI");
+		for (const auto& rp : RenderPipeline)
+			rp->RenderGUI();
+
+		RenderGraphGUI();
+		SceneFileGUI();
+		ProfilerGUI();
+		MetricsGUI();
+	}
 
 	ImGui::Begin("Performance", (bool*)0, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_AlwaysAutoResize);
 	ImGui::Text("%.3fms (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+	const auto* pool = RenderTargetPool::Instance();
+	ImGui::Text("Render targets: %zu (%.1fMB), %llu allocations", pool->GetTargetCount(),
+	            static_cast<double>(pool->GetAllocatedBytes()) / (1024.0 * 1024.0),
+	            static_cast<unsigned long long>(pool->GetAllocationCount()));
 	ImGui::End();
 
+	// Settings changed through the GUI take effect next frame
+	if (std::any_of(RenderPipeline.begin(), RenderPipeline.end(), [](const auto& rp) { return rp->IsGraphDirty(); }))
+		BuildRenderGraph();
+
+	RenderTargetPool::Instance()->EndFrame();
+
 	// Render ImGui to backbuffer
-	ImGui::Render();
-	ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
-	ImGuiIO& io = ImGui::GetIO();
-	(void)io;
-	if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
 	{
-		ImGui::UpdatePlatformWindows();
-		ImGui::RenderPlatformWindowsDefault();
+		PROFILE_ZONE("ImGui Render");
+		ImGui::Render();
+		ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
+		ImGuiIO& io = ImGui::GetIO();
+		(void)io;
+		if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
+		{
+			ImGui::UpdatePlatformWindows();
+			ImGui::RenderPlatformWindowsDefault();
+		}
 	}
 
 	DX::DeviceResources::Instance()->PIXEndEvent();
 
 	// Show the new frame.
+	PROFILE_ZONE("Present");
 	DX::DeviceResources::Instance()->Present();
 }
 
@@ -196,6 +289,268 @@ void Game::ClearAndSetRenderTarget()
 
 	DX::DeviceResources::Instance()->PIXEndEvent();
 }
+
+void Game::BuildRenderGraph()
+{
+	Graph.Clear();
+	for (const auto& rp : RenderPipeline)
+	{
+		RenderPass* pass = rp.get();
+		Graph.AddPass(pass->GetName(),
+		              [pass](RenderGraphBuilder& builder) { pass->Setup(builder); },
+		              [this, pass]()
+		              {
+			              PROFILE_ZONE(pass->GetName());
+			              pass->Render(GraphTargets);
+		              });
+		pass->ClearGraphDirty();
+	}
+
+	Graph.MarkOutput(ViewportOutputs[ViewportOutputIndex].Texture);
+	// Keep the cost view alive while counters are on so its histograms update whatever is shown
+	if (RayMarchingManagerComponent::GetCostCountersEnabled())
+		Graph.MarkOutput("Debug.CostHeatmap");
+	Graph.Compile();
+	GraphTargets.Realise(Graph);
+}
+
+void Game::RenderGraphGUI()
+{
+	ImGui::Begin("Render Graph");
+
+	const char* outputLabels[std::size(ViewportOutputs)] = {};
+	for (size_t i = 0; i < std::size(ViewportOutputs); ++i)
+		outputLabels[i] = ViewportOutputs[i].Label;
+	if (ImGui::Combo("Viewport Output", &ViewportOutputIndex, outputLabels, static_cast<int>(std::size(outputLabels))))
+		BuildRenderGraph();
+
+	// Passes in execution order, followed by any that were culled
+	ImGui::Text("Passes");
+	for (const int pass : Graph.GetExecutionOrder())
+		ImGui::BulletText("%s", Graph.GetPasses()[pass].Name.c_str());
+	for (const auto& pass : Graph.GetPasses())
+		if (pass.Culled)
+			ImGui::BulletText("%s (culled)", pass.Name.c_str());
+
+	ImGui::Text("Textures");
+	if (ImGui::BeginTable("Textures", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+	{
+		ImGui::TableSetupColumn("Name");
+		ImGui::TableSetupColumn("Size");
+		ImGui::TableSetupColumn("Lifetime");
+		ImGui::TableSetupColumn("Slot");
+		ImGui::TableHeadersRow();
+
+		for (const auto& resource : Graph.GetResources())
+		{
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(resource.Name.c_str());
+			ImGui::TableNextColumn();
+			ImGui::Text("%ux%u", resource.Desc.Width, resource.Desc.Height);
+			ImGui::TableNextColumn();
+			if (resource.Physical < 0)
+				ImGui::Text("culled");
+			else if (resource.Output)
+				ImGui::Text("%d - output", resource.FirstUse);
+			else
+				ImGui::Text("%d - %d", resource.FirstUse, resource.LastUse);
+			ImGui::TableNextColumn();
+			if (resource.Physical >= 0)
+				ImGui::Text("%d", resource.Physical);
+		}
+
+		ImGui::EndTable();
+	}
+
+	ImGui::Text("%zu textures in %zu slots: %.1fMB (%.1fMB unaliased)",
+	            Graph.GetResources().size(), Graph.GetPhysicalDescs().size(),
+	            static_cast<double>(GraphTargets.GetAllocatedBytes()) / (1024.0 * 1024.0),
+	            static_cast<double>(GraphTargets.GetUnaliasedBytes()) / (1024.0 * 1024.0));
+
+	ImGui::End();
+}
+
+void Game::SceneFileGUI()
+{
+	ImGui::Begin("Scene File");
+
+	ImGui::InputText("Path", &SceneFilePath);
+	ImGui::SameLine();
+	if (ImGui::Button("..."))
+		ImGuiFileDialog::Instance()->OpenDialog("SelectScene", "Choose Scene", ".rmscene", ".");
+	if (ImGuiFileDialog::Instance()->Display("SelectScene"))
+	{
+		if (ImGuiFileDialog::Instance()->IsOk())
+			SceneFilePath = ImGuiFileDialog::Instance()->GetFilePathName();
+		ImGuiFileDialog::Instance()->Close();
+	}
+
+	try
+	{
+		if (ImGui::Button("Save"))
+		{
+			SceneSerialisation::Save(SceneFilePath, GameObjects);
+			SceneFileStatus = "Saved " + SceneFilePath;
+		}
+
+		ImGui::SameLine();
+		if (ImGui::Button("Load"))
+		{
+			const auto start = std::chrono::high_resolution_clock::now();
+			SceneSerialisation::Load(SceneFilePath, GameObjects);
+			const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+			SceneFileStatus = std::format("Loaded {} in {:.2f}ms", SceneFilePath, elapsed.count());
+		}
+	}
+	catch (const std::exception& e)
+	{
+		SceneFileStatus = e.what();
+	}
+
+	if (!SceneFileStatus.empty())
+		ImGui::TextWrapped("%s", SceneFileStatus.c_str());
+
+	ImGui::End();
+}
+
+void Game::ProfilerGUI()
+{
+	ImGui::Begin("Profiler");
+
+	bool enabled = CPU::IsProfilerEnabled();
+	if (ImGui::Checkbox("Enabled", &enabled))
+		CPU::SetProfilerEnabled(enabled);
+	ImGui::SameLine();
+	ImGui::Checkbox("Pause", &ProfilerPaused);
+
+	// Keep the last frame shown while paused so it can be inspected
+	uint64_t frameStart = 0u;
+	uint64_t frameEnd = 0u;
+	if (!ProfilerPaused && CPU::GetLastProfilerFrame(frameStart, frameEnd))
+	{
+		ProfilerFrame = CPU::CaptureProfile(frameStart, frameEnd);
+		ProfilerFrameStart = frameStart;
+		ProfilerFrameEnd = frameEnd;
+	}
+
+	ImGui::InputText("Trace Path", &ProfilerTracePath);
+	ImGui::SameLine();
+	if (ImGui::Button("Save Trace"))
+	{
+		try
+		{
+			// Everything still in the ring buffers, not just the frame shown
+			const auto threads = CPU::CaptureProfile();
+			CPU::WriteChromeTrace(ProfilerTracePath, threads);
+			size_t zones = 0u;
+			for (const auto& thread : threads)
+				zones += thread.Events.size();
+			ProfilerStatus = std::format("Saved {} zones to {}", zones, ProfilerTracePath);
+		}
+		catch (const std::exception& e)
+		{
+			ProfilerStatus = e.what();
+		}
+	}
+	if (!ProfilerStatus.empty())
+		ImGui::TextWrapped("%s", ProfilerStatus.c_str());
+
+	const double frameNs = static_cast<double>(std::max<uint64_t>(ProfilerFrameEnd - ProfilerFrameStart, 1u));
+	ImGui::Text("Frame: %.3fms", frameNs * 1e-6);
+
+	// Flame view: a lane per thread, a row per zone depth and time across
+	const float rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+	const float width = std::max(ImGui::GetContentRegionAvail().x, 1.0f);
+	const double scale = static_cast<double>(width) / frameNs;
+	ImDrawList* drawList = ImGui::GetWindowDrawList();
+	for (const auto& thread : ProfilerFrame)
+	{
+		if (thread.Events.empty())
+			continue;
+
+		uint32_t maxDepth = 0u;
+		for (const auto& event : thread.Events)
+			maxDepth = std::max(maxDepth, event.Depth);
+
+		ImGui::TextUnformatted(thread.Name.c_str());
+		const ImVec2 origin = ImGui::GetCursorScreenPos();
+		ImGui::InvisibleButton(thread.Name.c_str(), ImVec2(width, rowHeight * static_cast<float>(maxDepth + 1u)));
+		const bool hovered = ImGui::IsItemHovered();
+		const ImVec2 mouse = ImGui::GetIO().MousePos;
+
+		for (const auto& event : thread.Events)
+		{
+			// Zones that straddle the frame boundary are clipped to it
+			const uint64_t start = std::max(event.Start, ProfilerFrameStart) - ProfilerFrameStart;
+			const uint64_t end = std::min(event.End, ProfilerFrameEnd) - ProfilerFrameStart;
+			const ImVec2 topLeft(origin.x + static_cast<float>(static_cast<double>(start) * scale),
+			                     origin.y + rowHeight * static_cast<float>(event.Depth));
+			const ImVec2 bottomRight(std::max(origin.x + static_cast<float>(static_cast<double>(end) * scale), topLeft.x + 1.0f),
+			                         topLeft.y + rowHeight - 1.0f);
+
+			drawList->AddRectFilled(topLeft, bottomRight, GetZoneColour(event.Name));
+			drawList->PushClipRect(topLeft, bottomRight, true);
+			drawList->AddText(ImVec2(topLeft.x + 2.0f, topLeft.y + 2.0f), IM_COL32_WHITE, event.Name);
+			drawList->PopClipRect();
+
+			if (hovered && mouse.x >= topLeft.x && mouse.x < bottomRight.x && mouse.y >= topLeft.y && mouse.y < bottomRight.y)
+				ImGui::SetTooltip("%s\n%.3fms", event.Name, static_cast<double>(event.End - event.Start) * 1e-6);
+		}
+	}
+
+	ImGui::End();
+}
+
+void Game::MetricsGUI()
+{
+	ImGui::Begin("Metrics");
+
+	if (!MetricsExport)
+	{
+		std::string path = MetricsSettings.Path.string();
+		if (ImGui::InputText("File", &path))
+			MetricsSettings.Path = path;
+		int port = MetricsSettings.Port;
+		if (ImGui::InputInt("Port", &port))
+			MetricsSettings.Port = static_cast<uint16_t>(std::clamp(port, 0, 65535));
+		float interval = static_cast<float>(MetricsSettings.IntervalSeconds);
+		if (ImGui::DragFloat("Interval (s)", &interval, 0.1f, 0.1f, 600.0f))
+			MetricsSettings.IntervalSeconds = interval;
+
+		if (ImGui::Button("Start Export"))
+		{
+			try
+			{
+				MetricsExport = std::make_unique<CPU::MetricsExporter>(CPU::GetMetrics(), MetricsSettings);
+				MetricsStatus.clear();
+			}
+			catch (const std::exception& e)
+			{
+				MetricsStatus = e.what();
+			}
+		}
+	}
+	else
+	{
+		const CPU::MetricsExportSettings& settings = MetricsExport->GetSettings();
+		if (!settings.Path.empty())
+			ImGui::Text("File: %s every %.1fs", settings.Path.string().c_str(), settings.IntervalSeconds);
+		if (settings.Port != 0u)
+			ImGui::Text("Serving http://127.0.0.1:%u/metrics", static_cast<unsigned int>(settings.Port));
+		ImGui::Text("%llu publishes, %llu scrapes", static_cast<unsigned long long>(MetricsExport->GetPublishCount()),
+		            static_cast<unsigned long long>(MetricsExport->GetRequestCount()));
+
+		MetricsStatus = MetricsExport->GetLastError();
+		if (ImGui::Button("Stop Export"))
+			MetricsExport.reset();
+	}
+
+	if (!MetricsStatus.empty())
+		ImGui::TextWrapped("%s", MetricsStatus.c_str());
+
+	ImGui::End();
+}
 #pragma endregion
 
 #pragma region Message Handlers
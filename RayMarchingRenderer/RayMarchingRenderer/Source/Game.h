@@ -2,7 +2,11 @@
 
 #include "Utility/StepTimer.h"
 
+#include "CPU/Metrics.h"
+#include "CPU/Profiler.h"
 #include "Game/GameObject.h"
+#include "Rendering/RenderGraph.h"
+#include "Rendering/RenderGraphTargets.h"
 #include "Rendering/RenderPass.h"
 
 // A basic game implementation that creates a D3D11 device and
@@ -11,7 +15,7 @@ class Game final : public DX::IDeviceNotify
 {
 public:
 	Game() noexcept(false);
-	~Game() = default;
+	~Game();
 
 	Game(Game&&) = default;
 	Game& operator=(Game&&) = default;
@@ -46,6 +50,19 @@ private:
 
 	void ClearAndSetRenderTarget();
 
+	// Rebuilds the render graph from the pipeline's passes, then compiles and realises it
+	void BuildRenderGraph();
+	void RenderGraphGUI();
+
+	// Save and load of the scene to the binary scene format
+	void SceneFileGUI();
+
+	// Profiler switch, flame view of the last frame and trace export
+	void ProfilerGUI();
+
+	// Prometheus metrics export for long-running nodes
+	void MetricsGUI();
+
 	void CreateDeviceDependentResources();
 	void CreateWindowSizeDependentResources();
 
@@ -54,4 +71,23 @@ private:
 
 	std::vector<GameObject*> GameObjects{};
 	std::vector<std::shared_ptr<RenderPass>> RenderPipeline{};
+
+	RenderGraph Graph{};
+	RenderGraphTargets GraphTargets{};
+	int ViewportOutputIndex{ 0 };
+
+	std::string SceneFilePath{ "scene.rmscene" };
+	std::string SceneFileStatus{};
+
+	bool ProfilerPaused{ false };
+	uint64_t ProfilerFrameStart{ 0u };
+	uint64_t ProfilerFrameEnd{ 0u };
+	std::vector<CPU::ProfileThread> ProfilerFrame{};
+	std::string ProfilerTracePath{ "profile_trace.json" };
+	std::string ProfilerStatus{};
+
+	uint64_t LastTickTime{ 0u };
+	CPU::MetricsExportSettings MetricsSettings{ "raymarch.prom" };
+	std::unique_ptr<CPU::MetricsExporter> MetricsExport{};
+	std::string MetricsStatus{};
 };
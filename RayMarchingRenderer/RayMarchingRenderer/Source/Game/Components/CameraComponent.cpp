@@ -65,13 +65,18 @@ void CameraComponent::Render()
 
 	static CameraConstantBuffer ccb = {};
 	ccb.View = GetViewMatrix();
-	ccb.Position = Parent->GetComponent<TransformComponent>()->GetPosition();
+	ccb.Position = Parent->GetComponent<TransformComponent>()->GetWorldPosition();
 	ccb.FOV = FOV;
 	context->UpdateSubresource(ConstantBuffer.Get(), 0, nullptr, &ccb, 0, 0);
 
 	context->PSSetConstantBuffers(1, 1, ConstantBuffer.GetAddressOf());
 	context->PSSetShaderResources(0, 1, SkyboxSRV.GetAddressOf());
 	context->PSSetSamplers(0, 1, LinearSampler.GetAddressOf());
+
+	// Also used by compute passes that trace secondary rays
+	context->CSSetConstantBuffers(1, 1, ConstantBuffer.GetAddressOf());
+	context->CSSetShaderResources(0, 1, SkyboxSRV.GetAddressOf());
+	context->CSSetSamplers(0, 1, LinearSampler.GetAddressOf());
 }
 
 void CameraComponent::RenderGUI()
@@ -109,7 +114,8 @@ DirectX::SimpleMath::Matrix CameraComponent::GetViewMatrix() const
 
 	const TransformComponent* transform = Parent->GetComponent<TransformComponent>();
 
-	const DirectX::SimpleMath::Vector3 eye = transform->GetPosition();
+	// A parent carries the camera with it, but the rotation is its own, in degrees
+	const DirectX::SimpleMath::Vector3 eye = transform->GetWorldPosition();
 	const DirectX::SimpleMath::Vector3 dir = transform->GetRotation() * 0.01745329f;
 
 	// Pitch and Yaw
@@ -19,6 +19,10 @@ public:
 	[[nodiscard]] float GetMetalicness() const { return Metalicness; }
 	[[nodiscard]] float GetRoughness() const { return Roughness; }
 
+	void SetColour(const DirectX::SimpleMath::Vector3& colour) { Colour = colour; }
+	void SetMetalicness(float metalicness) { Metalicness = metalicness; }
+	void SetRoughness(float roughness) { Roughness = roughness; }
+
 protected:
 	[[nodiscard]] std::string GetComponentName() const override { return "Material"; }
 
@@ -21,6 +21,15 @@ public:
 	[[nodiscard]] float GetLinearAttenuation() const { return LinearAttenuation; }
 	[[nodiscard]] float GetQuadraticAttenuation() const { return QuadraticAttenuation; }
 
+	void SetColour(const DirectX::SimpleMath::Vector3& colour) { Colour = colour; }
+	void SetShadowSharpness(float shadowSharpness) { ShadowSharpness = shadowSharpness; }
+	void SetAttenuation(float constant, float linear, float quadratic)
+	{
+		ConstantAttenuation = constant;
+		LinearAttenuation = linear;
+		QuadraticAttenuation = quadratic;
+	}
+
 protected:
 	[[nodiscard]] std::string GetComponentName() const override { return "Ray March Light"; }
 
@@ -8,6 +8,45 @@ void RayMarchObjectComponent::RenderGUI()
 
 	ImGui::DragFloat3("Parameters", &Parameters.x, 0.005f);
 
-	const char* csgOptions[3] = { "Add", "Intersect", "Subtract" };
-	ImGui::Combo("Bool Operation", &BoolOperator, csgOptions, 3);
+	const char* csgOptions[6] = { "Add", "Intersect", "Subtract", "Smooth Add", "Smooth Intersect", "Smooth Subtract" };
+	ImGui::Combo("Bool Operation", &BoolOperator, csgOptions, 6);
+	if (BoolOperator >= 3)
+	{
+		ImGui::DragFloat("Blend Radius", &BlendRadius, 0.005f, 0.001f, 100.0f);
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Only where both distances are within this of each other is blended.");
+	}
+
+	const char* repetitionOptions[4] = { "None", "Grid", "Radial", "Mirror" };
+	ImGui::Combo("Repetition", &RepetitionMode, repetitionOptions, 4);
+	switch (RepetitionMode)
+	{
+	case 1:
+		ImGui::DragFloat3("Cell Size", &RepetitionSpacing.x, 0.01f, 0.0f, 1000.0f);
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("0 leaves an axis unrepeated. Copies are only exact while they fit inside their cells.");
+		ImGui::DragFloat3("Copies Either Side", &RepetitionLimit.x, 0.1f, 0.0f, 10000.0f, "%.0f");
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("0 repeats forever along the axis.");
+		break;
+	case 2:
+		ImGui::DragFloat("Ring Radius", &RepetitionSpacing.x, 0.01f, 0.0f, 1000.0f);
+		ImGui::DragFloat("Copies", &RepetitionLimit.x, 0.1f, 1.0f, 1000.0f, "%.0f");
+		break;
+	case 3:
+	{
+		bool axes[3] = { RepetitionLimit.x != 0.0f, RepetitionLimit.y != 0.0f, RepetitionLimit.z != 0.0f };
+		ImGui::Checkbox("Mirror X", &axes[0]);
+		ImGui::SameLine();
+		ImGui::Checkbox("Y", &axes[1]);
+		ImGui::SameLine();
+		ImGui::Checkbox("Z", &axes[2]);
+		RepetitionLimit = DirectX::SimpleMath::Vector3(axes[0] ? 1.0f : 0.0f, axes[1] ? 1.0f : 0.0f, axes[2] ? 1.0f : 0.0f);
+		ImGui::DragFloat3("Offset", &RepetitionSpacing.x, 0.01f);
+		break;
+	}
+	default: break;
+	}
+	if (RepetitionMode != 0)
+		ImGui::SliderFloat("Variation", &RepetitionVariation, 0.0f, 0.9f);
 }
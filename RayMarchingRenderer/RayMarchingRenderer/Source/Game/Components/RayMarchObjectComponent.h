@@ -16,14 +16,39 @@ public:
 	void RenderGUI() override;
 
 	[[nodiscard]] int GetBoolOperator() const { return BoolOperator; }
+	// Largest difference between distances the smooth operators blend
+	[[nodiscard]] float GetBlendRadius() const { return BlendRadius; }
 	[[nodiscard]] int GetSDFType() const { return SDFType; }
 	[[nodiscard]] DirectX::SimpleMath::Vector3 GetParameters() const { return Parameters; }
+	// Copies of the object one evaluation covers, as CPU::Repetition
+	[[nodiscard]] int GetRepetitionMode() const { return RepetitionMode; }
+	[[nodiscard]] DirectX::SimpleMath::Vector3 GetRepetitionSpacing() const { return RepetitionSpacing; }
+	[[nodiscard]] DirectX::SimpleMath::Vector3 GetRepetitionLimit() const { return RepetitionLimit; }
+	[[nodiscard]] float GetRepetitionVariation() const { return RepetitionVariation; }
+
+	void SetBoolOperator(int boolOperator) { BoolOperator = boolOperator; }
+	void SetBlendRadius(float blendRadius) { BlendRadius = blendRadius; }
+	void SetSDFType(int sdfType) { SDFType = sdfType; }
+	void SetParameters(const DirectX::SimpleMath::Vector3& parameters) { Parameters = parameters; }
+	void SetRepetition(int mode, const DirectX::SimpleMath::Vector3& spacing, const DirectX::SimpleMath::Vector3& limit, float variation)
+	{
+		RepetitionMode = mode;
+		RepetitionSpacing = spacing;
+		RepetitionLimit = limit;
+		RepetitionVariation = variation;
+	}
 
 protected:
 	[[nodiscard]] std::string GetComponentName() const override { return "Ray March Object"; }
 
 private:
 	int BoolOperator{ 0 };
+	float BlendRadius{ 0.25f };
 	int SDFType{ 0 };
 	DirectX::SimpleMath::Vector3 Parameters{ DirectX::SimpleMath::Vector3::One };
+
+	int RepetitionMode{ 0 };
+	DirectX::SimpleMath::Vector3 RepetitionSpacing{ DirectX::SimpleMath::Vector3::Zero };
+	DirectX::SimpleMath::Vector3 RepetitionLimit{ DirectX::SimpleMath::Vector3::Zero };
+	float RepetitionVariation{ 0.0f };
 };
@@ -41,43 +41,65 @@ void RayMarchingManagerComponent::CreateConstantBuffers()
 
 void RayMarchingManagerComponent::Update(float deltaTime)
 {
+	PROFILE_ZONE("Scene Code Generation");
+
 	// Generate scene distance shader
 	const auto rmObjects = GameObject::FindComponents<RayMarchObjectComponent>(GameObjects);
 
 	const auto sdfManager = Parent->GetComponent<SDFManagerComponent>();
 
-	// Construct string of signed distance functions being used and total boolean operator values
+	// Construct string of signed distance functions being used, each object's boolean operator and which objects repeat
 	std::string sdfs;
-	int boolOpsTotal = 0;
+	std::string boolOpsLayout;
+	std::string repetitionLayout;
 	for (const auto& obj : rmObjects)
 	{
-		const std::string objSdf = sdfManager->GenerateSignedDistanceFunction(obj->GetSDFType());
+		const std::string objSdf = sdfManager->GenerateSignedDistanceFunction(obj->GetSDFType()) + sdfManager->GenerateGradientFunction(obj->GetSDFType());
 		if (!sdfs.contains(objSdf))
 			sdfs += objSdf;
 
-		boolOpsTotal += obj->GetBoolOperator();
+		boolOpsLayout += std::to_string(obj->GetBoolOperator());
+		repetitionLayout += obj->GetRepetitionMode() != 0 ? "r" : "-";
 	};
 
+	sdfManager->UpdateSnippetCosts(rmObjects, deltaTime);
+
+	// Objects rays intersect in closed form rather than march, by primitive type
+	std::vector<int> analyticTypes(rmObjects.size(), -1);
+	if (AnalyticPrimitivesEnabled)
+		analyticTypes = sdfManager->FindAnalyticObjects(rmObjects);
+	std::string analyticLayout;
+	for (const int type : analyticTypes)
+		analyticLayout += std::to_string(type) + ",";
+
 	// Use hash to prevent unnecessary shader changes
 	static constexpr std::hash<std::string> hash;
 	static size_t prevSdfHash = hash("");
-	const size_t curSdfHash = hash(sdfs + std::to_string(rmObjects.size()) + std::to_string(boolOpsTotal));
+	const size_t curSdfHash = hash(sdfs + std::to_string(rmObjects.size()) + boolOpsLayout + (CostCountersEnabled ? "c" : "") + analyticLayout + repetitionLayout);
 	if (curSdfHash != prevSdfHash)
 	{
 		prevSdfHash = curSdfHash;
 
 		sdfManager->WriteStringToHeaderShader(sdfs);
-		sdfManager->WriteSceneDistanceFunctionToShaderHeader(sdfManager->GenerateSceneDistanceFunctionContents(rmObjects));
+		sdfManager->WriteSceneDistanceFunctionToShaderHeader(sdfManager->GenerateSceneDistanceFunctionContents(rmObjects),
+		                                                     sdfManager->GenerateSceneDistanceFunctionContents(rmObjects, &analyticTypes),
+		                                                     sdfManager->GenerateAnalyticIntersectionContents(analyticTypes),
+		                                                     sdfManager->GenerateObjectGradientContents(rmObjects),
+		                                                     sdfManager->GenerateSceneGradientContents(rmObjects));
 
 		// Recompile pixel shader
 		const auto meshRenderer = Parent->GetComponent<MeshRendererComponent>();
 		const auto shader = meshRenderer->GetShader();
-		shader->CreatePixelShader();
+		shader->CreatePixelShader(GetSceneShaderDefines());
+
+		++SceneShaderRevision;
 	}
 }
 
 void RayMarchingManagerComponent::Render()
 {
+	PROFILE_ZONE("Scene Packing");
+
 	const auto context = DX::DeviceResources::Instance()->GetD3DDeviceContext();
 
 	// Update RenderSettings constant buffer
@@ -86,9 +108,11 @@ void RayMarchingManagerComponent::Render()
 	RenderSettingsData.Resolution[1] = viewportSize.bottom;
 	context->UpdateSubresource(RenderSettingsConstantBuffer.Get(), 0, nullptr, &RenderSettingsData, 0, 0);
 	context->PSSetConstantBuffers(0, 1, RenderSettingsConstantBuffer.GetAddressOf());
+	context->CSSetConstantBuffers(0, 1, RenderSettingsConstantBuffer.GetAddressOf());
 
 	// Update R.M. Scene data constant buffer
 	const auto rmObjects = GameObject::FindComponents<RayMarchObjectComponent>(GameObjects);
+	const auto sdfManager = Parent->GetComponent<SDFManagerComponent>();
 	for (int i = 0; i < RAYMARCH_MAX_OBJECTS; ++i)
 	{
 		// Populate GPU cbuffer with object data
@@ -96,27 +120,36 @@ void RayMarchingManagerComponent::Render()
 		{
 			const auto transform = rmObjects[i]->Parent->GetComponent<TransformComponent>();
 
-			RayMarchSceneData.ObjectsList[i].Position = transform->GetPosition();
-			RayMarchSceneData.ObjectsList[i].Rotation = transform->GetRotation();
-			RayMarchSceneData.ObjectsList[i].Scale = transform->GetScale();
+			RayMarchSceneData.ObjectsList[i].Position = transform->GetWorldPosition();
+			RayMarchSceneData.ObjectsList[i].Rotation = transform->GetWorldRotation();
+			RayMarchSceneData.ObjectsList[i].Scale = transform->GetWorldScale();
 
 			RayMarchSceneData.ObjectsList[i].Parameters = rmObjects[i]->GetParameters();
 			RayMarchSceneData.ObjectsList[i].SDFType = rmObjects[i]->GetSDFType();
 			RayMarchSceneData.ObjectsList[i].BoolOperator = rmObjects[i]->GetBoolOperator();
+			RayMarchSceneData.ObjectsList[i].BlendRadius = rmObjects[i]->GetBlendRadius();
+			RayMarchSceneData.ObjectsList[i].StepScale = sdfManager->GetStepScale(*rmObjects[i]);
 
 			const auto material = rmObjects[i]->Parent->GetComponent<MaterialComponent>();
 			RayMarchSceneData.ObjectsList[i].Colour = material->GetColour();
 			RayMarchSceneData.ObjectsList[i].Metalicness = material->GetMetalicness();
 			RayMarchSceneData.ObjectsList[i].Roughness = material->GetRoughness();
+
+			RayMarchSceneData.RepetitionsList[i].Mode = rmObjects[i]->GetRepetitionMode();
+			RayMarchSceneData.RepetitionsList[i].Spacing = rmObjects[i]->GetRepetitionSpacing();
+			RayMarchSceneData.RepetitionsList[i].Limit = rmObjects[i]->GetRepetitionLimit();
+			RayMarchSceneData.RepetitionsList[i].Variation = rmObjects[i]->GetRepetitionVariation();
 		}
 		else
 		{
 			// Clear if object data not in use
 			RayMarchSceneData.ObjectsList[i] = {};
+			RayMarchSceneData.RepetitionsList[i] = {};
 		}
 	}
 	context->UpdateSubresource(RayMarchSceneConstantBuffer.Get(), 0, nullptr, &RayMarchSceneData, 0, 0);
 	context->PSSetConstantBuffers(2, 1, RayMarchSceneConstantBuffer.GetAddressOf());
+	context->CSSetConstantBuffers(2, 1, RayMarchSceneConstantBuffer.GetAddressOf());
 
 	// Update R.M. Lights data constant buffer
 	const auto rmLights = GameObject::FindComponents<RayMarchLightComponent>(GameObjects);
@@ -126,7 +159,7 @@ void RayMarchingManagerComponent::Render()
 		{
 			const auto transform = rmLights[i]->Parent->GetComponent<TransformComponent>();
 
-			RayMarchLightData.LightsList[i].Position = transform->GetPosition();
+			RayMarchLightData.LightsList[i].Position = transform->GetWorldPosition();
 			RayMarchLightData.LightsList[i].Colour = rmLights[i]->GetColour();
 			RayMarchLightData.LightsList[i].ShadowSharpness = rmLights[i]->GetShadowSharpness();
 			RayMarchLightData.LightsList[i].ConstantAttenuation = rmLights[i]->GetConstantAttenuation();
@@ -140,6 +173,36 @@ void RayMarchingManagerComponent::Render()
 	}
 	context->UpdateSubresource(RayMarchLightConstantBuffer.Get(), 0, nullptr, &RayMarchLightData, 0, 0);
 	context->PSSetConstantBuffers(3, 1, RayMarchLightConstantBuffer.GetAddressOf());
+	context->CSSetConstantBuffers(3, 1, RayMarchLightConstantBuffer.GetAddressOf());
+
+	const CPU::RenderMetrics& metrics = CPU::GetRenderMetrics();
+	CPU::GetMetrics().Set(metrics.SceneObjects, static_cast<double>(rmObjects.size()));
+	CPU::GetMetrics().Set(metrics.SceneLights, static_cast<double>(rmLights.size()));
+}
+
+const D3D_SHADER_MACRO* RayMarchingManagerComponent::GetSceneShaderDefines()
+{
+	static constexpr D3D_SHADER_MACRO costCounterDefines[] = { { "RAYMARCH_COST_COUNTERS", "1" }, { nullptr, nullptr } };
+	static constexpr D3D_SHADER_MACRO noDefines[] = { { nullptr, nullptr } };
+	return CostCountersEnabled ? costCounterDefines : noDefines;
+}
+
+CPU::PackedRenderSettings RayMarchingManagerComponent::GetSceneRenderSettings() const
+{
+	CPU::PackedRenderSettings settings{};
+	settings.MaxSteps = RenderSettingsData.MaxSteps;
+	settings.MaxDist = RenderSettingsData.MaxDist;
+	settings.IntersectionThreshold = RenderSettingsData.IntersectionThreshold;
+	settings.AmbientOcclusionStrength = RenderSettingsData.AmbientOcclusionStrength;
+	return settings;
+}
+
+void RayMarchingManagerComponent::SetSceneRenderSettings(const CPU::PackedRenderSettings& settings)
+{
+	RenderSettingsData.MaxSteps = settings.MaxSteps;
+	RenderSettingsData.MaxDist = settings.MaxDist;
+	RenderSettingsData.IntersectionThreshold = settings.IntersectionThreshold;
+	RenderSettingsData.AmbientOcclusionStrength = settings.AmbientOcclusionStrength;
 }
 
 void RayMarchingManagerComponent::RenderGUI()
@@ -147,5 +210,19 @@ void RayMarchingManagerComponent::RenderGUI()
 	ImGui::DragInt("Max Steps", reinterpret_cast<int*>(&RenderSettingsData.MaxSteps), 1.0f, 1, 1000);
 	ImGui::DragFloat("Max Dist", &RenderSettingsData.MaxDist, .5f, 1.0f, 10000.0f);
 	ImGui::DragFloat("Threshold", &RenderSettingsData.IntersectionThreshold, 0.0001f, 0.0001f, 0.3f);
+	ImGui::DragFloat("Cone Threshold", &RenderSettingsData.ConeThresholdScale, 0.01f, 0.0f, 8.0f);
+	if (ImGui::IsItemHovered())
+		ImGui::SetTooltip("Hit threshold as a multiple of the pixel cone radius at the ray's depth. 0 uses Threshold everywhere.");
+	ImGui::DragFloat("Secondary Cone Threshold", &RenderSettingsData.SecondaryConeThresholdScale, 0.01f, 0.0f, 32.0f);
+	if (ImGui::IsItemHovered())
+		ImGui::SetTooltip("Cone Threshold for shadow and reflection rays, usually a few times coarser. 0 uses Threshold everywhere.");
+	if (RenderSettingsData.ConeThresholdScale > 0.0f || RenderSettingsData.SecondaryConeThresholdScale > 0.0f)
+		ImGui::DragFloatRange2("Threshold Clamp", &RenderSettingsData.MinThreshold, &RenderSettingsData.MaxThreshold, 0.0001f, 0.0001f, 1.0f, "%.4f");
 	ImGui::DragFloat("AO Strength", &RenderSettingsData.AmbientOcclusionStrength, 0.001f, 0.005f, 10.0f);
+	ImGui::Checkbox("Analytic Primitives", &AnalyticPrimitivesEnabled);
+	if (ImGui::IsItemHovered())
+		ImGui::SetTooltip("Intersect built-in primitives that are only unioned with the scene exactly instead of marching them.\nAmbient occlusion comes from the step count, so their shading changes.");
+	ImGui::DragFloat("Fractal LOD", &RenderSettingsData.FootprintScale, 0.01f, 0.0f, 4.0f);
+	if (ImGui::IsItemHovered())
+		ImGui::SetTooltip("Multiplies the pixel footprint below which fractal SDFs skip detail. 0 evaluates every iteration.");
 }
@@ -1,10 +1,14 @@
 #pragma once
 #include "Game/GameObject.h"
 #include "Game/Components/RayMarchObjectComponent.h"
+#include "CPU/GBuffer.h"
+#include "CPU/SceneFile.h"
 
 #define RAYMARCH_MAX_OBJECTS 30
 #define RAYMARCH_MAX_LIGHTS 10
 
+static_assert(RAYMARCH_MAX_OBJECTS - 1 <= CPU::MaxEncodedObjectIndex, "Object indices must fit the G-buffer's 8 bit material channel");
+
 class RayMarchingManagerComponent : public Component
 {
 	struct RenderSettings
@@ -14,8 +18,13 @@ class RayMarchingManagerComponent : public Component
 		float MaxDist{ 500.0f };
 		float IntersectionThreshold{ 0.01f };
 		float AmbientOcclusionStrength{ 3.0f };
+		float FootprintScale{ 1.0f };
+		float ConeThresholdScale{ 0.0f };
+		float SecondaryConeThresholdScale{ 0.0f };
+		float MinThreshold{ 0.0005f };
+		float MaxThreshold{ 0.25f };
 
-		float PADDING[2]{};
+		float PADDING{};
 	};
 
 	struct RayMarchScene
@@ -36,8 +45,17 @@ class RayMarchingManagerComponent : public Component
 			float Metalicness{ 0.0f };
 			float Roughness{ 0.0f };
 
-			float PADDING[2]{};
+			float StepScale{ 1.0f };
+			float BlendRadius{ 0.0f };
 		} ObjectsList[RAYMARCH_MAX_OBJECTS];
+
+		struct Repetition
+		{
+			DirectX::SimpleMath::Vector3 Spacing{ DirectX::SimpleMath::Vector3::Zero };
+			unsigned int Mode{ 0u };
+			DirectX::SimpleMath::Vector3 Limit{ DirectX::SimpleMath::Vector3::Zero };
+			float Variation{ 0.0f };
+		} RepetitionsList[RAYMARCH_MAX_OBJECTS];
 	};
 
 	struct RayMarchLights
@@ -57,6 +75,11 @@ class RayMarchingManagerComponent : public Component
 		} LightsList[RAYMARCH_MAX_LIGHTS];
 	};
 
+	// Scene files store these records as is
+	static_assert(sizeof(RayMarchScene::Object) == sizeof(CPU::PackedObject));
+	static_assert(sizeof(RayMarchScene::Repetition) == sizeof(CPU::PackedRepetition));
+	static_assert(sizeof(RayMarchLights::Light) == sizeof(CPU::PackedLight));
+
 public:
 	RayMarchingManagerComponent(const std::vector<GameObject*>& gameObjects);
 	RayMarchingManagerComponent(const RayMarchingManagerComponent&) = default;
@@ -69,6 +92,21 @@ public:
 	void Render() override;
 	void RenderGUI() override;
 
+	// Incremented whenever the generated scene distance header is rewritten, so passes
+	// with their own shaders including it know to recompile
+	[[nodiscard]] static unsigned int GetSceneShaderRevision() { return SceneShaderRevision; }
+
+	// Per-pixel cost counters (CostCounters.hlsli), compiled into the scene shaders on the next update when enabled.
+	// Passes that write counters check this in Setup, so the render graph must be rebuilt after a change.
+	[[nodiscard]] static bool GetCostCountersEnabled() { return CostCountersEnabled; }
+	static void SetCostCountersEnabled(bool enabled) { CostCountersEnabled = enabled; }
+	// Null terminated macros for shaders that include the generated scene distance function
+	[[nodiscard]] static const D3D_SHADER_MACRO* GetSceneShaderDefines();
+
+	// Render settings saved with a scene; the resolution follows the viewport
+	[[nodiscard]] CPU::PackedRenderSettings GetSceneRenderSettings() const;
+	void SetSceneRenderSettings(const CPU::PackedRenderSettings& settings);
+
 protected:
 	[[nodiscard]] std::string GetComponentName() const override { return "Ray Marching Manager"; }
 
@@ -83,4 +121,8 @@ private:
 	Microsoft::WRL::ComPtr<ID3D11Buffer> RayMarchLightConstantBuffer;
 
 	const std::vector<GameObject*>& GameObjects;
+	bool AnalyticPrimitivesEnabled{ false };
+
+	static inline unsigned int SceneShaderRevision{ 0u };
+	static inline bool CostCountersEnabled{ false };
 };
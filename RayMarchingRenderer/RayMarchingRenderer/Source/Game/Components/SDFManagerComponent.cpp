@@ -3,6 +3,7 @@
 
 #include <fstream>
 
+#include "CPU/SignedDistance.h"
 
 void SDFManagerComponent::RenderGUI()
 {
@@ -17,12 +18,35 @@ void SDFManagerComponent::RenderGUI()
 		ImGui::PushID(i);
 
 		ImGui::InputText("##", &SDFFuncContents[i].first);
-		ImGui::Text(("float sdf" + SDFFuncContents[i].first + "(float3 p, float3 param) {").c_str());
+		ImGui::Text(("float sdf" + SDFFuncContents[i].first + "(float3 p, float3 param, float footprint) {").c_str());
 		ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x);
 		ImGui::InputTextMultiline("###", &SDFFuncContents[i].second);
 		ImGui::PopItemWidth();
 		ImGui::Text("}");
 
+		// Measured cost, from the background benchmark
+		const uint64_t hash = CPU::HashSnippet(SDFFuncContents[i].first, SDFFuncContents[i].second);
+		if (const CPU::SnippetCost* cost = Benchmark ? Benchmark->FindCost(hash, GetDisplayParameters(i)) : nullptr)
+		{
+			const float stepScale = CPU::GetSnippetStepScale(cost->Lipschitz);
+			const ImVec4 colour = stepScale < 1.0f ? ImVec4(1.0f, 0.6f, 0.2f, 1.0f) : ImGui::GetStyleColorVec4(ImGuiCol_Text);
+			ImGui::TextColored(colour, "%.1fM evaluations/s, Lipschitz %.2f", static_cast<double>(cost->EvaluationsPerSecond) * 1e-6,
+			                   static_cast<double>(cost->Lipschitz));
+			if (ImGui::IsItemHovered())
+				ImGui::SetTooltip("Measured on the GPU with param (%.2f, %.2f, %.2f), steepest slope %.2f%s%.2f", cost->Parameters.x, cost->Parameters.y,
+				                  cost->Parameters.z, static_cast<double>(cost->MaxSlope),
+				                  stepScale < 1.0f ? "\nOverestimates distance, so rays step through it at a scale of " : "\nStep scale ",
+				                  static_cast<double>(stepScale));
+		}
+		else if (const std::string* error = Benchmark ? Benchmark->FindError(hash) : nullptr)
+		{
+			ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "Doesn't compile");
+			if (ImGui::IsItemHovered())
+				ImGui::SetTooltip("%s", error->c_str());
+		}
+		else
+			ImGui::TextDisabled("Measuring...");
+
 		ImGui::PopID();
 
 		ImGui::Separator();
@@ -36,26 +60,65 @@ void SDFManagerComponent::RenderGUI()
 
 std::string SDFManagerComponent::GenerateSignedDistanceFunction(int objectType) const
 {
-	std::string function = "float sdf" + SDFFuncContents[objectType % SDFFuncContents.size()].first + "(float3 p, float3 param){\n\t";
+	std::string function = "float sdf" + SDFFuncContents[objectType % SDFFuncContents.size()].first + "(float3 p, float3 param, float footprint){\n\t";
 	function += SDFFuncContents[objectType % SDFFuncContents.size()].second;
 	function += "\n}\n\n";
 
 	return function;
 }
 
-std::string SDFManagerComponent::GenerateSceneDistanceFunctionContents(const std::vector<RayMarchObjectComponent*>& raymarchObjects) const
+std::string SDFManagerComponent::GenerateGradientFunction(int objectType) const
+{
+	const std::string& name = SDFFuncContents[objectType % SDFFuncContents.size()].first;
+	std::string function = "float3 gradSdf" + name + "(float3 p, float3 param, float footprint, float offset){\n\t";
+	if (const int primitiveType = GetPrimitiveType(objectType); primitiveType >= 0)
+		function += "return Gradient" + PrimitiveSnippets[primitiveType].first + "(p, param);";
+	else
+	{
+		// Central differences, as CPU::SignedDistanceGradient takes for the types without an exact gradient
+		const auto tap = [&name](const std::string& sign, const std::string& axis)
+		{
+			return "sdf" + name + "(p " + sign + " k." + axis + ", param, footprint)";
+		};
+		function += "const float2 k = float2(offset, 0.0f);\n\treturn float3(";
+		const std::string axes[3] = { "xyy", "yxy", "yyx" };
+		for (int i = 0; i < 3; i++)
+			function += std::string(i > 0 ? ",\n\t              " : "") + tap("+", axes[i]) + " - " + tap("-", axes[i]);
+		function += ") / (2.0f * offset);";
+	}
+	function += "\n}\n\n";
+
+	return function;
+}
+
+std::string SDFManagerComponent::GenerateSceneDistanceFunctionContents(const std::vector<RayMarchObjectComponent*>& raymarchObjects,
+                                                                      const std::vector<int>* analyticTypes) const
 {
-	const std::string boolOperators[3] = { "min", "max", "max" };
+	// Smooth operators also take the object's blend radius, see SmoothUnion in SceneDistanceTemplate.hlsli
+	const std::string boolOperators[6] = { "min", "max", "max", "SmoothUnion", "SmoothIntersection", "SmoothIntersection" };
+	const auto combine = [&](const RayMarchObjectComponent* obj, const std::string& index, const std::string& objectDist)
+	{
+		const int boolOperator = obj->GetBoolOperator() % static_cast<int>(std::size(boolOperators));
+		const std::string blendRadius = boolOperator >= 3 ? ", ObjectsList[" + index + "].BlendRadius" : "";
+		return "\tdist = " + boolOperators[boolOperator] + "(dist, " + (CPU::IsSubtractOperator(boolOperator) ? "-" : "") + objectDist + blendRadius + ");\n";
+	};
 
 	std::string objectsDistanceCheck;
 	for (int i = 0; i < raymarchObjects.size(); i++)
 	{
 		const RayMarchObjectComponent* obj = raymarchObjects[i];
 
+		// Skipped objects still take an index, so hits keep pointing into ObjectsList
+		if (analyticTypes && (*analyticTypes)[i] >= 0)
+		{
+			objectsDistanceCheck += "\t++curIndex;\n\n";
+			continue;
+		}
+
 		std::string index = std::to_string(i);
 		// Distance calculation
-		objectsDistanceCheck += "\tdist = " + boolOperators[obj->GetBoolOperator()] + "(dist, " + (obj->GetBoolOperator() == 2 ? "-" : "") + "sdf" + SDFFuncContents[obj->GetSDFType() % SDFFuncContents.size()].first;
-		objectsDistanceCheck += +"(Rotate(Translate(p, ObjectsList[" + index + "].Position), ObjectsList[" + index + "].Rotation) / ObjectsList[" + index + "].Scale.x, ObjectsList[" + index + "].Parameters) * ObjectsList[" + index + "].Scale.x);\n";
+		objectsDistanceCheck += GenerateObjectDistance(obj, index);
+		objectsDistanceCheck += combine(obj, index, "objectDist" + index);
 
 		// Index calculation
 		objectsDistanceCheck += "\tindex = lerp(index, curIndex, prevDist != dist);\n";
@@ -66,6 +129,215 @@ std::string SDFManagerComponent::GenerateSceneDistanceFunctionContents(const std
 	return objectsDistanceCheck;
 }
 
+std::string SDFManagerComponent::GenerateObjectDistance(const RayMarchObjectComponent* obj, const std::string& index) const
+{
+	const std::string& name = SDFFuncContents[obj->GetSDFType() % SDFFuncContents.size()].first;
+	const std::string objectDist = "objectDist" + index;
+
+	// Every copy in one evaluation, see REPEATED_DISTANCE in SceneDistanceTemplate.hlsli
+	if (obj->GetRepetitionMode() != 0)
+		return "\tfloat " + objectDist + ";\n\tREPEATED_DISTANCE(" + name + ", " + index + ", " + objectDist + ");\n";
+
+	return "\tconst float " + objectDist + " = sdf" + name + "(Rotate(Translate(p, ObjectsList[" + index + "].Position), ObjectsList[" + index + "].Rotation) / ObjectsList[" + index + "].Scale.x, ObjectsList[" + index + "].Parameters, footprint / ObjectsList[" + index + "].Scale.x) * ObjectsList[" + index + "].Scale.x * ObjectsList[" + index + "].StepScale;\n";
+}
+
+std::string SDFManagerComponent::GenerateAnalyticIntersectionContents(const std::vector<int>& analyticTypes) const
+{
+	std::string intersections;
+	for (int i = 0; i < analyticTypes.size(); i++)
+	{
+		if (analyticTypes[i] >= 0)
+			intersections += "\tIntersectAnalyticObject(hit, ro, rd, " + std::to_string(i) + ", " + std::to_string(analyticTypes[i]) + ");\n";
+	}
+
+	return intersections;
+}
+
+std::string SDFManagerComponent::GenerateObjectGradientContents(const std::vector<RayMarchObjectComponent*>& raymarchObjects) const
+{
+	std::string objectGradients;
+	for (int i = 0; i < raymarchObjects.size(); i++)
+	{
+		const RayMarchObjectComponent* obj = raymarchObjects[i];
+
+		// Subtracted objects bound the scene by their negated distance
+		const std::string index = std::to_string(i);
+		if (obj->GetRepetitionMode() != 0)
+		{
+			// The nearest copy's, see REPEATED_GRADIENT in SceneDistanceTemplate.hlsli
+			objectGradients += "\tcase " + index + ":\n\t{\n\t\tfloat3 gradient;\n";
+			objectGradients += "\t\tREPEATED_GRADIENT(" + SDFFuncContents[obj->GetSDFType() % SDFFuncContents.size()].first + ", " + index + ", gradient);\n";
+			objectGradients += "\t\treturn " + std::string(CPU::IsSubtractOperator(obj->GetBoolOperator()) ? "-" : "") + "InverseRotate(gradient, ObjectsList[" + index + "].Rotation);\n\t}\n";
+			continue;
+		}
+
+		objectGradients += "\tcase " + index + ": return " + (CPU::IsSubtractOperator(obj->GetBoolOperator()) ? "-" : "") + "InverseRotate(gradSdf" + SDFFuncContents[obj->GetSDFType() % SDFFuncContents.size()].first;
+		objectGradients += "(Rotate(Translate(p, ObjectsList[" + index + "].Position), ObjectsList[" + index + "].Rotation) / ObjectsList[" + index + "].Scale.x, ObjectsList[" + index + "].Parameters, footprint / ObjectsList[" + index + "].Scale.x, offset / ObjectsList[" + index + "].Scale.x), ObjectsList[" + index + "].Rotation);\n";
+	}
+
+	return objectGradients;
+}
+
+std::string SDFManagerComponent::GenerateSceneGradientContents(const std::vector<RayMarchObjectComponent*>& raymarchObjects) const
+{
+	// Near p the scene distance is the distance to the object that last set it, unless objects blend there
+	const bool smooth = std::ranges::any_of(raymarchObjects, [](const RayMarchObjectComponent* obj) { return obj->GetBoolOperator() >= 3; });
+	if (!smooth)
+		return "\tCOST_ADD(sdfEvaluations, 1);\n\treturn GetObjectGradient(GetDistanceToScene(p, footprint).index, p, footprint, offset);\n";
+
+	// Every object's distance again, folding in the gradients of those that move it, see CombineGradient
+	std::string gradient = "\tCOST_ADD(sdfEvaluations, 1);\n\tfloat dist = renderSettings.maxDist;\n\tfloat3 gradient = float3(0.0f, 1.0f, 0.0f);\n\n";
+	for (int i = 0; i < raymarchObjects.size(); i++)
+	{
+		const std::string index = std::to_string(i);
+		gradient += GenerateObjectDistance(raymarchObjects[i], index);
+		gradient += "\tCombineGradient(dist, gradient, objectDist" + index + ", " + index + ", " + std::to_string(raymarchObjects[i]->GetBoolOperator()) + ", p, footprint, offset);\n\n";
+	}
+	gradient += "\treturn gradient;\n";
+
+	return gradient;
+}
+
+std::vector<int> SDFManagerComponent::FindAnalyticObjects(const std::vector<RayMarchObjectComponent*>& raymarchObjects) const
+{
+	std::vector<int> analyticTypes(raymarchObjects.size(), -1);
+	for (int i = static_cast<int>(raymarchObjects.size()) - 1; i >= 0; --i)
+	{
+		// Everything before an intersection, subtraction or smooth union is changed by it
+		if (raymarchObjects[i]->GetBoolOperator() != 0)
+			break;
+
+		// Repeated objects have more than one surface to intersect
+		if (raymarchObjects[i]->GetRepetitionMode() == 0)
+			analyticTypes[i] = GetPrimitiveType(raymarchObjects[i]->GetSDFType());
+	}
+
+	return analyticTypes;
+}
+
+int SDFManagerComponent::GetPrimitiveType(int objectType) const
+{
+	const std::pair<std::string, std::string>& snippet = SDFFuncContents[objectType % SDFFuncContents.size()];
+	for (int type = 0; type < static_cast<int>(std::size(PrimitiveSnippets)); ++type)
+	{
+		if (snippet == PrimitiveSnippets[type])
+			return type;
+	}
+
+	return -1;
+}
+
+unsigned int SDFManagerComponent::EstimateSDFInstructionCount(int objectType) const
+{
+	const std::string function = GenerateSignedDistanceFunction(objectType);
+	if (const auto cached = InstructionCounts.find(function); cached != InstructionCounts.end())
+		return cached->second;
+
+	// Inputs come from a constant buffer so nothing is folded away
+	const std::string source = function +
+		"cbuffer Input : register(b0) { float3 P; float PADDING; float3 Param; }\n"
+		"float4 main() : SV_Target { return sdf" + SDFFuncContents[objectType % SDFFuncContents.size()].first + "(P, Param, 0.0f); }\n";
+
+	unsigned int instructionCount = 0u;
+	Microsoft::WRL::ComPtr<ID3DBlob> blob{};
+	Microsoft::WRL::ComPtr<ID3DBlob> errors{};
+	if (SUCCEEDED(D3DCompile(source.c_str(), source.size(), "SDFSnippet", nullptr, nullptr, "main", "ps_5_0",
+	                         D3DCOMPILE_OPTIMIZATION_LEVEL3, 0, blob.GetAddressOf(), errors.GetAddressOf())))
+	{
+		Microsoft::WRL::ComPtr<ID3D11ShaderReflection> reflection{};
+		D3D11_SHADER_DESC desc{};
+		if (SUCCEEDED(D3DReflect(blob->GetBufferPointer(), blob->GetBufferSize(), IID_PPV_ARGS(reflection.GetAddressOf()))) &&
+		    SUCCEEDED(reflection->GetDesc(&desc)))
+			instructionCount = desc.InstructionCount;
+	}
+
+	InstructionCounts[function] = instructionCount;
+	return instructionCount;
+}
+
+void SDFManagerComponent::UpdateSnippetCosts(const std::vector<RayMarchObjectComponent*>& raymarchObjects, const float deltaTime)
+{
+	if (!Benchmark)
+		Benchmark = std::make_unique<SnippetBenchmark>();
+
+	DisplayParameters.assign(SDFFuncContents.size(), CPU::Float3(1.0f));
+	std::vector<bool> used(SDFFuncContents.size(), false);
+	for (const RayMarchObjectComponent* obj : raymarchObjects)
+	{
+		const size_t index = static_cast<size_t>(obj->GetSDFType()) % SDFFuncContents.size();
+		if (!used[index])
+			DisplayParameters[index] = CPU::Float3(obj->GetParameters().x, obj->GetParameters().y, obj->GetParameters().z);
+		used[index] = true;
+	}
+
+	// Pairs still settling from last frame carry their time over, pairs no longer in use are dropped
+	std::unordered_map<uint64_t, float> settling{};
+	const auto settle = [&](const size_t index, const CPU::Float3& parameters)
+	{
+		const auto& [name, body] = SDFFuncContents[index];
+		const uint64_t measurement = CPU::HashSnippetMeasurement(CPU::HashSnippet(name, body), parameters);
+		if (settling.contains(measurement))
+			return;
+
+		const auto previous = SettlingMeasurements.find(measurement);
+		const float seconds = previous != SettlingMeasurements.end() ? previous->second + deltaTime : 0.0f;
+		settling[measurement] = seconds;
+		if (seconds >= SnippetSettleSeconds)
+			Benchmark->Request(name, body, parameters);
+	};
+
+	for (size_t i = 0; i < SDFFuncContents.size(); ++i)
+		settle(i, GetDisplayParameters(i));
+	for (const RayMarchObjectComponent* obj : raymarchObjects)
+		settle(static_cast<size_t>(obj->GetSDFType()) % SDFFuncContents.size(), CPU::Float3(obj->GetParameters().x, obj->GetParameters().y, obj->GetParameters().z));
+	SettlingMeasurements = std::move(settling);
+
+	Benchmark->Update();
+}
+
+float SDFManagerComponent::GetStepScale(const RayMarchObjectComponent& object) const
+{
+	if (!Benchmark || SDFFuncContents.empty())
+		return 1.0f;
+
+	const auto& [name, body] = SDFFuncContents[static_cast<size_t>(object.GetSDFType()) % SDFFuncContents.size()];
+	const CPU::SnippetCost* cost = Benchmark->FindCost(CPU::HashSnippet(name, body),
+	                                                   CPU::Float3(object.GetParameters().x, object.GetParameters().y, object.GetParameters().z));
+	return cost ? CPU::GetSnippetStepScale(cost->Lipschitz) : 1.0f;
+}
+
+CPU::Float3 SDFManagerComponent::GetDisplayParameters(const size_t index) const
+{
+	return index < DisplayParameters.size() ? DisplayParameters[index] : CPU::Float3(1.0f);
+}
+
+std::vector<CPU::SnippetCost> SDFManagerComponent::GetSnippetCosts() const
+{
+	if (!Benchmark)
+		return {};
+
+	// Measurements of snippets since edited or removed are left behind
+	std::vector<CPU::SnippetCost> costs = Benchmark->GetCosts();
+	std::erase_if(costs, [this](const CPU::SnippetCost& cost)
+	{
+		return std::none_of(SDFFuncContents.begin(), SDFFuncContents.end(), [&cost](const auto& snippet)
+		{
+			return CPU::HashSnippet(snippet.first, snippet.second) == cost.Hash;
+		});
+	});
+	return costs;
+}
+
+void SDFManagerComponent::SetSnippetCosts(const std::vector<CPU::SnippetCost>& costs)
+{
+	if (!Benchmark)
+		Benchmark = std::make_unique<SnippetBenchmark>();
+
+	// Results are keyed by snippet hash and param, so a stale cost is simply never looked up
+	for (const CPU::SnippetCost& cost : costs)
+		Benchmark->AddCost(cost);
+}
+
 void SDFManagerComponent::WriteStringToHeaderShader(const std::string& content, std::ios_base::openmode writeMode) const
 {
 	std::ofstream file;
@@ -74,7 +346,9 @@ void SDFManagerComponent::WriteStringToHeaderShader(const std::string& content,
 	file.close();
 }
 
-void SDFManagerComponent::WriteSceneDistanceFunctionToShaderHeader(const std::string& funcContents) const
+void SDFManagerComponent::WriteSceneDistanceFunctionToShaderHeader(const std::string& funcContents, const std::string& marchedContents,
+                                                                   const std::string& analyticContents, const std::string& gradientContents,
+                                                                   const std::string& sceneGradientContents) const
 {
 	if (!std::filesystem::exists(ShaderHeaderTemplatePath))
 		return; // TODO: Error handling
@@ -86,11 +360,21 @@ void SDFManagerComponent::WriteSceneDistanceFunctionToShaderHeader(const std::st
 	                       (std::istreambuf_iterator<char>()));
 	shaderTemplate.close();
 
-	// Replace flag with function contents
-	const size_t start_pos = templateContent.find(DistanceFunctionContentsFlag);
-	if (start_pos == std::string::npos)
-		return; // TODO: Error handling
-	templateContent.replace(start_pos, DistanceFunctionContentsFlag.length(), funcContents);
+	// Replace flags with function contents
+	const std::pair<const std::string&, const std::string&> replacements[] = {
+		{ DistanceFunctionContentsFlag, funcContents },
+		{ MarchedFunctionContentsFlag, marchedContents },
+		{ AnalyticFunctionContentsFlag, analyticContents },
+		{ GradientFunctionContentsFlag, gradientContents },
+		{ SceneGradientContentsFlag, sceneGradientContents }
+	};
+	for (const auto& [flag, contents] : replacements)
+	{
+		const size_t start_pos = templateContent.find(flag);
+		if (start_pos == std::string::npos)
+			return; // TODO: Error handling
+		templateContent.replace(start_pos, flag.length(), contents);
+	}
 
 	// Write content to file
 	std::ofstream file;
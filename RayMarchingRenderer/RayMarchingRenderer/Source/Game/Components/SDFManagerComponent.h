@@ -1,8 +1,11 @@
 #pragma once
 #include "Game/GameObject.h"
 #include "RayMarchObjectComponent.h"
+#include "Rendering/SnippetBenchmark.h"
 
 #include <filesystem>
+#include <memory>
+#include <unordered_map>
 
 
 class SDFManagerComponent : public Component
@@ -20,16 +23,60 @@ public:
 	void RenderGUI() override;
 
 	[[nodiscard]] std::string GenerateSignedDistanceFunction(int objectType) const;
-	[[nodiscard]] std::string GenerateSceneDistanceFunctionContents(const std::vector<RayMarchObjectComponent*>& gameObjects) const;
+	// gradSdf function for the snippet: exact (SDFGradients.hlsli) for an unedited primitive, central differences otherwise
+	[[nodiscard]] std::string GenerateGradientFunction(int objectType) const;
+	// Distance to every object, or to the ones analyticTypes marks -1 when given
+	[[nodiscard]] std::string GenerateSceneDistanceFunctionContents(const std::vector<RayMarchObjectComponent*>& gameObjects,
+	                                                                const std::vector<int>* analyticTypes = nullptr) const;
+	// Intersections for the objects analyticTypes gives a primitive for
+	[[nodiscard]] std::string GenerateAnalyticIntersectionContents(const std::vector<int>& analyticTypes) const;
+	// Gradient of each object's distance, selected by index
+	[[nodiscard]] std::string GenerateObjectGradientContents(const std::vector<RayMarchObjectComponent*>& gameObjects) const;
+	// Gradient of the scene distance: the nearest object's, or the blended objects' when any object uses a smooth operator
+	[[nodiscard]] std::string GenerateSceneGradientContents(const std::vector<RayMarchObjectComponent*>& gameObjects) const;
+
+	// For each object, the built-in primitive (ANALYTIC_* in AnalyticPrimitives.hlsli) rays intersect it as in closed
+	// form, or -1 to march it. Only objects unioned with the rest of the scene and using an unedited primitive snippet
+	// qualify, as for CPU::FindAnalyticPrimitives.
+	[[nodiscard]] std::vector<int> FindAnalyticObjects(const std::vector<RayMarchObjectComponent*>& raymarchObjects) const;
 
 	void WriteStringToHeaderShader(const std::string& content, std::ios_base::openmode writeMode = std::ios_base::out) const;
-	void WriteSceneDistanceFunctionToShaderHeader(const std::string& funcContents) const;
+	void WriteSceneDistanceFunctionToShaderHeader(const std::string& funcContents, const std::string& marchedContents,
+	                                              const std::string& analyticContents, const std::string& gradientContents,
+	                                              const std::string& sceneGradientContents) const;
+
+	// Name and body of each user SDF, indexed by RayMarchObjectComponent::GetSDFType()
+	[[nodiscard]] const std::vector<std::pair<std::string, std::string>>& GetSDFLibrary() const { return SDFFuncContents; }
+	void SetSDFLibrary(const std::vector<std::pair<std::string, std::string>>& library) { SDFFuncContents = library; }
+
+	// Instructions in a snippet compiled on its own, a rough GPU cost per evaluation. Loops count once.
+	// Cached per snippet; 0 if the snippet doesn't compile.
+	[[nodiscard]] unsigned int EstimateSDFInstructionCount(int objectType) const;
+
+	// Measures snippets in the background once they stop changing, with the param of every object
+	// using them (or 1 for unused ones). Called by the ray marching manager each frame.
+	void UpdateSnippetCosts(const std::vector<RayMarchObjectComponent*>& raymarchObjects, float deltaTime);
+
+	// Multiplier on the object's distance from its snippet's Lipschitz estimate with the object's param.
+	// 1 until that has been measured.
+	[[nodiscard]] float GetStepScale(const RayMarchObjectComponent& object) const;
+
+	// Every measurement of the current snippets, with each param measured
+	[[nodiscard]] std::vector<CPU::SnippetCost> GetSnippetCosts() const;
+	// Costs stored with a scene; ones that don't match their snippet are measured again
+	void SetSnippetCosts(const std::vector<CPU::SnippetCost>& costs);
 
 protected:
 	[[nodiscard]] std::string GetComponentName() const override { return "SDF Manager"; }
 
 private:
-	std::vector<std::pair<std::string, std::string>> SDFFuncContents = {
+	// Index into PrimitiveSnippets of the object type's snippet if it is an unedited primitive, otherwise -1
+	[[nodiscard]] int GetPrimitiveType(int objectType) const;
+	// Declares objectDist<index>, the object's distance as it enters the scene distance before its operator
+	[[nodiscard]] std::string GenerateObjectDistance(const RayMarchObjectComponent* obj, const std::string& index) const;
+
+	// The built-in primitives, in CPU::SDFType order. Objects using one unedited can be intersected analytically.
+	static inline const std::pair<std::string, std::string> PrimitiveSnippets[] = {
 		{
 			"Sphere",
 			"return length(p) - param.x;"
@@ -59,7 +106,129 @@ private:
 		}
 	};
 
+	std::vector<std::pair<std::string, std::string>> SDFFuncContents = {
+		PrimitiveSnippets[0],
+		PrimitiveSnippets[1],
+		PrimitiveSnippets[2],
+		PrimitiveSnippets[3],
+		PrimitiveSnippets[4],
+		// Built-in fractals, matching CPU/FractalKernels.cpp. Trig free, unlike the example snippets, and
+		// they skip iterations whose detail would be smaller than footprint.
+		{
+			"Mandelbulb",
+			R"(float3 w = p;
+    float m = dot(w, w);
+    float dz = 1.0;
+    for (int i = 0; i < 4; i++)
+    {
+        dz = 8.0 * m * m * m * sqrt(m) * dz + 1.0;
+        float x2 = w.x * w.x, x4 = x2 * x2;
+        float y2 = w.y * w.y, y4 = y2 * y2;
+        float z2 = w.z * w.z, z4 = z2 * z2;
+        float k3 = x2 + z2;
+        float k2 = rsqrt(k3 * k3 * k3 * k3 * k3 * k3 * k3);
+        float k1 = x4 + y4 + z4 - 6.0 * y2 * z2 - 6.0 * x2 * y2 + 2.0 * z2 * x2;
+        float k4 = x2 - y2 + z2;
+        w = p + float3(64.0 * w.x * w.y * w.z * (x2 - z2) * k4 * (x4 - 6.0 * x2 * z2 + z4) * k1 * k2,
+                       -16.0 * y2 * k3 * k4 * k4 + k1 * k1,
+                       -8.0 * w.y * k4 * (x4 * x4 - 28.0 * x4 * x2 * z2 + 70.0 * x4 * z4 - 28.0 * x2 * z2 * z4 + z4 * z4) * k1 * k2);
+        m = dot(w, w);
+        if (m > 256.0 || dz * footprint > 1.0) break;
+    }
+    return 0.25 * log(m) * sqrt(m) / dz;)"
+		},
+		{
+			"Juliabulb",
+			R"(float3 w = p;
+    float m = dot(w, w);
+    float dz = 1.0;
+    for (int i = 0; i < 4; i++)
+    {
+        dz = 8.0 * m * m * m * sqrt(m) * dz;
+        float x2 = w.x * w.x, x4 = x2 * x2;
+        float y2 = w.y * w.y, y4 = y2 * y2;
+        float z2 = w.z * w.z, z4 = z2 * z2;
+        float k3 = x2 + z2;
+        float k2 = rsqrt(k3 * k3 * k3 * k3 * k3 * k3 * k3);
+        float k1 = x4 + y4 + z4 - 6.0 * y2 * z2 - 6.0 * x2 * y2 + 2.0 * z2 * x2;
+        float k4 = x2 - y2 + z2;
+        w = param + float3(64.0 * w.x * w.y * w.z * (x2 - z2) * k4 * (x4 - 6.0 * x2 * z2 + z4) * k1 * k2,
+                           -16.0 * y2 * k3 * k4 * k4 + k1 * k1,
+                           -8.0 * w.y * k4 * (x4 * x4 - 28.0 * x4 * x2 * z2 + 70.0 * x4 * z4 - 28.0 * x2 * z2 * z4 + z4 * z4) * k1 * k2);
+        m = dot(w, w);
+        if (m > 256.0 || dz * footprint > 1.0) break;
+    }
+    return 0.25 * log(m) * sqrt(m) / dz;)"
+		},
+		{
+			"QuaternionJulia",
+			R"(float4 z = float4(p, 0.0);
+    float md2 = 1.0;
+    float mz2 = dot(z, z);
+    for (int i = 0; i < 11; i++)
+    {
+        md2 *= 4.0 * mz2;
+        z = float4(z.x * z.x - dot(z.yzw, z.yzw), 2.0 * z.x * z.yzw) + float4(param, 0.0);
+        mz2 = dot(z, z);
+        if (mz2 > 4.0 || md2 * footprint * footprint > 1.0) break;
+    }
+    return 0.25 * sqrt(mz2 / md2) * log(mz2);)"
+		},
+		{
+			"Sierpinski",
+			R"(float s = 1.0;
+    for (int i = 0; i < 8; i++)
+    {
+        if (1.7320508 < footprint * s)
+        {
+            float3 t = float3(p.x + p.y - p.z, p.x - p.y + p.z, -p.x + p.y + p.z);
+            return (max(max(t.x, t.y), max(t.z, -p.x - p.y - p.z)) - 1.0 + s / 256.0) / (1.7320508 * s);
+        }
+        if (p.x + p.y < 0.0) p.xy = -p.yx;
+        if (p.x + p.z < 0.0) p.xz = -p.zx;
+        if (p.y + p.z < 0.0) p.zy = -p.yz;
+        p = p * 2.0 - 1.0;
+        s *= 2.0;
+    }
+    return length(p) / s;)"
+		},
+		{
+			"Menger",
+			R"(float3 q = abs(p) - 1.0;
+    float d = length(max(q, 0.0)) + min(max(q.x, max(q.y, q.z)), 0.0);
+    float s = 1.0;
+    for (int i = 0; i < 4 && footprint * s * 3.0 <= 1.0; i++)
+    {
+        float3 a = p * s - 2.0 * floor(p * s * 0.5) - 1.0;
+        s *= 3.0;
+        float3 r = abs(1.0 - 3.0 * abs(a));
+        float da = max(r.x, r.y), db = max(r.y, r.z), dc = max(r.z, r.x);
+        d = max(d, (min(da, min(db, dc)) - 1.0) / s);
+    }
+    return d;)"
+		}
+	};
+
 	const std::filesystem::path ShaderHeaderPath = std::filesystem::current_path() / "Source" / "Rendering" / "Shaders" / "GeneratedSceneDistance.hlsli";
 	const std::filesystem::path ShaderHeaderTemplatePath = std::filesystem::current_path() / "Source" / "Rendering" / "Shaders" / "SceneDistanceTemplate.hlsli";
 	const std::string DistanceFunctionContentsFlag = "$DIST_FUNC_CONTENTS";
+	const std::string MarchedFunctionContentsFlag = "$MARCHED_FUNC_CONTENTS";
+	const std::string AnalyticFunctionContentsFlag = "$ANALYTIC_FUNC_CONTENTS";
+	const std::string GradientFunctionContentsFlag = "$GRAD_FUNC_CONTENTS";
+	const std::string SceneGradientContentsFlag = "$SCENE_GRAD_CONTENTS";
+
+	mutable std::unordered_map<std::string, unsigned int> InstructionCounts{};
+
+	// Seconds a snippet and param must go unchanged before they are measured, so typing or dragging a
+	// parameter doesn't queue a measurement per frame
+	static constexpr float SnippetSettleSeconds = 0.5f;
+
+	// param the snippet at a library index is shown measured with
+	[[nodiscard]] CPU::Float3 GetDisplayParameters(size_t index) const;
+
+	std::unique_ptr<SnippetBenchmark> Benchmark{};
+	// Seconds each snippet and param pair in use has gone unchanged, by CPU::HashSnippetMeasurement
+	std::unordered_map<uint64_t, float> SettlingMeasurements{};
+	// param of the first object using each snippet as of the last UpdateSnippetCosts, 1 for unused ones
+	std::vector<CPU::Float3> DisplayParameters{};
 };
@@ -1,28 +1,148 @@
 #include "pch.h"
 #include "Game/Components/TransformComponent.h"
 
+#include <algorithm>
+
+namespace
+{
+	CPU::Float3 ToFloat3(const DirectX::SimpleMath::Vector3& v) { return { v.x, v.y, v.z }; }
+	DirectX::SimpleMath::Vector3 ToVector3(const CPU::Float3& v) { return { v.x, v.y, v.z }; }
+}
+
+TransformComponent::~TransformComponent()
+{
+	if (ParentTransform)
+		std::erase(ParentTransform->Children, this);
+
+	// Copied, as detaching removes each from Children
+	const std::vector<TransformComponent*> children = Children;
+	for (TransformComponent* child : children)
+		child->SetParentTransform(nullptr);
+}
+
 void TransformComponent::RenderGUI()
 {
 	ImGui::PushID(this);
 
-	ImGui::DragFloat3("Position", &Position.x, 0.01f);
+	if (ParentTransform)
+	{
+		ImGui::Text("Parent: %s", ParentTransform->Parent ? ParentTransform->Parent->GetName().c_str() : "Unnamed");
+		ImGui::SameLine();
+		if (ImGui::Button("Detach"))
+			SetParentTransform(nullptr);
+	}
+	else
+		ImGui::TextUnformatted("Parent: None");
+
+	if (ImGui::DragFloat3("Position", &Position.x, 0.01f))
+		MarkDirty();
 	if (ImGui::Button("Reset Position"))
-		Position = DirectX::SimpleMath::Vector3::Zero;
-	ImGui::DragFloat3("Rotation", &Rotation.x, 0.01f);
+		SetPosition(DirectX::SimpleMath::Vector3::Zero);
+	if (ImGui::DragFloat3("Rotation", &Rotation.x, 0.01f))
+		MarkDirty();
 	if (ImGui::Button("Reset Rotation"))
-		Rotation = DirectX::SimpleMath::Vector3::Zero;
-	ImGui::DragFloat3("Scale", &Scale.x, 0.01f);
+		SetRotation(DirectX::SimpleMath::Vector3::Zero);
+	if (ImGui::DragFloat3("Scale", &Scale.x, 0.01f))
+		MarkDirty();
 	if (ImGui::Button("Reset Scale"))
-		Scale = DirectX::SimpleMath::Vector3::One;
+		SetScale(DirectX::SimpleMath::Vector3::One);
 
 	ImGui::PopID();
 }
 
+DirectX::SimpleMath::Vector3 TransformComponent::GetWorldPosition() const
+{
+	UpdateWorld();
+	return ToVector3(World.Position);
+}
+
+DirectX::SimpleMath::Vector3 TransformComponent::GetWorldRotation() const
+{
+	UpdateWorld();
+	return ToVector3(World.Rotation);
+}
+
+DirectX::SimpleMath::Vector3 TransformComponent::GetWorldScale() const
+{
+	UpdateWorld();
+	return WorldScale;
+}
+
 DirectX::SimpleMath::Matrix TransformComponent::GetWorldMatrix() const
 {
+	UpdateWorld();
+	return WorldMatrix;
+}
+
+bool TransformComponent::SetParentTransform(TransformComponent* parent)
+{
+	for (const TransformComponent* ancestor = parent; ancestor; ancestor = ancestor->ParentTransform)
+		if (ancestor == this)
+			return false;
+	if (parent == ParentTransform)
+		return true;
+
+	UpdateWorld();
+	const CPU::Transform world = World;
+	const DirectX::SimpleMath::Vector3 worldScale = WorldScale;
+
+	if (ParentTransform)
+		std::erase(ParentTransform->Children, this);
+	ParentTransform = parent;
+
+	if (parent)
+	{
+		parent->Children.push_back(this);
+		parent->UpdateWorld();
+		const CPU::Transform local = CPU::GetRelativeTransform(parent->World, world);
+		Position = ToVector3(local.Position);
+		Rotation = ToVector3(local.Rotation);
+		Scale = worldScale / parent->World.Scale;
+	}
+	else
+	{
+		Position = ToVector3(world.Position);
+		Rotation = ToVector3(world.Rotation);
+		Scale = worldScale;
+	}
+
+	MarkDirty();
+	return true;
+}
+
+void TransformComponent::MarkDirty()
+{
+	if (Dirty)
+		return;
+
+	Dirty = true;
+	for (TransformComponent* child : Children)
+		child->MarkDirty();
+}
+
+void TransformComponent::UpdateWorld() const
+{
+	if (!Dirty)
+		return;
+
 	const DirectX::SimpleMath::Matrix tra = XMMatrixTranslationFromVector(Position);
 	const DirectX::SimpleMath::Matrix rot = XMMatrixRotationRollPitchYawFromVector(Rotation);
 	const DirectX::SimpleMath::Matrix sca = XMMatrixScalingFromVector(Scale);
+	const CPU::Transform local{ ToFloat3(Position), ToFloat3(Rotation), Scale.x };
+
+	if (ParentTransform)
+	{
+		ParentTransform->UpdateWorld();
+		World = CPU::ComposeTransforms(ParentTransform->World, local);
+		WorldScale = Scale * ParentTransform->World.Scale;
+		WorldMatrix = sca * rot * tra * ParentTransform->WorldMatrix;
+	}
+	else
+	{
+		World = local;
+		WorldScale = Scale;
+		WorldMatrix = sca * rot * tra;
+	}
 
-	return sca * rot * tra;
+	Dirty = false;
 }
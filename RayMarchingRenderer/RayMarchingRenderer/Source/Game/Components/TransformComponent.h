@@ -1,35 +1,64 @@
 #pragma once
+#include <vector>
+
+#include "CPU/TransformHierarchy.h"
 #include "Game/GameObject.h"
 
+// Position, rotation and scale relative to an optional parent transform. The world transform is cached and only
+// recomputed when this or an ancestor has changed since it was last read.
 class TransformComponent final : public Component
 {
 public:
 	TransformComponent() = default;
-	TransformComponent(const TransformComponent&) = default;
-	TransformComponent(TransformComponent&&) = default;
-	TransformComponent& operator=(const TransformComponent&) = default;
-	TransformComponent& operator=(TransformComponent&&) = default;
-	~TransformComponent() override = default;
+	// Linked to others by pointer, so never copied or moved
+	TransformComponent(const TransformComponent&) = delete;
+	TransformComponent(TransformComponent&&) = delete;
+	TransformComponent& operator=(const TransformComponent&) = delete;
+	TransformComponent& operator=(TransformComponent&&) = delete;
+	// Children keep their world transforms and become roots
+	~TransformComponent() override;
 
 	void Update(float deltaTime) override {};
 	void Render() override {};
 	void RenderGUI() override;
 
+	// Relative to the parent transform
 	[[nodiscard]] DirectX::SimpleMath::Vector3 GetPosition() const { return Position; }
 	[[nodiscard]] DirectX::SimpleMath::Vector3 GetRotation() const { return Rotation; }
 	[[nodiscard]] DirectX::SimpleMath::Vector3 GetScale() const { return Scale; }
 
+	// As the ray marcher takes them: rotation as CPU::Rotate, and the parent's scale taken as uniform from x
+	[[nodiscard]] DirectX::SimpleMath::Vector3 GetWorldPosition() const;
+	[[nodiscard]] DirectX::SimpleMath::Vector3 GetWorldRotation() const;
+	[[nodiscard]] DirectX::SimpleMath::Vector3 GetWorldScale() const;
 	[[nodiscard]] DirectX::SimpleMath::Matrix GetWorldMatrix() const;
 
-	void SetPosition(DirectX::SimpleMath::Vector3 val) { Position = val; }
-	void SetRotation(DirectX::SimpleMath::Vector3 val) { Rotation = val; }
-	void SetScale(DirectX::SimpleMath::Vector3 val) { Scale = val; }
+	[[nodiscard]] TransformComponent* GetParentTransform() const { return ParentTransform; }
+	[[nodiscard]] const std::vector<TransformComponent*>& GetChildTransforms() const { return Children; }
+	// Keeps the world transform. Fails, changing nothing, if parent is this or under it. nullptr detaches.
+	bool SetParentTransform(TransformComponent* parent);
+
+	void SetPosition(DirectX::SimpleMath::Vector3 val) { Position = val; MarkDirty(); }
+	void SetRotation(DirectX::SimpleMath::Vector3 val) { Rotation = val; MarkDirty(); }
+	void SetScale(DirectX::SimpleMath::Vector3 val) { Scale = val; MarkDirty(); }
 
 protected:
 	[[nodiscard]] std::string GetComponentName() const override { return "Transform"; }
 
 private:
+	// A dirty transform's children are all dirty, so marking stops at the first that already is
+	void MarkDirty();
+	void UpdateWorld() const;
+
 	DirectX::SimpleMath::Vector3 Position{ DirectX::SimpleMath::Vector3::Zero };
 	DirectX::SimpleMath::Vector3 Rotation{ DirectX::SimpleMath::Vector3::Zero };
 	DirectX::SimpleMath::Vector3 Scale{ DirectX::SimpleMath::Vector3::One };
+
+	TransformComponent* ParentTransform{ nullptr };
+	std::vector<TransformComponent*> Children{};
+
+	mutable bool Dirty{ true };
+	mutable CPU::Transform World{};
+	mutable DirectX::SimpleMath::Vector3 WorldScale{ DirectX::SimpleMath::Vector3::One };
+	mutable DirectX::SimpleMath::Matrix WorldMatrix{};
 };
@@ -6,6 +6,25 @@
 
 #include "Game/Components/TransformComponent.h"
 
+namespace
+{
+	// Every GameObject and component pool. Remaining GameObjects are destroyed first, so their components go back
+	// to pools that still exist.
+	struct Pools
+	{
+		CPU::ObjectPool<GameObject> GameObjects{};
+		std::vector<std::unique_ptr<ComponentPoolBase>> Components{};
+
+		~Pools() { GameObjects.Clear(); }
+	};
+
+	Pools& GetPools()
+	{
+		static Pools pools{};
+		return pools;
+	}
+}
+
 GameObject::GameObject()
 {
 	AddTransform();
@@ -16,50 +35,104 @@ GameObject::GameObject(const std::string name) : Name(name)
 	AddTransform();
 }
 
+GameObject::~GameObject()
+{
+	while (!Components.empty())
+		Components.pop_back();
+}
+
+GameObject* GameObject::Create(const std::string& name)
+{
+	return GetPools().GameObjects.Create(name);
+}
+
+void GameObject::Destroy(GameObject* gameObject)
+{
+	GetPools().GameObjects.Destroy(gameObject);
+}
+
+GameObject* GameObject::Find(const CPU::PoolHandle handle)
+{
+	return GetPools().GameObjects.Get(handle);
+}
+
+CPU::PoolHandle GameObject::GetHandle() const
+{
+	return GetPools().GameObjects.GetHandle(this);
+}
+
+const CPU::PoolCounters& GameObject::GetPoolCounters()
+{
+	return GetPools().GameObjects.GetCounters();
+}
+
+ComponentPoolBase& GameObject::AddComponentPool(std::unique_ptr<ComponentPoolBase> pool)
+{
+	return *GetPools().Components.emplace_back(std::move(pool));
+}
+
 void GameObject::AddTransform()
 {
+	// Room for the few components an object usually has in one allocation
+	Components.reserve(4);
 	if (!GetComponent<TransformComponent>())
 	{
-		auto* comp = AddComponent(new TransformComponent());
+		auto* comp = AddComponent<TransformComponent>();
 		comp->Removable = false;
 	}
 }
 
 void GameObject::Update(float deltaTime)
 {
-	for (const auto& [type, components] : Components)
-		for (const auto& component : components)
-			component->Update(deltaTime);
+	for (const auto& [type, component] : Components)
+		component->Update(deltaTime);
 }
 
 void GameObject::Render()
 {
-	for (const auto& [type, components] : Components)
-		for (const auto& component : components)
-			component->Render();
+	for (const auto& [type, component] : Components)
+		component->Render();
 }
 
 void GameObject::RenderGUI()
 {
-	if (ImGui::CollapsingHeader((Name + "###").c_str()))
+	const bool open = ImGui::CollapsingHeader((Name + "###").c_str());
+
+	// Dropping one object's header on another's parents the dropped object's transform to this one's. The payload
+	// is a handle, as the dragged object can be removed before it is dropped.
+	if (ImGui::BeginDragDropSource())
+	{
+		const CPU::PoolHandle handle = GetHandle();
+		ImGui::SetDragDropPayload("GameObject", &handle, sizeof(handle));
+		ImGui::TextUnformatted(Name.c_str());
+		ImGui::EndDragDropSource();
+	}
+	if (ImGui::BeginDragDropTarget())
+	{
+		if (const ImGuiPayload* payload = ImGui::AcceptDragDropPayload("GameObject"))
+		{
+			if (GameObject* child = Find(*static_cast<const CPU::PoolHandle*>(payload->Data)))
+				child->GetComponent<TransformComponent>()->SetParentTransform(GetComponent<TransformComponent>());
+		}
+		ImGui::EndDragDropTarget();
+	}
+
+	if (open)
 	{
 		ImGui::InputText("Name", &Name);
 
-		for (const auto& [type, components] : Components)
+		for (const auto& [type, component] : Components)
 		{
-			for (const auto& component : components)
+			ImGui::PushID(component.get());
+			if (ImGui::TreeNode(component->GetComponentName().c_str()))
 			{
-				ImGui::PushID(component.get());
-				if (ImGui::TreeNode(component->GetComponentName().c_str()))
-				{
-					component->RenderGUI();
+				component->RenderGUI();
 
-					ImGui::Separator();
+				ImGui::Separator();
 
-					ImGui::TreePop();
-				}
-				ImGui::PopID();
+				ImGui::TreePop();
 			}
+			ImGui::PopID();
 		}
 	}
 }
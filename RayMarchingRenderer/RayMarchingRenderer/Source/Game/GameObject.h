@@ -1,8 +1,11 @@
 #pragma once
-#include <unordered_map>
+#include <memory>
 #include <typeindex>
+#include <utility>
 #include <vector>
 
+#include "CPU/ObjectPool.h"
+
 class GameObject;
 
 class Component
@@ -30,30 +33,54 @@ private:
 	bool Removable{ true };
 };
 
+// Holds the pool of one component type, so the pools of every type can be destroyed together
+class ComponentPoolBase
+{
+public:
+	virtual ~ComponentPoolBase() = default;
+};
+
+// GameObjects and their components live in pools (CPU/ObjectPool.h), one per type, so churn reuses warm slots
+// rather than allocating. Create and Destroy them through GameObject::Create, GameObject::Destroy, AddComponent and
+// RemoveComponent, never new and delete.
 class GameObject final
 {
 public:
 	GameObject();
 	GameObject(const std::string name);
-	GameObject(const GameObject&) = default;
-	GameObject(GameObject&&) = default;
-	GameObject& operator=(const GameObject&) = default;
-	GameObject& operator=(GameObject&&) = default;
-	~GameObject() = default;
+	// Components point back at their GameObject, so it never moves
+	GameObject(const GameObject&) = delete;
+	GameObject(GameObject&&) = delete;
+	GameObject& operator=(const GameObject&) = delete;
+	GameObject& operator=(GameObject&&) = delete;
+	// Destroys the components newest first, so the transform goes last
+	~GameObject();
+
+	[[nodiscard]] static GameObject* Create(const std::string& name);
+	// Does nothing for nullptr
+	static void Destroy(GameObject* gameObject);
+	// nullptr once the GameObject the handle was made for is destroyed
+	[[nodiscard]] static GameObject* Find(CPU::PoolHandle handle);
+	[[nodiscard]] CPU::PoolHandle GetHandle() const;
+	// Live objects and chunk allocations of the GameObject pool, for the GUI
+	[[nodiscard]] static const CPU::PoolCounters& GetPoolCounters();
 
 	void Update(float deltaTime);
 	void Render();
 	void RenderGUI();
 
+	[[nodiscard]] const std::string& GetName() const { return Name; }
+
 	template <typename T> requires std::is_base_of_v<Component, T>
 	[[nodiscard]] T* GetComponent()
 	{
 		const auto type = std::type_index(typeid(T));
 
-		if (!Components.contains(type))
-			return nullptr;
+		for (const auto& [componentType, component] : Components)
+			if (componentType == type)
+				return static_cast<T*>(component.get());
 
-		return reinterpret_cast<T*>(Components.at(type)[0].get());
+		return nullptr;
 	}
 
 	template <typename T> requires std::is_base_of_v<Component, T>
@@ -61,23 +88,25 @@ public:
 	{
 		const auto type = std::type_index(typeid(T));
 
-		if (!Components.contains(type))
-			return std::vector<T*>();
-
 		std::vector<T*> rawPtrList;
-		rawPtrList.reserve(Components.at(type).size());
-		for (const auto& sPtr : Components.at(type))
-			rawPtrList.push_back(reinterpret_cast<T*>(sPtr.get()));
+		for (const auto& [componentType, component] : Components)
+			if (componentType == type)
+				rawPtrList.push_back(static_cast<T*>(component.get()));
 
 		return rawPtrList;
 	}
 
-	template <typename T> requires std::is_base_of_v<Component, T>
-	T* AddComponent(T* component)
+	// Constructs the component from args in its type's pool
+	template <typename T, typename... Args> requires std::is_base_of_v<Component, T>
+	T* AddComponent(Args&&... args)
 	{
+		T* component = GetComponentPool<T>().Create(std::forward<Args>(args)...);
 		component->Parent = this;
-		Components[std::type_index(typeid(T))].push_back(std::shared_ptr<Component>(component));
-		return reinterpret_cast<T*>(component);
+		Components.emplace_back(std::type_index(typeid(T)), ComponentPtr(component, [](Component* owned)
+		{
+			GetComponentPool<T>().Destroy(static_cast<T*>(owned));
+		}));
+		return component;
 	}
 
 	template <typename T> requires std::is_base_of_v<Component, T>
@@ -88,16 +117,11 @@ public:
 		if (!component->Removable)
 			throw std::invalid_argument("The component requested for removal is set as irremovable");
 
-		if (!Components.contains(type))
-			throw std::invalid_argument("No components of specified type are assigned to this GameObject");
-
-		for (int i = 0; i < Components[type].size(); i++)
+		for (auto it = Components.begin(); it != Components.end(); ++it)
 		{
-			if (Components[type][i].get() == component)
+			if (it->first == type && it->second.get() == component)
 			{
-				Components[type].erase(Components[type].begin() + i);
-				if (Components[type].size() == 0)
-					Components.erase(type);
+				Components.erase(it);
 				return;
 			}
 		}
@@ -133,9 +157,26 @@ public:
 
 
 private:
+	// Returns the pool's component to it
+	using ComponentPtr = std::unique_ptr<Component, void (*)(Component*)>;
+
+	template <typename T>
+	[[nodiscard]] static CPU::ObjectPool<T>& GetComponentPool()
+	{
+		struct Pool final : ComponentPoolBase
+		{
+			CPU::ObjectPool<T> Components{};
+		};
+		static Pool& pool = static_cast<Pool&>(AddComponentPool(std::make_unique<Pool>()));
+		return pool.Components;
+	}
+	// Kept until every GameObject is destroyed at exit
+	static ComponentPoolBase& AddComponentPool(std::unique_ptr<ComponentPoolBase> pool);
+
 	void AddTransform();
 
-	std::unordered_map<std::type_index, std::vector<std::shared_ptr<Component>>> Components{};
+	// In the order they were added
+	std::vector<std::pair<std::type_index, ComponentPtr>> Components{};
 
 	std::string Name{ "GameObject" };
 };
@@ -0,0 +1,204 @@
+#include "pch.h"
+#include "Game/SceneSerialisation.h"
+
+#include "CPU/SceneFile.h"
+#include "Game/Components/CameraComponent.h"
+#include "Game/Components/MaterialComponent.h"
+#include "Game/Components/RayMarchingManagerComponent.h"
+#include "Game/Components/RayMarchLightComponent.h"
+#include "Game/Components/RayMarchObjectComponent.h"
+#include "Game/Components/SDFManagerComponent.h"
+#include "Game/Components/TransformComponent.h"
+
+namespace
+{
+	CPU::Float3 ToFloat3(const DirectX::SimpleMath::Vector3& v) { return { v.x, v.y, v.z }; }
+	DirectX::SimpleMath::Vector3 ToVector3(const CPU::Float3& v) { return { v.x, v.y, v.z }; }
+
+	template <typename T>
+	T* FindFirst(const std::vector<GameObject*>& gameObjects)
+	{
+		const auto components = GameObject::FindComponents<T>(gameObjects);
+		return components.empty() ? nullptr : components[0];
+	}
+}
+
+void SceneSerialisation::Save(const std::filesystem::path& path, const std::vector<GameObject*>& gameObjects)
+{
+	CPU::SceneDocument document{};
+
+	if (const auto manager = FindFirst<RayMarchingManagerComponent>(gameObjects))
+		document.RenderSettings = manager->GetSceneRenderSettings();
+	if (const auto sdfManager = FindFirst<SDFManagerComponent>(gameObjects))
+	{
+		document.SDFLibrary = sdfManager->GetSDFLibrary();
+		document.SnippetCosts = sdfManager->GetSnippetCosts();
+	}
+
+	if (const auto camera = FindFirst<CameraComponent>(gameObjects))
+	{
+		const auto transform = camera->Parent->GetComponent<TransformComponent>();
+		document.Camera.Position = ToFloat3(transform->GetWorldPosition());
+		document.Camera.Rotation = ToFloat3(transform->GetRotation());
+		document.Camera.FOV = camera->GetFOV();
+	}
+
+	const auto objects = GameObject::FindComponents<RayMarchObjectComponent>(gameObjects);
+	std::unordered_map<const TransformComponent*, int32_t> objectIndices{};
+	for (size_t i = 0; i < objects.size(); ++i)
+		objectIndices.emplace(objects[i]->Parent->GetComponent<TransformComponent>(), static_cast<int32_t>(i));
+
+	for (const auto object : objects)
+	{
+		const auto transform = object->Parent->GetComponent<TransformComponent>();
+		const auto material = object->Parent->GetComponent<MaterialComponent>();
+
+		// World transforms, so readers without the hierarchy see the same scene
+		CPU::PackedObject packed{};
+		packed.Position = ToFloat3(transform->GetWorldPosition());
+		packed.Rotation = ToFloat3(transform->GetWorldRotation());
+		packed.Scale = ToFloat3(transform->GetWorldScale());
+		packed.Parameters = ToFloat3(object->GetParameters());
+		packed.SDFType = static_cast<uint32_t>(object->GetSDFType());
+		packed.BoolOperator = static_cast<uint32_t>(object->GetBoolOperator());
+		packed.BlendRadius = object->GetBlendRadius();
+		if (material)
+		{
+			packed.Colour = ToFloat3(material->GetColour());
+			packed.Metalicness = material->GetMetalicness();
+			packed.Roughness = material->GetRoughness();
+		}
+
+		document.Objects.push_back(packed);
+		document.ObjectNames.push_back(object->Parent->GetName());
+
+		CPU::PackedRepetition repetition{};
+		repetition.Mode = static_cast<uint32_t>(object->GetRepetitionMode());
+		repetition.Spacing = ToFloat3(object->GetRepetitionSpacing());
+		repetition.Limit = ToFloat3(object->GetRepetitionLimit());
+		repetition.Variation = object->GetRepetitionVariation();
+		document.Repetitions.push_back(repetition);
+
+		// The nearest ancestor that is saved too
+		int32_t parent = -1;
+		for (auto ancestor = transform->GetParentTransform(); ancestor && parent == -1; ancestor = ancestor->GetParentTransform())
+			if (const auto found = objectIndices.find(ancestor); found != objectIndices.end())
+				parent = found->second;
+		document.Parents.push_back(parent);
+	}
+
+	// Files without repeated objects leave the section empty
+	if (std::ranges::all_of(document.Repetitions, [](const CPU::PackedRepetition& repetition) { return repetition.Mode == 0u; }))
+		document.Repetitions.clear();
+	if (std::ranges::all_of(document.Parents, [](const int32_t parent) { return parent == -1; }))
+		document.Parents.clear();
+
+	for (const auto light : GameObject::FindComponents<RayMarchLightComponent>(gameObjects))
+	{
+		CPU::PackedLight packed{};
+		packed.Position = ToFloat3(light->Parent->GetComponent<TransformComponent>()->GetWorldPosition());
+		packed.Colour = ToFloat3(light->GetColour());
+		packed.ShadowSharpness = light->GetShadowSharpness();
+		packed.ConstantAttenuation = light->GetConstantAttenuation();
+		packed.LinearAttenuation = light->GetLinearAttenuation();
+		packed.QuadraticAttenuation = light->GetQuadraticAttenuation();
+
+		document.Lights.push_back(packed);
+		document.LightNames.push_back(light->Parent->GetName());
+	}
+
+	CPU::WriteSceneFile(path, document);
+}
+
+void SceneSerialisation::Load(const std::filesystem::path& path, std::vector<GameObject*>& gameObjects)
+{
+	// Validate the whole file before touching the scene
+	const CPU::SceneFileView file(path);
+
+	std::vector<std::pair<std::string, std::string>> library{};
+	library.reserve(file.GetSnippetCount());
+	for (size_t i = 0; i < file.GetSnippetCount(); ++i)
+		library.emplace_back(file.GetSnippetName(i), file.GetSnippetBody(i));
+
+	if (const auto manager = FindFirst<RayMarchingManagerComponent>(gameObjects))
+		manager->SetSceneRenderSettings(file.GetRenderSettings());
+	if (const auto sdfManager = FindFirst<SDFManagerComponent>(gameObjects); sdfManager && !library.empty())
+	{
+		sdfManager->SetSDFLibrary(library);
+		sdfManager->SetSnippetCosts({ file.GetSnippetCosts().begin(), file.GetSnippetCosts().end() });
+	}
+
+	if (const auto camera = FindFirst<CameraComponent>(gameObjects))
+	{
+		const auto transform = camera->Parent->GetComponent<TransformComponent>();
+		transform->SetParentTransform(nullptr);
+		transform->SetPosition(ToVector3(file.GetCamera().Position));
+		transform->SetRotation(ToVector3(file.GetCamera().Rotation));
+		camera->SetFOV(file.GetCamera().FOV);
+	}
+
+	// Remove the current objects and lights, keeping the manager and camera
+	std::erase_if(gameObjects, [](GameObject* go)
+	{
+		if (!go->GetComponent<RayMarchObjectComponent>() && !go->GetComponent<RayMarchLightComponent>())
+			return false;
+
+		GameObject::Destroy(go);
+		return true;
+	});
+
+	const auto objects = file.GetObjects();
+	gameObjects.reserve(gameObjects.size() + objects.size() + file.GetLights().size());
+	std::vector<TransformComponent*> objectTransforms{};
+	objectTransforms.reserve(objects.size());
+	for (size_t i = 0; i < objects.size(); ++i)
+	{
+		const CPU::PackedObject& packed = objects[i];
+		const std::string_view name = file.GetObjectName(i);
+		auto* go = GameObject::Create(name.empty() ? "Ray Marched Object" : std::string(name));
+
+		const auto transform = go->GetComponent<TransformComponent>();
+		transform->SetPosition(ToVector3(packed.Position));
+		transform->SetRotation(ToVector3(packed.Rotation));
+		transform->SetScale(ToVector3(packed.Scale));
+		objectTransforms.push_back(transform);
+
+		auto* object = go->AddComponent<RayMarchObjectComponent>();
+		object->SetParameters(ToVector3(packed.Parameters));
+		object->SetSDFType(static_cast<int>(packed.SDFType));
+		object->SetBoolOperator(static_cast<int>(packed.BoolOperator));
+		// Files from before the smooth operators leave it 0, which keeps the component's default
+		if (packed.BlendRadius > 0.0f)
+			object->SetBlendRadius(packed.BlendRadius);
+		const CPU::PackedRepetition repetition = file.GetRepetition(i);
+		object->SetRepetition(static_cast<int>(repetition.Mode), ToVector3(repetition.Spacing), ToVector3(repetition.Limit), repetition.Variation);
+
+		auto* material = go->AddComponent<MaterialComponent>();
+		material->SetColour(ToVector3(packed.Colour));
+		material->SetMetalicness(packed.Metalicness);
+		material->SetRoughness(packed.Roughness);
+
+		gameObjects.push_back(go);
+	}
+
+	// Parented once every object is at its world transform, which parenting keeps. Cycles are refused and stay roots.
+	for (size_t i = 0; i < objectTransforms.size(); ++i)
+		if (const int parent = file.GetParent(i); parent != -1)
+			objectTransforms[i]->SetParentTransform(objectTransforms[parent]);
+
+	const auto lights = file.GetLights();
+	for (size_t i = 0; i < lights.size(); ++i)
+	{
+		const CPU::PackedLight& packed = lights[i];
+		const std::string_view name = file.GetLightName(i);
+		auto* go = GameObject::Create(name.empty() ? "Ray Marched Light" : std::string(name));
+		go->GetComponent<TransformComponent>()->SetPosition(ToVector3(packed.Position));
+
+		auto* light = go->AddComponent<RayMarchLightComponent>();
+		light->SetColour(ToVector3(packed.Colour));
+		light->SetShadowSharpness(packed.ShadowSharpness);
+		light->SetAttenuation(packed.ConstantAttenuation, packed.LinearAttenuation, packed.QuadraticAttenuation);
+
+		gameObjects.push_back(go);
+	}
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <filesystem>
+#include <vector>
+
+#include "Game/GameObject.h"
+
+// Saves and loads the editor scene through the binary scene format in CPU/SceneFile.h
+namespace SceneSerialisation
+{
+	// Writes every ray marched object and light, the camera, render settings and SDF library.
+	// Throws std::runtime_error if the file can't be written.
+	void Save(const std::filesystem::path& path, const std::vector<GameObject*>& gameObjects);
+
+	// Replaces the ray marched objects and lights in gameObjects with those in the file and applies
+	// its camera, render settings and SDF library. Throws std::runtime_error if the file is invalid,
+	// in which case the scene is left untouched.
+	void Load(const std::filesystem::path& path, std::vector<GameObject*>& gameObjects);
+}
@@ -0,0 +1,62 @@
+#include "pch.h"
+#include "Rendering/GPUCounterBuffer.h"
+
+#include <cstring>
+
+GPUCounterBuffer::GPUCounterBuffer(const int numCounters)
+	: Values(numCounters, 0u)
+{
+	const auto device = DX::DeviceResources::Instance()->GetD3DDevice();
+
+	D3D11_BUFFER_DESC bd = {};
+	bd.Usage = D3D11_USAGE_DEFAULT;
+	bd.ByteWidth = sizeof(uint32_t) * numCounters;
+	bd.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+	bd.CPUAccessFlags = 0;
+	bd.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+	DX::ThrowIfFailed(device->CreateBuffer(&bd, nullptr, CounterBuffer.ReleaseAndGetAddressOf()));
+
+	D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+	uavDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+	uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+	uavDesc.Buffer.FirstElement = 0;
+	uavDesc.Buffer.NumElements = numCounters;
+	uavDesc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_RAW;
+	DX::ThrowIfFailed(device->CreateUnorderedAccessView(CounterBuffer.Get(), &uavDesc, CounterUAV.ReleaseAndGetAddressOf()));
+
+	bd.Usage = D3D11_USAGE_STAGING;
+	bd.BindFlags = 0;
+	bd.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+	bd.MiscFlags = 0;
+	for (auto& staging : StagingBuffers)
+		DX::ThrowIfFailed(device->CreateBuffer(&bd, nullptr, staging.ReleaseAndGetAddressOf()));
+}
+
+void GPUCounterBuffer::Clear()
+{
+	const auto context = DX::DeviceResources::Instance()->GetD3DDeviceContext();
+
+	static constexpr UINT zero[4] = { 0u, 0u, 0u, 0u };
+	context->ClearUnorderedAccessViewUint(CounterUAV.Get(), zero);
+}
+
+void GPUCounterBuffer::Readback()
+{
+	const auto context = DX::DeviceResources::Instance()->GetD3DDeviceContext();
+
+	context->CopyResource(StagingBuffers[FrameIndex].Get(), CounterBuffer.Get());
+	Pending[FrameIndex] = true;
+
+	// Collect the oldest copy in flight if the GPU has finished with it
+	FrameIndex = (FrameIndex + 1) % FrameLatency;
+	if (!Pending[FrameIndex])
+		return;
+
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	if (context->Map(StagingBuffers[FrameIndex].Get(), 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped) != S_OK)
+		return;
+
+	std::memcpy(Values.data(), mapped.pData, Values.size() * sizeof(uint32_t));
+	context->Unmap(StagingBuffers[FrameIndex].Get(), 0);
+	Pending[FrameIndex] = false;
+}
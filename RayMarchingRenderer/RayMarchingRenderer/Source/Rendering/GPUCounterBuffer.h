@@ -0,0 +1,36 @@
+#pragma once
+#include <array>
+#include <vector>
+
+// Raw UAV buffer of uint counters incremented by shaders with InterlockedAdd.
+// Values are copied to a ring of staging buffers and read back a few frames
+// later so the CPU never waits on the GPU.
+class GPUCounterBuffer
+{
+public:
+	GPUCounterBuffer(int numCounters);
+	GPUCounterBuffer(const GPUCounterBuffer&) = delete;
+	GPUCounterBuffer(GPUCounterBuffer&&) = default;
+	GPUCounterBuffer& operator=(const GPUCounterBuffer&) = delete;
+	GPUCounterBuffer& operator=(GPUCounterBuffer&&) = default;
+	~GPUCounterBuffer() = default;
+
+	// Zero all counters, call before the passes that write them
+	void Clear();
+	// Queue a copy of this frame's counters and collect the oldest completed copy
+	void Readback();
+
+	[[nodiscard]] ID3D11UnorderedAccessView* GetUAV() const { return CounterUAV.Get(); }
+	[[nodiscard]] const std::vector<uint32_t>& GetValues() const { return Values; }
+
+private:
+	static constexpr int FrameLatency = 3;
+
+	Microsoft::WRL::ComPtr<ID3D11Buffer> CounterBuffer{};
+	Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> CounterUAV{};
+	std::array<Microsoft::WRL::ComPtr<ID3D11Buffer>, FrameLatency> StagingBuffers{};
+	std::array<bool, FrameLatency> Pending{};
+	int FrameIndex{ 0 };
+
+	std::vector<uint32_t> Values{};
+};
@@ -0,0 +1,78 @@
+#include "pch.h"
+#include "Rendering/GPUTimer.h"
+
+GPUTimer::GPUTimer(const int numTimestamps)
+	: ResolvedMs(numTimestamps, 0.0f)
+{
+	const auto device = DX::DeviceResources::Instance()->GetD3DDevice();
+
+	D3D11_QUERY_DESC disjointDesc = {};
+	disjointDesc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+	D3D11_QUERY_DESC timestampDesc = {};
+	timestampDesc.Query = D3D11_QUERY_TIMESTAMP;
+
+	for (auto& frame : Frames)
+	{
+		DX::ThrowIfFailed(device->CreateQuery(&disjointDesc, frame.Disjoint.ReleaseAndGetAddressOf()));
+
+		frame.Timestamps.resize(numTimestamps);
+		for (auto& timestamp : frame.Timestamps)
+			DX::ThrowIfFailed(device->CreateQuery(&timestampDesc, timestamp.ReleaseAndGetAddressOf()));
+	}
+}
+
+void GPUTimer::Begin()
+{
+	const auto context = DX::DeviceResources::Instance()->GetD3DDeviceContext();
+
+	// Results of this slot's previous frame are dropped if they never arrived
+	FrameQueries& frame = Frames[FrameIndex];
+	context->Begin(frame.Disjoint.Get());
+	context->End(frame.Timestamps[0].Get());
+}
+
+void GPUTimer::Timestamp(const int index)
+{
+	const auto context = DX::DeviceResources::Instance()->GetD3DDeviceContext();
+	context->End(Frames[FrameIndex].Timestamps[index].Get());
+}
+
+void GPUTimer::End()
+{
+	const auto context = DX::DeviceResources::Instance()->GetD3DDeviceContext();
+
+	FrameQueries& frame = Frames[FrameIndex];
+	context->End(frame.Disjoint.Get());
+	frame.Pending = true;
+
+	// Resolve the oldest frame in flight
+	FrameIndex = (FrameIndex + 1) % FrameLatency;
+	if (Frames[FrameIndex].Pending)
+		Resolve(Frames[FrameIndex]);
+}
+
+void GPUTimer::Resolve(FrameQueries& frame)
+{
+	const auto context = DX::DeviceResources::Instance()->GetD3DDeviceContext();
+
+	D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint = {};
+	if (context->GetData(frame.Disjoint.Get(), &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+		return;
+	frame.Pending = false;
+
+	if (disjoint.Disjoint || disjoint.Frequency == 0)
+		return;
+
+	std::vector<UINT64> ticks(frame.Timestamps.size(), 0);
+	for (size_t i = 0; i < ticks.size(); ++i)
+		if (context->GetData(frame.Timestamps[i].Get(), &ticks[i], sizeof(UINT64), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+			return;
+
+	for (size_t i = 0; i < ticks.size(); ++i)
+		ResolvedMs[i] = static_cast<float>(static_cast<double>(ticks[i] - ticks[0]) / static_cast<double>(disjoint.Frequency) * 1000.0);
+}
+
+float GPUTimer::GetMilliseconds(const int begin, const int end) const
+{
+	return ResolvedMs[end] - ResolvedMs[begin];
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <array>
+#include <vector>
+
+// Measures GPU time between timestamps recorded on the immediate context.
+// Results are read back a few frames later so the CPU never waits on the GPU.
+class GPUTimer
+{
+public:
+	GPUTimer(int numTimestamps);
+	GPUTimer(const GPUTimer&) = delete;
+	GPUTimer(GPUTimer&&) = default;
+	GPUTimer& operator=(const GPUTimer&) = delete;
+	GPUTimer& operator=(GPUTimer&&) = default;
+	~GPUTimer() = default;
+
+	// Starts a frame and records timestamp 0
+	void Begin();
+	void Timestamp(int index);
+	void End();
+
+	// Time between two timestamps of the most recently resolved frame
+	[[nodiscard]] float GetMilliseconds(int begin, int end) const;
+
+private:
+	static constexpr int FrameLatency = 3;
+
+	struct FrameQueries
+	{
+		Microsoft::WRL::ComPtr<ID3D11Query> Disjoint{};
+		std::vector<Microsoft::WRL::ComPtr<ID3D11Query>> Timestamps{};
+		bool Pending{ false };
+	};
+
+	void Resolve(FrameQueries& frame);
+
+	std::array<FrameQueries, FrameLatency> Frames{};
+	int FrameIndex{ 0 };
+
+	std::vector<float> ResolvedMs{};
+};
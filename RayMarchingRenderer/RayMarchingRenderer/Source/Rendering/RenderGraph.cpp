@@ -0,0 +1,227 @@
+#include "Rendering/RenderGraph.h"
+
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+
+RenderGraphResource RenderGraphBuilder::Create(const std::string& name, const RenderGraphTextureDesc& desc)
+{
+	const RenderGraphResource resource = Graph.FindOrAddResource(name);
+	RenderGraph::Resource& entry = Graph.Resources[resource];
+	if (entry.Producer >= 0)
+		throw std::runtime_error("Render graph texture \"" + name + "\" is created by both \"" +
+		                         Graph.Passes[entry.Producer].Name + "\" and \"" + Graph.Passes[Pass].Name + "\"");
+
+	entry.Desc = desc;
+	entry.Producer = Pass;
+	Graph.Passes[Pass].Creates.push_back(resource);
+	return resource;
+}
+
+RenderGraphResource RenderGraphBuilder::Read(const std::string& name)
+{
+	const RenderGraphResource resource = Graph.FindOrAddResource(name);
+	Graph.Passes[Pass].Reads.push_back(resource);
+	return resource;
+}
+
+void RenderGraph::Clear()
+{
+	Passes.clear();
+	Resources.clear();
+	ResourceIndices.clear();
+	ExecutionOrder.clear();
+	PhysicalDescs.clear();
+	Compiled = false;
+}
+
+int RenderGraph::AddPass(const std::string& name, const SetupFunction& setup, ExecuteFunction execute)
+{
+	const int pass = static_cast<int>(Passes.size());
+	Passes.push_back({ name, std::move(execute) });
+	Compiled = false;
+
+	RenderGraphBuilder builder(*this, pass);
+	setup(builder);
+
+	return pass;
+}
+
+void RenderGraph::MarkOutput(const std::string& name)
+{
+	Resources[FindOrAddResource(name)].Output = true;
+	Compiled = false;
+}
+
+void RenderGraph::Compile()
+{
+	for (const Resource& resource : Resources)
+		if (resource.Producer < 0)
+			throw std::runtime_error("Render graph texture \"" + resource.Name + "\" is used but never created");
+
+	CullPasses();
+	SortPasses();
+	AssignPhysicalSlots();
+
+	Compiled = true;
+}
+
+void RenderGraph::Execute() const
+{
+	for (const int pass : ExecutionOrder)
+		if (Passes[pass].Execute)
+			Passes[pass].Execute();
+}
+
+RenderGraphResource RenderGraph::Find(const std::string& name) const
+{
+	const auto it = ResourceIndices.find(name);
+	return it != ResourceIndices.end() ? it->second : InvalidRenderGraphResource;
+}
+
+RenderGraphResource RenderGraph::FindOrAddResource(const std::string& name)
+{
+	const RenderGraphResource existing = Find(name);
+	if (existing != InvalidRenderGraphResource)
+		return existing;
+
+	const auto resource = static_cast<RenderGraphResource>(Resources.size());
+	Resources.push_back({ name });
+	ResourceIndices.emplace(name, resource);
+	return resource;
+}
+
+void RenderGraph::CullPasses()
+{
+	// Walk back from the outputs, everything not reached contributes nothing to the frame
+	for (Pass& pass : Passes)
+		pass.Culled = true;
+
+	std::vector<int> stack{};
+	for (const Resource& resource : Resources)
+		if (resource.Output)
+			stack.push_back(resource.Producer);
+
+	while (!stack.empty())
+	{
+		Pass& pass = Passes[stack.back()];
+		stack.pop_back();
+		if (!pass.Culled)
+			continue;
+
+		pass.Culled = false;
+		for (const RenderGraphResource read : pass.Reads)
+			stack.push_back(Resources[read].Producer);
+	}
+}
+
+void RenderGraph::SortPasses()
+{
+	// Kahn's algorithm, preferring the earliest added pass so independent passes keep their declaration order
+	std::vector<int> dependencyCount(Passes.size(), 0);
+	std::vector<std::vector<int>> dependents(Passes.size());
+	for (int i = 0; i < static_cast<int>(Passes.size()); ++i)
+	{
+		if (Passes[i].Culled)
+			continue;
+
+		for (const RenderGraphResource read : Passes[i].Reads)
+		{
+			const int producer = Resources[read].Producer;
+			if (producer == i)
+				continue;
+
+			dependents[producer].push_back(i);
+			++dependencyCount[i];
+		}
+	}
+
+	std::priority_queue<int, std::vector<int>, std::greater<>> ready{};
+	int livePasses = 0;
+	for (int i = 0; i < static_cast<int>(Passes.size()); ++i)
+	{
+		if (Passes[i].Culled)
+			continue;
+
+		++livePasses;
+		if (dependencyCount[i] == 0)
+			ready.push(i);
+	}
+
+	ExecutionOrder.clear();
+	while (!ready.empty())
+	{
+		const int pass = ready.top();
+		ready.pop();
+		ExecutionOrder.push_back(pass);
+
+		for (const int dependent : dependents[pass])
+			if (--dependencyCount[dependent] == 0)
+				ready.push(dependent);
+	}
+
+	if (static_cast<int>(ExecutionOrder.size()) != livePasses)
+		throw std::runtime_error("Render graph passes form a dependency cycle");
+}
+
+void RenderGraph::AssignPhysicalSlots()
+{
+	// Lifetime of each texture as positions in the execution order
+	for (Resource& resource : Resources)
+	{
+		resource.FirstUse = -1;
+		resource.LastUse = -1;
+		resource.Physical = -1;
+	}
+
+	for (int position = 0; position < static_cast<int>(ExecutionOrder.size()); ++position)
+	{
+		const Pass& pass = Passes[ExecutionOrder[position]];
+		for (const RenderGraphResource created : pass.Creates)
+			Resources[created].FirstUse = Resources[created].LastUse = position;
+		for (const RenderGraphResource read : pass.Reads)
+			Resources[read].LastUse = std::max(Resources[read].LastUse, position);
+	}
+
+	const int endOfFrame = static_cast<int>(ExecutionOrder.size());
+	for (Resource& resource : Resources)
+		if (resource.Output && resource.FirstUse >= 0)
+			resource.LastUse = endOfFrame;
+
+	// Greedy interval assignment: a slot is reused once the last reader of its current texture has run
+	std::vector<int> order(Resources.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [this](const int a, const int b)
+	{
+		return Resources[a].FirstUse < Resources[b].FirstUse;
+	});
+
+	PhysicalDescs.clear();
+	std::vector<int> slotFreeAfter{};
+	for (const int index : order)
+	{
+		Resource& resource = Resources[index];
+		if (resource.FirstUse < 0)
+			continue;
+
+		for (int slot = 0; slot < static_cast<int>(PhysicalDescs.size()); ++slot)
+		{
+			if (slotFreeAfter[slot] < resource.FirstUse && PhysicalDescs[slot] == resource.Desc)
+			{
+				resource.Physical = slot;
+				break;
+			}
+		}
+
+		if (resource.Physical < 0)
+		{
+			resource.Physical = static_cast<int>(PhysicalDescs.size());
+			PhysicalDescs.push_back(resource.Desc);
+			slotFreeAfter.push_back(-1);
+		}
+
+		slotFreeAfter[resource.Physical] = resource.LastUse;
+	}
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Backend independent texture description. Format and flags are opaque to the
+// graph (DXGI_FORMAT and D3D11_BIND_* values on D3D11) and only compared when
+// deciding whether two transient textures can share memory.
+struct RenderGraphTextureDesc
+{
+	uint32_t Width{ 1u };
+	uint32_t Height{ 1u };
+	uint32_t Format{ 0u };
+	uint32_t BindFlags{ 0u };
+	uint32_t MipLevels{ 1u }; // 0 for a full mip chain
+	uint32_t MiscFlags{ 0u };
+
+	[[nodiscard]] bool operator==(const RenderGraphTextureDesc&) const = default;
+};
+
+// Index of a texture declared in a RenderGraph
+using RenderGraphResource = int;
+inline constexpr RenderGraphResource InvalidRenderGraphResource = -1;
+
+class RenderGraph;
+
+// Handed to a pass's setup callback to declare the textures it creates and reads
+class RenderGraphBuilder
+{
+public:
+	// Declares a texture written by this pass. Each name has exactly one producer.
+	RenderGraphResource Create(const std::string& name, const RenderGraphTextureDesc& desc);
+	// Declares a texture read by this pass. Its producer may be added later.
+	RenderGraphResource Read(const std::string& name);
+
+private:
+	friend class RenderGraph;
+
+	RenderGraphBuilder(RenderGraph& graph, int pass) : Graph(graph), Pass(pass) {}
+
+	RenderGraph& Graph;
+	int Pass;
+};
+
+// Frame graph of passes connected by named textures. Compile() orders passes by
+// their dependencies, culls passes that do not contribute to an output, and
+// assigns textures to physical slots so that textures whose lifetimes do not
+// overlap share memory. Backends (RenderGraphTargets on D3D11,
+// CPU::RenderGraphImages on the CPU) allocate one texture per physical slot.
+class RenderGraph
+{
+public:
+	using SetupFunction = std::function<void(RenderGraphBuilder&)>;
+	using ExecuteFunction = std::function<void()>;
+
+	struct Pass
+	{
+		std::string Name{};
+		ExecuteFunction Execute{};
+		std::vector<RenderGraphResource> Creates{};
+		std::vector<RenderGraphResource> Reads{};
+		bool Culled{ false };
+	};
+
+	struct Resource
+	{
+		std::string Name{};
+		RenderGraphTextureDesc Desc{};
+		int Producer{ -1 };
+		bool Output{ false };
+
+		// Positions in the execution order of the producer and last reader, -1 when culled
+		int FirstUse{ -1 };
+		int LastUse{ -1 };
+		int Physical{ -1 };
+	};
+
+	// Removes all passes and textures
+	void Clear();
+
+	// Adds a pass, calling setup immediately to record its declarations
+	int AddPass(const std::string& name, const SetupFunction& setup, ExecuteFunction execute);
+
+	// Marks a texture as a result of the graph. Outputs live until the end of the frame.
+	void MarkOutput(const std::string& name);
+
+	// Throws std::runtime_error if a texture is read but never created, or passes form a cycle
+	void Compile();
+
+	// Runs every pass that survived culling, in execution order
+	void Execute() const;
+
+	[[nodiscard]] RenderGraphResource Find(const std::string& name) const;
+	[[nodiscard]] bool IsCompiled() const { return Compiled; }
+
+	[[nodiscard]] const std::vector<Pass>& GetPasses() const { return Passes; }
+	[[nodiscard]] const std::vector<Resource>& GetResources() const { return Resources; }
+	[[nodiscard]] const std::vector<int>& GetExecutionOrder() const { return ExecutionOrder; }
+
+	// Physical slot backing a texture, -1 if its producer was culled
+	[[nodiscard]] int GetPhysicalIndex(const RenderGraphResource resource) const { return Resources[resource].Physical; }
+	[[nodiscard]] const std::vector<RenderGraphTextureDesc>& GetPhysicalDescs() const { return PhysicalDescs; }
+
+private:
+	friend class RenderGraphBuilder;
+
+	RenderGraphResource FindOrAddResource(const std::string& name);
+
+	void CullPasses();
+	void SortPasses();
+	void AssignPhysicalSlots();
+
+	std::vector<Pass> Passes{};
+	std::vector<Resource> Resources{};
+	std::unordered_map<std::string, RenderGraphResource> ResourceIndices{};
+	std::vector<int> ExecutionOrder{};
+	std::vector<RenderGraphTextureDesc> PhysicalDescs{};
+	bool Compiled{ false };
+};
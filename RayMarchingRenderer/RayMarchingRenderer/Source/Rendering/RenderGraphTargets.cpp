@@ -0,0 +1,68 @@
+#include "pch.h"
+#include "Rendering/RenderGraphTargets.h"
+
+void RenderGraphTargets::Realise(const RenderGraph& graph)
+{
+	Graph = &graph;
+
+	const auto& descs = graph.GetPhysicalDescs();
+	Targets.resize(descs.size());
+	for (size_t i = 0; i < descs.size(); ++i)
+		RenderTargetPool::Instance()->Fit(Targets[i], ToRenderTargetDesc(descs[i]));
+}
+
+const RenderTarget& RenderGraphTargets::Get(const RenderGraphResource resource) const
+{
+	return *Targets[Graph->GetPhysicalIndex(resource)];
+}
+
+const RenderTarget& RenderGraphTargets::Get(const std::string& name) const
+{
+	return Get(Graph->Find(name));
+}
+
+size_t RenderGraphTargets::GetAllocatedBytes() const
+{
+	size_t bytes = 0u;
+	for (const auto& target : Targets)
+		bytes += target->GetSizeInBytes();
+	return bytes;
+}
+
+size_t RenderGraphTargets::GetUnaliasedBytes() const
+{
+	// Compared at bucket size, as the pool would have allocated them
+	size_t bytes = 0u;
+	for (const auto& resource : Graph->GetResources())
+	{
+		if (resource.Physical < 0)
+			continue;
+
+		bytes += RenderTarget::CalculateSizeInBytes(RenderTargetPool::GetBucketDesc(ToRenderTargetDesc(resource.Desc)));
+	}
+	return bytes;
+}
+
+RenderTargetDesc RenderGraphTargets::ToRenderTargetDesc(const RenderGraphTextureDesc& desc)
+{
+	RenderTargetDesc result{};
+	result.Width = desc.Width;
+	result.Height = desc.Height;
+	result.Format = static_cast<DXGI_FORMAT>(desc.Format);
+	result.BindFlags = desc.BindFlags;
+	result.MipLevels = desc.MipLevels;
+	result.MiscFlags = desc.MiscFlags;
+	return result;
+}
+
+RenderGraphTextureDesc RenderGraphTargets::ToTextureDesc(const RenderTargetDesc& desc)
+{
+	RenderGraphTextureDesc result{};
+	result.Width = desc.Width;
+	result.Height = desc.Height;
+	result.Format = static_cast<uint32_t>(desc.Format);
+	result.BindFlags = desc.BindFlags;
+	result.MipLevels = desc.MipLevels;
+	result.MiscFlags = desc.MiscFlags;
+	return result;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include "Rendering/RenderGraph.h"
+#include "Rendering/RenderTargetPool.h"
+
+// D3D11 backend of a compiled RenderGraph. Each physical slot is backed by one
+// pooled render target, so textures the graph aliases share a single allocation.
+class RenderGraphTargets
+{
+public:
+	// Fits a pooled target to every physical slot of graph
+	void Realise(const RenderGraph& graph);
+
+	// Target backing a texture of the realised graph
+	[[nodiscard]] const RenderTarget& Get(RenderGraphResource resource) const;
+	[[nodiscard]] const RenderTarget& Get(const std::string& name) const;
+
+	// Memory used by the physical slots, and what one target per texture would have used
+	[[nodiscard]] size_t GetAllocatedBytes() const;
+	[[nodiscard]] size_t GetUnaliasedBytes() const;
+
+	[[nodiscard]] static RenderTargetDesc ToRenderTargetDesc(const RenderGraphTextureDesc& desc);
+	[[nodiscard]] static RenderGraphTextureDesc ToTextureDesc(const RenderTargetDesc& desc);
+
+private:
+	const RenderGraph* Graph{ nullptr };
+	std::vector<std::shared_ptr<RenderTarget>> Targets{};
+};
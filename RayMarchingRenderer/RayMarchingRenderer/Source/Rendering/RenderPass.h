@@ -1,4 +1,8 @@
 #pragma once
+#include "Rendering/RenderGraph.h"
+
+class RenderGraphTargets;
+
 class RenderPass
 {
 public:
@@ -9,7 +13,22 @@ public:
 	RenderPass& operator=(RenderPass&&) = default;
 	virtual ~RenderPass() = default;
 
+	// Creates size independent resources such as shaders and states, called once
 	virtual void Initialise() = 0;
-	virtual void Render() = 0;
+	// Declares the textures this pass creates and reads, called whenever the render graph is rebuilt. Must not compile shaders.
+	virtual void Setup(RenderGraphBuilder& builder) = 0;
+	virtual void Render(const RenderGraphTargets& targets) = 0;
 	virtual void RenderGUI() = 0;
+
+	[[nodiscard]] virtual const char* GetName() const = 0;
+
+	// Set when a setting used by Setup changes, so the owner rebuilds the graph
+	[[nodiscard]] bool IsGraphDirty() const { return GraphDirty; }
+	void ClearGraphDirty() { GraphDirty = false; }
+
+protected:
+	void MarkGraphDirty() { GraphDirty = true; }
+
+private:
+	bool GraphDirty{ false };
 };
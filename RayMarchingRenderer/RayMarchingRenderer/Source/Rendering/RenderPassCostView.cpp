@@ -0,0 +1,359 @@
+#include "pch.h"
+#include "Rendering/RenderPassCostView.h"
+
+#include "Game/GameObject.h"
+#include "Game/Components/RayMarchingManagerComponent.h"
+#include "Game/Components/RayMarchLightComponent.h"
+#include "Game/Components/RayMarchObjectComponent.h"
+#include "Game/Components/SDFManagerComponent.h"
+#include "Rendering/RenderGraphTargets.h"
+#include "Rendering/RenderPassDefault.h"
+#include "Rendering/RenderPassReflectionTrace.h"
+
+RenderPassCostView::RenderPassCostView(std::vector<GameObject*>& gameObjects, const RenderPassDefault& gbuffer, const RenderPassReflectionTrace& reflectionTrace)
+	: GameObjects(gameObjects),
+	  GBuffer(gbuffer),
+	  ReflectionTrace(reflectionTrace)
+{
+	const auto device = DX::DeviceResources::Instance()->GetD3DDevice();
+
+	D3D11_BUFFER_DESC bd = {};
+	bd.Usage = D3D11_USAGE_DEFAULT;
+	bd.ByteWidth = sizeof(CostViewSettings);
+	bd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	bd.CPUAccessFlags = 0;
+	DX::ThrowIfFailed(device->CreateBuffer(&bd, nullptr, SettingsConstantBuffer.ReleaseAndGetAddressOf()));
+
+	Histograms = CreateHistograms();
+	PlotValues.resize(HistogramBins);
+}
+
+void RenderPassCostView::Initialise()
+{
+	const auto device = DX::DeviceResources::Instance()->GetD3DDevice();
+
+	ID3DBlob* csBlob = nullptr;
+	DX::ThrowIfFailed(DX::CompileShaderFromFile(L"Source/Rendering/Shaders/CostHeatmapShader.hlsl", "main", "cs_5_0", &csBlob));
+	DX::ThrowIfFailed(device->CreateComputeShader(csBlob->GetBufferPointer(), csBlob->GetBufferSize(), nullptr, ComputeShader.ReleaseAndGetAddressOf()));
+	csBlob->Release();
+}
+
+void RenderPassCostView::Setup(RenderGraphBuilder& builder)
+{
+	const auto outputSize = DX::DeviceResources::Instance()->GetViewportSize();
+
+	// Counters only exist when compiled in, otherwise the heatmap is left black
+	const bool enabled = RayMarchingManagerComponent::GetCostCountersEnabled();
+	PrimaryCost = enabled ? builder.Read("Cost.Primary") : InvalidRenderGraphResource;
+	ShadowCost = enabled ? builder.Read("Cost.Shadow") : InvalidRenderGraphResource;
+	ReflectionCost = enabled ? builder.Read("Cost.Reflection") : InvalidRenderGraphResource;
+
+	RenderTargetDesc desc{};
+	desc.Width = outputSize.right;
+	desc.Height = outputSize.bottom;
+	desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+	HeatmapTarget = builder.Create("Debug.CostHeatmap", RenderGraphTargets::ToTextureDesc(desc));
+}
+
+void RenderPassCostView::Render(const RenderGraphTargets& targets)
+{
+	const auto context = DX::DeviceResources::Instance()->GetD3DDeviceContext();
+	const auto outputSize = DX::DeviceResources::Instance()->GetViewportSize();
+	const RenderTarget& heatmap = targets.Get(HeatmapTarget);
+
+	if (PrimaryCost == InvalidRenderGraphResource)
+	{
+		static constexpr float black[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		context->ClearUnorderedAccessViewFloat(heatmap.GetUAV(), black);
+		return;
+	}
+
+	const CPU::CostHistograms layout = CreateHistograms();
+	const CPU::CostHistogram& shown = Histograms.Metrics[Metric];
+	if (AutoRange)
+		HeatmapMax = static_cast<float>(std::max(1u, shown.GetPercentile(0.99)));
+
+	CostViewSettings settings{};
+	settings.Resolution[0] = outputSize.right;
+	settings.Resolution[1] = outputSize.bottom;
+	settings.ReflectionScale = ReflectionTrace.GetScale();
+	settings.Metric = static_cast<unsigned int>(Metric);
+	settings.HeatmapMax = HeatmapMax;
+	for (int i = 0; i < CPU::CostMetricCount; ++i)
+		settings.BinWidths[i] = layout.Metrics[i].BinWidth;
+	context->UpdateSubresource(SettingsConstantBuffer.Get(), 0, nullptr, &settings, 0, 0);
+	context->CSSetConstantBuffers(4, 1, SettingsConstantBuffer.GetAddressOf());
+
+	HistogramCounters.Clear();
+
+	ID3D11ShaderResourceView* const srvs[3] = {
+		targets.Get(PrimaryCost).GetSRV(),
+		targets.Get(ShadowCost).GetSRV(),
+		targets.Get(ReflectionCost).GetSRV()
+	};
+	ID3D11UnorderedAccessView* const uavs[2] = { heatmap.GetUAV(), HistogramCounters.GetUAV() };
+	context->CSSetShaderResources(0, 3, srvs);
+	context->CSSetUnorderedAccessViews(0, 2, uavs, nullptr);
+	context->CSSetShader(ComputeShader.Get(), nullptr, 0);
+	context->Dispatch((outputSize.right + 7) / 8, (outputSize.bottom + 7) / 8, 1);
+
+	static constexpr ID3D11ShaderResourceView* nullSrvs[3] = { nullptr, nullptr, nullptr };
+	static constexpr ID3D11UnorderedAccessView* nullUavs[2] = { nullptr, nullptr };
+	context->CSSetShaderResources(0, 3, nullSrvs);
+	context->CSSetUnorderedAccessViews(0, 2, nullUavs, nullptr);
+
+	HistogramCounters.Readback();
+	ReadHistograms();
+}
+
+CPU::CostHistograms RenderPassCostView::CreateHistograms() const
+{
+	const auto manager = GameObject::FindComponents<RayMarchingManagerComponent>(GameObjects);
+	const uint32_t maxSteps = manager.empty() ? CPU::PackedRenderSettings{}.MaxSteps : manager[0]->GetSceneRenderSettings().MaxSteps;
+	const int lightCount = std::min(static_cast<int>(GameObject::FindComponents<RayMarchLightComponent>(GameObjects).size()), CPU::MaxCostLights);
+	return CPU::CreateCostHistograms(maxSteps, lightCount, HistogramBins);
+}
+
+void RenderPassCostView::ReadHistograms()
+{
+	// Readback lags a few frames, so bins may briefly use the previous widths after Max Steps changes
+	Histograms = CreateHistograms();
+
+	const std::vector<uint32_t>& values = HistogramCounters.GetValues();
+	const size_t sums = static_cast<size_t>(CPU::CostMetricCount) * HistogramBins;
+	const size_t maxima = sums + CPU::CostMetricCount * 2u;
+	for (int i = 0; i < CPU::CostMetricCount; ++i)
+	{
+		CPU::CostHistogram& histogram = Histograms.Metrics[i];
+		histogram.Bins.assign(HistogramBins, 0u);
+		for (int bin = 0; bin < HistogramBins; ++bin)
+		{
+			histogram.Bins[bin] = values[static_cast<size_t>(i) * HistogramBins + bin];
+			histogram.Count += histogram.Bins[bin];
+		}
+
+		histogram.Sum = static_cast<uint64_t>(values[sums + i * 2u]) | static_cast<uint64_t>(values[sums + i * 2u + 1u]) << 32u;
+		histogram.Max = values[maxima + i];
+	}
+
+	const CPU::RenderMetrics& metrics = CPU::GetRenderMetrics();
+	CPU::GetMetrics().Set(metrics.StepsPerPixel, Histograms.Metrics[static_cast<int>(CPU::CostMetric::PrimarySteps)].GetMean());
+	CPU::GetMetrics().Set(metrics.ShadowStepsPerPixel, Histograms.Metrics[static_cast<int>(CPU::CostMetric::ShadowSteps)].GetMean());
+}
+
+CPU::ObjectCostReport RenderPassCostView::CreateObjectCostReport() const
+{
+	const auto rmObjects = GameObject::FindComponents<RayMarchObjectComponent>(GameObjects);
+	const auto sdfManagers = GameObject::FindComponents<SDFManagerComponent>(GameObjects);
+	const size_t objectCount = std::min<size_t>(rmObjects.size(), RAYMARCH_MAX_OBJECTS);
+
+	// Every scene evaluation credits exactly one object, so the counts also add up to the scene evaluations
+	CPU::ObjectCostCounters counters{};
+	counters.Reset(objectCount);
+	for (const std::vector<uint32_t>* passCounts : { &GBuffer.GetObjectNearestCounts(), &ReflectionTrace.GetObjectNearestCounts() })
+	{
+		for (size_t i = 0; i < passCounts->size(); ++i)
+		{
+			counters.SceneEvaluations += (*passCounts)[i];
+			if (i < objectCount)
+				counters.Nearest[i] += (*passCounts)[i];
+		}
+	}
+
+	std::vector<CPU::ObjectCostSource> sources{};
+	for (size_t i = 0; i < objectCount; ++i)
+	{
+		const int sdfType = rmObjects[i]->GetSDFType();
+		CPU::ObjectCostSource source{};
+		source.Name = rmObjects[i]->Parent->GetName();
+		source.SDFType = sdfType;
+		if (!sdfManagers.empty() && !sdfManagers[0]->GetSDFLibrary().empty())
+		{
+			const auto& library = sdfManagers[0]->GetSDFLibrary();
+			source.TypeName = library[sdfType % library.size()].first;
+			source.UnitCost = static_cast<double>(sdfManagers[0]->EstimateSDFInstructionCount(sdfType));
+		}
+		sources.push_back(source);
+	}
+
+	return CPU::CreateObjectCostReport(counters, sources, "instructions");
+}
+
+void RenderPassCostView::RenderObjectCostsGUI()
+{
+	CPU::ObjectCostReport report = CreateObjectCostReport();
+	ImGui::Text("Scene evaluations: %llu, estimated %.3g snippet instructions", static_cast<unsigned long long>(report.SceneEvaluations), report.TotalCost);
+	ImGui::TextWrapped("Every object is evaluated at each scene evaluation. Nearest counts the evaluations an object supplied the distance for. "
+	                   "Instructions are static counts of the snippet, so loops count once.");
+
+	const double evaluations = static_cast<double>(std::max<uint64_t>(1u, report.SceneEvaluations));
+	constexpr ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_Sortable | ImGuiTableFlags_Resizable;
+
+	if (ImGui::BeginTable("Objects", 6, flags))
+	{
+		ImGui::TableSetupColumn("#", ImGuiTableColumnFlags_None, 0.0f, static_cast<ImGuiID>(CPU::ObjectCostColumn::Object));
+		ImGui::TableSetupColumn("Object", ImGuiTableColumnFlags_None, 0.0f, static_cast<ImGuiID>(CPU::ObjectCostColumn::Name));
+		ImGui::TableSetupColumn("SDF", ImGuiTableColumnFlags_None, 0.0f, static_cast<ImGuiID>(CPU::ObjectCostColumn::Type));
+		ImGui::TableSetupColumn("Nearest", ImGuiTableColumnFlags_PreferSortDescending, 0.0f, static_cast<ImGuiID>(CPU::ObjectCostColumn::Nearest));
+		ImGui::TableSetupColumn("Instructions", ImGuiTableColumnFlags_PreferSortDescending, 0.0f, static_cast<ImGuiID>(CPU::ObjectCostColumn::UnitCost));
+		ImGui::TableSetupColumn("Cost", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending, 0.0f,
+		                        static_cast<ImGuiID>(CPU::ObjectCostColumn::EstimatedCost));
+		ImGui::TableHeadersRow();
+
+		// Counters change every frame, so sort every frame rather than only when the specs change
+		if (const ImGuiTableSortSpecs* specs = ImGui::TableGetSortSpecs(); specs && specs->SpecsCount > 0)
+			CPU::SortObjectCosts(report.Objects, static_cast<CPU::ObjectCostColumn>(specs->Specs[0].ColumnUserID),
+			                     specs->Specs[0].SortDirection == ImGuiSortDirection_Ascending);
+
+		for (const CPU::ObjectCostEntry& entry : report.Objects)
+		{
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::Text("%d", entry.Object);
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(entry.Name.c_str());
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(entry.TypeName.c_str());
+			ImGui::TableNextColumn();
+			ImGui::Text("%.1f%%", 100.0 * static_cast<double>(entry.Nearest) / evaluations);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.0f", entry.UnitCost);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.1f%%", entry.Share * 100.0);
+		}
+		ImGui::EndTable();
+	}
+
+	if (ImGui::BeginTable("SDF Types", 5, flags))
+	{
+		ImGui::TableSetupColumn("SDF", ImGuiTableColumnFlags_None, 0.0f, static_cast<ImGuiID>(CPU::ObjectCostColumn::Type));
+		ImGui::TableSetupColumn("Objects", ImGuiTableColumnFlags_NoSort);
+		ImGui::TableSetupColumn("Nearest", ImGuiTableColumnFlags_PreferSortDescending, 0.0f, static_cast<ImGuiID>(CPU::ObjectCostColumn::Nearest));
+		ImGui::TableSetupColumn("Instructions", ImGuiTableColumnFlags_NoSort);
+		ImGui::TableSetupColumn("Cost", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending, 0.0f,
+		                        static_cast<ImGuiID>(CPU::ObjectCostColumn::EstimatedCost));
+		ImGui::TableHeadersRow();
+
+		if (const ImGuiTableSortSpecs* specs = ImGui::TableGetSortSpecs(); specs && specs->SpecsCount > 0)
+			CPU::SortTypeCosts(report.Types, static_cast<CPU::ObjectCostColumn>(specs->Specs[0].ColumnUserID),
+			                   specs->Specs[0].SortDirection == ImGuiSortDirection_Ascending);
+
+		for (const CPU::TypeCostEntry& type : report.Types)
+		{
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(type.TypeName.c_str());
+			ImGui::TableNextColumn();
+			ImGui::Text("%d", type.Objects);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.1f%%", 100.0 * static_cast<double>(type.Nearest) / evaluations);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.0f", type.EstimatedCost / static_cast<double>(std::max<uint64_t>(1u, type.Evaluations)));
+			ImGui::TableNextColumn();
+			ImGui::Text("%.1f%%", type.Share * 100.0);
+		}
+		ImGui::EndTable();
+	}
+
+	if (ImGui::Button("Save Object Costs"))
+	{
+		try
+		{
+			CPU::WriteObjectCostsJson("object_costs.json", report);
+			ObjectSaveStatus = "Saved object_costs.json";
+		}
+		catch (const std::exception& e)
+		{
+			ObjectSaveStatus = e.what();
+		}
+	}
+	if (!ObjectSaveStatus.empty())
+		ImGui::TextWrapped("%s", ObjectSaveStatus.c_str());
+}
+
+void RenderPassCostView::RenderGUI()
+{
+	ImGui::Begin("Cost Counters");
+
+	bool enabled = RayMarchingManagerComponent::GetCostCountersEnabled();
+	if (ImGui::Checkbox("Enabled", &enabled))
+	{
+		RayMarchingManagerComponent::SetCostCountersEnabled(enabled);
+		MarkGraphDirty();
+	}
+
+	if (!enabled)
+	{
+		ImGui::TextWrapped("Compiles per-pixel counters into the scene shaders. Show them with the Cost Heatmap viewport output.");
+		ImGui::End();
+		return;
+	}
+
+	const char* labels[CPU::CostMetricCount] = {};
+	for (int i = 0; i < CPU::CostMetricCount; ++i)
+		labels[i] = CPU::GetCostMetricLabel(i);
+	ImGui::Combo("Heatmap", &Metric, labels, CPU::CostMetricCount);
+
+	ImGui::Checkbox("Auto Range (99th percentile)", &AutoRange);
+	if (!AutoRange)
+		ImGui::DragFloat("Heatmap Max", &HeatmapMax, 1.0f, 1.0f, 100000.0f);
+
+	// Histogram of the heatmap's counter
+	const CPU::CostHistogram& shown = Histograms.Metrics[Metric];
+	for (int bin = 0; bin < HistogramBins; ++bin)
+		PlotValues[bin] = bin < static_cast<int>(shown.Bins.size()) ? static_cast<float>(shown.Bins[bin]) : 0.0f;
+	ImGui::PlotHistogram("##Histogram", PlotValues.data(), HistogramBins, 0, nullptr, 0.0f, FLT_MAX, ImVec2(0.0f, 80.0f));
+	ImGui::Text("%u per bin, last bin holds the rest", shown.BinWidth);
+
+	// Summary of every counter, per pixel
+	if (ImGui::BeginTable("Counters", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+	{
+		ImGui::TableSetupColumn("Counter");
+		ImGui::TableSetupColumn("Mean");
+		ImGui::TableSetupColumn("p50");
+		ImGui::TableSetupColumn("p99");
+		ImGui::TableSetupColumn("Max");
+		ImGui::TableHeadersRow();
+
+		for (int i = 0; i < CPU::CostMetricCount; ++i)
+		{
+			const CPU::CostHistogram& histogram = Histograms.Metrics[i];
+			if (i >= static_cast<int>(CPU::CostMetric::LightShadowSteps) && histogram.Max == 0u)
+				continue;
+
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(labels[i]);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.2f", histogram.GetMean());
+			ImGui::TableNextColumn();
+			ImGui::Text("%u", histogram.GetPercentile(0.5));
+			ImGui::TableNextColumn();
+			ImGui::Text("%u", histogram.GetPercentile(0.99));
+			ImGui::TableNextColumn();
+			ImGui::Text("%u", histogram.Max);
+		}
+		ImGui::EndTable();
+	}
+
+	if (ImGui::Button("Save Histograms"))
+	{
+		try
+		{
+			CPU::WriteCostHistogramsJson("cost_histograms.json", Histograms);
+			SaveStatus = "Saved cost_histograms.json";
+		}
+		catch (const std::exception& e)
+		{
+			SaveStatus = e.what();
+		}
+	}
+	if (!SaveStatus.empty())
+		ImGui::TextWrapped("%s", SaveStatus.c_str());
+
+	if (ImGui::CollapsingHeader("Objects"))
+		RenderObjectCostsGUI();
+
+	ImGui::End();
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "Rendering/RenderPass.h"
+#include "Rendering/GPUCounterBuffer.h"
+#include "CPU/CostCounters.h"
+#include "CPU/ObjectCosts.h"
+
+class GameObject;
+class RenderPassDefault;
+class RenderPassReflectionTrace;
+
+// Per-pixel cost instrumentation. Owns the switch that compiles cost counters
+// into the scene shaders, and when they are on reads Cost.Primary, Cost.Shadow
+// and Cost.Reflection to publish Debug.CostHeatmap, a heatmap of one counter,
+// while gathering histograms of every counter. Also attributes the scene
+// distance cost to objects and SDF types from the per-object counters.
+class RenderPassCostView : public RenderPass
+{
+	struct CostViewSettings
+	{
+		unsigned int Resolution[2]{ 0u, 0u };
+		unsigned int ReflectionScale{ 1u };
+		unsigned int Metric{ 0u };
+		float HeatmapMax{ 1.0f };
+
+		unsigned int PADDING[3]{};
+
+		unsigned int BinWidths[16]{};
+	};
+	static_assert(CPU::CostMetricCount <= 16);
+
+public:
+	RenderPassCostView(std::vector<GameObject*>& gameObjects, const RenderPassDefault& gbuffer, const RenderPassReflectionTrace& reflectionTrace);
+	RenderPassCostView(const RenderPassCostView&) = delete;
+	RenderPassCostView(RenderPassCostView&&) = default;
+	RenderPassCostView& operator=(const RenderPassCostView&) = delete;
+	RenderPassCostView& operator=(RenderPassCostView&&) = delete;
+	~RenderPassCostView() override = default;
+
+	void Initialise() override;
+	void Setup(RenderGraphBuilder& builder) override;
+	void Render(const RenderGraphTargets& targets) override;
+	void RenderGUI() override;
+
+	[[nodiscard]] const char* GetName() const override { return "Cost Heatmap"; }
+
+	// Histograms of the most recent frame read back from the GPU
+	[[nodiscard]] const CPU::CostHistograms& GetHistograms() const { return Histograms; }
+
+	// Cost of each object in instructions of its snippet, from the most recent counters read back
+	[[nodiscard]] CPU::ObjectCostReport CreateObjectCostReport() const;
+
+private:
+	static constexpr int HistogramBins = 64;
+
+	// Bin ranges follow the current max steps and light count
+	[[nodiscard]] CPU::CostHistograms CreateHistograms() const;
+	void ReadHistograms();
+	void RenderObjectCostsGUI();
+
+	std::vector<GameObject*>& GameObjects;
+	const RenderPassDefault& GBuffer;
+	const RenderPassReflectionTrace& ReflectionTrace;
+
+	Microsoft::WRL::ComPtr<ID3D11ComputeShader> ComputeShader{ nullptr };
+	Microsoft::WRL::ComPtr<ID3D11Buffer> SettingsConstantBuffer{ nullptr };
+
+	RenderGraphResource PrimaryCost{ InvalidRenderGraphResource };
+	RenderGraphResource ShadowCost{ InvalidRenderGraphResource };
+	RenderGraphResource ReflectionCost{ InvalidRenderGraphResource };
+	RenderGraphResource HeatmapTarget{ InvalidRenderGraphResource };
+
+	// Bins per metric, then the 64 bit sum and the maximum of each metric, see CostHeatmapShader.hlsl
+	GPUCounterBuffer HistogramCounters{ CPU::CostMetricCount * (HistogramBins + 3) };
+	CPU::CostHistograms Histograms{};
+	std::vector<float> PlotValues{};
+
+	int Metric{ 0 };
+	bool AutoRange{ true };
+	float HeatmapMax{ 100.0f };
+	std::string SaveStatus{};
+	std::string ObjectSaveStatus{};
+};
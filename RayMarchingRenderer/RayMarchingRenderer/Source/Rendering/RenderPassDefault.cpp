@@ -3,72 +3,18 @@
 
 #include "Game/GameObject.h"
 #include "Game/Components/MaterialComponent.h"
+#include "Game/Components/RayMarchingManagerComponent.h"
 #include "Game/Components/RayMarchLightComponent.h"
 #include "Game/Components/RayMarchObjectComponent.h"
+#include "Rendering/RenderGraphTargets.h"
 
 RenderPassDefault::RenderPassDefault(std::vector<GameObject*>& gameObjects)
-	: GameObjects(gameObjects) {}
+	: GameObjects(gameObjects),
+	  ObjectCounters(RAYMARCH_MAX_OBJECTS) {}
 
 void RenderPassDefault::Initialise()
 {
 	const auto device = DX::DeviceResources::Instance()->GetD3DDevice();
-	const auto outputSize = DX::DeviceResources::Instance()->GetViewportSize();
-
-	// Create render textures
-	RenderTargetViews.clear();
-	Microsoft::WRL::ComPtr<ID3D11Texture2D> rtvTex;
-	D3D11_TEXTURE2D_DESC texDesc = {};
-	texDesc.Width = outputSize.right;
-	texDesc.Height = outputSize.bottom;
-	texDesc.MipLevels = 1;
-	texDesc.ArraySize = 1;
-	texDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-	texDesc.SampleDesc.Count = 1;
-	texDesc.Usage = D3D11_USAGE_DEFAULT;
-	texDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
-	texDesc.CPUAccessFlags = 0;
-	texDesc.MiscFlags = 0;
-	// Main RTV
-	DX::ThrowIfFailed(device->CreateTexture2D(&texDesc, nullptr, rtvTex.ReleaseAndGetAddressOf()));
-	RenderTargetViews.push_back(nullptr);
-	DX::ThrowIfFailed(device->CreateRenderTargetView(rtvTex.Get(), nullptr, RenderTargetViews[RenderTargetViews.size() - 1].ReleaseAndGetAddressOf()));
-	// Normal/Depth RTV
-	DX::ThrowIfFailed(device->CreateTexture2D(&texDesc, nullptr, rtvTex.ReleaseAndGetAddressOf()));
-	RenderTargetViews.push_back(nullptr);
-	DX::ThrowIfFailed(device->CreateRenderTargetView(rtvTex.Get(), nullptr, RenderTargetViews[RenderTargetViews.size() - 1].ReleaseAndGetAddressOf()));
-	// Reflection Colour and (unnormalised) Depth RTV
-	DX::ThrowIfFailed(device->CreateTexture2D(&texDesc, nullptr, rtvTex.ReleaseAndGetAddressOf()));
-	RenderTargetViews.push_back(nullptr);
-	DX::ThrowIfFailed(device->CreateRenderTargetView(rtvTex.Get(), nullptr, RenderTargetViews[RenderTargetViews.size() - 1].ReleaseAndGetAddressOf()));
-	// Metalicness and Roughness RTV
-	texDesc.Format = DXGI_FORMAT_R32G32_FLOAT;
-	DX::ThrowIfFailed(device->CreateTexture2D(&texDesc, nullptr, rtvTex.ReleaseAndGetAddressOf()));
-	RenderTargetViews.push_back(nullptr);
-	DX::ThrowIfFailed(device->CreateRenderTargetView(rtvTex.Get(), nullptr, RenderTargetViews[RenderTargetViews.size() - 1].ReleaseAndGetAddressOf()));
-
-
-	// Create depth stencil
-	Microsoft::WRL::ComPtr<ID3D11Texture2D> depthStencilTex;
-	D3D11_TEXTURE2D_DESC depthTexDesc = {};
-	depthTexDesc.Width = outputSize.right;
-	depthTexDesc.Height = outputSize.bottom;
-	depthTexDesc.MipLevels = 1;
-	depthTexDesc.ArraySize = 1;
-	depthTexDesc.Format = DXGI_FORMAT_R32_TYPELESS;
-	depthTexDesc.SampleDesc.Count = 1;
-	depthTexDesc.SampleDesc.Quality = 0;
-	depthTexDesc.Usage = D3D11_USAGE_DEFAULT;
-	depthTexDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE;
-	depthTexDesc.CPUAccessFlags = 0;
-	depthTexDesc.MiscFlags = 0;
-	DX::ThrowIfFailed(device->CreateTexture2D(&depthTexDesc, nullptr, depthStencilTex.GetAddressOf()));
-
-	D3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc = {};
-	depthStencilViewDesc.Flags = 0;
-	depthStencilViewDesc.Format = DXGI_FORMAT_D32_FLOAT;
-	depthStencilViewDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
-	depthStencilViewDesc.Texture2D.MipSlice = 0;
-	DX::ThrowIfFailed(device->CreateDepthStencilView(depthStencilTex.Get(), &depthStencilViewDesc, DepthStencilView.ReleaseAndGetAddressOf()));
 
 	// Create render state
 	D3D11_RASTERIZER_DESC renderStateDesc = {};
@@ -76,30 +22,88 @@ void RenderPassDefault::Initialise()
 	renderStateDesc.FillMode = D3D11_FILL_SOLID;
 	renderStateDesc.DepthClipEnable = true;
 	DX::ThrowIfFailed(device->CreateRasterizerState(&renderStateDesc, RenderState.ReleaseAndGetAddressOf()));
+}
+
+void RenderPassDefault::Setup(RenderGraphBuilder& builder)
+{
+	const auto outputSize = DX::DeviceResources::Instance()->GetViewportSize();
+
+	// Compact G-buffer layout described in CPU/GBuffer.h
+	static constexpr const char* names[GBufferTargetCount] = {
+		"GBuffer.Colour",
+		"GBuffer.Normal",
+		"GBuffer.Depth",
+		"GBuffer.Material"
+	};
+	const DXGI_FORMAT formats[GBufferTargetCount] = {
+		DXGI_FORMAT_R16G16B16A16_FLOAT, // Colour
+		DXGI_FORMAT_R16G16_SNORM, // Octahedral normal
+		DepthFormat == CPU::GBufferDepthFormat::Float32 ? DXGI_FORMAT_R32_FLOAT : DXGI_FORMAT_R16_UNORM, // Depth
+		DXGI_FORMAT_R8G8B8A8_UNORM // Metalicness, roughness, object index
+	};
+
+	RenderTargetDesc desc{};
+	desc.Width = outputSize.right;
+	desc.Height = outputSize.bottom;
+	desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+
+	for (int i = 0; i < GBufferTargetCount; ++i)
+	{
+		desc.Format = formats[i];
+		RenderTargets[i] = builder.Create(names[i], RenderGraphTargets::ToTextureDesc(desc));
+	}
 
-	// Create SRV from RTV
-	RenderTargetSRV.clear();
-	for (int i = 0; i < RenderTargetViews.size(); ++i)
+	// Per-pixel cost counters for the cost heatmap
+	for (RenderGraphResource& target : CostTargets)
+		target = InvalidRenderGraphResource;
+	if (RayMarchingManagerComponent::GetCostCountersEnabled())
 	{
-		RenderTargetSRV.push_back(nullptr);
-		Microsoft::WRL::ComPtr<ID3D11Resource> geometryPassResource;
-		RenderTargetViews[i]->GetResource(geometryPassResource.ReleaseAndGetAddressOf());
-		DX::ThrowIfFailed(device->CreateShaderResourceView(geometryPassResource.Get(), nullptr, RenderTargetSRV[i].ReleaseAndGetAddressOf()));
+		desc.Format = DXGI_FORMAT_R32G32B32A32_UINT;
+		CostTargets[0] = builder.Create("Cost.Primary", RenderGraphTargets::ToTextureDesc(desc));
+		CostTargets[1] = builder.Create("Cost.Shadow", RenderGraphTargets::ToTextureDesc(desc));
 	}
+
+	// Depth stencil, only used within this pass
+	desc.Format = DXGI_FORMAT_D32_FLOAT;
+	desc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+	DepthStencil = builder.Create("GBuffer.DepthStencil", RenderGraphTargets::ToTextureDesc(desc));
 }
 
-void RenderPassDefault::Render()
+void RenderPassDefault::Render(const RenderGraphTargets& targets)
 {
 	const auto context = DX::DeviceResources::Instance()->GetD3DDeviceContext();
 	const auto outputSize = DX::DeviceResources::Instance()->GetViewportSize();
 
+	ID3D11RenderTargetView* renderTargetViews[GBufferTargetCount + CostTargetCount] = {};
+	for (int i = 0; i < GBufferTargetCount; ++i)
+		renderTargetViews[i] = targets.Get(RenderTargets[i]).GetRTV();
+
+	UINT targetCount = GBufferTargetCount;
+	if (CostTargets[0] != InvalidRenderGraphResource)
+	{
+		for (const RenderGraphResource target : CostTargets)
+			renderTargetViews[targetCount++] = targets.Get(target).GetRTV();
+	}
+	ID3D11DepthStencilView* depthStencilView = targets.Get(DepthStencil).GetDSV();
+
 	static constexpr DirectX::SimpleMath::Color clearColour(1.0f, 0.0f, 0.0f, 1.0f);
-	context->ClearRenderTargetView(RenderTargetViews[0].Get(), &clearColour.x);
-	context->ClearDepthStencilView(DepthStencilView.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+	context->ClearRenderTargetView(renderTargetViews[GBufferColour], &clearColour.x);
+	context->ClearDepthStencilView(depthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
 
-	// Bind resources
-	context->OMSetRenderTargets(RenderTargetViews.size(), RenderTargetViews.data()->GetAddressOf(), DepthStencilView.Get());
+	// Bind resources, with the per-object counters after the targets (u6 in PixelShader.hlsl)
+	const bool costCounters = CostTargets[0] != InvalidRenderGraphResource;
+	if (costCounters)
+	{
+		ObjectCounters.Clear();
+		ID3D11UnorderedAccessView* const objectCounters = ObjectCounters.GetUAV();
+		context->OMSetRenderTargetsAndUnorderedAccessViews(targetCount, renderTargetViews, depthStencilView, targetCount, 1, &objectCounters, nullptr);
+	}
+	else
+	{
+		context->OMSetRenderTargets(targetCount, renderTargetViews, depthStencilView);
+	}
 
+	// Targets are bucket sized, only the top-left viewport sized region is rendered
 	const CD3D11_VIEWPORT viewport(0.0f, 0.0f,
 	                               outputSize.right, outputSize.bottom,
 	                               0.0f, 1.0f);
@@ -112,15 +116,27 @@ void RenderPassDefault::Render()
 		go->Render();
 
 	// Unbind render targets
-	const std::vector<ID3D11RenderTargetView*> nullRtvs(RenderTargetViews.size(), nullptr);
+	ID3D11RenderTargetView* const nullRtvs[GBufferTargetCount + CostTargetCount] = {};
 	ID3D11DepthStencilView* nullDsv = nullptr;
-	context->OMSetRenderTargets(RenderTargetViews.size(), nullRtvs.data(), nullDsv);
+	if (costCounters)
+	{
+		ID3D11UnorderedAccessView* const nullUav = nullptr;
+		context->OMSetRenderTargetsAndUnorderedAccessViews(targetCount, nullRtvs, nullDsv, targetCount, 1, &nullUav, nullptr);
+		ObjectCounters.Readback();
+	}
+	else
+	{
+		context->OMSetRenderTargets(targetCount, nullRtvs, nullDsv);
+	}
 }
 
 void RenderPassDefault::RenderGUI()
 {
 	ImGui::Begin("Scene View");
 
+	const CPU::PoolCounters& counters = GameObject::GetPoolCounters();
+	ImGui::Text("%zu GameObjects, %zu created, %zu pool chunks", counters.Created - counters.Destroyed, counters.Created, counters.ChunkAllocations);
+
 	for (int i = 0; i < GameObjects.size(); ++i)
 	{
 		const auto go = GameObjects[i];
@@ -131,6 +147,7 @@ void RenderPassDefault::RenderGUI()
 		if (ImGui::Button("X"))
 		{
 			GameObjects.erase(GameObjects.begin() + i);
+			GameObject::Destroy(go);
 			ImGui::PopID();
 			break;
 		}
@@ -143,20 +160,38 @@ void RenderPassDefault::RenderGUI()
 
 	if (ImGui::Button("Add Ray Marched Object"))
 	{
-		const auto go = new GameObject("New Ray Marched Object");
-		go->AddComponent(new RayMarchObjectComponent());
-		go->AddComponent(new MaterialComponent());
+		const auto go = GameObject::Create("New Ray Marched Object");
+		go->AddComponent<RayMarchObjectComponent>();
+		go->AddComponent<MaterialComponent>();
 
 		GameObjects.push_back(go);
 	}
 
 	if (ImGui::Button("Add Ray Marched Light"))
 	{
-		const auto go = new GameObject("New Ray Marched Light");
-		go->AddComponent(new RayMarchLightComponent());
+		const auto go = GameObject::Create("New Ray Marched Light");
+		go->AddComponent<RayMarchLightComponent>();
 
 		GameObjects.push_back(go);
 	}
 
 	ImGui::End();
+
+	ImGui::Begin("G-Buffer");
+
+	bool compactDepth = DepthFormat == CPU::GBufferDepthFormat::Unorm16;
+	if (ImGui::Checkbox("16-bit Depth", &compactDepth))
+	{
+		DepthFormat = compactDepth ? CPU::GBufferDepthFormat::Unorm16 : CPU::GBufferDepthFormat::Float32;
+		MarkGraphDirty();
+	}
+
+	// Byte budget of the current and original layouts at the viewport resolution
+	const auto outputSize = DX::DeviceResources::Instance()->GetViewportSize();
+	ImGui::Text("Current");
+	ImGui::TextUnformatted(CPU::FormatGBufferBudget(CPU::GetCompactGBufferLayout(DepthFormat), outputSize.right, outputSize.bottom).c_str());
+	ImGui::Text("Legacy");
+	ImGui::TextUnformatted(CPU::FormatGBufferBudget(CPU::GetLegacyGBufferLayout(), outputSize.right, outputSize.bottom).c_str());
+
+	ImGui::End();
 }
@@ -1,11 +1,27 @@
 #pragma once
 #include "Rendering/RenderPass.h"
+#include "Rendering/GPUCounterBuffer.h"
+#include "CPU/GBuffer.h"
 
 class GameObject;
 
 class RenderPassDefault : public RenderPass
 {
 public:
+	// Render target order, matching PS_OUTPUT in PixelShader.hlsl. Published to
+	// the render graph as GBuffer.Colour, .Normal, .Depth and .Material.
+	enum GBufferTarget : int
+	{
+		GBufferColour = 0,
+		GBufferNormal,
+		GBufferDepth,
+		GBufferMaterial,
+		GBufferTargetCount
+	};
+
+	// Extra targets written when cost counters are enabled, see PS_OUTPUT. Published as Cost.Primary and Cost.Shadow.
+	static constexpr int CostTargetCount = 2;
+
 	RenderPassDefault(std::vector<GameObject*>& gameObjects);
 	RenderPassDefault(const RenderPassDefault&) = default;
 	RenderPassDefault(RenderPassDefault&&) = default;
@@ -14,26 +30,23 @@ public:
 	~RenderPassDefault() override = default;
 
 	void Initialise() override;
-	void Render() override;
+	void Setup(RenderGraphBuilder& builder) override;
+	void Render(const RenderGraphTargets& targets) override;
 	void RenderGUI() override;
 
-	[[nodiscard]] ID3D11ShaderResourceView* GetSRV() const { return RenderTargetSRV[0].Get(); }
-	[[nodiscard]] ID3D11ShaderResourceView* GetSRV(const int i) const { return RenderTargetSRV[i % RenderTargetSRV.size()].Get(); }
+	[[nodiscard]] const char* GetName() const override { return "G-Buffer"; }
 
-	[[nodiscard]] std::vector<ID3D11ShaderResourceView*> GetSRVs() const
-	{
-		std::vector<ID3D11ShaderResourceView*> res;
-		for (const auto& srv : RenderTargetSRV)
-			res.push_back(srv.Get());
-		return res;
-	}
+	// Scene evaluations each object was nearest in, per object, from a recent frame with cost counters enabled
+	[[nodiscard]] const std::vector<uint32_t>& GetObjectNearestCounts() const { return ObjectCounters.GetValues(); }
 
 private:
 	std::vector<GameObject*>& GameObjects;
 
-	std::vector<Microsoft::WRL::ComPtr<ID3D11RenderTargetView>> RenderTargetViews{};
-	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> DepthStencilView{};
+	RenderGraphResource RenderTargets[GBufferTargetCount]{};
+	RenderGraphResource CostTargets[CostTargetCount]{ InvalidRenderGraphResource, InvalidRenderGraphResource };
+	RenderGraphResource DepthStencil{ InvalidRenderGraphResource };
 	Microsoft::WRL::ComPtr<ID3D11RasterizerState> RenderState{};
+	GPUCounterBuffer ObjectCounters;
 
-	std::vector<Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> RenderTargetSRV{};
+	CPU::GBufferDepthFormat DepthFormat{ CPU::GBufferDepthFormat::Float32 };
 };
@@ -0,0 +1,167 @@
+#include "pch.h"
+#include "Rendering/RenderPassReflectionTrace.h"
+
+#include "Game/Components/RayMarchingManagerComponent.h"
+#include "Rendering/RenderGraphTargets.h"
+
+RenderPassReflectionTrace::RenderPassReflectionTrace()
+	: ObjectCounters(RAYMARCH_MAX_OBJECTS)
+{
+	const auto device = DX::DeviceResources::Instance()->GetD3DDevice();
+
+	D3D11_BUFFER_DESC bd = {};
+	bd.Usage = D3D11_USAGE_DEFAULT;
+	bd.ByteWidth = sizeof(ReflectionTraceSettings);
+	bd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	bd.CPUAccessFlags = 0;
+	DX::ThrowIfFailed(device->CreateBuffer(&bd, nullptr, SettingsConstantBuffer.ReleaseAndGetAddressOf()));
+}
+
+void RenderPassReflectionTrace::CreateShaders()
+{
+	const auto device = DX::DeviceResources::Instance()->GetD3DDevice();
+
+	// The trace shader includes the generated scene distance function, so is rebuilt whenever that changes
+	SceneShaderRevision = RayMarchingManagerComponent::GetSceneShaderRevision();
+
+	ID3DBlob* csBlob = nullptr;
+	DX::ThrowIfFailed(DX::CompileShaderFromFile(L"Source/Rendering/Shaders/ReflectionTraceShader.hlsl", "main", "cs_5_0", &csBlob,
+	                                            RayMarchingManagerComponent::GetSceneShaderDefines()));
+	DX::ThrowIfFailed(device->CreateComputeShader(csBlob->GetBufferPointer(), csBlob->GetBufferSize(), nullptr, TraceShader.ReleaseAndGetAddressOf()));
+	csBlob->Release();
+
+	DX::ThrowIfFailed(DX::CompileShaderFromFile(L"Source/Rendering/Shaders/ReflectionUpsampleShader.hlsl", "main", "cs_5_0", &csBlob));
+	DX::ThrowIfFailed(device->CreateComputeShader(csBlob->GetBufferPointer(), csBlob->GetBufferSize(), nullptr, UpsampleShader.ReleaseAndGetAddressOf()));
+	csBlob->Release();
+}
+
+void RenderPassReflectionTrace::Initialise()
+{
+	CreateShaders();
+}
+
+void RenderPassReflectionTrace::Setup(RenderGraphBuilder& builder)
+{
+	const auto outputSize = DX::DeviceResources::Instance()->GetViewportSize();
+	const unsigned int scale = GetScale();
+
+	GBufferNormal = builder.Read("GBuffer.Normal");
+	GBufferDepth = builder.Read("GBuffer.Depth");
+	GBufferMaterial = builder.Read("GBuffer.Material");
+
+	// Full resolution reflection colour and (unnormalised) depth, with a full mip chain used for roughness blur
+	RenderTargetDesc desc{};
+	desc.Width = outputSize.right;
+	desc.Height = outputSize.bottom;
+	desc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_RENDER_TARGET;
+	desc.MipLevels = 0;
+	desc.MiscFlags = D3D11_RESOURCE_MISC_GENERATE_MIPS;
+	ReflectionTarget = builder.Create("Reflections.Colour", RenderGraphTargets::ToTextureDesc(desc));
+
+	desc.Width = (desc.Width + scale - 1) / scale;
+	desc.Height = (desc.Height + scale - 1) / scale;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+	desc.MipLevels = 1;
+	desc.MiscFlags = 0;
+
+	// Reduced resolution trace target, not needed when tracing at full resolution
+	TracedTarget = scale == 1 ? InvalidRenderGraphResource : builder.Create("Reflections.Traced", RenderGraphTargets::ToTextureDesc(desc));
+
+	desc.Format = DXGI_FORMAT_R32G32B32A32_UINT;
+	CostTarget = RayMarchingManagerComponent::GetCostCountersEnabled() ? builder.Create("Cost.Reflection", RenderGraphTargets::ToTextureDesc(desc)) : InvalidRenderGraphResource;
+}
+
+void RenderPassReflectionTrace::Render(const RenderGraphTargets& targets)
+{
+	const auto context = DX::DeviceResources::Instance()->GetD3DDeviceContext();
+	const auto outputSize = DX::DeviceResources::Instance()->GetViewportSize();
+	const unsigned int scale = GetScale();
+	const UINT width = std::max(1l, outputSize.right);
+	const UINT height = std::max(1l, outputSize.bottom);
+	const RenderTarget& reflection = targets.Get(ReflectionTarget);
+
+	if (SceneShaderRevision != RayMarchingManagerComponent::GetSceneShaderRevision())
+		CreateShaders();
+
+	static constexpr ID3D11ShaderResourceView* nullSrvs[4] = { nullptr, nullptr, nullptr, nullptr };
+	static constexpr ID3D11UnorderedAccessView* nullUavs[4] = { nullptr, nullptr, nullptr, nullptr };
+
+	Timer.Begin();
+	RayCounter.Clear();
+	const bool costCounters = CostTarget != InvalidRenderGraphResource;
+	if (costCounters)
+		ObjectCounters.Clear();
+
+	ReflectionTraceSettings settings{};
+	settings.Resolution[0] = width;
+	settings.Resolution[1] = height;
+	settings.Scale = scale;
+	context->UpdateSubresource(SettingsConstantBuffer.Get(), 0, nullptr, &settings, 0, 0);
+	context->CSSetConstantBuffers(4, 1, SettingsConstantBuffer.GetAddressOf());
+
+	// Trace, straight into the full resolution target when not downsampling.
+	// Scene constant buffers and skybox are bound by the Ray Marching Manager and Camera.
+	ID3D11ShaderResourceView* const traceSrvs[3] = {
+		targets.Get(GBufferNormal).GetSRV(),
+		targets.Get(GBufferDepth).GetSRV(),
+		targets.Get(GBufferMaterial).GetSRV()
+	};
+	ID3D11UnorderedAccessView* const traceUavs[4] = {
+		scale == 1 ? reflection.GetUAV() : targets.Get(TracedTarget).GetUAV(),
+		RayCounter.GetUAV(),
+		costCounters ? targets.Get(CostTarget).GetUAV() : nullptr,
+		costCounters ? ObjectCounters.GetUAV() : nullptr
+	};
+	context->CSSetShaderResources(1, 3, traceSrvs);
+	context->CSSetUnorderedAccessViews(0, 4, traceUavs, nullptr);
+	context->CSSetShader(TraceShader.Get(), nullptr, 0);
+	context->Dispatch((width + scale * 8 - 1) / (scale * 8), (height + scale * 8 - 1) / (scale * 8), 1);
+	context->CSSetShaderResources(1, 3, nullSrvs);
+	context->CSSetUnorderedAccessViews(0, 4, nullUavs, nullptr);
+	Timer.Timestamp(1);
+
+	// Upsample guided by the full resolution G-buffer
+	if (scale != 1)
+	{
+		ID3D11ShaderResourceView* const upsampleSrvs[4] = {
+			targets.Get(GBufferNormal).GetSRV(),
+			targets.Get(GBufferDepth).GetSRV(),
+			targets.Get(GBufferMaterial).GetSRV(),
+			targets.Get(TracedTarget).GetSRV()
+		};
+		ID3D11UnorderedAccessView* const upsampleUav = reflection.GetUAV();
+		context->CSSetShaderResources(0, 4, upsampleSrvs);
+		context->CSSetUnorderedAccessViews(0, 1, &upsampleUav, nullptr);
+		context->CSSetShader(UpsampleShader.Get(), nullptr, 0);
+		context->Dispatch((width + 7) / 8, (height + 7) / 8, 1);
+		context->CSSetShaderResources(0, 4, nullSrvs);
+		context->CSSetUnorderedAccessViews(0, 1, nullUavs, nullptr);
+	}
+	Timer.Timestamp(2);
+
+	// Build reflection colour pyramid for roughness blur
+	context->GenerateMips(reflection.GetSRV());
+
+	RayCounter.Readback();
+	if (costCounters)
+		ObjectCounters.Readback();
+	Timer.End();
+}
+
+void RenderPassReflectionTrace::RenderGUI()
+{
+	ImGui::Begin("Reflections");
+
+	const char* resolutionOptions[3] = { "Full", "Half", "Quarter" };
+	if (ImGui::Combo("Trace Resolution", &ResolutionIndex, resolutionOptions, 3))
+		MarkGraphDirty();
+
+	const auto outputSize = DX::DeviceResources::Instance()->GetViewportSize();
+	const float pixels = static_cast<float>(std::max(1l, outputSize.right * outputSize.bottom));
+	const uint32_t rays = RayCounter.GetValues()[0];
+	ImGui::Text("Reflection rays: %u (%.1f%% of pixels)", rays, 100.0f * static_cast<float>(rays) / pixels);
+	ImGui::Text("Trace: %.3fms, Upsample: %.3fms", Timer.GetMilliseconds(0, 1), Timer.GetMilliseconds(1, 2));
+
+	ImGui::End();
+}
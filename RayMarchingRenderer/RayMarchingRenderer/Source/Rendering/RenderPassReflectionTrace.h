@@ -0,0 +1,67 @@
+#pragma once
+#include "Rendering/RenderPass.h"
+#include "Rendering/GPUCounterBuffer.h"
+#include "Rendering/GPUTimer.h"
+
+// Marches reflection rays from the G-buffer at full, half or quarter resolution,
+// then joint bilateral upsamples them to a full resolution target whose mip
+// chain is used for roughness blur by RenderPassReflections. Reads the G-buffer
+// normal, depth and material, and publishes Reflections.Colour.
+class RenderPassReflectionTrace : public RenderPass
+{
+	struct ReflectionTraceSettings
+	{
+		unsigned int Resolution[2]{ 0u, 0u };
+		unsigned int Scale{ 1u };
+
+		unsigned int PADDING{};
+	};
+
+public:
+	RenderPassReflectionTrace();
+	RenderPassReflectionTrace(const RenderPassReflectionTrace&) = delete;
+	RenderPassReflectionTrace(RenderPassReflectionTrace&&) = default;
+	RenderPassReflectionTrace& operator=(const RenderPassReflectionTrace&) = delete;
+	RenderPassReflectionTrace& operator=(RenderPassReflectionTrace&&) = delete;
+	~RenderPassReflectionTrace() override = default;
+
+	void Initialise() override;
+	void Setup(RenderGraphBuilder& builder) override;
+	void Render(const RenderGraphTargets& targets) override;
+	void RenderGUI() override;
+
+	[[nodiscard]] const char* GetName() const override { return "Reflection Trace"; }
+
+	// Full resolution pixels per traced pixel along each axis
+	[[nodiscard]] unsigned int GetScale() const { return 1u << ResolutionIndex; }
+
+	// Scene evaluations each object was nearest in, per object, from a recent frame with cost counters enabled
+	[[nodiscard]] const std::vector<uint32_t>& GetObjectNearestCounts() const { return ObjectCounters.GetValues(); }
+
+private:
+	void CreateShaders();
+
+	Microsoft::WRL::ComPtr<ID3D11ComputeShader> TraceShader{ nullptr };
+	Microsoft::WRL::ComPtr<ID3D11ComputeShader> UpsampleShader{ nullptr };
+	Microsoft::WRL::ComPtr<ID3D11Buffer> SettingsConstantBuffer{ nullptr };
+
+	RenderGraphResource GBufferNormal{ InvalidRenderGraphResource };
+	RenderGraphResource GBufferDepth{ InvalidRenderGraphResource };
+	RenderGraphResource GBufferMaterial{ InvalidRenderGraphResource };
+
+	// Reduced resolution trace result, invalid when tracing at full resolution
+	RenderGraphResource TracedTarget{ InvalidRenderGraphResource };
+
+	// Full resolution reflection colour and depth in half precision, with mip chain
+	RenderGraphResource ReflectionTarget{ InvalidRenderGraphResource };
+
+	// Cost counters of each traced ray, at the trace resolution. Only created when cost counters are enabled.
+	RenderGraphResource CostTarget{ InvalidRenderGraphResource };
+
+	GPUCounterBuffer RayCounter{ 1 };
+	GPUCounterBuffer ObjectCounters;
+	GPUTimer Timer{ 3 };
+
+	int ResolutionIndex{ 1 }; // 0: Full, 1: Half, 2: Quarter
+	unsigned int SceneShaderRevision{ 0u };
+};
@@ -1,38 +1,24 @@
 #include "pch.h"
 #include "RenderPassReflections.h"
 
-RenderPassReflections::RenderPassReflections(const RenderPassDefault* rpd) : RPD(rpd) { }
+#include <array>
+
+#include "Rendering/RenderGraphTargets.h"
 
 void RenderPassReflections::Initialise()
 {
 	const auto device = DX::DeviceResources::Instance()->GetD3DDevice();
-	const auto outputSize = DX::DeviceResources::Instance()->GetViewportSize();
-
-	// Create UAV
-	Microsoft::WRL::ComPtr<ID3D11Texture2D> rtvTex;
-	D3D11_TEXTURE2D_DESC texDesc = {};
-	texDesc.Width = outputSize.right;
-	texDesc.Height = outputSize.bottom;
-	texDesc.MipLevels = 1;
-	texDesc.ArraySize = 1;
-	texDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-	texDesc.SampleDesc.Count = 1;
-	texDesc.Usage = D3D11_USAGE_DEFAULT;
-	texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
-	texDesc.CPUAccessFlags = 0;
-	texDesc.MiscFlags = 0;
-	DX::ThrowIfFailed(device->CreateTexture2D(&texDesc, nullptr, rtvTex.ReleaseAndGetAddressOf()));
 
-	D3D11_UNORDERED_ACCESS_VIEW_DESC postProcUAVDesc;
-	postProcUAVDesc.Format = DXGI_FORMAT_UNKNOWN;
-	postProcUAVDesc.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D;
-	postProcUAVDesc.Texture2D.MipSlice = 0;
-	DX::ThrowIfFailed(device->CreateUnorderedAccessView(rtvTex.Get(), &postProcUAVDesc, ResultUAV.ReleaseAndGetAddressOf()));
-
-	// Create SRV
-	Microsoft::WRL::ComPtr<ID3D11Resource> geometryPassResource;
-	ResultUAV->GetResource(geometryPassResource.ReleaseAndGetAddressOf());
-	DX::ThrowIfFailed(device->CreateShaderResourceView(geometryPassResource.Get(), nullptr, UnorderedAccessSRV.ReleaseAndGetAddressOf()));
+	// Create sampler for reading the reflection mip chain
+	D3D11_SAMPLER_DESC sampDesc{};
+	sampDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+	sampDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+	sampDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+	sampDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+	sampDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
+	sampDesc.MinLOD = 0;
+	sampDesc.MaxLOD = D3D11_FLOAT32_MAX;
+	DX::ThrowIfFailed(device->CreateSamplerState(&sampDesc, LinearClampSampler.ReleaseAndGetAddressOf()));
 
 	// Compile and create compute shader
 	ID3DBlob* csBlob = nullptr;
@@ -43,20 +29,41 @@ void RenderPassReflections::Initialise()
 	csBlob->Release();
 }
 
-void RenderPassReflections::Render()
+void RenderPassReflections::Setup(RenderGraphBuilder& builder)
+{
+	const auto outputSize = DX::DeviceResources::Instance()->GetViewportSize();
+
+	GBufferColour = builder.Read("GBuffer.Colour");
+	ReflectionColour = builder.Read("Reflections.Colour");
+	GBufferMaterial = builder.Read("GBuffer.Material");
+
+	RenderTargetDesc desc{};
+	desc.Width = static_cast<UINT>(outputSize.right);
+	desc.Height = static_cast<UINT>(outputSize.bottom);
+	desc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+	ResultTarget = builder.Create("Reflections.Result", RenderGraphTargets::ToTextureDesc(desc));
+}
+
+void RenderPassReflections::Render(const RenderGraphTargets& targets)
 {
 	const auto context = DX::DeviceResources::Instance()->GetD3DDeviceContext();
 	const auto outputSize = DX::DeviceResources::Instance()->GetViewportSize();
 
 	// Bind textures to compute shader
-	const auto srvs = RPD->GetSRVs();
-	for (int i = 0; i < srvs.size(); ++i)
-		context->CSSetShaderResources(i, 1, &srvs[i]);
-	context->CSSetUnorderedAccessViews(0, 1, ResultUAV.GetAddressOf(), nullptr);
+	const std::array<ID3D11ShaderResourceView*, 3> srvs = {
+		targets.Get(GBufferColour).GetSRV(),
+		targets.Get(ReflectionColour).GetSRV(),
+		targets.Get(GBufferMaterial).GetSRV()
+	};
+	context->CSSetShaderResources(0, static_cast<UINT>(srvs.size()), srvs.data());
+	ID3D11UnorderedAccessView* resultUav = targets.Get(ResultTarget).GetUAV();
+	context->CSSetUnorderedAccessViews(0, 1, &resultUav, nullptr);
+	context->CSSetSamplers(0, 1, LinearClampSampler.GetAddressOf());
 
 	// Dispatch compute shader
 	context->CSSetShader(ComputeShader.Get(), nullptr, 0);
-	context->Dispatch(outputSize.right / 8, outputSize.bottom / 8, 1);
+	context->Dispatch((outputSize.right + 7) / 8, (outputSize.bottom + 7) / 8, 1);
 
 	// Unbind textures
 	static constexpr ID3D11UnorderedAccessView* nullUav = nullptr;
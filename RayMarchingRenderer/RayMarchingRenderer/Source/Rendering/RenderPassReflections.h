@@ -1,11 +1,13 @@
 #pragma once
 #include "RenderPass.h"
-#include <Rendering\RenderPassDefault.h>
 
+// Composites roughness blurred reflections over the G-buffer colour, reading
+// GBuffer.Colour, Reflections.Colour and GBuffer.Material and publishing
+// Reflections.Result, the final viewport image.
 class RenderPassReflections : public RenderPass
 {
 public:
-	RenderPassReflections(const RenderPassDefault* rpd);
+	RenderPassReflections() = default;
 	RenderPassReflections(const RenderPassReflections&) = default;
 	RenderPassReflections(RenderPassReflections&&) = default;
 	RenderPassReflections& operator=(const RenderPassReflections&) = delete;
@@ -13,16 +15,18 @@ public:
 	~RenderPassReflections() override = default;
 
 	void Initialise() override;
-	void Render() override;
+	void Setup(RenderGraphBuilder& builder) override;
+	void Render(const RenderGraphTargets& targets) override;
 	void RenderGUI() override {};
 
-	[[nodiscard]] ID3D11ShaderResourceView* GetSRV() const { return UnorderedAccessSRV.Get(); }
+	[[nodiscard]] const char* GetName() const override { return "Reflection Composite"; }
 
 private:
 	Microsoft::WRL::ComPtr<ID3D11ComputeShader> ComputeShader{ nullptr };
+	Microsoft::WRL::ComPtr<ID3D11SamplerState> LinearClampSampler{ nullptr };
 
-	Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> ResultUAV{ nullptr };
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> UnorderedAccessSRV{ nullptr };
-
-	const RenderPassDefault* RPD;
+	RenderGraphResource GBufferColour{ InvalidRenderGraphResource };
+	RenderGraphResource GBufferMaterial{ InvalidRenderGraphResource };
+	RenderGraphResource ReflectionColour{ InvalidRenderGraphResource };
+	RenderGraphResource ResultTarget{ InvalidRenderGraphResource };
 };
@@ -0,0 +1,156 @@
+#include "pch.h"
+#include "Rendering/RenderTargetPool.h"
+
+namespace
+{
+	UINT GetBytesPerPixel(const DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_R32G32B32A32_FLOAT:
+		case DXGI_FORMAT_R32G32B32A32_UINT:
+			return 16u;
+		case DXGI_FORMAT_R16G16B16A16_FLOAT:
+		case DXGI_FORMAT_R32G32_FLOAT:
+			return 8u;
+		case DXGI_FORMAT_R16G16_SNORM:
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+		case DXGI_FORMAT_R32_FLOAT:
+		case DXGI_FORMAT_D32_FLOAT:
+			return 4u;
+		case DXGI_FORMAT_R16_UNORM:
+			return 2u;
+		default:
+			return 4u;
+		}
+	}
+}
+
+RenderTarget::RenderTarget(const RenderTargetDesc& desc)
+	: Desc(desc)
+{
+	const auto device = DX::DeviceResources::Instance()->GetD3DDevice();
+
+	D3D11_TEXTURE2D_DESC texDesc = {};
+	texDesc.Width = Desc.Width;
+	texDesc.Height = Desc.Height;
+	texDesc.MipLevels = Desc.MipLevels;
+	texDesc.ArraySize = 1;
+	texDesc.Format = Desc.Format;
+	texDesc.SampleDesc.Count = 1;
+	texDesc.Usage = D3D11_USAGE_DEFAULT;
+	texDesc.BindFlags = Desc.BindFlags;
+	texDesc.CPUAccessFlags = 0;
+	texDesc.MiscFlags = Desc.MiscFlags;
+	DX::ThrowIfFailed(device->CreateTexture2D(&texDesc, nullptr, Texture.ReleaseAndGetAddressOf()));
+
+	if (Desc.BindFlags & D3D11_BIND_RENDER_TARGET)
+		DX::ThrowIfFailed(device->CreateRenderTargetView(Texture.Get(), nullptr, RTV.ReleaseAndGetAddressOf()));
+	if (Desc.BindFlags & D3D11_BIND_SHADER_RESOURCE)
+		DX::ThrowIfFailed(device->CreateShaderResourceView(Texture.Get(), nullptr, SRV.ReleaseAndGetAddressOf()));
+	if (Desc.BindFlags & D3D11_BIND_UNORDERED_ACCESS)
+		DX::ThrowIfFailed(device->CreateUnorderedAccessView(Texture.Get(), nullptr, UAV.ReleaseAndGetAddressOf()));
+	if (Desc.BindFlags & D3D11_BIND_DEPTH_STENCIL)
+		DX::ThrowIfFailed(device->CreateDepthStencilView(Texture.Get(), nullptr, DSV.ReleaseAndGetAddressOf()));
+
+	SizeInBytes = CalculateSizeInBytes(Desc);
+}
+
+size_t RenderTarget::CalculateSizeInBytes(const RenderTargetDesc& desc)
+{
+	// Mip chains add roughly a third
+	size_t bytes = static_cast<size_t>(desc.Width) * desc.Height * GetBytesPerPixel(desc.Format);
+	if (desc.MipLevels != 1u)
+		bytes += bytes / 3;
+	return bytes;
+}
+
+UINT RenderTargetPool::GetBucketSize(const UINT size)
+{
+	return std::max(1u, (size + BucketGranularity - 1u) / BucketGranularity) * BucketGranularity;
+}
+
+RenderTargetDesc RenderTargetPool::GetBucketDesc(const RenderTargetDesc& desc)
+{
+	// Mip chains are built over the whole texture, so any slack would be averaged into the coarse levels
+	if (desc.MipLevels != 1u)
+		return desc;
+
+	RenderTargetDesc bucketDesc = desc;
+	bucketDesc.Width = GetBucketSize(desc.Width);
+	bucketDesc.Height = GetBucketSize(desc.Height);
+	return bucketDesc;
+}
+
+bool RenderTargetPool::IsCompatible(const RenderTargetDesc& allocated, const RenderTargetDesc& requested)
+{
+	if (allocated.Format != requested.Format ||
+	    allocated.BindFlags != requested.BindFlags ||
+	    allocated.MipLevels != requested.MipLevels ||
+	    allocated.MiscFlags != requested.MiscFlags)
+		return false;
+
+	if (requested.MipLevels != 1u)
+		return allocated.Width == requested.Width && allocated.Height == requested.Height;
+
+	// Allow one bucket of slack so dragging back and forth across a boundary doesn't thrash
+	return allocated.Width >= requested.Width && allocated.Height >= requested.Height &&
+	       allocated.Width <= GetBucketSize(requested.Width) + BucketGranularity &&
+	       allocated.Height <= GetBucketSize(requested.Height) + BucketGranularity;
+}
+
+bool RenderTargetPool::Fit(std::shared_ptr<RenderTarget>& target, const RenderTargetDesc& desc)
+{
+	if (target && IsCompatible(target->Desc, desc))
+	{
+		target->LastUsedFrame = FrameIndex;
+		return false;
+	}
+
+	const RenderTargetDesc bucketDesc = GetBucketDesc(desc);
+
+	// Return the current target to the pool, then reuse an unreferenced one of the exact bucket if possible
+	target.reset();
+	for (const auto& pooled : Targets)
+	{
+		const RenderTargetDesc& pooledDesc = pooled->Desc;
+		if (pooled.use_count() == 1 &&
+		    pooledDesc.Width == bucketDesc.Width && pooledDesc.Height == bucketDesc.Height &&
+		    IsCompatible(pooledDesc, desc))
+		{
+			target = pooled;
+			target->LastUsedFrame = FrameIndex;
+			return true;
+		}
+	}
+
+	target = std::make_shared<RenderTarget>(bucketDesc);
+	target->LastUsedFrame = FrameIndex;
+	Targets.push_back(target);
+	++AllocationCount;
+
+	return true;
+}
+
+void RenderTargetPool::EndFrame()
+{
+	++FrameIndex;
+
+	// Targets still held by a pass count as used every frame
+	for (const auto& target : Targets)
+		if (target.use_count() > 1)
+			target->LastUsedFrame = FrameIndex;
+
+	std::erase_if(Targets, [this](const std::shared_ptr<RenderTarget>& target)
+	{
+		return target.use_count() == 1 && FrameIndex - target->LastUsedFrame > UnusedFrameLimit;
+	});
+}
+
+size_t RenderTargetPool::GetAllocatedBytes() const
+{
+	size_t bytes = 0u;
+	for (const auto& target : Targets)
+		bytes += target->GetSizeInBytes();
+	return bytes;
+}
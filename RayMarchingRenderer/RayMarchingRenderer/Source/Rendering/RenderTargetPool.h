@@ -0,0 +1,95 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+struct RenderTargetDesc
+{
+	UINT Width{ 1u };
+	UINT Height{ 1u };
+	DXGI_FORMAT Format{ DXGI_FORMAT_R16G16B16A16_FLOAT };
+	UINT BindFlags{ D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE };
+	UINT MipLevels{ 1u }; // 0 for a full mip chain
+	UINT MiscFlags{ 0u };
+};
+
+// Texture plus whichever views its bind flags allow. Allocated at bucket size,
+// so passes render into the top-left Width x Height of it.
+class RenderTarget
+{
+public:
+	RenderTarget(const RenderTargetDesc& desc);
+	RenderTarget(const RenderTarget&) = delete;
+	RenderTarget(RenderTarget&&) = default;
+	RenderTarget& operator=(const RenderTarget&) = delete;
+	RenderTarget& operator=(RenderTarget&&) = default;
+	~RenderTarget() = default;
+
+	[[nodiscard]] const RenderTargetDesc& GetDesc() const { return Desc; }
+	[[nodiscard]] UINT GetWidth() const { return Desc.Width; }
+	[[nodiscard]] UINT GetHeight() const { return Desc.Height; }
+	[[nodiscard]] size_t GetSizeInBytes() const { return SizeInBytes; }
+
+	// Approximate video memory used by a target of the given description
+	[[nodiscard]] static size_t CalculateSizeInBytes(const RenderTargetDesc& desc);
+
+	[[nodiscard]] ID3D11Texture2D* GetTexture() const { return Texture.Get(); }
+	[[nodiscard]] ID3D11RenderTargetView* GetRTV() const { return RTV.Get(); }
+	[[nodiscard]] ID3D11ShaderResourceView* GetSRV() const { return SRV.Get(); }
+	[[nodiscard]] ID3D11UnorderedAccessView* GetUAV() const { return UAV.Get(); }
+	[[nodiscard]] ID3D11DepthStencilView* GetDSV() const { return DSV.Get(); }
+
+private:
+	friend class RenderTargetPool;
+
+	RenderTargetDesc Desc{};
+	size_t SizeInBytes{ 0u };
+	uint64_t LastUsedFrame{ 0u };
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> Texture{ nullptr };
+	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> RTV{ nullptr };
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> SRV{ nullptr };
+	Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> UAV{ nullptr };
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> DSV{ nullptr };
+};
+
+// Hands out render targets rounded up to size buckets, so resizing the
+// viewport only reallocates when it crosses a bucket boundary. Targets no
+// longer referenced by a pass stay pooled for a while for reuse.
+class RenderTargetPool
+{
+public:
+	static RenderTargetPool* Instance()
+	{
+		static auto pool = new RenderTargetPool();
+		return pool;
+	}
+
+	// Points target at an allocation able to hold desc, keeping the current one
+	// when it is compatible and at most one bucket too large (exactly the size
+	// for mip chained targets). Returns true if
+	// target changed, in which case any views cached from it are stale.
+	bool Fit(std::shared_ptr<RenderTarget>& target, const RenderTargetDesc& desc);
+
+	// Releases pooled targets nobody has used for a while
+	void EndFrame();
+
+	[[nodiscard]] static UINT GetBucketSize(UINT size);
+	// desc at the size the pool allocates it: rounded up to buckets, except mip chained targets which are exact
+	[[nodiscard]] static RenderTargetDesc GetBucketDesc(const RenderTargetDesc& desc);
+
+	[[nodiscard]] size_t GetTargetCount() const { return Targets.size(); }
+	[[nodiscard]] size_t GetAllocatedBytes() const;
+	[[nodiscard]] uint64_t GetAllocationCount() const { return AllocationCount; }
+
+private:
+	RenderTargetPool() = default;
+
+	[[nodiscard]] static bool IsCompatible(const RenderTargetDesc& allocated, const RenderTargetDesc& requested);
+
+	static constexpr UINT BucketGranularity = 256u;
+	static constexpr uint64_t UnusedFrameLimit = 120u;
+
+	std::vector<std::shared_ptr<RenderTarget>> Targets{};
+	uint64_t FrameIndex{ 0u };
+	uint64_t AllocationCount{ 0u };
+};
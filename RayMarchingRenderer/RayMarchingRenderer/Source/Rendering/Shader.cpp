@@ -33,13 +33,13 @@ void Shader::CreateVertexShaderAndInputLayout()
 	vsBlob->Release();
 }
 
-void Shader::CreatePixelShader()
+void Shader::CreatePixelShader(const D3D_SHADER_MACRO* defines)
 {
 	const auto device = DX::DeviceResources::Instance()->GetD3DDevice();
 
 	// Read and create Pixel shader
 	ID3DBlob* psBlob = nullptr;
-	DX::ThrowIfFailed(DX::CompileShaderFromFile(L"Source/Rendering/Shaders/PixelShader.hlsl", "main", "ps_5_0", &psBlob));
+	DX::ThrowIfFailed(DX::CompileShaderFromFile(L"Source/Rendering/Shaders/PixelShader.hlsl", "main", "ps_5_0", &psBlob, defines));
 	DX::ThrowIfFailed(device->CreatePixelShader(psBlob->GetBufferPointer(),
 	                                            psBlob->GetBufferSize(),
 	                                            nullptr,
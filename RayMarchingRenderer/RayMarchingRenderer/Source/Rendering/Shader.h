@@ -17,7 +17,8 @@ public:
 	[[nodiscard]] ID3D11InputLayout* GetInputLayout() const { return InputLayout.Get(); }
 
 	void CreateVertexShaderAndInputLayout();
-	void CreatePixelShader();
+	// defines is a null terminated array of macros, such as RayMarchingManagerComponent::GetSceneShaderDefines
+	void CreatePixelShader(const D3D_SHADER_MACRO* defines = nullptr);
 
 private:
 	Microsoft::WRL::ComPtr<ID3D11VertexShader> VertexShader;
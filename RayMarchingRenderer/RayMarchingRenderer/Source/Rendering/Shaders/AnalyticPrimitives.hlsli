@@ -0,0 +1,331 @@
+// Closed form ray intersections for the built-in primitive snippets, ported
+// by CPU/AnalyticPrimitives.cpp. Each takes a unit length ray in the
+// primitive's local space and gives the entry depth, 0 or less when the ray
+// starts inside, and the outward normal there. The scene's analytic objects
+// are intersected by the generated IntersectAnalyticPrimitives.
+
+#define ANALYTIC_SPHERE 0
+#define ANALYTIC_BOX 1
+#define ANALYTIC_TORUS 2
+#define ANALYTIC_CONE 3
+#define ANALYTIC_CYLINDER 4
+
+#define ANALYTIC_FAR 1e30f
+
+struct AnalyticHit
+{
+    float depth;
+    float3 normal;
+    int index; // Into ObjectsList, -1 for a miss
+};
+
+// Depths at which o + d * t lies between the planes at lo and hi along one axis
+bool ClipSlab(float o, float d, float lo, float hi, out float nearDepth, out float farDepth)
+{
+    if (abs(d) < 1e-12f)
+    {
+        nearDepth = -ANALYTIC_FAR;
+        farDepth = ANALYTIC_FAR;
+        return o >= lo && o <= hi;
+    }
+
+    const float t0 = (lo - o) / d;
+    const float t1 = (hi - o) / d;
+    nearDepth = min(t0, t1);
+    farDepth = max(t0, t1);
+    return true;
+}
+
+bool IntersectSphere(float3 o, float3 d, float3 param, out float depth, out float3 normal)
+{
+    depth = 0.0f;
+    normal = float3(0.0f, 0.0f, 0.0f);
+
+    // Squared distance from the closest point on the line, rather than b^2 - c, keeps precision far away
+    const float b = dot(o, d);
+    const float3 closest = o - d * b;
+    const float h = param.x * param.x - dot(closest, closest);
+    if (h < 0.0f || sqrt(h) - b < 0.0f)
+        return false;
+
+    depth = -b - sqrt(h);
+    normal = (o + d * depth) / param.x;
+    return true;
+}
+
+bool IntersectBox(float3 o, float3 d, float3 param, out float depth, out float3 normal)
+{
+    depth = 0.0f;
+    normal = float3(0.0f, 0.0f, 0.0f);
+
+    float nearDepth = -ANALYTIC_FAR;
+    float farDepth = ANALYTIC_FAR;
+    int axis = 0;
+    [unroll]
+    for (int i = 0; i < 3; ++i)
+    {
+        float slabNear, slabFar;
+        if (!ClipSlab(o[i], d[i], -param[i], param[i], slabNear, slabFar))
+            return false;
+        if (slabNear > nearDepth)
+        {
+            nearDepth = slabNear;
+            axis = i;
+        }
+        farDepth = min(farDepth, slabFar);
+    }
+    if (nearDepth > farDepth || farDepth < 0.0f)
+        return false;
+
+    depth = nearDepth;
+    normal[axis] = d[axis] > 0.0f ? -1.0f : 1.0f;
+    return true;
+}
+
+bool IntersectCylinder(float3 o, float3 d, float3 param, out float depth, out float3 normal)
+{
+    depth = 0.0f;
+    normal = float3(0.0f, 0.0f, 0.0f);
+
+    // Capped by the slab |y| <= param.y
+    float nearDepth, farDepth;
+    if (!ClipSlab(o.y, d.y, -param.y, param.y, nearDepth, farDepth))
+        return false;
+    const float capDepth = nearDepth;
+
+    // Infinite cylinder of radius param.x about y, solved in the xz plane like the sphere
+    const float len = length(d.xz);
+    if (len > 1e-12f)
+    {
+        const float2 u = d.xz / len;
+        const float b = dot(o.xz, u);
+        const float2 closest = o.xz - u * b;
+        const float h = param.x * param.x - dot(closest, closest);
+        if (h < 0.0f)
+            return false;
+        nearDepth = max(nearDepth, (-b - sqrt(h)) / len);
+        farDepth = min(farDepth, (-b + sqrt(h)) / len);
+    }
+    else if (dot(o.xz, o.xz) > param.x * param.x)
+        return false;
+    if (nearDepth > farDepth || farDepth < 0.0f)
+        return false;
+
+    depth = nearDepth;
+    const float3 p = o + d * depth;
+    normal = nearDepth == capDepth ? float3(0.0f, d.y > 0.0f ? -1.0f : 1.0f, 0.0f) : normalize(float3(p.x, 0.0f, p.z));
+    return true;
+}
+
+bool IntersectCone(float3 o, float3 d, float3 param, out float depth, out float3 normal)
+{
+    depth = 0.0f;
+    normal = float3(0.0f, 0.0f, 0.0f);
+
+    // Tip at the origin, base of radius param.z * k at y = -param.z
+    const float k2 = (param.x / param.y) * (param.x / param.y);
+    float slabNear, slabFar;
+    if (!ClipSlab(o.y, d.y, -param.z, 0.0f, slabNear, slabFar))
+        return false;
+
+    // Inside the double cone where a t^2 + 2 b t + c <= 0. That is one interval or two rays, and within
+    // the slab only the lower nappe is left, so at most one of them survives clipping.
+    const float a = d.x * d.x + d.z * d.z - k2 * d.y * d.y;
+    const float b = o.x * d.x + o.z * d.z - k2 * o.y * d.y;
+    const float c = o.x * o.x + o.z * o.z - k2 * o.y * o.y;
+    float2 intervals[2] = { float2(ANALYTIC_FAR, -ANALYTIC_FAR), float2(ANALYTIC_FAR, -ANALYTIC_FAR) };
+    if (abs(a) < 1e-9f)
+    {
+        if (abs(b) > 1e-12f)
+        {
+            const float root = -c / (2.0f * b);
+            intervals[0] = b > 0.0f ? float2(-ANALYTIC_FAR, root) : float2(root, ANALYTIC_FAR);
+        }
+        else if (c <= 0.0f)
+            intervals[0] = float2(-ANALYTIC_FAR, ANALYTIC_FAR);
+    }
+    else
+    {
+        const float discriminant = b * b - a * c;
+        if (discriminant >= 0.0f)
+        {
+            const float r0 = (-b - sqrt(discriminant)) / a;
+            const float r1 = (-b + sqrt(discriminant)) / a;
+            if (a > 0.0f)
+                intervals[0] = float2(min(r0, r1), max(r0, r1));
+            else
+            {
+                intervals[0] = float2(-ANALYTIC_FAR, min(r0, r1));
+                intervals[1] = float2(max(r0, r1), ANALYTIC_FAR);
+            }
+        }
+        else if (a < 0.0f)
+            intervals[0] = float2(-ANALYTIC_FAR, ANALYTIC_FAR);
+    }
+
+    [unroll]
+    for (int i = 0; i < 2; ++i)
+    {
+        const float nearDepth = max(intervals[i].x, slabNear);
+        const float farDepth = min(intervals[i].y, slabFar);
+        if (nearDepth > farDepth || farDepth < 0.0f)
+            continue;
+
+        depth = nearDepth;
+        const float3 p = o + d * depth;
+        normal = nearDepth == slabNear ? float3(0.0f, d.y > 0.0f ? -1.0f : 1.0f, 0.0f) : normalize(float3(p.x, -k2 * p.y, p.z));
+        return true;
+    }
+    return false;
+}
+
+// Gradient of (|p|^2 + R^2 - r^2)^2 - 4 R^2 (x^2 + z^2), normalised
+float3 GetTorusNormal(float3 p, float3 param)
+{
+    return normalize(p * (dot(p, p) - param.y * param.y - param.x * param.x * float3(1.0f, -1.0f, 1.0f)));
+}
+
+// Quartic solved by resolvent cubic, after Inigo Quilez's iTorus
+bool IntersectTorus(float3 o, float3 d, float3 param, out float depth, out float3 normal)
+{
+    depth = 0.0f;
+    normal = float3(0.0f, 0.0f, 0.0f);
+
+    if (length(float2(length(o.xz) - param.x, o.y)) < param.y)
+    {
+        normal = GetTorusNormal(o, param);
+        return true;
+    }
+
+    // The ring is in xz, and the quartic is written with it in xy
+    const float3 ro = o.xzy;
+    const float3 rd = d.xzy;
+    const float ra2 = param.x * param.x;
+    const float rb2 = param.y * param.y;
+    const float m = dot(ro, ro);
+    const float n = dot(ro, rd);
+
+    // Bounding sphere
+    const float bound = param.x + param.y;
+    if (n * n - m + bound * bound < 0.0f)
+        return false;
+
+    const float k = (m - rb2 - ra2) * 0.5f;
+    float k3 = n;
+    float k2 = n * n + ra2 * rd.z * rd.z + k;
+    float k1 = k * n + ra2 * ro.z * rd.z;
+    float k0 = k * k + ra2 * ro.z * ro.z - ra2 * rb2;
+
+    // Solve for 1 / t instead when the cubic term would vanish
+    const bool inverted = abs(k3 * (k3 * k3 - k2) + k1) < 0.01f;
+    if (inverted)
+    {
+        const float swap = k1;
+        k1 = k3;
+        k3 = swap;
+        k0 = 1.0f / k0;
+        k1 *= k0;
+        k2 *= k0;
+        k3 *= k0;
+    }
+
+    float c2 = 2.0f * k2 - 3.0f * k3 * k3;
+    float c1 = k3 * (k3 * k3 - k2) + k1;
+    float c0 = k3 * (k3 * (-3.0f * k3 * k3 + 4.0f * k2) - 8.0f * k1) + 4.0f * k0;
+    c2 /= 3.0f;
+    c1 *= 2.0f;
+    c0 /= 3.0f;
+
+    const float q = c2 * c2 + c0;
+    const float r = 3.0f * c0 * c2 - c2 * c2 * c2 - c1 * c1;
+    const float h = r * r - q * q * q;
+    float z;
+    if (h < 0.0f)
+    {
+        const float sq = sqrt(q);
+        z = 2.0f * sq * cos(acos(clamp(r / (sq * q), -1.0f, 1.0f)) / 3.0f);
+    }
+    else
+    {
+        const float sq = pow(sqrt(h) + abs(r), 1.0f / 3.0f);
+        z = sign(r) * abs(sq + q / sq);
+    }
+    z = c2 - z;
+
+    float d1 = z - 3.0f * c2;
+    float d2 = z * z - 3.0f * c0;
+    if (abs(d1) < 1.0e-4f)
+    {
+        if (d2 < 0.0f)
+            return false;
+        d2 = sqrt(d2);
+    }
+    else
+    {
+        if (d1 < 0.0f)
+            return false;
+        d1 = sqrt(d1 * 0.5f);
+        d2 = c1 / d1;
+    }
+
+    float result = ANALYTIC_FAR;
+    const float2 discriminants = float2(d1 * d1 - z + d2, d1 * d1 - z - d2);
+    const float2 offsets = float2(-d1, d1);
+    [unroll]
+    for (int i = 0; i < 2; ++i)
+    {
+        if (discriminants[i] <= 0.0f)
+            continue;
+
+        float2 t = offsets[i] + float2(-1.0f, 1.0f) * sqrt(discriminants[i]) - k3;
+        t = inverted ? 2.0f / t : t;
+        if (t.x > 0.0f)
+            result = min(result, t.x);
+        if (t.y > 0.0f)
+            result = min(result, t.y);
+    }
+    if (result >= ANALYTIC_FAR)
+        return false;
+
+    depth = result;
+    normal = GetTorusNormal(o + d * depth, param);
+    return true;
+}
+
+// Parameters a primitive's snippet draws a closed shape with. Analytic objects without them are skipped,
+// where marching would draw a degenerate or empty shape.
+bool HasAnalyticParameters(int type, float3 param)
+{
+    switch (type)
+    {
+    case ANALYTIC_SPHERE: return param.x > 0.0f;
+    case ANALYTIC_TORUS:
+    case ANALYTIC_CYLINDER: return param.x > 0.0f && param.y > 0.0f;
+    default: return all(param > 0.0f);
+    }
+}
+
+// Radius of a sphere about the local origin containing the primitive
+float GetPrimitiveBoundingRadius(int type, float3 param)
+{
+    switch (type)
+    {
+    case ANALYTIC_SPHERE: return param.x;
+    case ANALYTIC_BOX: return length(param);
+    case ANALYTIC_TORUS: return param.x + param.y;
+    case ANALYTIC_CONE: return param.z * sqrt(1.0f + (param.x / param.y) * (param.x / param.y));
+    default: return length(param.xy);
+    }
+}
+
+bool IntersectPrimitive(int type, float3 o, float3 d, float3 param, out float depth, out float3 normal)
+{
+    switch (type)
+    {
+    case ANALYTIC_SPHERE: return IntersectSphere(o, d, param, depth, normal);
+    case ANALYTIC_BOX: return IntersectBox(o, d, param, depth, normal);
+    case ANALYTIC_TORUS: return IntersectTorus(o, d, param, depth, normal);
+    case ANALYTIC_CONE: return IntersectCone(o, d, param, depth, normal);
+    default: return IntersectCylinder(o, d, param, depth, normal);
+    }
+}
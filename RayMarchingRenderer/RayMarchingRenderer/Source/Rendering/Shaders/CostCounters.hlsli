@@ -0,0 +1,75 @@
+// Per-pixel cost counters, compiled in when RAYMARCH_COST_COUNTERS is defined
+// (see RayMarchingManagerComponent::GetSceneShaderDefines). Counts are kept per
+// invocation and written out by the pass that owns the pixel. Mirrored on the
+// CPU by CPU/CostCounters.h and CPU/ObjectCosts.h.
+//
+// Shaders marching the scene with counters define RAYMARCH_OBJECT_COST_UAV as
+// the register of the per-object counter buffer before including this.
+
+#ifdef RAYMARCH_COST_COUNTERS
+
+struct CostCounters
+{
+    uint normalEvaluations; // CalculateNormal calls
+    uint sdfEvaluations; // Every GetDistanceToScene call
+    uint shadowSteps[RAYMARCH_MAX_LIGHTS]; // Shadow ray SDF evaluations
+    uint objectNearest[RAYMARCH_MAX_OBJECTS]; // Scene evaluations each object supplied the distance for
+};
+
+static CostCounters Cost = (CostCounters) 0;
+
+void AddShadowCost(int light, uint evaluations)
+{
+    Cost.shadowSteps[light] += evaluations;
+    Cost.sdfEvaluations += evaluations;
+}
+
+#define COST_ADD(member, count) Cost.member += (count)
+#define COST_ADD_SHADOW(light, count) AddShadowCost(light, count)
+#define COST_ADD_NEAREST(index) Cost.objectNearest[index]++
+
+// Scene evaluations per object summed over the frame, read by RenderPassCostView
+RWByteAddressBuffer ObjectCosts : register(RAYMARCH_OBJECT_COST_UAV);
+
+// One atomic per object this invocation evaluated nearest, at the end of the pixel
+void FlushObjectCosts()
+{
+    for (uint i = 0; i < RAYMARCH_MAX_OBJECTS; ++i)
+    {
+        if (Cost.objectNearest[i] > 0)
+            ObjectCosts.InterlockedAdd(i * 4, Cost.objectNearest[i]);
+    }
+}
+
+uint GetShadowStepsTotal()
+{
+    uint total = 0;
+    [unroll]
+    for (int i = 0; i < RAYMARCH_MAX_LIGHTS; ++i)
+        total += Cost.shadowSteps[i];
+    return total;
+}
+
+// Shadow steps of each light in 10 bits, three lights per channel. A shadow
+// ray takes at most MaxSteps (1000 in the GUI) steps, so nothing saturates.
+uint4 PackShadowSteps()
+{
+    uint4 packed = 0;
+    [unroll]
+    for (int i = 0; i < RAYMARCH_MAX_LIGHTS; ++i)
+        packed[i / 3] |= min(Cost.shadowSteps[i], 1023u) << ((i % 3) * 10);
+    return packed;
+}
+
+#else
+
+#define COST_ADD(member, count)
+#define COST_ADD_SHADOW(light, count)
+#define COST_ADD_NEAREST(index)
+
+#endif
+
+uint UnpackShadowSteps(uint4 packed, uint light)
+{
+    return (packed[light / 3] >> ((light % 3) * 10)) & 1023u;
+}
@@ -0,0 +1,103 @@
+#define RAYMARCH_MAX_LIGHTS 10
+#include "CostCounters.hlsli"
+
+Texture2D<uint4> InCost : register(t0);
+Texture2D<uint4> InShadowCost : register(t1);
+Texture2D<uint4> InReflectionCost : register(t2);
+
+RWTexture2D<float4> Output : register(u0);
+RWByteAddressBuffer Histograms : register(u1);
+
+// Metric order of CPU::CostMetric
+#define COST_METRIC_COUNT 15
+#define COST_HISTOGRAM_BINS 64
+
+cbuffer CostViewSettings : register(b4)
+{
+    uint2 Resolution; // Viewport size, targets may be larger
+    uint ReflectionScale; // Full resolution pixels per traced reflection pixel, along each axis
+    uint Metric; // Shown in the heatmap
+    float HeatmapMax; // Cost shown as red
+    uint3 PADDING;
+    uint4 BinWidths[4]; // Per metric
+}
+
+// Colours each pixel by the cost of one counter and accumulates histograms of
+// every counter. Counters are written by the G-buffer pass (PixelShader.hlsl)
+// and reflection trace when built with RAYMARCH_COST_COUNTERS.
+//
+// Histogram buffer layout, in uints: bins [metric][bin], then the 64 bit sum
+// of each metric as low and high words, then the maximum of each metric.
+
+groupshared uint GroupBins[COST_METRIC_COUNT * COST_HISTOGRAM_BINS];
+groupshared uint GroupSums[COST_METRIC_COUNT];
+groupshared uint GroupMax[COST_METRIC_COUNT];
+
+// Blue (cheap) to red (expensive), the same ramp as CPU::CalculateHeatmapColour
+float3 HeatmapColour(float t)
+{
+    const float s = saturate(t) * 4.0f;
+    return saturate(1.5f - abs(s - float3(3.0f, 2.0f, 1.0f)));
+}
+
+[numthreads(8, 8, 1)]
+void main(uint3 DTid : SV_DispatchThreadID, uint GI : SV_GroupIndex)
+{
+    for (uint i = GI; i < COST_METRIC_COUNT * COST_HISTOGRAM_BINS; i += 64)
+        GroupBins[i] = 0;
+    if (GI < COST_METRIC_COUNT)
+    {
+        GroupSums[GI] = 0;
+        GroupMax[GI] = 0;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    if (all(DTid.xy < Resolution))
+    {
+        const uint4 cost = InCost[DTid.xy];
+        const uint4 shadowCost = InShadowCost[DTid.xy];
+
+        // A reflection ray is traced per ReflectionScale x ReflectionScale block, its cost is spread over the block
+        const uint blockSize = ReflectionScale * ReflectionScale;
+        const uint4 reflectionCost = (InReflectionCost[DTid.xy / ReflectionScale] + blockSize / 2) / blockSize;
+
+        uint values[COST_METRIC_COUNT];
+        values[0] = cost.x; // Primary steps
+        values[1] = cost.y + reflectionCost.y; // Normal evaluations
+        values[2] = cost.z + reflectionCost.z; // Shadow steps
+        values[3] = reflectionCost.x; // Reflection steps
+        values[4] = cost.w + reflectionCost.w; // SDF evaluations
+        [unroll]
+        for (uint light = 0; light < RAYMARCH_MAX_LIGHTS; ++light)
+            values[5 + light] = UnpackShadowSteps(shadowCost, light);
+
+        [unroll]
+        for (uint m = 0; m < COST_METRIC_COUNT; ++m)
+        {
+            const uint bin = min(values[m] / BinWidths[m / 4][m % 4], COST_HISTOGRAM_BINS - 1);
+            InterlockedAdd(GroupBins[m * COST_HISTOGRAM_BINS + bin], 1);
+            InterlockedAdd(GroupSums[m], values[m]);
+            InterlockedMax(GroupMax[m], values[m]);
+        }
+
+        Output[DTid.xy] = float4(HeatmapColour(values[Metric] / max(HeatmapMax, 1.0f)), 1.0f);
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    // One global atomic per non-empty bin of the group
+    for (uint j = GI; j < COST_METRIC_COUNT * COST_HISTOGRAM_BINS; j += 64)
+        if (GroupBins[j])
+            Histograms.InterlockedAdd(j * 4, GroupBins[j]);
+
+    if (GI < COST_METRIC_COUNT)
+    {
+        // 64 bit sum, carrying into the high word when the low word wraps
+        const uint sumAddress = (COST_METRIC_COUNT * COST_HISTOGRAM_BINS + GI * 2) * 4;
+        uint previous;
+        Histograms.InterlockedAdd(sumAddress, GroupSums[GI], previous);
+        if (previous + GroupSums[GI] < previous)
+            Histograms.InterlockedAdd(sumAddress + 4, 1);
+
+        Histograms.InterlockedMax((COST_METRIC_COUNT * (COST_HISTOGRAM_BINS + 2) + GI) * 4, GroupMax[GI]);
+    }
+}
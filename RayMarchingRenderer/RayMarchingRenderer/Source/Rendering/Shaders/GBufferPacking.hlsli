@@ -0,0 +1,49 @@
+// Compact G-buffer encoding, mirrored on the CPU by CPU/GBuffer.cpp.
+//
+//   SV_Target0 Colour   R16G16B16A16_FLOAT  HDR colour
+//   SV_Target1 Normal   R16G16_SNORM        Octahedral encoded world normal
+//   SV_Target2 Depth    R32_FLOAT/R16_UNORM Depth / maxDist
+//   SV_Target3 Material R8G8B8A8_UNORM      Metalicness, roughness, (object index + 1) / 255, unused
+//
+// Storage conversion is done by the output merger on write and by the
+// texture units on read, so only the encodings live here.
+
+float2 SignNotZero(float2 v)
+{
+    return float2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+}
+
+// Octahedral normal mapping into [-1, 1]^2 (Cigolle et al. 2014)
+float2 OctahedralEncode(float3 n)
+{
+    const float l1 = abs(n.x) + abs(n.y) + abs(n.z);
+    if (l1 <= 0.0f)
+        return float2(0.0f, 0.0f); // Misses have no normal
+
+    float2 e = n.xy / l1;
+    if (n.z < 0.0f)
+        e = (1.0f - abs(e.yx)) * SignNotZero(e);
+    return e;
+}
+
+float3 OctahedralDecode(float2 e)
+{
+    float3 n = float3(e, 1.0f - abs(e.x) - abs(e.y));
+    if (n.z < 0.0f)
+        n.xy = (1.0f - abs(e.yx)) * SignNotZero(e);
+    return normalize(n);
+}
+
+// Object index -1 (miss) to 254 stored exactly in an 8 bit UNORM channel
+#if defined(RAYMARCH_MAX_OBJECTS) && RAYMARCH_MAX_OBJECTS > 255
+#error Object indices must fit the 8 bit material channel, see CPU::MaxEncodedObjectIndex
+#endif
+float EncodeObjectIndex(int index)
+{
+    return (index + 1) / 255.0f;
+}
+
+int DecodeObjectIndex(float encoded)
+{
+    return (int) round(encoded * 255.0f) - 1;
+}
@@ -0,0 +1,326 @@
+// Scene constant buffers and ray marching functions shared by the
+// pixel shader and the compute passes that march the scene.
+
+TextureCube SkyboxTex : register(t0);
+SamplerState Sampler : register(s0);
+
+// Constant Buffers
+cbuffer RenderSettings : register(b0)
+{
+    struct RS
+    {
+        uint2 resolution;
+        unsigned int maxSteps;
+        float maxDist;
+        float intersectionThreshold;
+		float AmbientOcclusionStrength;
+        float footprintScale; // Multiplies the pixel cone footprint SDFs drop detail below, 0 keeps all of it
+        // Hit threshold from the ray's pixel cone, see GetIntersectionThreshold
+        float coneThresholdScale;
+        float secondaryConeThresholdScale;
+        float minThreshold;
+        float maxThreshold;
+
+
+        float PADDING;
+    } renderSettings;
+}
+
+cbuffer Camera : register(b1)
+{
+    struct WC
+    {
+        matrix view;
+        float3 position;
+        float fov;
+    } camera;
+}
+
+#define RAYMARCH_MAX_OBJECTS 30
+cbuffer RayMarchScene : register(b2)
+{
+	struct Object
+	{
+        float4 Position;
+        float4 Rotation;
+        float4 Scale;
+		float3 Parameters;
+		unsigned int SDFType;
+		unsigned int BoolOperator;
+
+        // Material
+        float3 Colour;
+        float Metalicness;
+        float Roughness;
+
+        float StepScale; // Multiplies the distance, 1 / the SDF's Lipschitz estimate when it overestimates
+        float BlendRadius; // Largest difference between distances the smooth operators blend
+	} ObjectsList[RAYMARCH_MAX_OBJECTS];
+
+    // Copies of each object, as CPU::Repetition. Only objects generated as repeated read theirs.
+    struct Repetition
+    {
+        float3 Spacing;
+        unsigned int Mode;
+        float3 Limit;
+        float Variation;
+    } RepetitionsList[RAYMARCH_MAX_OBJECTS];
+}
+
+#define RAYMARCH_MAX_LIGHTS 10
+cbuffer RayMarchLights : register(b3)
+{
+	struct Light
+	{
+		float4 Position;
+		float3 Colour;
+        float ShadowSharpness;
+		float ConstantAttenuation;
+		float LinearAttenuation;
+		float QuadraticAttenuation;
+
+		float PADDING;
+	} LightsList[RAYMARCH_MAX_LIGHTS];
+};
+
+struct SceneDistanceInfo
+{
+    float distance;
+    int index;
+};
+
+#include "CostCounters.hlsli"
+#include "AnalyticPrimitives.hlsli"
+#include "SDFGradients.hlsli"
+#include "GeneratedSceneDistance.hlsli"
+
+// Cone a pixel sweeps out along a ray path. Its radius at depth t along the
+// current ray is (offset + t) * angle, with offset the path length before the
+// ray's origin.
+struct RayCone
+{
+    float angle;
+    float offset;
+};
+
+float GetConeRadius(RayCone cone, float depth)
+{
+    return (cone.offset + depth) * cone.angle;
+}
+
+// Footprint passed to the SDFs
+float GetConeFootprint(RayCone cone, float depth)
+{
+    return GetConeRadius(cone, depth) * renderSettings.footprintScale;
+}
+
+// Distance below which a ray at depth along cone has hit: intersectionThreshold, or the cone's radius
+// times coneScale (coneThresholdScale for primary rays) clamped to [minThreshold, maxThreshold]
+float GetIntersectionThreshold(RS rs, float coneScale, RayCone cone, float depth)
+{
+    if (coneScale <= 0.0f)
+        return rs.intersectionThreshold;
+    return clamp(GetConeRadius(cone, depth) * coneScale, rs.minThreshold, rs.maxThreshold);
+}
+
+// Offset along the normal for rays leaving a hit at depth along cone, clear of the threshold the hit
+// was found at and of the one the new ray starts with
+float GetSurfaceOffset(RS rs, RayCone cone, float depth, float secondaryScale)
+{
+    RayCone secondary = cone;
+    secondary.offset += depth;
+    return 2.0f * max(GetIntersectionThreshold(rs, rs.coneThresholdScale, cone, depth),
+                      GetIntersectionThreshold(rs, secondaryScale, secondary, 0.0f));
+}
+
+// Ray Marching
+struct Ray
+{
+    bool hit;
+    float3 hitPosition;
+    float3 hitNormal;
+    int hitIndex;
+    float depth;
+    uint stepCount;
+    RayCone cone;
+};
+
+// Near p the scene distance is the distance to the object that last set it, negated when that object was
+// subtracted, so the scene's gradient is that object's, unless objects blend there (see GetSceneGradient).
+// offset spaces the taps.
+float3 CalculateNormal(float3 p, float footprint, float offset)
+{
+    COST_ADD(normalEvaluations, 1);
+    return normalize(GetSceneGradient(p, footprint, offset));
+}
+
+Ray RayMarch(float3 ro, float3 rd, RS rs, RayCone cone)
+{
+    // Initialise ray
+    Ray ray;
+    ray.hit = false;
+    ray.hitPosition = float3(0.0f, 0.0f, 0.0f);
+    ray.hitNormal = float3(0.0f, 0.0f, 0.0f);
+    ray.hitIndex = -1;
+    ray.depth = 0.0f;
+    ray.stepCount = 0;
+    ray.cone = cone;
+
+    // Analytic primitives are hit exactly, so marching only looks for the other objects in front of them
+    const AnalyticHit analytic = IntersectAnalyticPrimitives(ro, rd, rs.maxDist);
+    
+    // Step along ray direction
+    [loop]
+    for (; ray.stepCount < rs.maxSteps; ++ray.stepCount)
+    {
+        const float footprint = GetConeFootprint(cone, ray.depth);
+        SceneDistanceInfo distInfo = GetDistanceToMarchedObjects(ro + rd * ray.depth, footprint);
+        COST_ADD(sdfEvaluations, 1);
+
+        // If distance less than threshold, ray has intersected
+        const float threshold = GetIntersectionThreshold(rs, rs.coneThresholdScale, cone, ray.depth);
+        if (distInfo.distance < threshold)
+        {
+            ray.hit = true;
+            ray.hitPosition = ro + rd * ray.depth;
+            ray.hitNormal = CalculateNormal(ray.hitPosition, footprint, 0.5f * threshold);
+            ray.hitIndex = distInfo.index;
+                    
+            return ray;
+        }
+        
+        // Increment total depth by distance to scene
+        ray.depth += distInfo.distance;
+        if (ray.depth > analytic.depth)
+            break;
+    }
+
+    if (analytic.index >= 0)
+    {
+        ray.hit = true;
+        ray.depth = analytic.depth;
+        ray.hitPosition = ro + rd * ray.depth;
+        ray.hitNormal = analytic.normal;
+        ray.hitIndex = analytic.index;
+    }
+    
+    return ray;
+}
+
+float ShadowMarch(float3 ro, int lightIdx, RayCone cone)
+{
+    float result = 1.0f;
+
+    const float3 rd = normalize(LightsList[lightIdx].Position.xyz - ro);
+
+    // Marching would stop on any analytic primitive between here and the light
+    if (IntersectAnalyticPrimitives(ro, rd, min(distance(ro, LightsList[lightIdx].Position.xyz), renderSettings.maxDist)).index >= 0)
+        return 0.0f;
+
+    float depth = 0;
+    uint evaluations = 0;
+    [loop]
+    for (int i = 0; i < renderSettings.maxSteps; ++i)
+    {
+        const float3 p = ro + rd * depth;
+        const SceneDistanceInfo distInfo = GetDistanceToScene(p, GetConeFootprint(cone, depth));
+        ++evaluations;
+
+        // If ray is able to become close to light, there is no shadow.
+        if (dot(normalize(LightsList[lightIdx].Position.xyz - p), rd) < 0)
+            break;
+
+        // If distance less than threshold, ray has intersected
+        if (distInfo.distance < GetIntersectionThreshold(renderSettings, renderSettings.secondaryConeThresholdScale, cone, depth))
+        {
+            result = 0.0f;
+            break;
+        }
+
+        // Soft shadowing
+        result = min(result, LightsList[lightIdx].ShadowSharpness * distInfo.distance / depth);
+        
+        // Increment total depth by distance to light
+        depth += distInfo.distance;
+        if (depth > renderSettings.maxDist)
+            break;
+    }
+
+    COST_ADD_SHADOW(lightIdx, evaluations);
+    return result;
+}
+
+float CalculateDiffuse(float3 n, float3 ld)
+{
+    return saturate(dot(n, ld));
+}
+
+float CalculateSpecular(float3 rd, float3 ref, float li, float s)
+{
+    return saturate(li * pow(dot(rd, ref), s));
+}
+
+float3 CalculateLightColour(Ray ray)
+{
+    float3 lightCol = float3(0.0f, 0.0f, 0.0f);
+    const float3 rd = normalize(ray.hitPosition - camera.position);
+
+    // Shadow rays carry on the cone from the hit
+    RayCone shadowCone = ray.cone;
+    shadowCone.offset += ray.depth;
+    const float shadowOffset = GetSurfaceOffset(renderSettings, ray.cone, ray.depth, renderSettings.secondaryConeThresholdScale);
+
+    [unroll(RAYMARCH_MAX_LIGHTS)]
+    for (int i = 0; i < RAYMARCH_MAX_LIGHTS; ++i)
+    {
+        const float diffuse = CalculateDiffuse(ray.hitNormal, normalize(LightsList[i].Position.xyz - ray.hitPosition));
+
+        float specular = 0.0f;
+        float shadowAmount = 1.0f;
+        if (diffuse > 0.0f)
+        {
+            specular = CalculateSpecular(rd, 
+										reflect(ray.hitNormal, normalize(LightsList[i].Position.xyz - ray.hitPosition)), 
+										1.0f, 
+										(1.0f - ObjectsList[ray.hitIndex].Roughness) * 256.0f + 2.0f);
+            shadowAmount = ShadowMarch(ray.hitPosition + ray.hitNormal * shadowOffset, i, shadowCone);
+        }
+
+        const float d = distance(ray.hitPosition, LightsList[i].Position.xyz);
+        const float attentuation = 1.0f / (LightsList[i].ConstantAttenuation + LightsList[i].LinearAttenuation * d + LightsList[i].QuadraticAttenuation * d * d);
+
+        lightCol += LightsList[i].Colour * ((diffuse * shadowAmount + specular) * attentuation);
+    }
+
+    return lightCol;
+}
+
+float4 CalculateSkyColour(float3 dir)
+{
+    float2 uv = float2(atan2(dir.x, dir.z) / (2 * 3.142f) + 0.5,
+					   dir.y * 0.5 + 0.5);
+
+
+    return SkyboxTex.SampleLevel(Sampler, dir, 0.0f);
+}
+
+// Primary ray direction through a viewport texture coordinate
+float3 CalculateRayDirection(float2 texCoord)
+{
+    const float aspectRatio = renderSettings.resolution[0] / (float) renderSettings.resolution[1];
+    float2 uv = texCoord;
+    uv.y = 1.0f - uv.y; // Flip UV on Y axis
+    uv = uv * 2.0f - 1.0f; // Move UV to (-1, 1) range
+    uv.x *= aspectRatio; // Apply viewport aspect ratio
+
+    return normalize(mul(transpose(camera.view), float4(uv, tan(-camera.fov), 0.0f)).xyz);
+}
+
+// Half the angle one pixel subtends at the centre of the view, the primary rays' cone angle.
+// The image plane spans 2 units over the viewport height at tan(-fov) from the eye.
+float CalculatePixelConeAngle()
+{
+    return 1.0f / (renderSettings.resolution[1] * abs(tan(-camera.fov)));
+}
+
+
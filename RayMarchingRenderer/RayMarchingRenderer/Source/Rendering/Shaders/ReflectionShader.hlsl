@@ -1,47 +1,61 @@
 Texture2D<float4> InColour : register(t0);
-Texture2D<float4> InNormDepth : register(t1);
-Texture2D<float4> InReflectionColDepth : register(t2);
-Texture2D<float2> InMetalicnessRoughness : register(t3);
+Texture2D<float4> InReflectionColDepth : register(t1);
+Texture2D<float4> InMaterial : register(t2);
+
+SamplerState LinearClampSampler : register(s0);
 
 RWTexture2D<float4> Output : register(u0);
 
+// Leading member of the Ray Marching Manager's render settings, bound to b0
+cbuffer RenderSettings : register(b0)
+{
+    uint2 Resolution; // Viewport size, targets may be larger
+}
+
 // Combines object colour with reflection colour.
 //
-// Reflection is blurred based on surface roughness
-// using the gaussian blur algorithm from:
-// https://xorshaders.weebly.com/tutorials/blur-shaders-5-part-2
+// Reflection is blurred based on surface roughness. The reflection
+// colour target is traced by ReflectionTraceShader.hlsl, possibly at
+// reduced resolution, and has its mip chain generated once per frame, so each
+// pixel samples the level whose texel footprint matches the blur
+// radius. Four offset trilinear taps hide the box filter's blockiness,
+// making the cost independent of the radius (previously 96 taps).
+// Mirrored on the CPU by CPU/ReflectionComposite.cpp.
+
+static const float BlurSize = 50.0f; // Blur radius in pixels at roughness 1
 
 [numthreads(8, 8, 1)]
 void main(uint3 DTid : SV_DispatchThreadID)
 {
-    Output[DTid.xy] = float4(InNormDepth[DTid.xy].rgb, 1.0f);
+    if (any(DTid.xy >= Resolution))
+        return;
 
-    const float PI2 = 6.283185f;
+    uint width, height, numLevels;
+    InReflectionColDepth.GetDimensions(0, width, height, numLevels);
 
-    const float size = 50.0f;
-    const float directions = 16.0f;
-    const float quality = 6.0f;
+    const float3 colour = InColour[DTid.xy].rgb;
+    const float2 metalRough = InMaterial[DTid.xy].xy;
 
     float3 blurredReflection = InReflectionColDepth[DTid.xy].rgb;
-    if (InMetalicnessRoughness[DTid.xy].x)
+    if (metalRough.x)
     {
-        [unroll(directions)]
-        for (float d = 0.0; d < PI2; d += PI2 / directions)
-        {
-            [unroll(quality)]
-            for (float i = 1.0 / quality; i <= 1.0; i += 1.0 / quality)
-            {
-                float newSize = InMetalicnessRoughness[DTid.xy].g * size;
-                float2 uv = DTid.xy + float2(cos(d), sin(d)) * newSize * i;
-                blurredReflection += InReflectionColDepth[uv].rgb;
-            }
-        }
-
-        blurredReflection /= quality * directions - 15.0f;
+        const float2 size = float2(width, height);
+        const float radius = metalRough.y * BlurSize;
+        const float lod = clamp(log2(max(radius, 1.0f)), 0.0f, numLevels - 1.0f);
+        const float2 uv = (DTid.xy + 0.5f) / size;
+        const float2 offset = 0.5f * radius / size;
+        // The pool allocates mip chained targets at the exact viewport size, so the pyramid holds only rendered
+        // texels and this clamp is all that keeps taps inside it
+        const float2 maxUv = (Resolution - 0.5f) / size;
+
+        blurredReflection = 0.25f * (InReflectionColDepth.SampleLevel(LinearClampSampler, min(uv + float2(-offset.x, -offset.y), maxUv), lod).rgb +
+                                     InReflectionColDepth.SampleLevel(LinearClampSampler, min(uv + float2( offset.x, -offset.y), maxUv), lod).rgb +
+                                     InReflectionColDepth.SampleLevel(LinearClampSampler, min(uv + float2(-offset.x,  offset.y), maxUv), lod).rgb +
+                                     InReflectionColDepth.SampleLevel(LinearClampSampler, min(uv + float2( offset.x,  offset.y), maxUv), lod).rgb);
     }
 
-    Output[DTid.xy] = float4(lerp(InColour[DTid.xy].rgb, 
-								  lerp(InColour[DTid.xy].rgb, blurredReflection, 0.6f), 
-								  InMetalicnessRoughness[DTid.xy].r), 
+    Output[DTid.xy] = float4(lerp(colour,
+								  lerp(colour, blurredReflection, 0.6f),
+								  metalRough.r),
 							 1.0f);
-}
\ No newline at end of file
+}
@@ -0,0 +1,92 @@
+#define RAYMARCH_OBJECT_COST_UAV u3
+#include "RayMarching.hlsli"
+#include "GBufferPacking.hlsli"
+
+Texture2D<float2> InNormal : register(t1);
+Texture2D<float> InDepth : register(t2);
+Texture2D<float4> InMaterial : register(t3);
+
+RWTexture2D<float4> Output : register(u0);
+RWByteAddressBuffer RayCounter : register(u1);
+#ifdef RAYMARCH_COST_COUNTERS
+RWTexture2D<uint4> CostOutput : register(u2); // Reflection steps, normal evaluations, shadow steps, SDF evaluations
+#endif
+
+cbuffer ReflectionTraceSettings : register(b4)
+{
+    uint2 Resolution; // Viewport size, targets may be larger
+    uint Scale; // Full resolution pixels per traced pixel, along each axis
+    uint PADDING;
+}
+
+// Marches reflection rays from the G-buffer, one ray per Scale x Scale
+// block of pixels, into a reduced resolution target. The result is
+// brought back to full resolution by ReflectionUpsampleShader.hlsl.
+
+groupshared uint GroupRayCount;
+
+[numthreads(8, 8, 1)]
+void main(uint3 DTid : SV_DispatchThreadID, uint GI : SV_GroupIndex)
+{
+    if (GI == 0)
+        GroupRayCount = 0;
+    GroupMemoryBarrierWithGroupSync();
+
+    const uint2 outputSize = (Resolution + Scale - 1) / Scale;
+
+    if (all(DTid.xy < outputSize))
+    {
+        // Trace from the centre pixel of the block this thread covers
+        const uint2 pixel = min(DTid.xy * Scale + Scale / 2, Resolution - 1);
+        const float3 rd = CalculateRayDirection((pixel + 0.5f) / float2(Resolution));
+        const float4 material = InMaterial[pixel];
+
+        float4 result = float4(CalculateSkyColour(rd).rgb, renderSettings.maxDist);
+        if (DecodeObjectIndex(material.z) >= 0)
+        {
+            const float3 normal = OctahedralDecode(InNormal[pixel]);
+            const float3 hitPosition = camera.position + rd * InDepth[pixel] * renderSettings.maxDist;
+            const float3 refDir = reflect(rd, normal);
+
+            // Reflection, with render settings of lower fidelity
+            RS rs = renderSettings;
+            rs.maxSteps /= 2;
+            rs.coneThresholdScale = rs.secondaryConeThresholdScale;
+
+            Ray refRay = (Ray) 0; // reflection ray
+            refRay.hitIndex = -1;
+            float3 refLight = float3(0.8f, 0.8f, 0.8f);
+            if (material.x)
+            {
+                InterlockedAdd(GroupRayCount, 1);
+
+                // The reflected cone carries on from the primary hit, a traced pixel wide
+                RayCone cone;
+                cone.angle = CalculatePixelConeAngle() * Scale;
+                cone.offset = 0.0f;
+                const float depth = InDepth[pixel] * renderSettings.maxDist;
+                const float offset = GetSurfaceOffset(renderSettings, cone, depth, rs.coneThresholdScale);
+                cone.offset = depth;
+                refRay = RayMarch(hitPosition + normal * offset, refDir, rs, cone);
+                refLight = CalculateLightColour(refRay);
+            }
+
+            // Choose colour based on if reflection ray hit
+            const float3 refCol = lerp(CalculateSkyColour(refDir).rgb,
+                                       ObjectsList[refRay.hitIndex].Colour,
+                                       refRay.hit);
+
+            result = float4(refCol * lerp(float3(1, 1, 1), 0.2f + refLight, refRay.hit), refRay.depth);
+        }
+
+        Output[DTid.xy] = result;
+#ifdef RAYMARCH_COST_COUNTERS
+        CostOutput[DTid.xy] = uint4(refRay.stepCount, Cost.normalEvaluations, GetShadowStepsTotal(), Cost.sdfEvaluations);
+        FlushObjectCosts();
+#endif
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+    if (GI == 0 && GroupRayCount)
+        RayCounter.InterlockedAdd(0, GroupRayCount);
+}
@@ -0,0 +1,76 @@
+#include "GBufferPacking.hlsli"
+
+Texture2D<float2> InNormal : register(t0);
+Texture2D<float> InDepth : register(t1);
+Texture2D<float4> InMaterial : register(t2);
+Texture2D<float4> InTracedReflection : register(t3);
+
+RWTexture2D<float4> Output : register(u0);
+
+cbuffer ReflectionTraceSettings : register(b4)
+{
+    uint2 Resolution; // Viewport size, targets may be larger
+    uint Scale; // Full resolution pixels per traced pixel, along each axis
+    uint PADDING;
+}
+
+// Joint bilateral upsample of the reduced resolution reflection trace.
+//
+// Each full resolution pixel blends the four nearest traced pixels,
+// weighting the bilinear weights by how closely the G-buffer depth,
+// normal and object index at the traced pixel match its own. This
+// stops reflections bleeding across silhouettes and between objects.
+
+static const float DepthSigma = 0.02f; // Relative depth difference at which weight falls to 1/e
+static const float NormalPower = 16.0f;
+
+[numthreads(8, 8, 1)]
+void main(uint3 DTid : SV_DispatchThreadID)
+{
+    const uint2 fullSize = Resolution;
+    const uint2 tracedSize = (Resolution + Scale - 1) / Scale;
+
+    if (any(DTid.xy >= fullSize))
+        return;
+
+    const float3 normal = OctahedralDecode(InNormal[DTid.xy]);
+    const float depth = InDepth[DTid.xy];
+    const int index = DecodeObjectIndex(InMaterial[DTid.xy].z);
+
+    const float2 tracedPos = (DTid.xy + 0.5f) / Scale - 0.5f;
+    const int2 base = (int2) floor(tracedPos);
+    const float2 f = tracedPos - base;
+
+    float4 sum = float4(0.0f, 0.0f, 0.0f, 0.0f);
+    float weightSum = 0.0f;
+    float4 best = float4(0.0f, 0.0f, 0.0f, 0.0f);
+    float bestGuide = -1.0f;
+
+    [unroll]
+    for (int i = 0; i < 4; ++i)
+    {
+        const int2 offset = int2(i & 1, i >> 1);
+        const uint2 tap = (uint2) clamp(base + offset, int2(0, 0), int2(tracedSize) - 1);
+        const uint2 source = min(tap * Scale + Scale / 2, fullSize - 1); // Pixel the tap was traced from
+
+        const float depthWeight = exp(-abs(InDepth[source] - depth) / (DepthSigma * max(depth, 1e-4f)));
+        const float normalWeight = pow(saturate(dot(OctahedralDecode(InNormal[source]), normal)), NormalPower);
+        const float indexWeight = DecodeObjectIndex(InMaterial[source].z) == index ? 1.0f : 0.0f;
+        const float guide = depthWeight * normalWeight * indexWeight;
+
+        const float bilinear = (offset.x ? f.x : 1.0f - f.x) * (offset.y ? f.y : 1.0f - f.y);
+        const float4 value = InTracedReflection[tap];
+
+        sum += value * bilinear * guide;
+        weightSum += bilinear * guide;
+
+        // Fall back to the most similar tap when no tap matches (e.g. thin features)
+        if (guide > bestGuide)
+        {
+            bestGuide = guide;
+            best = value;
+        }
+    }
+
+    Output[DTid.xy] = weightSum > 1e-5f ? sum / weightSum : best;
+}
@@ -0,0 +1,54 @@
+// Exact gradients of the built-in primitive snippets, the closed forms that
+// forward mode differentiation of each gives (CPU/Dual.h runs it on the CPU
+// ports). They are unnormalised. The generated gradSdf function of a snippet
+// without one, edited or user written, takes central differences instead.
+
+// Chain rule through w = (length(p.xz), p.y), for the shapes of revolution about y
+float3 GradientFromRevolution(float3 p, float2 g)
+{
+    const float r = length(p.xz);
+    const float2 radial = r > 0.0f ? p.xz / r : float2(0.0f, 0.0f);
+    return float3(g.x * radial.x, g.y, g.x * radial.y);
+}
+
+float3 GradientSphere(float3 p, float3 param)
+{
+    return p;
+}
+
+float3 GradientBox(float3 p, float3 param)
+{
+    const float3 q = abs(p) - param.xyz;
+    if (any(q > 0.0f))
+        return sign(p) * max(q, 0.0f);
+
+    // Inside, the distance is to the nearest face
+    return sign(p) * (q.x > q.y && q.x > q.z ? float3(1.0f, 0.0f, 0.0f) : q.y > q.z ? float3(0.0f, 1.0f, 0.0f) : float3(0.0f, 0.0f, 1.0f));
+}
+
+float3 GradientTorus(float3 p, float3 param)
+{
+    return GradientFromRevolution(p, float2(length(p.xz) - param.x, p.y));
+}
+
+float3 GradientCone(float3 p, float3 param)
+{
+    // Away from the nearer of the side and the base, as in the snippet
+    const float2 q = param.z * float2(param.x / param.y, -1.0f);
+    const float2 w = float2(length(p.xz), p.y);
+    const float2 a = w - q * clamp(dot(w, q) / dot(q, q), 0.0f, 1.0f);
+    const float2 b = w - q * float2(clamp(w.x / q.x, 0.0f, 1.0f), 1.0f);
+    const float k = sign(q.y);
+    const float s = max(k * (w.x * q.y - w.y * q.x), k * (w.y - q.y));
+    return GradientFromRevolution(p, (dot(a, a) <= dot(b, b) ? a : b) * sign(s));
+}
+
+float3 GradientCylinder(float3 p, float3 param)
+{
+    const float2 w = float2(length(p.xz), p.y);
+    const float2 d = abs(w) - param.xy;
+    if (any(d > 0.0f))
+        return GradientFromRevolution(p, max(d, 0.0f) * sign(w));
+
+    return GradientFromRevolution(p, d.x > d.y ? float2(1.0f, 0.0f) : float2(0.0f, sign(w.y)));
+}
@@ -21,8 +21,191 @@ float3 Translate(float3 p, float3 t)
     return p - t;
 }
 
-// Distance function called from pixel shader
-SceneDistanceInfo GetDistanceToScene(float3 p)
+// Rotate's inverse, taking local space normals back to world space
+float3 InverseRotate(float3 p, float3 r)
+{
+    p.xy = mul(p.xy, Rotate2D(-r.z));
+    p.xz = mul(p.xz, Rotate2D(-r.y));
+    p.yz = mul(p.yz, Rotate2D(-r.x));
+
+    return p;
+}
+
+// Smooth operators, ported by CPU/SignedDistance.h. They only differ from min and max where the distances are
+// within radius of each other, so a blend never reaches further than radius from both operands.
+float SmoothUnion(float a, float b, float radius)
+{
+    const float h = radius - abs(a - b);
+    [branch]
+    if (h <= 0.0f)
+        return min(a, b);
+    return min(a, b) - h * h * 0.25f / radius;
+}
+
+float SmoothIntersection(float a, float b, float radius)
+{
+    return -SmoothUnion(-a, -b, radius);
+}
+
+// Derivative of SmoothUnion(a, b, radius) by b, 1 or 0 outside the blend
+float GetSmoothUnionWeight(float a, float b, float radius)
+{
+    const float h = max(radius - abs(a - b), 0.0f);
+    const float t = h > 0.0f ? h * 0.5f / radius : 0.0f;
+    return b < a ? 1.0f - t : t;
+}
+
+// Domain repetition, ported by CPU/SignedDistance.cpp
+#define REPETITION_GRID 1
+#define REPETITION_RADIAL 2
+#define REPETITION_MIRROR 3
+
+#define MAX_REPEATED_COPIES 8
+#define REPEATED_MAX_CELL 16777216.0f
+#define REPEATED_MAX_VARIATION 0.9f
+#define REPEATED_FAR 3.402823466e+38f
+
+struct RepeatedCopy
+{
+    float3 Point; // Relative to the copy's origin
+    float Scale;  // Of the copy, over the object's
+    float3 Flip;  // Sign the mirror took each axis by
+    float Angle;  // Rotation about y that took the point into the copy's sector
+};
+
+// Hash of a copy's cell to [0, 1)
+float HashCell(int3 cell)
+{
+    uint h = (asuint(cell.x) * 73856093u) ^ (asuint(cell.y) * 19349663u) ^ (asuint(cell.z) * 83492791u);
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return float(h >> 8) / 16777216.0f;
+}
+
+float GetCopyScale(Repetition repetition, int3 cell)
+{
+    return repetition.Variation > 0.0f ? 1.0f - min(repetition.Variation, REPEATED_MAX_VARIATION) * HashCell(cell) : 1.0f;
+}
+
+// Copies of a repeated object that can be nearest to local, a point in its rotated frame: the one in the cell (or
+// sector, or mirrored half) local is in and the neighbouring one towards local on each repeated axis
+uint GetRepeatedCopies(Repetition repetition, float3 local, out RepeatedCopy copies[MAX_REPEATED_COPIES])
+{
+    [unroll]
+    for (uint i = 0; i < MAX_REPEATED_COPIES; ++i)
+    {
+        copies[i].Point = local;
+        copies[i].Scale = 1.0f;
+        copies[i].Flip = float3(1.0f, 1.0f, 1.0f);
+        copies[i].Angle = 0.0f;
+    }
+
+    [branch]
+    if (repetition.Mode == REPETITION_GRID)
+    {
+        // Nearest cell on each axis and the neighbour on local's side of it, clamped to the limit when there is one
+        const bool3 repeated = repetition.Spacing > 0.0f;
+        const float3 spacing = repeated ? repetition.Spacing : 0.0f;
+        const float3 q = repeated ? clamp(local / (repeated ? spacing : 1.0f), -REPEATED_MAX_CELL, REPEATED_MAX_CELL) : 0.0f;
+        const float3 limit = floor(repetition.Limit);
+        float3 cell = round(q);
+        float3 next = cell + (q >= cell ? 1.0f : -1.0f);
+        cell = limit > 0.0f ? clamp(cell, -limit, limit) : cell;
+        next = repeated ? (limit > 0.0f ? clamp(next, -limit, limit) : next) : cell;
+        const uint neighbours = (cell.x != next.x ? 1u : 0u) | (cell.y != next.y ? 2u : 0u) | (cell.z != next.z ? 4u : 0u);
+
+        uint count = 0;
+        for (uint mask = 0; mask < MAX_REPEATED_COPIES; ++mask)
+        {
+            if ((mask & ~neighbours) != 0)
+                continue;
+
+            const float3 copyCell = float3((mask & 1u) ? next.x : cell.x, (mask & 2u) ? next.y : cell.y, (mask & 4u) ? next.z : cell.z);
+            copies[count].Point = local - copyCell * spacing;
+            copies[count].Scale = GetCopyScale(repetition, int3(copyCell));
+            ++count;
+        }
+        return count;
+    }
+    else if (repetition.Mode == REPETITION_RADIAL)
+    {
+        // Copies around y, the first on +x, and the nearest sector's neighbour on local's side of it
+        const int sectors = max(int(repetition.Limit.x), 1);
+        const float angle = 6.28318531f / float(sectors);
+        const float q = atan2(local.z, local.x) / angle;
+        const float nearest = round(q);
+        const float candidates[2] = { nearest, nearest + (q >= nearest ? 1.0f : -1.0f) };
+
+        const uint count = sectors > 1 ? 2 : 1;
+        for (uint i = 0; i < count; ++i)
+        {
+            copies[i].Angle = candidates[i] * angle;
+            copies[i].Point.xz = mul(local.xz, Rotate2D(copies[i].Angle));
+            copies[i].Point.x -= repetition.Spacing.x;
+            // Sectors wrap, so their cells do too. Candidates are never below -sectors.
+            copies[i].Scale = GetCopyScale(repetition, int3((int(candidates[i]) + sectors) % sectors, 0, 0));
+        }
+        return count;
+    }
+    else if (repetition.Mode == REPETITION_MIRROR)
+    {
+        const bool3 flipped = repetition.Limit != 0.0f && local < 0.0f;
+        copies[0].Flip = flipped ? -1.0f : 1.0f;
+        copies[0].Point = repetition.Limit != 0.0f ? abs(local) - repetition.Spacing : local;
+        copies[0].Scale = GetCopyScale(repetition, flipped ? 1 : 0);
+        return 1;
+    }
+
+    return 1;
+}
+
+// A copy's gradient, taken back to the object's rotated frame
+float3 UnrepeatGradient(float3 gradient, RepeatedCopy copy)
+{
+    gradient *= copy.Flip;
+    gradient.xz = mul(gradient.xz, Rotate2D(-copy.Angle));
+    return gradient;
+}
+
+// Sets result to the distance to the nearest copy of repeated object index, whose snippet is sdf<name>, as it
+// enters the scene distance. Expects p and footprint in scope.
+#define REPEATED_DISTANCE(name, index, result) \
+    { \
+        RepeatedCopy copies[MAX_REPEATED_COPIES]; \
+        const uint copyCount = GetRepeatedCopies(RepetitionsList[index], Rotate(Translate(p, ObjectsList[index].Position.xyz), ObjectsList[index].Rotation.xyz), copies); \
+        result = REPEATED_FAR; \
+        for (uint copyIndex = 0; copyIndex < copyCount; ++copyIndex) \
+        { \
+            const float copyScale = ObjectsList[index].Scale.x * copies[copyIndex].Scale; \
+            result = min(result, sdf##name(copies[copyIndex].Point / copyScale, ObjectsList[index].Parameters, footprint / copyScale) * copyScale * ObjectsList[index].StepScale); \
+        } \
+    }
+
+// Sets result to the gradient of the nearest copy in the object's rotated frame. Expects p, footprint and offset in scope.
+#define REPEATED_GRADIENT(name, index, result) \
+    { \
+        RepeatedCopy copies[MAX_REPEATED_COPIES]; \
+        const uint copyCount = GetRepeatedCopies(RepetitionsList[index], Rotate(Translate(p, ObjectsList[index].Position.xyz), ObjectsList[index].Rotation.xyz), copies); \
+        uint nearest = 0; \
+        float nearestDist = REPEATED_FAR; \
+        for (uint copyIndex = 0; copyCount > 1 && copyIndex < copyCount; ++copyIndex) \
+        { \
+            const float copyScale = ObjectsList[index].Scale.x * copies[copyIndex].Scale; \
+            const float copyDist = sdf##name(copies[copyIndex].Point / copyScale, ObjectsList[index].Parameters, footprint / copyScale) * copyScale; \
+            nearest = copyDist < nearestDist ? copyIndex : nearest; \
+            nearestDist = min(nearestDist, copyDist); \
+        } \
+        const float nearestScale = ObjectsList[index].Scale.x * copies[nearest].Scale; \
+        result = UnrepeatGradient(gradSdf##name(copies[nearest].Point / nearestScale, ObjectsList[index].Parameters, footprint / nearestScale, \
+                                                offset / nearestScale), copies[nearest]); \
+    }
+
+// Distance function called from pixel shader. footprint is the radius of the
+// ray's pixel cone at p, passed on to each SDF in its object's space.
+SceneDistanceInfo GetDistanceToScene(float3 p, float footprint)
 {
     float dist = renderSettings.maxDist;
     float prevDist = renderSettings.maxDist;
@@ -30,9 +213,114 @@ SceneDistanceInfo GetDistanceToScene(float3 p)
     int curIndex = 0;
 
 $DIST_FUNC_CONTENTS
+    COST_ADD_NEAREST(index);
+
     SceneDistanceInfo info;
     info.distance = dist;
     info.index = index;
 
     return info;
+}
+
+// Unnormalised gradient of one object's distance, as it enters the scene distance. offset spaces the taps of
+// snippets without an exact gradient.
+float3 GetObjectGradient(int index, float3 p, float footprint, float offset)
+{
+    [branch]
+    switch (index)
+    {
+$GRAD_FUNC_CONTENTS
+    default: return float3(0.0f, 1.0f, 0.0f);
+    }
+}
+
+// Folds an object's distance into dist by its operator, as GetDistanceToScene does, and its gradient into gradient by
+// how much of the result follows the object's distance. op is a literal in the generated code, so the switch folds.
+void CombineGradient(inout float dist, inout float3 gradient, float objectDist, int index, int op, float3 p, float footprint, float offset)
+{
+    const float radius = ObjectsList[index].BlendRadius;
+    float weight;
+    switch (op)
+    {
+    case 1: weight = objectDist > dist ? 1.0f : 0.0f; dist = max(dist, objectDist); break;
+    case 2: weight = -objectDist > dist ? 1.0f : 0.0f; dist = max(dist, -objectDist); break;
+    case 3: weight = GetSmoothUnionWeight(dist, objectDist, radius); dist = SmoothUnion(dist, objectDist, radius); break;
+    case 4: weight = GetSmoothUnionWeight(-dist, -objectDist, radius); dist = SmoothIntersection(dist, objectDist, radius); break;
+    case 5: weight = GetSmoothUnionWeight(-dist, objectDist, radius); dist = SmoothIntersection(dist, -objectDist, radius); break;
+    default: weight = objectDist < dist ? 1.0f : 0.0f; dist = min(dist, objectDist); break;
+    }
+
+    // Objects that don't move the result at p don't need their gradient
+    [branch]
+    if (weight > 0.0f)
+        gradient = lerp(gradient, GetObjectGradient(index, p, footprint, offset), weight);
+}
+
+// Unnormalised gradient of the scene distance: the nearest object's or, when objects blend, the gradients of the
+// objects that move the distance at p mixed by CombineGradient
+float3 GetSceneGradient(float3 p, float footprint, float offset)
+{
+$SCENE_GRAD_CONTENTS
+}
+
+// The same over the objects RayMarch marches, every one but the analytic primitives
+SceneDistanceInfo GetDistanceToMarchedObjects(float3 p, float footprint)
+{
+    float dist = renderSettings.maxDist;
+    float prevDist = renderSettings.maxDist;
+    int index = 0;
+    int curIndex = 0;
+
+$MARCHED_FUNC_CONTENTS
+    COST_ADD_NEAREST(index);
+
+    SceneDistanceInfo info;
+    info.distance = dist;
+    info.index = index;
+
+    return info;
+}
+
+// Keeps the analytic object's hit if it is nearer. The ray is brought into the object's space from where it
+// enters the object's bounding sphere, for precision.
+void IntersectAnalyticObject(inout AnalyticHit hit, float3 ro, float3 rd, int index, int type)
+{
+    const float scale = ObjectsList[index].Scale.x;
+    if (scale <= 0.0f || !HasAnalyticParameters(type, ObjectsList[index].Parameters))
+        return;
+
+    const float3 toCentre = ObjectsList[index].Position.xyz - ro;
+    const float centreDepth = dot(toCentre, rd);
+    const float radius = GetPrimitiveBoundingRadius(type, ObjectsList[index].Parameters) * scale * 1.001f;
+    if (dot(toCentre, toCentre) - centreDepth * centreDepth > radius * radius || centreDepth + radius < 0.0f || centreDepth - radius > hit.depth)
+        return;
+
+    const float start = max(centreDepth - radius, 0.0f);
+    const float3 localOrigin = Rotate(Translate(ro + rd * start, ObjectsList[index].Position.xyz), ObjectsList[index].Rotation.xyz) / scale;
+    const float3 localDirection = Rotate(rd, ObjectsList[index].Rotation.xyz);
+
+    float depth;
+    float3 normal;
+    if (!IntersectPrimitive(type, localOrigin, localDirection, ObjectsList[index].Parameters, depth, normal))
+        return;
+
+    depth = start + max(depth, 0.0f) * scale;
+    if (depth > hit.depth)
+        return;
+
+    hit.depth = depth;
+    hit.normal = InverseRotate(normal, ObjectsList[index].Rotation.xyz);
+    hit.index = index;
+}
+
+// Nearest analytic object along the ray within maxDepth, index -1 if there is none
+AnalyticHit IntersectAnalyticPrimitives(float3 ro, float3 rd, float maxDepth)
+{
+    AnalyticHit hit;
+    hit.depth = maxDepth;
+    hit.normal = float3(0.0f, 0.0f, 0.0f);
+    hit.index = -1;
+
+$ANALYTIC_FUNC_CONTENTS
+    return hit;
 }
\ No newline at end of file
@@ -0,0 +1,86 @@
+// Microbenchmark kernels for one user SDF snippet, see SnippetBenchmark.cpp.
+// The snippet's function is prepended at run time together with
+//   #define SNIPPET_SDF sdf<Name>
+// so this file is never compiled on its own. Points match
+// CPU::GetSnippetBenchmarkPoint and the estimator CPU::MeasureSnippetCost.
+// Snippets are measured at full detail, with a footprint of 0.
+
+#define SNIPPET_EVALUATIONS_PER_THREAD 16
+// CPU::SnippetSlopeBins, CPU::SnippetSlopeBinsPerOctave and CPU::SnippetSlopeMinLog2
+#define SNIPPET_SLOPE_BINS 64
+#define SNIPPET_SLOPE_BINS_PER_OCTAVE 8.0f
+#define SNIPPET_SLOPE_MIN_LOG2 -2.0f
+
+cbuffer SnippetBenchmarkSettings : register(b0)
+{
+    float3 Param;
+    uint PointCount;
+    float Extent; // CPU::SnippetBenchmarkExtent
+    float GradientStep; // CPU::SnippetGradientStep
+    uint2 PADDING;
+}
+
+// uint 0: largest gradient length as float bits (positive floats order like uints)
+// uint 1: written only if the snippet returns a magic value, so evaluations can't be optimised away
+// uint 4 onwards: slope histogram of SNIPPET_SLOPE_BINS counts
+RWByteAddressBuffer Result : register(u0);
+
+uint SnippetHash(uint x)
+{
+    x ^= x >> 16;
+    x *= 0x7FEB352D;
+    x ^= x >> 15;
+    x *= 0x846CA68B;
+    x ^= x >> 16;
+    return x;
+}
+
+float3 GetBenchmarkPoint(uint index)
+{
+    const uint3 h = uint3(SnippetHash(index * 3), SnippetHash(index * 3 + 1), SnippetHash(index * 3 + 2));
+    return (float3(h >> 8) * (1.0f / 16777216.0f) * 2.0f - 1.0f) * Extent;
+}
+
+uint GetSlopeBin(float slope)
+{
+    const float bin = (log2(max(slope, 1e-30f)) - SNIPPET_SLOPE_MIN_LOG2) * SNIPPET_SLOPE_BINS_PER_OCTAVE;
+    return (uint)clamp(bin, 0.0f, SNIPPET_SLOPE_BINS - 1.0f);
+}
+
+[numthreads(64, 1, 1)]
+void Throughput(uint3 DTid : SV_DispatchThreadID)
+{
+    float sum = 0.0f;
+    [loop]
+    for (uint i = 0; i < SNIPPET_EVALUATIONS_PER_THREAD; ++i)
+    {
+        const uint index = DTid.x * SNIPPET_EVALUATIONS_PER_THREAD + i;
+        if (index < PointCount)
+            sum += SNIPPET_SDF(GetBenchmarkPoint(index), Param, 0.0f);
+    }
+
+    if (sum == 1234567.0f)
+        Result.InterlockedAdd(4, 1);
+}
+
+[numthreads(64, 1, 1)]
+void Gradient(uint3 DTid : SV_DispatchThreadID)
+{
+    if (DTid.x >= PointCount)
+        return;
+
+    const float3 p = GetBenchmarkPoint(DTid.x);
+    const float h = GradientStep;
+    const float3 gradient = float3(
+        SNIPPET_SDF(p + float3(h, 0, 0), Param, 0.0f) - SNIPPET_SDF(p - float3(h, 0, 0), Param, 0.0f),
+        SNIPPET_SDF(p + float3(0, h, 0), Param, 0.0f) - SNIPPET_SDF(p - float3(0, h, 0), Param, 0.0f),
+        SNIPPET_SDF(p + float3(0, 0, h), Param, 0.0f) - SNIPPET_SDF(p - float3(0, 0, h), Param, 0.0f));
+    const float slope = length(gradient) / (2.0f * h);
+
+    // Points where the snippet returns NaN or infinity say nothing about its slope
+    if (!isnan(slope) && !isinf(slope))
+    {
+        Result.InterlockedMax(0, asuint(slope));
+        Result.InterlockedAdd(16 + GetSlopeBin(slope) * 4, 1);
+    }
+}
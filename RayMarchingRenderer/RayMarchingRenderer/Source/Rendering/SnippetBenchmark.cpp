@@ -0,0 +1,257 @@
+#include "pch.h"
+#include "Rendering/SnippetBenchmark.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	Microsoft::WRL::ComPtr<ID3DBlob> CompileKernel(const std::string& source, const char* entryPoint, std::string& error)
+	{
+		Microsoft::WRL::ComPtr<ID3DBlob> blob{};
+		Microsoft::WRL::ComPtr<ID3DBlob> errors{};
+		if (FAILED(D3DCompile(source.c_str(), source.size(), "SnippetBenchmark", nullptr, nullptr, entryPoint, "cs_5_0",
+		                      D3DCOMPILE_OPTIMIZATION_LEVEL3, 0, blob.GetAddressOf(), errors.GetAddressOf())))
+		{
+			error = errors ? std::string(static_cast<const char*>(errors->GetBufferPointer()), errors->GetBufferSize()) : "Compile failed";
+			return nullptr;
+		}
+		return blob;
+	}
+}
+
+SnippetBenchmark::SnippetBenchmark()
+{
+	const auto device = DX::DeviceResources::Instance()->GetD3DDevice();
+
+	const std::filesystem::path kernelPath = std::filesystem::current_path() / "Source" / "Rendering" / "Shaders" / "SnippetBenchmark.hlsli";
+	std::ifstream kernel(kernelPath);
+	KernelSource.assign(std::istreambuf_iterator<char>(kernel), std::istreambuf_iterator<char>());
+
+	D3D11_BUFFER_DESC bd = {};
+	bd.Usage = D3D11_USAGE_DEFAULT;
+	bd.ByteWidth = sizeof(SnippetBenchmarkSettings);
+	bd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	DX::ThrowIfFailed(device->CreateBuffer(&bd, nullptr, SettingsConstantBuffer.ReleaseAndGetAddressOf()));
+
+	bd = {};
+	bd.Usage = D3D11_USAGE_DEFAULT;
+	bd.ByteWidth = sizeof(uint32_t) * ResultSize;
+	bd.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+	bd.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+	DX::ThrowIfFailed(device->CreateBuffer(&bd, nullptr, ResultBuffer.ReleaseAndGetAddressOf()));
+
+	D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+	uavDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+	uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+	uavDesc.Buffer.NumElements = ResultSize;
+	uavDesc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_RAW;
+	DX::ThrowIfFailed(device->CreateUnorderedAccessView(ResultBuffer.Get(), &uavDesc, ResultUAV.ReleaseAndGetAddressOf()));
+
+	bd.Usage = D3D11_USAGE_STAGING;
+	bd.BindFlags = 0;
+	bd.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+	bd.MiscFlags = 0;
+	DX::ThrowIfFailed(device->CreateBuffer(&bd, nullptr, ResultStaging.ReleaseAndGetAddressOf()));
+
+	D3D11_QUERY_DESC queryDesc = {};
+	queryDesc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+	DX::ThrowIfFailed(device->CreateQuery(&queryDesc, Disjoint.ReleaseAndGetAddressOf()));
+	queryDesc.Query = D3D11_QUERY_TIMESTAMP;
+	for (auto& timestamp : Timestamps)
+		DX::ThrowIfFailed(device->CreateQuery(&queryDesc, timestamp.ReleaseAndGetAddressOf()));
+}
+
+void SnippetBenchmark::Request(const std::string& name, const std::string& body, const CPU::Float3& parameters)
+{
+	const uint64_t hash = CPU::HashSnippet(name, body);
+	const uint64_t measurement = CPU::HashSnippetMeasurement(hash, parameters);
+	if (Costs.contains(measurement) || Errors.contains(hash) || IsPending(hash, parameters))
+		return;
+
+	if (KernelSource.empty())
+	{
+		Errors[hash] = "SnippetBenchmark.hlsli not found";
+		return;
+	}
+
+	auto compile = Compiles.find(hash);
+	if (compile == Compiles.end())
+	{
+		// D3DCompile is thread safe, so the slow part of a measurement stays off the main thread
+		std::string source = "float sdf" + name + "(float3 p, float3 param, float footprint){\n" + body + "\n}\n#define SNIPPET_SDF sdf" + name + "\n" + KernelSource;
+		compile = Compiles.emplace(hash, std::async(std::launch::async, [source = std::move(source)]()
+		{
+			Kernels kernels{};
+			kernels.Throughput = CompileKernel(source, "Throughput", kernels.Error);
+			if (kernels.Throughput)
+				kernels.Gradient = CompileKernel(source, "Gradient", kernels.Error);
+			return kernels;
+		}).share()).first;
+	}
+
+	Job job{};
+	job.Hash = hash;
+	job.Measurement = measurement;
+	job.Parameters = parameters;
+	job.Compile = compile->second;
+	Jobs.push_back(std::move(job));
+}
+
+void SnippetBenchmark::Update()
+{
+	if (Jobs.empty())
+		return;
+
+	Job& job = Jobs.front();
+	if (!job.Dispatched)
+	{
+		if (job.Compile.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			return;
+
+		const Kernels& kernels = job.Compile.get();
+		if (!kernels.Error.empty())
+		{
+			const uint64_t hash = job.Hash;
+			Errors[hash] = kernels.Error;
+			// Every other param queued for the snippet fails the same way
+			std::erase_if(Jobs, [hash](const Job& queued) { return queued.Hash == hash; });
+			Compiles.erase(hash);
+			return;
+		}
+
+		Dispatch(kernels, job);
+		job.Dispatched = true;
+		return;
+	}
+
+	if (Resolve(job))
+		Jobs.pop_front();
+}
+
+void SnippetBenchmark::Dispatch(const Kernels& kernels, const Job& job)
+{
+	PROFILE_ZONE("Snippet Benchmark");
+	const auto device = DX::DeviceResources::Instance()->GetD3DDevice();
+	const auto context = DX::DeviceResources::Instance()->GetD3DDeviceContext();
+
+	Microsoft::WRL::ComPtr<ID3D11ComputeShader> throughput{};
+	Microsoft::WRL::ComPtr<ID3D11ComputeShader> gradient{};
+	DX::ThrowIfFailed(device->CreateComputeShader(kernels.Throughput->GetBufferPointer(), kernels.Throughput->GetBufferSize(), nullptr,
+	                                              throughput.ReleaseAndGetAddressOf()));
+	DX::ThrowIfFailed(device->CreateComputeShader(kernels.Gradient->GetBufferPointer(), kernels.Gradient->GetBufferSize(), nullptr,
+	                                              gradient.ReleaseAndGetAddressOf()));
+
+	DX::DeviceResources::Instance()->PIXBeginEvent(L"Snippet Benchmark");
+
+	// b0 belongs to the ray marching manager, so it is put back afterwards
+	Microsoft::WRL::ComPtr<ID3D11Buffer> previousSettings{};
+	context->CSGetConstantBuffers(0, 1, previousSettings.GetAddressOf());
+
+	static constexpr UINT zero[4] = { 0u, 0u, 0u, 0u };
+	context->ClearUnorderedAccessViewUint(ResultUAV.Get(), zero);
+	context->CSSetConstantBuffers(0, 1, SettingsConstantBuffer.GetAddressOf());
+	context->CSSetUnorderedAccessViews(0, 1, ResultUAV.GetAddressOf(), nullptr);
+
+	SnippetBenchmarkSettings settings{};
+	settings.Param[0] = job.Parameters.x;
+	settings.Param[1] = job.Parameters.y;
+	settings.Param[2] = job.Parameters.z;
+
+	context->Begin(Disjoint.Get());
+	context->End(Timestamps[0].Get());
+
+	settings.PointCount = ThroughputPoints;
+	context->UpdateSubresource(SettingsConstantBuffer.Get(), 0, nullptr, &settings, 0, 0);
+	context->CSSetShader(throughput.Get(), nullptr, 0);
+	context->Dispatch(ThroughputPoints / (EvaluationsPerThread * 64u), 1, 1);
+	context->End(Timestamps[1].Get());
+
+	settings.PointCount = GradientPoints;
+	context->UpdateSubresource(SettingsConstantBuffer.Get(), 0, nullptr, &settings, 0, 0);
+	context->CSSetShader(gradient.Get(), nullptr, 0);
+	context->Dispatch(GradientPoints / 64u, 1, 1);
+	context->End(Timestamps[2].Get());
+	context->End(Disjoint.Get());
+
+	context->CopyResource(ResultStaging.Get(), ResultBuffer.Get());
+
+	ID3D11UnorderedAccessView* nullUAV = nullptr;
+	context->CSSetUnorderedAccessViews(0, 1, &nullUAV, nullptr);
+	context->CSSetShader(nullptr, nullptr, 0);
+	context->CSSetConstantBuffers(0, 1, previousSettings.GetAddressOf());
+
+	DX::DeviceResources::Instance()->PIXEndEvent();
+}
+
+bool SnippetBenchmark::Resolve(const Job& job)
+{
+	const auto context = DX::DeviceResources::Instance()->GetD3DDeviceContext();
+
+	D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint = {};
+	if (context->GetData(Disjoint.Get(), &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+		return false;
+
+	UINT64 ticks[3] = {};
+	for (size_t i = 0; i < Timestamps.size(); ++i)
+		if (context->GetData(Timestamps[i].Get(), &ticks[i], sizeof(UINT64), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+			return false;
+
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	if (context->Map(ResultStaging.Get(), 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped) != S_OK)
+		return false;
+	uint32_t result[ResultSize]{};
+	std::memcpy(result, mapped.pData, sizeof(result));
+	context->Unmap(ResultStaging.Get(), 0);
+
+	// A disjoint interval (e.g. a clock change) has no usable timing. Nothing is recorded, so the next request measures again.
+	if (disjoint.Disjoint || disjoint.Frequency == 0 || ticks[1] <= ticks[0])
+		return true;
+
+	CPU::SnippetCost cost{};
+	cost.Hash = job.Hash;
+	cost.Parameters = job.Parameters;
+	cost.EvaluationsPerSecond = static_cast<float>(static_cast<double>(ThroughputPoints) * static_cast<double>(disjoint.Frequency) /
+	                                               static_cast<double>(ticks[1] - ticks[0]));
+	std::memcpy(&cost.MaxSlope, &result[0], sizeof(float));
+	uint32_t histogram[CPU::SnippetSlopeBins]{};
+	std::memcpy(histogram, &result[ResultHistogramOffset], sizeof(histogram));
+	cost.Lipschitz = CPU::GetSnippetLipschitz(histogram, cost.MaxSlope);
+	Costs[job.Measurement] = cost;
+	return true;
+}
+
+const CPU::SnippetCost* SnippetBenchmark::FindCost(const uint64_t hash, const CPU::Float3& parameters) const
+{
+	const auto cost = Costs.find(CPU::HashSnippetMeasurement(hash, parameters));
+	return cost != Costs.end() ? &cost->second : nullptr;
+}
+
+const std::string* SnippetBenchmark::FindError(const uint64_t hash) const
+{
+	const auto error = Errors.find(hash);
+	return error != Errors.end() ? &error->second : nullptr;
+}
+
+bool SnippetBenchmark::IsPending(const uint64_t hash, const CPU::Float3& parameters) const
+{
+	const uint64_t measurement = CPU::HashSnippetMeasurement(hash, parameters);
+	return std::any_of(Jobs.begin(), Jobs.end(), [measurement](const Job& job) { return job.Measurement == measurement; });
+}
+
+std::vector<CPU::SnippetCost> SnippetBenchmark::GetCosts() const
+{
+	std::vector<CPU::SnippetCost> costs{};
+	costs.reserve(Costs.size());
+	for (const auto& [measurement, cost] : Costs)
+		costs.push_back(cost);
+	return costs;
+}
+
+void SnippetBenchmark::AddCost(const CPU::SnippetCost& cost)
+{
+	if (cost.Hash != 0u)
+		Costs[CPU::HashSnippetMeasurement(cost.Hash, cost.Parameters)] = cost;
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <array>
+#include <deque>
+#include <future>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CPU/SnippetCost.h"
+
+// Measures user SDF snippets on the GPU in the background. Kernels are
+// compiled on a worker thread, dispatched once compiled, and their timestamps
+// and results read back once the GPU has finished, so no frame waits on a
+// measurement. Each snippet compiles once and is measured with every param
+// requested for it, one measurement at a time in request order.
+class SnippetBenchmark
+{
+public:
+	SnippetBenchmark();
+	SnippetBenchmark(const SnippetBenchmark&) = delete;
+	SnippetBenchmark(SnippetBenchmark&&) = delete;
+	SnippetBenchmark& operator=(const SnippetBenchmark&) = delete;
+	SnippetBenchmark& operator=(SnippetBenchmark&&) = delete;
+	~SnippetBenchmark() = default;
+
+	// Queues a measurement of sdf<name> with param unless it already has a result or is queued
+	void Request(const std::string& name, const std::string& body, const CPU::Float3& parameters);
+	// Advances the measurement in flight, call once per frame on the main thread
+	void Update();
+
+	// Null if the snippet hasn't been measured with param
+	[[nodiscard]] const CPU::SnippetCost* FindCost(uint64_t hash, const CPU::Float3& parameters) const;
+	// Compile errors of a snippet that couldn't be measured, null otherwise
+	[[nodiscard]] const std::string* FindError(uint64_t hash) const;
+	[[nodiscard]] bool IsPending(uint64_t hash, const CPU::Float3& parameters) const;
+	// Every measurement, for storing with a scene
+	[[nodiscard]] std::vector<CPU::SnippetCost> GetCosts() const;
+
+	// Seeds a result measured earlier, such as one stored with a scene
+	void AddCost(const CPU::SnippetCost& cost);
+
+private:
+	struct SnippetBenchmarkSettings
+	{
+		float Param[3]{};
+		uint32_t PointCount{ 0u };
+		float Extent{ CPU::SnippetBenchmarkExtent };
+		float GradientStep{ CPU::SnippetGradientStep };
+		uint32_t PADDING[2]{};
+	};
+
+	struct Kernels
+	{
+		Microsoft::WRL::ComPtr<ID3DBlob> Throughput{};
+		Microsoft::WRL::ComPtr<ID3DBlob> Gradient{};
+		std::string Error{};
+	};
+
+	struct Job
+	{
+		uint64_t Hash{ 0u };
+		uint64_t Measurement{ 0u }; // CPU::HashSnippetMeasurement
+		CPU::Float3 Parameters{ 1.0f };
+		std::shared_future<Kernels> Compile{};
+		bool Dispatched{ false };
+	};
+
+	static constexpr uint32_t ThroughputPoints = 1u << 20u;
+	static constexpr uint32_t GradientPoints = 1u << 16u;
+	static constexpr uint32_t EvaluationsPerThread = 16u; // SNIPPET_EVALUATIONS_PER_THREAD
+	// Max slope, magic value, two unused, then the slope histogram
+	static constexpr uint32_t ResultHistogramOffset = 4u;
+	static constexpr uint32_t ResultSize = ResultHistogramOffset + CPU::SnippetSlopeBins;
+
+	void Dispatch(const Kernels& kernels, const Job& job);
+	// True once the job's results have been read back
+	bool Resolve(const Job& job);
+
+	std::string KernelSource{};
+
+	std::deque<Job> Jobs{};
+	// Compiled or compiling kernels by snippet hash, shared by every param the snippet is measured with
+	std::unordered_map<uint64_t, std::shared_future<Kernels>> Compiles{};
+	// By measurement hash
+	std::unordered_map<uint64_t, CPU::SnippetCost> Costs{};
+	// By snippet hash
+	std::unordered_map<uint64_t, std::string> Errors{};
+
+	Microsoft::WRL::ComPtr<ID3D11Buffer> SettingsConstantBuffer{};
+	Microsoft::WRL::ComPtr<ID3D11Buffer> ResultBuffer{};
+	Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> ResultUAV{};
+	Microsoft::WRL::ComPtr<ID3D11Buffer> ResultStaging{};
+	Microsoft::WRL::ComPtr<ID3D11Query> Disjoint{};
+	std::array<Microsoft::WRL::ComPtr<ID3D11Query>, 3> Timestamps{};
+};
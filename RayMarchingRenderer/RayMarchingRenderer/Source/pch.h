@@ -59,6 +59,8 @@
 #include <stdexcept>
 
 #include "Core/DeviceResources.h"
+#include "CPU/Metrics.h"
+#include "CPU/Profiler.h"
 
 #ifdef _DEBUG
 #include <dxgidebug.h>
@@ -92,9 +94,11 @@ namespace DX
 		}
 	}
 
-	// Compile Shader
-	inline HRESULT CompileShaderFromFile(const WCHAR* fileName, LPCSTR entryPoint, LPCSTR shaderModel, ID3DBlob** blobOut)
+	// Compile Shader, defines is a null terminated array of macros
+	inline HRESULT CompileShaderFromFile(const WCHAR* fileName, LPCSTR entryPoint, LPCSTR shaderModel, ID3DBlob** blobOut,
+	                                     const D3D_SHADER_MACRO* defines = nullptr)
 	{
+		PROFILE_ZONE("Shader Compile");
 		HRESULT hr = S_OK;
 
 		DWORD dwShaderFlags = D3DCOMPILE_ENABLE_STRICTNESS;
@@ -108,11 +112,17 @@ namespace DX
 #endif
 
 		ID3DBlob* pErrorBlob = nullptr;
-		hr = D3DCompileFromFile(fileName, nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, entryPoint, shaderModel,
+		const uint64_t compileStart = CPU::GetProfilerTime();
+		hr = D3DCompileFromFile(fileName, defines, D3D_COMPILE_STANDARD_FILE_INCLUDE, entryPoint, shaderModel,
 		                        dwShaderFlags, 0, blobOut, &pErrorBlob);
 
+		const CPU::RenderMetrics& metrics = CPU::GetRenderMetrics();
+		CPU::GetMetrics().Observe(metrics.ShaderCompileSeconds, static_cast<double>(CPU::GetProfilerTime() - compileStart) * 1e-9);
+
 		if (FAILED(hr))
 		{
+			CPU::GetMetrics().Add(metrics.ShaderCompileFailures);
+
 			// Output if D3DCompileFromFile has error
 			if (pErrorBlob)
 			{